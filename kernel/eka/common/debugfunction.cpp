@@ -21,6 +21,7 @@
 #endif
 #include "dla.h"
 #ifndef __KERNEL_MODE__
+#include <e32atomics.h>
 #include "slab.h"
 #include "page_alloc.h"
 #endif
@@ -142,6 +143,8 @@ TInt RHybridHeap::DebugFunction(TInt aFunc, TAny* a1, TAny* a2)
 					cmd->iConfig.iSlabBits = iSlabConfigBits;
 					cmd->iConfig.iDelayedSlabThreshold = iPageThreshold;
 					cmd->iConfig.iPagePower = iPageThreshold;
+					cmd->iConfig.iMagazineCount = iMagazineCount;
+					cmd->iConfig.iBigSlabSize = iBigSlabSize;
 					break;
 					
 				case ESetConfig:
@@ -157,6 +160,32 @@ TInt RHybridHeap::DebugFunction(TInt aFunc, TAny* a1, TAny* a2)
 #endif
 					break;
 					
+				case ESetMagazineConfig:
+					//
+					// New number of thread magazines in front of the slab allocator.
+					// Cached cells are returned to the slabs before the change
+					//
+#if USE_HYBRID_HEAP
+					Lock();
+					r = MagazineConfig(cmd->iConfig.iMagazineCount);
+					Unlock();
+#endif
+					break;
+					
+				case ESetBigSlabConfig:
+					//
+					// New largest cell size for the big slab allocator. Cells
+					// already in big slabs stay there until they are freed
+					//
+#if USE_HYBRID_HEAP
+					Lock();
+					iBigSlabSize = iDLOnly ? 0 : cmd->iConfig.iBigSlabSize;
+					if ( iSlabInitThreshold == KMaxTInt32 )
+						BigSlabConfig(iBigSlabSize);	// slab system already set up
+					Unlock();
+#endif
+					break;
+					
 				case EHeapMetaData:
 					cmd->iData = this;
 					break;
@@ -463,6 +492,7 @@ TInt RHybridHeap::DoCheckHeap(SCheckInfo* aInfo)
 	TInt    npages;
 	__HEAP_CORRUPTED_TEST(CheckBitmap(NULL, 0, dummy, npages), ETHeapBadCellAddress, this, 0);  // Check page allocator buffers
 	DoCheckSlabTrees();	
+	DoCheckBigSlabs();
 	DoCheckCommittedSize(npages, GM);
 #endif				   
     winfo.iFunction = WalkCheckCell;
@@ -1111,6 +1141,48 @@ void RHybridHeap::DoCheckSlab(slab* aSlab, TAllocatorType aSlabType, TAny* aBfr)
 		}
 }
 
+void RHybridHeap::DoCheckBigSlab(bigslab* aSlab, TAny* aBfr)
+{
+	unsigned h = aSlab->iHeader;
+	unsigned size = BigSlabHeaderSize(h);
+	unsigned ix = BigSlabHeaderClass(h);
+	__HEAP_CORRUPTED_TEST(((h & ~0x00ffffff) == BIGSLAB_BIT), ETHeapBadCellAddress,aBfr,aSlab);
+	__HEAP_CORRUPTED_TEST((ix < BIGSLABCLASSES), ETHeapBadCellAddress,aBfr,aSlab);
+	__HEAP_CORRUPTED_TEST((size > MAXSLABSIZE && size <= MAXBIGSLABSIZE && (size & 7) == 0), ETHeapBadCellAddress,aBfr,aSlab);
+	unsigned count = KBigSlabPayload / size;
+	unsigned used = __e32_bit_count_32(aSlab->iMap[0]) + __e32_bit_count_32(aSlab->iMap[1]) - (64 - count);
+	__HEAP_CORRUPTED_TEST((used == aSlab->iUsed && used <= count), ETHeapBadCellAddress,aBfr,aSlab);
+	if ( aBfr )
+		{
+		// the buffer must be the start of an allocated cell
+		TInt offs = PtrDiff(aBfr, aSlab) - sizeof(bigslab);
+		unsigned cell = offs / size;
+		__HEAP_CORRUPTED_TEST((offs >= 0 && (offs % size) == 0 && cell < count), ETHeapBadCellAddress,aBfr,aSlab);
+		__HEAP_CORRUPTED_TEST((aSlab->iMap[cell>>5] & (1u<<(cell&31))), ETHeapBadCellAddress,aBfr,aSlab);
+		}
+}
+
+void RHybridHeap::DoCheckBigSlabs()
+{
+	for (TInt ix = 0; ix < BIGSLABCLASSES; ++ix)
+		{
+		bigslab** parent = &iBigSlabAlloc[ix].iPartial;
+		for (TInt l = 0; l < 2; ++l)
+			{
+			for (bigslab* s = *parent; s; s = s->iNext)
+				{
+				__HEAP_CORRUPTED_TEST((s->iPrev == parent), ETHeapBadCellAddress,s,PAGESIZE);
+				__HEAP_CORRUPTED_TEST((BigSlabHeaderClass(s->iHeader) == (unsigned)ix), ETHeapBadCellAddress,s,PAGESIZE);
+				DoCheckBigSlab(s);
+				unsigned count = KBigSlabPayload / BigSlabHeaderSize(s->iHeader);
+				__HEAP_CORRUPTED_TEST((l ? s->iUsed == count : (s->iUsed && s->iUsed < count)), ETHeapBadCellAddress,s,PAGESIZE);
+				parent = &s->iNext;
+				}
+			parent = &iBigSlabAlloc[ix].iFull;
+			}
+		}
+}
+
 //
 //  Check that committed size in heap equals number of pages in bitmap
 //  plus size of Doug Lea region
@@ -22,6 +22,7 @@
 #endif
 #include "dla.h"
 #ifndef __KERNEL_MODE__
+#include <e32atomics.h>
 #include "slab.h"
 #include "page_alloc.h"
 #endif
@@ -33,6 +34,15 @@
 // if non zero this causes the iSlabs to be configured only when the chunk size exceeds this level
 #define DELAYED_SLAB_THRESHOLD (64*1024)		// 64KB seems about right based on trace data
 #define SLAB_CONFIG 0xabe						// Use slabs of size 48, 40, 32, 24, 20, 16, 12, and 8 bytes
+#define BIGSLAB_CONFIG 0						// Big slabs (57-1016 bytes) are disabled unless configured
+#define MAGAZINE_CONFIG 0						// Thread magazines are disabled unless configured
+
+// Thread magazines satisfy slab sized requests without taking the heap lock. They are
+// left out of debug builds, where every cell carries a nesting level and allocation
+// count which must be kept consistent with the heap counters under the lock
+#ifndef _DEBUG
+#define __USE_MAGAZINES
+#endif
 
 #ifdef _DEBUG
 #define __SIMULATE_ALLOC_FAIL(s)	if (CheckForSimulatedAllocFail()) {s}
@@ -92,6 +102,11 @@
 		  if ( ((TUint32)P & 0x3) || ((TUint8*)P<iMemBase) || ((TUint8*)(P)>(TUint8*)this))  \
 			   BTraceContext12(BTrace::EHeap, BTrace::EHeapCorruption, (TUint32)this, (TUint32)P, (TUint32)S), HEAP_PANIC(ETHeapBadCellAddress); \
 		  else DoCheckSlab(S, EPartialFullSlab, P), BuildPartialSlabBitmap(B,S,P) 					  
+#define __BIGSLAB_BFR_CHECK(P) \
+	  if ( MEMORY_MONITORED ) \
+		  if ( ((TUint32)P & 0x7) || ((TUint8*)P<iMemBase) || ((TUint8*)(P)>(TUint8*)this))  \
+			   BTraceContext12(BTrace::EHeap, BTrace::EHeapCorruption, (TUint32)this, (TUint32)P, (TUint32)0), HEAP_PANIC(ETHeapBadCellAddress); \
+		  else DoCheckBigSlab(bigslab::BigSlabFor(P), P)
 #define __PAGE_BFR_CHECK(P) \
 		if ( MEMORY_MONITORED ) \
 			if ( ((TUint32)P &  ((1 << iPageSize)-1)) || ((TUint8*)P<iMemBase) || ((TUint8*)(P)>(TUint8*)this))  \
@@ -361,6 +376,8 @@ void RHybridHeap::Construct(TBool aSingleThread, TBool aDLOnly, TBool aUseAdjust
 #endif // DELAYED_SLAB_THRESHOLD
 	iUseAdjust = aUseAdjust;
 	iDLOnly    = aDLOnly;
+	iBigSlabSize = aDLOnly ? 0 : BIGSLAB_CONFIG;
+	iMagazineCount = aDLOnly ? 0 : MAGAZINE_CONFIG;
 #else
 	(void)aUseAdjust;	
 #endif 
@@ -449,11 +466,13 @@ void RHybridHeap::Init(TInt aBitmapSlab, TInt aPagePower)
 	
 #ifndef __KERNEL_MODE__	
 	SlabInit();
+	BigSlabInit();
 	iSlabConfigBits = aBitmapSlab;
 	if ( iChunkSize > iSlabInitThreshold )
 		{
 		iSlabInitThreshold = KMaxTInt32;
 		SlabConfig(aBitmapSlab);   // Delayed slab configuration done
+		BigSlabConfig(iBigSlabSize);
 		}
 	if ( aPagePower )
 		{
@@ -493,7 +512,11 @@ TInt RHybridHeap::AllocLen(const TAny* aCell) const
 	if ( aCell )
 		{
 		if (LowBits(aCell, iPageSize) )
+			{
+			if (bigslab::IsBigSlab(aCell))
+				return BigSlabHeaderSize(bigslab::BigSlabFor(aCell)->iHeader) - __DEBUG_HDR_SIZE;
 			return SlabHeaderSize(slab::SlabFor(aCell)->iHeader) - __DEBUG_HDR_SIZE;
+			}
 		
 		return PagedSize((void*)aCell) - __DEBUG_HDR_SIZE;
 		}
@@ -547,6 +570,27 @@ TAny* RHybridHeap::Alloc(TInt aSize)
 #ifdef ENABLE_BTRACE
 	TInt aSubAllocator=0;
 #endif
+
+#ifdef __USE_MAGAZINES
+	if ( iMagazines && (aSize < iSlabThreshold) )
+		{
+		addr = MagazineAllocate(aSize);
+		if ( addr )
+			{
+#ifdef ENABLE_BTRACE
+			if (iFlags & ETraceAllocs)
+				{
+				TUint32 traceData[3];
+				traceData[0] = AllocLen(addr);
+				traceData[1] = aSize;
+				traceData[2] = 1;
+				BTraceContextN(BTrace::EHeap, BTrace::EHeapAlloc, (TUint32)this, (TUint32)addr, traceData, sizeof(traceData));
+				}
+#endif
+			return addr;
+			}
+		}
+#endif
 	
 	Lock();
 	
@@ -554,6 +598,10 @@ TAny* RHybridHeap::Alloc(TInt aSize)
 	
 	if (aSize < iSlabThreshold)
 		{
+#ifdef __USE_MAGAZINES
+		if ( iMagazineCount && !iMagazines )
+			MagazineInit();
+#endif
 		TInt ix = iSizeMap[(aSize+3)>>2];
 		HEAP_ASSERT(ix != 0xff);
 		addr = SlabAllocate(iSlabAlloc[ix]);
@@ -565,7 +613,18 @@ TAny* RHybridHeap::Alloc(TInt aSize)
 		else
 			aSubAllocator=1;
 #endif
-		}else if((aSize >> iPageThreshold)==0)
+		}else if((aSize < iBigSlabThreshold) && (aSize > MAXSLABSIZE))
+			{
+			addr = BigSlabAllocate(aSize);
+			if ( !addr )
+				{ // Big slab allocation has failed, try to allocate from DL
+				addr = DlMalloc(aSize);
+				}
+#ifdef ENABLE_BTRACE
+			else
+				aSubAllocator=1;
+#endif
+			}else if((aSize >> iPageThreshold)==0)
 			{
 			addr = DlMalloc(aSize);
 			}
@@ -618,6 +677,7 @@ TInt RHybridHeap::Compress()
 		return 0;
 	
 	Lock();
+	MagazineFlush();
 	TInt Reduced = SysTrim(GM, 0);
 	if (iSparePage)
 		{
@@ -638,6 +698,20 @@ void RHybridHeap::Free(TAny* aPtr)
 #ifdef ENABLE_BTRACE
 	TInt aSubAllocator=0;
 #endif
+
+#ifdef __USE_MAGAZINES
+	if ( iMagazines && !MEMORY_MONITORED && (PtrDiff(aPtr, this) < 0) && LowBits(aPtr, iPageSize) && MagazineFree(aPtr) )
+		{
+#ifdef ENABLE_BTRACE
+		if (iFlags & ETraceAllocs)
+			{
+			TUint32 traceData = 1;
+			BTraceContextN(BTrace::EHeap, BTrace::EHeapFree, (TUint32)this, (TUint32)aPtr, &traceData, sizeof(traceData));
+			}
+#endif
+		return;
+		}
+#endif
 	Lock();
 	
 	aPtr = __GET_DEBUG_DATA_BFR(aPtr);
@@ -667,11 +741,21 @@ void RHybridHeap::Free(TAny* aPtr)
 #ifdef ENABLE_BTRACE
 		aSubAllocator = 1;
 #endif
-		TUint32 bm[4];   		
-		__SLAB_BFR_CHECK(slab::SlabFor(aPtr),aPtr,bm);
-		__DECREMENT_COUNTERS(__GET_USER_DATA_BFR(aPtr));  
-		__ZAP_CELL(aPtr);		
-		SlabFree(aPtr);
+		if ( bigslab::IsBigSlab(aPtr) )
+			{
+			__BIGSLAB_BFR_CHECK(aPtr);
+			__DECREMENT_COUNTERS(__GET_USER_DATA_BFR(aPtr));  
+			__ZAP_CELL(aPtr);		
+			BigSlabFree(aPtr);
+			}
+		else
+			{
+			TUint32 bm[4];   		
+			__SLAB_BFR_CHECK(slab::SlabFor(aPtr),aPtr,bm);
+			__DECREMENT_COUNTERS(__GET_USER_DATA_BFR(aPtr));  
+			__ZAP_CELL(aPtr);		
+			SlabFree(aPtr);
+			}
 		}
 #endif  // __KERNEL_MODE__	
 //	iCellCount--;
@@ -797,7 +881,14 @@ TAny* RHybridHeap::ReAllocImpl(TAny* aPtr, TInt aSize, TInt aMode)
 		{	// current cell in slab iArena
 		TUint32 bm[4];
 		Lock();
-		__SLAB_BFR_CHECK(slab::SlabFor(aPtr), aPtr, bm);
+		if ( bigslab::IsBigSlab(aPtr) )
+			{
+			__BIGSLAB_BFR_CHECK(aPtr);
+			}
+		else
+			{
+			__SLAB_BFR_CHECK(slab::SlabFor(aPtr), aPtr, bm);
+			}
 		Unlock();
 		if ( aSize <= oldsize)
 			return aPtr;
@@ -1796,8 +1887,10 @@ TInt RHybridHeap::GetInfo(struct HeapInfo* i, SWalkInfo* wi) const
 	i->iFootprint = iChunkSize;
 	i->iMaxSize = iMaxLength;
 #ifndef __KERNEL_MODE__		
+	((RHybridHeap*)this)->MagazineFlush();	// cells cached in magazines are free, not allocated
 	PagedInfo(i, wi);
 	SlabInfo(i, wi);
+	BigSlabInfo(i, wi);
 #endif	
 	return DlInfo(i,wi);
 }
@@ -1863,6 +1956,7 @@ void* RHybridHeap::Map(void* p, TInt sz)
 	if (iChunkSize >= iSlabInitThreshold)
 		{	// set up slab system now that heap is large enough
 		SlabConfig(iSlabConfigBits);
+		BigSlabConfig(iBigSlabSize);
 		iSlabInitThreshold = KMaxTInt32;
 		}
 
@@ -2180,6 +2274,7 @@ void RHybridHeap::SlabInit()
 	iPartialPage = 0;
 	iFullSlab = 0;
 	iSparePage = 0;
+	iMagazines = 0;		// magazine page, if any, has been released with the page bitmap
 	memset(&iSizeMap[0],0xff,sizeof(iSizeMap));
 	memset(&iSlabAlloc[0],0,sizeof(iSlabAlloc));
 }
@@ -2330,6 +2425,366 @@ void* RHybridHeap::InitNewSlab(slabset& allocator, slab* s)
 	return Offset(s,sizeof(slabhdr));
 }
 
+//
+// Big slab allocator code
+//
+// Cells larger than MAXSLABSIZE and up to MAXBIGSLABSIZE bytes can be allocated from
+// pages dedicated to a single size class. The bigslab header at the start of the page
+// holds a bitmap of its allocated cells. A big slab page is told apart from a page of
+// 1KB slabs by BIGSLAB_BIT in its first word, which is always zero in a slab iHeader.
+// The size classes are chosen to waste as little of the page as possible.
+//
+
+const TUint16 bigslab_size[BIGSLABCLASSES] =
+{
+	64, 72, 80, 88, 96, 112, 128, 144, 160, 184, 200,
+	224, 248, 288, 336, 400, 448, 504, 576, 672, 808, 1016
+};
+
+void RHybridHeap::BigSlabInit()
+{
+	iBigSlabThreshold = 0;
+	memset(&iBigSizeMap[0],0xff,sizeof(iBigSizeMap));
+	memset(&iBigSlabAlloc[0],0,sizeof(iBigSlabAlloc));
+}
+
+void RHybridHeap::BigSlabConfig(TInt aMaxSize)
+//
+// Use big slabs for cells up to the size class that holds aMaxSize bytes
+//
+{
+	iBigSlabThreshold = 0;
+	memset(&iBigSizeMap[0],0xff,sizeof(iBigSizeMap));
+	if (iDLOnly || aMaxSize <= MAXSLABSIZE)
+		return;
+	
+	TInt last = 0;
+	while (last < BIGSLABCLASSES-1 && bigslab_size[last] < (unsigned)aMaxSize)
+		++last;
+	TInt ix = 0;
+	for (unsigned sz = 0; sz <= bigslab_size[last]; sz += 8)
+		{
+		if (bigslab_size[ix] < sz)
+			++ix;		// class sizes are multiples of 8 so this steps one class at a time
+		iBigSizeMap[sz>>3] = (TUint8)ix;
+		}
+	iBigSlabThreshold = bigslab_size[last] + 1;
+}
+
+void RHybridHeap::BigSlabLink(bigslab* s, bigslab** r)
+{
+	bigslab* n = *r;
+	s->iNext = n;
+	s->iPrev = r;
+	if (n)
+		n->iPrev = &s->iNext;
+	*r = s;
+}
+
+void RHybridHeap::BigSlabUnlink(bigslab* s)
+{
+	bigslab* n = s->iNext;
+	*s->iPrev = n;
+	if (n)
+		n->iPrev = s->iPrev;
+}
+
+bigslab* RHybridHeap::AllocNewBigSlab(TInt aClass)
+//
+// Acquire a page and initialise it as an empty big slab of the given size class
+//
+{
+	page* p	 = iSparePage;
+	if (p)
+		iSparePage = 0;
+	else
+		{
+		p = static_cast<page*>(Map(0, iPageSize));
+		if (!p)
+			return 0;
+		}
+	HEAP_ASSERT(p == Floor(p, iPageSize));
+	// Store page allocated for big slab into paged_bitmap (for RHybridHeap::Reset())
+	if (!PagedSetSize(p, iPageSize))
+		{
+		Unmap(p, iPageSize);
+		return 0;
+		}
+	bigslab* s = reinterpret_cast<bigslab*>(p);
+	unsigned size = bigslab_size[aClass];
+	unsigned count = KBigSlabPayload / size;
+	s->iHeader = BIGSLAB_BIT | (aClass<<16) | size;
+	s->iUsed = 0;
+	// mark the bits beyond the last cell as allocated so that they are never found free
+	s->iMap[0] = (count < 32) ? ~((1u<<count)-1) : 0;
+	s->iMap[1] = (count < 32) ? ~0u : ~((1u<<(count-32))-1);
+	return s;
+}
+
+void* RHybridHeap::BigSlabAllocate(TInt aSize)
+//
+// Allocate a cell from the lowest free position in the first partial big slab
+// of the size class, moving the slab to the full list when its last cell is used
+//
+{
+	TInt ix = iBigSizeMap[(aSize+7)>>3];
+	HEAP_ASSERT(ix != 0xff);
+	bigslabset& ss = iBigSlabAlloc[ix];
+	bigslab* s = ss.iPartial;
+	if (!s)
+		{
+		s = AllocNewBigSlab(ix);
+		if (!s)
+			return 0;
+		BigSlabLink(s, &ss.iPartial);
+		}
+	unsigned size = BigSlabHeaderSize(s->iHeader);
+	unsigned w = (~s->iMap[0]) ? 0 : 1;
+	unsigned bit = __e32_find_ls1_32(~s->iMap[w]);
+	unsigned cell = (w<<5) + bit;
+	HEAP_ASSERT(cell < KBigSlabPayload / size);
+	s->iMap[w] |= (1u<<bit);
+	if (++s->iUsed == KBigSlabPayload / size)
+		{
+		BigSlabUnlink(s);
+		BigSlabLink(s, &ss.iFull);
+		}
+	return Offset(s, sizeof(bigslab) + cell*size);
+}
+
+void RHybridHeap::BigSlabFree(void* p)
+//
+// Free a big slab cell. A full slab goes back to the partial list and an
+// empty slab gives its page back
+//
+{
+	bigslab* s = bigslab::BigSlabFor(p);
+	unsigned h = s->iHeader;
+	unsigned size = BigSlabHeaderSize(h);
+	unsigned cell = (PtrDiff(p, s) - sizeof(bigslab)) / size;
+	HEAP_ASSERT(PtrDiff(p, s) == (TInt)(sizeof(bigslab) + cell*size));
+	HEAP_ASSERT(s->iMap[cell>>5] & (1u<<(cell&31)));
+	s->iMap[cell>>5] &= ~(1u<<(cell&31));
+	if (s->iUsed-- == KBigSlabPayload / size)
+		{	// slab was full, make its cells available again
+		BigSlabUnlink(s);
+		BigSlabLink(s, &iBigSlabAlloc[BigSlabHeaderClass(h)].iPartial);
+		}
+	if (s->iUsed == 0)
+		{
+		BigSlabUnlink(s);
+		FreePage(reinterpret_cast<page*>(s));
+		}
+}
+
+void RHybridHeap::BigSlabInfo(struct HeapInfo* i, SWalkInfo* wi) const
+{
+	for (int ix = 0; ix < BIGSLABCLASSES; ++ix)
+		{
+		bigslab* const lists[2] = {iBigSlabAlloc[ix].iPartial, iBigSlabAlloc[ix].iFull};
+		for (int l = 0; l < 2; ++l)
+			{
+			for (bigslab* s = lists[l]; s; s = s->iNext)
+				{
+				unsigned size = BigSlabHeaderSize(s->iHeader);
+				unsigned count = KBigSlabPayload / size;
+				for (unsigned cell = 0; cell < count; ++cell)
+					{
+					TAny* bfr = Offset(s, sizeof(bigslab) + cell*size);
+					if (s->iMap[cell>>5] & (1u<<(cell&31)))
+						{
+						i->iAllocBytes += size;
+						++i->iAllocN;
+						Walk(wi, bfr, size, EGoodAllocatedCell, ESlabAllocator);
+						}
+					else
+						{
+						i->iFreeBytes += size;
+						++i->iFreeN;
+						Walk(wi, bfr, size, EGoodFreeCell, ESlabAllocator);
+						}
+					}
+				}
+			}
+		}
+}
+
+//
+// Thread magazine code
+//
+// A magazine caches a few free cells of each slab size class for the threads whose
+// id hashes to it, so most small allocations and frees are done without the heap lock.
+// The heap lock is only taken to move MAGAZINEBATCH cells between a magazine and its
+// slabsets when the magazine runs empty or overflows. A thread which finds its magazine
+// in use by another thread simply takes the locked path.
+//
+// Once mapped, the magazine page stays mapped until the heap is reset, as a thread
+// may still be using a magazine when they are disabled.
+//
+
+#ifdef __USERSIDE_THREAD_DATA__
+TLocalThreadData* LocalThreadData();
+#endif
+
+static inline TUint MagazineThreadKey()
+//
+// Returns a value which picks the calling thread's magazine. Where the thread's
+// local data is available the id cached there is used, saving an exec call.
+//
+{
+#ifdef __USERSIDE_THREAD_DATA__
+	return LocalThreadData()->iThreadId;
+#else
+	return (TUint)RThread().Id();
+#endif
+}
+
+void RHybridHeap::MagazineInit()
+//
+// Map and clear the page holding the magazines. Called with the heap locked.
+// If no page can be mapped the heap carries on without magazines.
+//
+{
+	HEAP_ASSERT(iMagazines == 0);
+	void* p = Map(0, iPageSize);
+	if (!p)
+		return;
+	// the magazine page is mapped into paged_bitmap like a slab page (for RHybridHeap::Reset())
+	if (!PagedSetSize(p, iPageSize))
+		{
+		Unmap(p, iPageSize);
+		return;
+		}
+	memset(p, 0, iPageSize);
+	__e32_atomic_store_rel_ptr(&iMagazines, p);
+}
+
+TInt RHybridHeap::MagazineConfig(TInt aCount)
+//
+// Set the number of magazines in use. Called with the heap locked.
+// Cells left in a magazine which is busy at the time are returned by a later flush.
+//
+{
+	if (aCount < 0)
+		return KErrArgument;
+	if (aCount > MAXMAGAZINES)
+		aCount = MAXMAGAZINES;
+	while (aCount & (aCount-1))
+		aCount &= (aCount-1);	// round down to a power of 2
+	if (iDLOnly || (iFlags & ESingleThreaded))
+		aCount = 0;
+	__e32_atomic_store_ord32(&iMagazineCount, aCount);
+	MagazineFlush();
+	return KErrNone;
+}
+
+void RHybridHeap::MagazineFlush()
+//
+// Return all cells cached in the magazines to their slabsets. Called with the heap locked.
+// A magazine which is in use by another thread is left alone.
+//
+{
+	if (!iMagazines)
+		return;
+	for (TInt i = 0; i < MAXMAGAZINES; ++i)
+		{
+		magazine& m = iMagazines[i];
+		if (__e32_atomic_swp_acq32(&m.iLock, 1))
+			continue;
+		for (TInt ix = 0; ix < (MAXSLABSIZE>>2); ++ix)
+			{
+			while (m.iCount[ix])
+				SlabFree(m.iCells[ix][--m.iCount[ix]]);
+			}
+		__e32_atomic_store_rel32(&m.iLock, 0);
+		}
+}
+
+magazine* RHybridHeap::MagazineLock()
+//
+// Find and lock the calling thread's magazine. Returns NULL if magazines are
+// disabled or the magazine is in use by another thread.
+//
+{
+	TUint count = __e32_atomic_load_acq32(&iMagazineCount);
+	if (count == 0)
+		return 0;
+	magazine* m = &iMagazines[MagazineThreadKey() & (count-1)];
+	if (__e32_atomic_swp_acq32(&m->iLock, 1))
+		return 0;
+	if (__e32_atomic_load_acq32(&iMagazineCount) == 0)
+		{
+		// disabled meanwhile, don't cache any more cells
+		__e32_atomic_store_rel32(&m->iLock, 0);
+		return 0;
+		}
+	return m;
+}
+
+void* RHybridHeap::MagazineAllocate(TInt aSize)
+//
+// Allocate a cell from the calling thread's magazine, refilling the magazine
+// from the slabset when it is empty. Returns NULL if the magazine is busy or the
+// slabset cannot supply any cells, in which case the caller takes the locked path.
+//
+{
+	TInt ix = iSizeMap[(aSize+3)>>2];
+	if (ix == 0xff)
+		return 0;		// slab configuration not complete
+	magazine* mp = MagazineLock();
+	if (!mp)
+		return 0;
+	magazine& m = *mp;
+	TUint count = m.iCount[ix];
+	if (count == 0)
+		{
+		Lock();
+		while (count < MAGAZINEBATCH)
+			{
+			void* p = SlabAllocate(iSlabAlloc[ix]);
+			if (!p)
+				break;
+			m.iCells[ix][count++] = p;
+			}
+		Unlock();
+		}
+	void* p = 0;
+	if (count)
+		p = m.iCells[ix][--count];
+	m.iCount[ix] = (TUint8)count;
+	__e32_atomic_store_rel32(&m.iLock, 0);
+	return p;
+}
+
+TBool RHybridHeap::MagazineFree(void* p)
+//
+// Free a slab cell into the calling thread's magazine, returning a batch of cells
+// to the slabset when the magazine is full. Returns EFalse if the magazine is busy.
+//
+{
+	if (bigslab::IsBigSlab(p))
+		return EFalse;		// big slab cells are not cached
+	// The size field of a slab header does not change while the slab has allocated cells
+	TInt ix = (SlabHeaderSize(slab::SlabFor(p)->iHeader)>>2) - 1;
+	HEAP_ASSERT(ix >= 0 && ix < (MAXSLABSIZE>>2));
+	magazine* mp = MagazineLock();
+	if (!mp)
+		return EFalse;
+	magazine& m = *mp;
+	TUint count = m.iCount[ix];
+	if (count == MAGAZINESIZE)
+		{
+		Lock();
+		while (count > MAGAZINESIZE - MAGAZINEBATCH)
+			SlabFree(m.iCells[ix][--count]);
+		Unlock();
+		}
+	m.iCells[ix][count++] = p;
+	m.iCount[ix] = (TUint8)count;
+	__e32_atomic_store_rel32(&m.iLock, 0);
+	return ETrue;
+}
+
 const unsigned char slab_bitcount[16] = {0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4};
 
 const unsigned char slab_ext_frag[16] =
@@ -99,7 +99,8 @@ TInt DDeviceEthernet::Create(DLogicalChannelBase*& aChannel)
 
 DChannelEthernet::DChannelEthernet()
 // Constructor
-    :   iRxCompleteDfc(CompleteRxDfc, this, 2)
+    :   iRxCompleteDfc(CompleteRxDfc, this, 2),
+        iCoalesceDfc(CoalesceDfc, this, 2)
     {
     __KTRACE_OPT(KNETWORK1, Kern::Printf("DChannelEthernet::DChannelEthernet()"));
 
@@ -125,6 +126,7 @@ DChannelEthernet::~DChannelEthernet()
 // Destructor
     {
     __KTRACE_OPT(KNETWORK1, Kern::Printf("DChannelEthernet::~DChannelEthernet()"));
+	Kern::DestroyClientRequest(iBatchRequest);
 	Kern::DestroyClientRequest(iWriteRequest);
 	Kern::DestroyClientBufferRequest(iReadRequest);
 	// decrement it's reference count
@@ -149,6 +151,14 @@ void DChannelEthernet::Complete(TInt aMask, TInt aReason)
 		__KTRACE_OPT(KNETWORK2, Kern::Printf(" >ldd tx: PRE complete reason=%d iClient=%08x iTxStatus=%08x\n", aReason, iClient, iWriteRequest->StatusPtr()));
 		Kern::QueueRequestComplete(iClient, iWriteRequest, aReason);
 		}
+    if (aMask & EBatch)
+		{
+    	__KTRACE_OPT(KNETWORK1, Kern::Printf("DChannelEthernet::Complete iBatchRequest"));
+		if (iBatchRequest->IsReady())
+			{
+			Kern::QueueRequestComplete(iClient, iBatchRequest, aReason);
+			}
+		}
 	}
 
 
@@ -168,6 +178,8 @@ void DChannelEthernet::Shutdown()
 	    iRxCompleteDfc.Cancel();
 		}
 
+	StopBatch();
+
 	// No harm in doing this
     __KTRACE_OPT(KNETWORK1, Kern::Printf("DChannelEthernet::Shutdown()- Completing message"));
     iMsgQ.iMessage->Complete(KErrNone,EFalse);
@@ -198,8 +210,13 @@ TInt DChannelEthernet::DoCreate(TInt aUnit,
 	if (r != KErrNone)
 		return r;
 
+	r = Kern::CreateClientRequest(iBatchRequest);
+	if (r != KErrNone)
+		return r;
+
 	SetDfcQ(((DEthernet*)iPdd)->DfcQ(aUnit));
 	iRxCompleteDfc.SetDfcQ(iDfcQ);
+	iCoalesceDfc.SetDfcQ(iDfcQ);
     iMsgQ.Receive();
         
     ((DEthernet *)iPdd)->iLdd=this;
@@ -225,23 +242,37 @@ void DChannelEthernet::Start()
 
 
 void DChannelEthernet::ReceiveIsr()
-	// Copies data into the iFifo's buffers
+	// Copies data into the iFifo's buffers, or the receive ring in batch mode
     {
     __KTRACE_OPT(KNETWORK1, Kern::Printf("DChannelEthernet::ReceiveIsr()"));
     TBuf8<KMaxEthernetPacket+32> * buffer;
 //	TInt err;
 
-    buffer = iFIFO.GetFree();
-    if(buffer == NULL)
+	// In batch mode the frame goes straight into the receive ring, unless
+	// earlier frames are still waiting in the FIFO for the ring to have room
+	TInt slot = KErrNotFound;
+	if (iRings && iFIFO.IsEmpty())
+		slot = FreeRxSlot();
+	if (slot >= 0)
 		{
-	    __KTRACE_OPT(KNETWORK1, Kern::Printf("DChannelEthernet::ReceiveIsr()- Dropping a frame"));
-		/*err =*/ PddReceive(*buffer, EFalse); //Need to call as must drain RX buffer
-		// Should something be done about returned errors?
-		return;
+		/*err =*/ PddReceive(*iRxBufs[slot], ETrue);
+		// the frame must be complete before FillRxRing() sees the new count
+		__e32_atomic_store_rel32(&iRxFill, iRxFill + 1);
+		}
+	else
+		{
+	    buffer = iFIFO.GetFree();
+	    if(buffer == NULL)
+			{
+		    __KTRACE_OPT(KNETWORK1, Kern::Printf("DChannelEthernet::ReceiveIsr()- Dropping a frame"));
+			/*err =*/ PddReceive(*buffer, EFalse); //Need to call as must drain RX buffer
+			// Should something be done about returned errors?
+			return;
+			}
+	    else
+			/*err =*/ PddReceive(*buffer, ETrue);
+			// Should something be done about returned errors?
 		}
-    else
-		/*err =*/ PddReceive(*buffer, ETrue);
-		// Should something be done about returned errors?
 
 	// Add another DFc as we have a buffer and is not already queued
 	if (!iRxCompleteDfc.Queued())
@@ -270,6 +301,12 @@ void DChannelEthernet::DoCompleteRx()
 	__KTRACE_OPT(KNETWORK1, Kern::Printf("DChannelEthernet::DoCompleteRx()"));
 	__KTRACE_OPT2(KNETWORK1, KNETWORK2, Kern::Printf(" >ldd isr triggered..."));
 
+	if (iPool)
+		{
+		FillRxRing();
+		CheckRxBatch();
+		return;
+		}
 
 	if (iReadRequest->IsReady())
     	{
@@ -298,6 +335,258 @@ void DChannelEthernet::DoCompleteRx()
 
     }
 
+void DChannelEthernet::CoalesceDfc(TAny* aPtr)
+    {
+    __KTRACE_OPT(KNETWORK1, Kern::Printf("DChannelEthernet::CoalesceDfc(TAny* aPtr)"));
+    DChannelEthernet *pC=(DChannelEthernet*)aPtr;
+	if (pC->iPool && pC->RxWaiting())
+		pC->Complete(EBatch, KErrNone);
+    }
+
+
+TInt DChannelEthernet::FreeRxSlot()
+	{
+	// The client's tail is only believed if it lies among the frames it has
+	// been given, so a bad one just makes the ring look full
+	TUint32 tail = __e32_atomic_load_acq32(&iRings->iRx.iTail);
+	if (iRxHead - tail > (TUint32)KEthernetRingSlots || iRxFill - tail >= (TUint32)KEthernetRingSlots)
+		return KErrNotFound;
+	return iRxFill % KEthernetRingSlots;
+	}
+
+
+void DChannelEthernet::FillRxRing()
+	{
+	// Frames which arrived while the ring was full are copied from the FIFO
+	// as the client makes room. The slot is claimed with interrupts off so
+	// that ReceiveIsr() doesn't take it too.
+	TBuf8<KMaxEthernetPacket+32> * buffer;
+	while ((buffer = iFIFO.GetNext()) != NULL)
+		{
+		TInt irq = DisableIrqs();
+		TInt slot = FreeRxSlot();
+		if (slot >= 0)
+			++iRxFill;
+		RestoreIrqs(irq);
+		if (slot < 0)
+			break;
+		iRxBufs[slot]->Copy(*buffer);
+		iFIFO.SetNext();
+		}
+
+	TEthernetRing& ring = iRings->iRx;
+	TUint32 fill = __e32_atomic_load_acq32(&iRxFill);
+	TUint8* base = Kern::ShBufPtr(iFrameBufs[0]);
+	TInt n = fill - iRxHead;
+	for (TUint32 head = iRxHead; head != fill; ++head)
+		{
+		TInt slot = head % KEthernetRingSlots;
+		TEthernetSlot& s = ring.iSlots[slot];
+		s.iOffset = iRxBufs[slot]->Ptr() - base;
+		s.iLength = (TUint16)iRxBufs[slot]->Length();
+		s.iStatus = KErrNone;
+		}
+	if (n)
+		{
+		// the frames must be visible before the new head
+		__e32_memory_barrier();
+		iRxHead = fill;
+		ring.iHead = fill;
+		}
+	__KTRACE_OPT(KNETWORK2, Kern::Printf("DChannelEthernet::FillRxRing()- %d frames, head=%d", n, iRxHead));
+	}
+
+
+TInt DChannelEthernet::RxWaiting()
+	{
+	// a tail outside the ring has nothing waiting for it
+	TUint32 waiting = iRxHead - iRings->iRx.iTail;
+	return waiting > (TUint32)KEthernetRingSlots ? 0 : waiting;
+	}
+
+
+void DChannelEthernet::CheckRxBatch()
+	{
+	if (!iBatchRequest->IsReady())
+		return;
+	TInt waiting = RxWaiting();
+	if (waiting == 0)
+		return;
+	if (waiting >= iRxCoalesceFrames || iRxCoalesceTicks == 0)
+		{
+		iCoalesceTimer.Cancel();
+		iCoalesceDfc.Cancel();
+		Complete(EBatch, KErrNone);
+		}
+	else
+		{
+		// does nothing if the timer is already running for an earlier frame
+		iCoalesceTimer.OneShot(iRxCoalesceTicks, iCoalesceDfc);
+		}
+	}
+
+
+TInt DChannelEthernet::StartBatch(TEthernetBatchV01& aBatch)
+	{
+	__KTRACE_OPT(KNETWORK1, Kern::Printf("DChannelEthernet::StartBatch() frames=%d time=%d", aBatch.iRxCoalesceFrames, aBatch.iRxCoalesceTime));
+	__ASSERT_COMPILE(sizeof(TEthernetRings) <= (TUint)KEthernetFrameBufferSize);
+	__ASSERT_COMPILE(sizeof(TBuf8<KMaxEthernetPacket+32>) <= (TUint)KEthernetFrameBufferSize);
+
+	if (iPool)
+		return KErrInUse;
+	if (aBatch.iRxCoalesceFrames < 1 || aBatch.iRxCoalesceFrames > KEthernetRingSlots || aBatch.iRxCoalesceTime < 0)
+		return KErrArgument;
+	if (iReadRequest->IsReady())
+		return KErrInUse;
+
+	NKern::ThreadEnterCS();
+	// The pools aren't page aligned, so each is mapped in one piece and the
+	// offsets between its buffers are the same in the client as they are here.
+	// The PDD receives into descriptors in the receive pool, which the client
+	// can only read, so it can't change their lengths under the PDD.
+	TShPoolCreateInfo info(TShPoolCreateInfo::ENonPageAlignedBuffer, KEthernetFrameBufferSize, 1 + KEthernetRingSlots, 5);
+	TShPoolCreateInfo rxInfo(TShPoolCreateInfo::ENonPageAlignedBuffer, KEthernetFrameBufferSize, KEthernetRingSlots, 5);
+	TInt r = Kern::ShPoolCreate(iPool, info, ETrue, EShPoolWriteable | EShPoolAllocate);
+	if (r == KErrNone)
+		r = Kern::ShPoolCreate(iRxPool, rxInfo, ETrue, EShPoolWriteable | EShPoolAllocate);
+	if (r == KErrNone)
+		r = Kern::ShPoolAlloc(iPool, iRingsBuf, 0);
+	TInt i;
+	for (i = 0; r == KErrNone && i < 2*KEthernetRingSlots; ++i)
+		r = Kern::ShPoolAlloc(i < KEthernetRingSlots ? iRxPool : iPool, iFrameBufs[i], 0);
+	TInt handles[4] = {KErrNone, KErrNone, KErrNone, KErrNone};
+	TEthernetRings* rings = NULL;
+	if (r == KErrNone)
+		{
+		rings = (TEthernetRings*)Kern::ShBufPtr(iRingsBuf);
+		memclr(rings, sizeof(TEthernetRings));
+		TUint8* base = Kern::ShBufPtr(iFrameBufs[0]);
+		for (i = 0; i < KEthernetRingSlots; ++i)
+			{
+			iRxBufs[i] = new (Kern::ShBufPtr(iFrameBufs[i])) TBuf8<KMaxEthernetPacket+32>;
+			iTxFrames[i] = Kern::ShBufPtr(iFrameBufs[KEthernetRingSlots + i]);
+			rings->iRx.iSlots[i].iOffset = iRxBufs[i]->Ptr() - base;
+			rings->iTx.iSlots[i].iOffset = iTxFrames[i] - (TUint8*)rings;
+			}
+		handles[0] = Kern::ShPoolMakeHandleAndOpen(iPool, iClient, EShPoolWriteable);
+		if (handles[0] >= 0)
+			handles[1] = Kern::ShBufMakeHandleAndOpen(iRingsBuf, iClient);
+		if (handles[1] >= 0)
+			handles[2] = Kern::ShPoolMakeHandleAndOpen(iRxPool, iClient, 0);
+		if (handles[2] >= 0)
+			handles[3] = Kern::ShBufMakeHandleAndOpen(iFrameBufs[0], iClient);
+		for (i = 0; i < 4 && handles[i] > 0; ++i)
+			{}
+		if (i < 4)
+			{
+			r = handles[i];
+			while (i--)
+				Kern::CloseHandle(iClient, handles[i]);
+			}
+		}
+	NKern::ThreadLeaveCS();
+	if (r != KErrNone)
+		{
+		StopBatch();
+		return r;
+		}
+
+	aBatch.iPoolHandle = handles[0];
+	aBatch.iRingsHandle = handles[1];
+	aBatch.iRxPoolHandle = handles[2];
+	aBatch.iRxFramesHandle = handles[3];
+	iRxFill = 0;
+	iRxHead = 0;
+	iTxTail = 0;
+	iRxCoalesceFrames = aBatch.iRxCoalesceFrames;
+	TInt tick = NKern::TickPeriod();
+	iRxCoalesceTicks = (aBatch.iRxCoalesceTime + tick - 1) / tick;
+
+	// ReceiveIsr() may use the receive ring from now on
+	__e32_memory_barrier();
+	iRings = rings;
+
+	// frames which arrived before batch mode go to the ring
+	FillRxRing();
+	if (iStatus == EOpen)
+		Start();
+	return KErrNone;
+	}
+
+
+void DChannelEthernet::StopBatch()
+	{
+	if (!iPool)
+		return;
+	__KTRACE_OPT(KNETWORK1, Kern::Printf("DChannelEthernet::StopBatch()"));
+	iCoalesceTimer.Cancel();
+	iCoalesceDfc.Cancel();
+	TInt irq = DisableIrqs();
+	iRings = NULL;
+	RestoreIrqs(irq);
+	NKern::ThreadEnterCS();
+	for (TInt i = 0; i < 2*KEthernetRingSlots; ++i)
+		{
+		if (iFrameBufs[i])
+			{
+			Kern::ShBufClose(iFrameBufs[i]);
+			iFrameBufs[i] = NULL;
+			}
+		}
+	if (iRingsBuf)
+		{
+		Kern::ShBufClose(iRingsBuf);
+		iRingsBuf = NULL;
+		}
+	if (iRxPool)
+		{
+		Kern::ShPoolClose(iRxPool);
+		iRxPool = NULL;
+		}
+	Kern::ShPoolClose(iPool);
+	iPool = NULL;
+	NKern::ThreadLeaveCS();
+	}
+
+
+TInt DChannelEthernet::SendBatch()
+	{
+	if (!iPool)
+		return KErrNotReady;
+	TEthernetRing& ring = iRings->iTx;
+	TUint32 head = ring.iHead;
+	// the frames were written before the head
+	__e32_memory_barrier();
+	if (head - iTxTail > (TUint32)KEthernetRingSlots)
+		return KErrCorrupt;
+	TInt sent = 0;
+	while (iTxTail != head)
+		{
+		TInt slot = iTxTail % KEthernetRingSlots;
+		TEthernetSlot& s = ring.iSlots[slot];
+		TInt len = s.iLength;
+		TInt r = KErrNone;
+		if (len > iFIFO.iTxBuf.MaxLength())
+			r = KErrTxFrameToBig;
+		else if (len)
+			{
+			iFIFO.iTxBuf.Copy(iTxFrames[slot], len);
+			__KTRACE_OPT2(KNETWORK1, KNETWORK2, Kern::Printf(" >ldd tx: tcp seq=%u ack=%u\n", GetTcpSeqNumber(iFIFO.iTxBuf), GetTcpAckNumber(iFIFO.iTxBuf)) );
+			if (PddSend(iFIFO.iTxBuf) != KErrNone)
+				r = KErrCommsLineFail;
+			else
+				++sent;
+			}
+		s.iStatus = (TInt16)r;
+		++iTxTail;
+		}
+	// the statuses must be visible before the new tail
+	__e32_memory_barrier();
+	ring.iTail = iTxTail;
+	return sent;
+	}
+
+
 //Override sendMsg to allow data copy in the context of client thread for WDP.
 TInt DChannelEthernet::SendMsg(TMessageBase* aMsg)
 	{
@@ -336,6 +625,7 @@ TInt DChannelEthernet::SendControl(TMessageBase* aMsg)
 	TInt bufMaxLen;
 	TEthernetConfigV01 config;
 	TEthernetCaps caps;
+	TEthernetBatchV01 batch;
 	TAny* a1 = m.Ptr0();
 	TInt r = KErrNone;
 	switch(id)
@@ -363,6 +653,21 @@ TInt DChannelEthernet::SendControl(TMessageBase* aMsg)
 			m.iArg[0] = &caps;
 			break;
 			}
+		case RBusDevEthernet::EControlStartBatch:
+			{
+			__KTRACE_OPT(KNETWORK1, Kern::Printf("DChannelEthernet::SendControl EControlStartBatch"));
+			Kern::KUDesInfo(*(const TDesC8*)a1, bufLen, bufMaxLen);
+			if((TUint)bufLen < sizeof(batch) || (TUint)bufMaxLen < sizeof(batch))
+				{
+				return KErrArgument;
+				}
+			TPtr8 b((TUint8*)&batch,0,sizeof(batch));
+			Kern::KUDesGet(*(TDes8*)&b, *(const TDesC8*)a1);
+			m.iArg[0] = &batch;
+			break;
+			}
+		case RBusDevEthernet::EControlSendBatch:
+			break;
 		case RBusDevEthernet::EControlSetConfig:
 		case RBusDevEthernet::EControlSetMac:
 			{
@@ -382,7 +687,7 @@ TInt DChannelEthernet::SendControl(TMessageBase* aMsg)
 			return KErrNotSupported;
 		}
 	r = DLogicalChannel::SendMsg(aMsg);
-	if(r != KErrNone)
+	if(r < KErrNone)
 		return r;
 	switch(id)
 		{
@@ -396,6 +701,11 @@ TInt DChannelEthernet::SendControl(TMessageBase* aMsg)
 			Kern::KUDesPut(*(TDes8*)a1, (const TDesC8&)caps);
 			break;
 			}
+		case RBusDevEthernet::EControlStartBatch:
+			{
+			Kern::KUDesPut(*(TDes8*)a1, TPtrC8((const TUint8*)&batch, sizeof(batch)));
+			break;
+			}
 		}
 	return r;
 	}
@@ -416,6 +726,10 @@ TInt DChannelEthernet::SendRequest(TMessageBase* aMsg)
 				{
 				return KErrNotReady;
 				}
+			if(iPool)
+				{
+				return KErrInUse;
+				}
 			TInt len;
 			umemget32(&len, a2, sizeof(len));
 			if(len == 0)
@@ -436,6 +750,10 @@ TInt DChannelEthernet::SendRequest(TMessageBase* aMsg)
 			TInt len;
 			TInt bufLen;
 			TInt bufMaxLen;
+			if(iPool)
+				{
+				return KErrInUse;
+				}
 			umemget32(&len, a2, sizeof(len));
 			if(len == 0)
 				{
@@ -463,6 +781,15 @@ TInt DChannelEthernet::SendRequest(TMessageBase* aMsg)
 			iReadRequest->EndSetup();
 			break;
 			}
+		case RBusDevEthernet::ERequestReceiveBatch:
+			{
+			r = iBatchRequest->SetStatus(pS);
+			if (r != KErrNone)
+				{
+				return r;
+				}
+			break;
+			}
 #ifdef ETH_CHIP_IO_ENABLED
 		case RBusDevEthernet::EChipDiagIOCtrl:
 			{
@@ -549,6 +876,13 @@ void DChannelEthernet::DoCancel(TInt aMask)
 		__KTRACE_OPT2(KNETWORK1, KNETWORK2, Kern::Printf("> ldd: DChannelEthernet::DoCancel - Completing write cancel\n"));
 		Complete(ETx,KErrCancel);
 		}
+
+	if (aMask & RBusDevEthernet::ERequestReceiveBatchCancel)
+		{
+		iCoalesceTimer.Cancel();
+		iCoalesceDfc.Cancel();
+		Complete(EBatch,KErrCancel);
+		}
     }
 
 
@@ -575,6 +909,17 @@ TInt DChannelEthernet::DoRequest(TInt aReqNo, TRequestStatus* /*aStatus*/, TAny*
 		    __KTRACE_OPT2(KNETWORK1, KNETWORK2, Kern::Printf(" >ldd tx: RBusDevEthernet::ERequestWrite..."));
 			InitiateWrite(a1,len);
 		    break;
+
+		case RBusDevEthernet::ERequestReceiveBatch:
+			if (!iPool)
+				{
+				Complete(EBatch, KErrNotReady);
+				break;
+				}
+			// the client may have made room for frames still in the FIFO
+			FillRxRing();
+			CheckRxBatch();
+		    break;
 #ifdef ETH_CHIP_IO_ENABLED
         case RBusDevEthernet::EChipDiagIOCtrl:
             {
@@ -687,6 +1032,18 @@ TInt DChannelEthernet::DoControl(TInt aFunction, TAny* a1, TAny* /*a2*/)
 			*(TEthernetCaps*)a1 = capsBuf;
 			break;
 			}
+		case RBusDevEthernet::EControlStartBatch:
+			{
+			__KTRACE_OPT(KNETWORK1, Kern::Printf("DChannelEthernet::DoControl EControlStartBatch"));
+			r = StartBatch(*(TEthernetBatchV01*)a1);
+			break;
+			}
+		case RBusDevEthernet::EControlSendBatch:
+			{
+			__KTRACE_OPT(KNETWORK2, Kern::Printf("DChannelEthernet::DoControl EControlSendBatch"));
+			r = SendBatch();
+			break;
+			}
 		default:
 			{
 			__KTRACE_OPT(KNETWORK1, Kern::Printf("DChannelEthernet::DoControl default 0x%x", aFunction));
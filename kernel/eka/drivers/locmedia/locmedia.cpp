@@ -67,14 +67,64 @@ HBuf* DriveNames[KMaxLocalDrives];
 TInt UsedMedia=0;
 TPasswordStore* ThePasswordStore=NULL;
 
+/*
+TLocMediaIoScheduler
+
+Internal class which orders the read and write requests a media's DFC finds 
+waiting on its message queue before passing them one at a time to 
+DPrimaryMediaBase::HandleMsg(). Within each batch:
+	(1) paging reads go first, background paging writes go last and everything else goes in between;
+	(2) requests of the same kind go in ascending order of media position starting from the end 
+		of the last request, wrapping round once, so contiguous requests reach the media driver 
+		back to back and the media isn't swept back and forth;
+	(3) a request never overtakes an earlier one which it overlaps unless both are reads.
+Any other kind of request ends the batch, so it is still handled after everything which arrived before it.
+
+Each request in the queue comes from a different thread blocked in TThreadMessage::SendReceive(), 
+so the order in which they are serviced is not otherwise defined.
+*/
+class TLocMediaIoScheduler
+	{
+public:
+	enum {EDefaultWindow=16, EMaxWindow=32};
+public:
+	TLocMediaIoScheduler();
+	static TBool Schedulable(TLocDrvRequest& aReq);
+	inline TBool Enabled() const
+		{return iWindow > 1;}
+	inline TBool Full() const
+		{return iCount >= iWindow;}
+	void Add(TLocDrvRequest& aReq);
+	void Run(DPrimaryMediaBase& aPrimaryMedia);
+private:
+	TInt Next() const;
+	TBool Blocked(TInt aIndex) const;
+	static TInt Class(TLocDrvRequest& aReq);
+	static Int64 Position(TLocDrvRequest& aReq);
+	static TBool IsRead(TLocDrvRequest& aReq);
+public:
+	TInt iWindow;							// maximum batch size, <= 1 to service requests in arrival order
+	TLocalDriveIoSchedulerInfo iInfo;		// statistics
+private:
+	TInt iCount;
+	TLocDrvRequest* iReq[EMaxWindow];		// in arrival order
+	Int64 iHeadPos;							// media position following the last request dispatched
+	TInt iHeadKind;							// class and direction of the last request dispatched
+	};
+
 class DPrimaryMediaBase::DBody : public DBase
 	{
 public:
 	DBody(DPrimaryMediaBase& aPrimaryMediaBase);
+	void RequestStart(TLocDrvRequest& aReq);
+	void RequestEnd();
+	TInt IoSchedulerInfo(TLocalDriveIoSchedulerInfo& aInfo);
 public:
 	DPrimaryMediaBase& iPrimaryMediaBase;	// ptr to parent
 	TInt iPhysDevIndex;
 	TInt iRequestCount;
+	TLocMediaIoScheduler iIoScheduler;
+	TInt iInFlight;							// number of requests in progress
 #ifdef __DEMAND_PAGING__
 	DMediaPagingDevice* iPagingDevice;
 	TInt iPageSizeMsk;			// Mask of page size (e.g. 4096-1 -> 4095)
@@ -1754,6 +1804,7 @@ void handleMsg(TAny* aPtr)
 	{
 	OstTraceFunctionEntry0( _HANDLEMSG_ENTRY );
 	DPrimaryMediaBase* primaryMedia=(DPrimaryMediaBase*)aPtr;
+	TLocMediaIoScheduler& scheduler=primaryMedia->iBody->iIoScheduler;
 
 	for(TLocDrvRequest* m = (TLocDrvRequest*) primaryMedia->iMsgQ.iMessage; 
 		m != NULL; 
@@ -1763,14 +1814,31 @@ void handleMsg(TAny* aPtr)
 		if (!primaryMedia->iMsgQ.iQ.IsEmpty())	
 			__KTRACE_OPT(KLOCDRV, Kern::Printf("TRACE: handleMsg, queue not empty %08X", m));	
 #endif
-		primaryMedia->HandleMsg(*m);
-		
+
 #ifdef __DEMAND_PAGING__
 		// don't empty the queue if this media is paging as there 
 		// may be a (higher-priority) paging DFC waiting to run...
 		if (primaryMedia->iPagingMedia)
+			{
+			primaryMedia->HandleMsg(*m);
 			break;
+			}
 #endif
+
+		// batch up reads and writes while there are more waiting so they can be reordered,
+		// anything else is handled after the requests which arrived before it
+		if (scheduler.Enabled() && TLocMediaIoScheduler::Schedulable(*m))
+			{
+			scheduler.Add(*m);
+			if (!scheduler.Full() && !primaryMedia->iMsgQ.iQ.IsEmpty())
+				continue;
+			scheduler.Run(*primaryMedia);
+			}
+		else
+			{
+			scheduler.Run(*primaryMedia);
+			primaryMedia->HandleMsg(*m);
+			}
 		}
 
 
@@ -1798,6 +1866,201 @@ DPrimaryMediaBase::DBody::DBody(DPrimaryMediaBase& aPrimaryMediaBase) :
 	{
 	}
 
+void DPrimaryMediaBase::DBody::RequestStart(TLocDrvRequest& aReq)
+//
+// Count a request as it is sent to the media. Called in the requesting thread.
+//
+	{
+	TLocalDriveIoSchedulerInfo& info = iIoScheduler.iInfo;
+	TInt id = aReq.Id();
+	if (id == DLocalDrive::ERead || id == DLocalDrive::EWrite || (aReq.Flags() & TLocDrvRequest::EPaging))
+		__e32_atomic_add_ord32((id == DLocalDrive::EWrite) ? &info.iWriteCount : &info.iReadCount, 1);
+	else
+		__e32_atomic_add_ord32(&info.iOtherCount, 1);
+	TInt inFlight = (TInt)__e32_atomic_add_ord32(&iInFlight, 1) + 1;
+	if (inFlight > info.iMaxInFlight)
+		info.iMaxInFlight = inFlight;	// not exact if racing, but good enough for statistics
+	}
+
+void DPrimaryMediaBase::DBody::RequestEnd()
+	{
+	__e32_atomic_add_ord32(&iInFlight, TUint32(-1));
+	}
+
+TInt DPrimaryMediaBase::DBody::IoSchedulerInfo(TLocalDriveIoSchedulerInfo& aInfo)
+//
+// Handle a RLocalDrive::EQueryIoSchedulerInfo query. aInfo holds the caller's 
+// settings on entry and is overwritten with the current statistics.
+//
+	{
+	TInt window = aInfo.iWindow;
+	TBool reset = aInfo.iReset;
+	if (window != TLocalDriveIoSchedulerInfo::ENoChange)
+		{
+		if (window < 0 || window > TLocMediaIoScheduler::EMaxWindow)
+			return KErrArgument;
+		iIoScheduler.iWindow = window;
+		}
+	aInfo = iIoScheduler.iInfo;
+	aInfo.iWindow = iIoScheduler.iWindow;
+	aInfo.iReset = reset;
+	aInfo.iBatching = (iPrimaryMediaBase.iDfcQ != NULL);
+#ifdef __DEMAND_PAGING__
+	if (iPrimaryMediaBase.iPagingMedia)
+		aInfo.iBatching = EFalse;		// handleMsg services paging media one request at a time
+#endif
+	if (reset)
+		{
+		memclr(&iIoScheduler.iInfo, sizeof(iIoScheduler.iInfo));
+		iIoScheduler.iInfo.iMaxInFlight = iInFlight;
+		}
+	return KErrNone;
+	}
+
+TLocMediaIoScheduler::TLocMediaIoScheduler()
+	:	iWindow(EDefaultWindow), iCount(0), iHeadPos(0), iHeadKind(-1)
+	{
+	memclr(&iInfo, sizeof(iInfo));
+	}
+
+TBool TLocMediaIoScheduler::IsRead(TLocDrvRequest& aReq)
+	{
+	return aReq.Id() != DLocalDrive::EWrite;
+	}
+
+TBool TLocMediaIoScheduler::Schedulable(TLocDrvRequest& aReq)
+	{
+	switch (aReq.Id())
+		{
+		case DLocalDrive::ERead:
+		case DLocalDrive::EWrite:
+#ifdef __DEMAND_PAGING__
+		case DMediaPagingDevice::ERomPageInRequest:
+		case DMediaPagingDevice::ECodePageInRequest:
+#endif
+			return ETrue;
+		default:
+			return EFalse;
+		}
+	}
+
+TInt TLocMediaIoScheduler::Class(TLocDrvRequest& aReq)
+//
+// Paging reads (class 0) are serviced before other requests (class 1),
+// which are serviced before background paging writes (class 2).
+//
+	{
+	TInt flags = aReq.Flags();
+	if (flags & TLocDrvRequest::EPaging)
+		{
+		if (IsRead(aReq))
+			return 0;
+		if (flags & TLocDrvRequest::EBackgroundPaging)
+			return 2;
+		}
+	return 1;
+	}
+
+Int64 TLocMediaIoScheduler::Position(TLocDrvRequest& aReq)
+	{
+	Int64 pos = aReq.Pos();
+	if (!(aReq.Flags() & TLocDrvRequest::EAdjusted))
+		pos += aReq.Drive()->iPartitionBaseAddr;
+	return pos;
+	}
+
+void TLocMediaIoScheduler::Add(TLocDrvRequest& aReq)
+	{
+	__ASSERT_DEBUG(iCount < EMaxWindow, LOCM_FAULT());
+	iReq[iCount++] = &aReq;
+	}
+
+TBool TLocMediaIoScheduler::Blocked(TInt aIndex) const
+//
+// A request can't overtake an earlier request it overlaps unless both are reads.
+//
+	{
+	TLocDrvRequest& r = *iReq[aIndex];
+	Int64 start = Position(r);
+	Int64 end = start + r.Length();
+	TBool read = IsRead(r);
+	for (TInt i = 0; i < aIndex; ++i)
+		{
+		TLocDrvRequest& e = *iReq[i];
+		if (read && IsRead(e))
+			continue;
+		Int64 s = Position(e);
+		if (s < end && start < s + e.Length())
+			return ETrue;
+		}
+	return EFalse;
+	}
+
+TInt TLocMediaIoScheduler::Next() const
+//
+// Returns the index of the next request to dispatch.
+//
+	{
+	TInt best = 0;			// the oldest request is never blocked
+	TInt bestClass = Class(*iReq[0]);
+	Int64 bestPos = Position(*iReq[0]);
+	TBool bestWrapped = bestPos < iHeadPos;
+	for (TInt i = 1; i < iCount; ++i)
+		{
+		TLocDrvRequest& r = *iReq[i];
+		TInt c = Class(r);
+		if (c > bestClass)
+			continue;
+		Int64 pos = Position(r);
+		TBool wrapped = pos < iHeadPos;
+		if (c == bestClass && (wrapped > bestWrapped || (wrapped == bestWrapped && pos >= bestPos)))
+			continue;
+		if (Blocked(i))
+			continue;
+		best = i;
+		bestClass = c;
+		bestPos = pos;
+		bestWrapped = wrapped;
+		}
+	return best;
+	}
+
+void TLocMediaIoScheduler::Run(DPrimaryMediaBase& aPrimaryMedia)
+//
+// Pass the batched requests to HandleMsg() in scheduled order.
+//
+	{
+	if (iCount > 1)
+		{
+		++iInfo.iBatchCount;
+		iInfo.iScheduledCount += iCount;
+		if (iCount > iInfo.iMaxBatch)
+			iInfo.iMaxBatch = iCount;
+		}
+	while (iCount)
+		{
+		TInt i = Next();
+		TLocDrvRequest& m = *iReq[i];
+		TInt c = Class(m);
+		TInt kind = (c << 1) | IsRead(m);
+		Int64 pos = Position(m);
+		if (i > 0)
+			{
+			++iInfo.iReorderedCount;
+			if (c == 0 && Class(*iReq[0]) != 0)
+				++iInfo.iPromotedCount;
+			}
+		if (pos == iHeadPos && kind == iHeadKind)
+			++iInfo.iSequentialCount;
+		iHeadPos = pos + m.Length();
+		iHeadKind = kind;
+		--iCount;
+		memmove(&iReq[i], &iReq[i+1], (iCount - i) * sizeof(TLocDrvRequest*));
+
+		aPrimaryMedia.HandleMsg(m);
+		}
+	}
+
 EXPORT_C DPrimaryMediaBase::DPrimaryMediaBase()
 	:	iMsgQ(handleMsg, this, NULL, 1),
 		iDeferred(NULL, NULL, NULL, 0),			// callback never used
@@ -2055,6 +2318,12 @@ Passes the request through to the media driver.
 	
 	TInt reqId = aReq.Id();
 
+	// the I/O scheduler statistics are kept here rather than by the media driver
+	if (reqId == DLocalDrive::EQueryDevice && (TInt) aReq.iArg[0] == RLocalDrive::EQueryIoSchedulerInfo)
+		{
+		return iBody->IoSchedulerInfo(*(TLocalDriveIoSchedulerInfo*) aReq.RemoteDes());
+		}
+
 	TInt r = HandleMediaNotPresent(aReq);
 	if (r != KErrNone)
 		{
@@ -2113,6 +2382,7 @@ Passes the request through to the media driver.
 #endif
 		}
 
+	iBody->RequestStart(aReq);
 	if (iDfcQ)
 		{
 		__TRACE_TIMING(0x10);
@@ -2139,6 +2409,7 @@ Passes the request through to the media driver.
 		if (r == KErrNone)
 			r = iDriver->Request(aReq);		
 		}
+	iBody->RequestEnd();
 
 #ifdef __DEMAND_PAGING__
 		// NB change in behavior IF DATA PAGING IS ENABLED: TLocDrvRequest::RemoteDes() points 
@@ -4004,6 +4275,7 @@ void pageInDfc(TAny* aPtr)
 	DPrimaryMediaBase* primaryMedia=(DPrimaryMediaBase*)aPtr;
 	__ASSERT_ALWAYS(primaryMedia && primaryMedia->iPagingMedia && primaryMedia->iBody->iPagingDevice,LOCM_FAULT());
 	DMediaPagingDevice* pagingdevice=primaryMedia->iBody->iPagingDevice;
+	TLocMediaIoScheduler& scheduler=primaryMedia->iBody->iIoScheduler;
 
 	TLocDrvRequest* m = (TLocDrvRequest*) pagingdevice->iMainQ.iMessage;
 	pagingdevice->iMainQ.iMessage = NULL;
@@ -4028,7 +4300,20 @@ void pageInDfc(TAny* aPtr)
 		__KTRACE_OPT(KLOCDPAGING, Kern::Printf("pageInDfc: process request 0x%08x, last in queue 0x%08x",m, pagingdevice->iMainQ.Last()) );
 		OstTraceDefExt2(OST_TRACE_CATEGORY_RND, TRACE_DEMANDPAGING, PAGEINDFC2, "process request=0x%08x; last in queue=0x%08x",(TUint) m, (TUint) pagingdevice->iMainQ.Last());
 
-		primaryMedia->HandleMsg(*m);
+		// batch up paging requests while there are more waiting so page-ins 
+		// can go ahead of page-outs and contiguous requests go together
+		if (scheduler.Enabled() && TLocMediaIoScheduler::Schedulable(*m))
+			{
+			scheduler.Add(*m);
+			if (!scheduler.Full() && !pagingdevice->iMainQ.iQ.IsEmpty())
+				continue;
+			scheduler.Run(*primaryMedia);
+			}
+		else
+			{
+			scheduler.Run(*primaryMedia);
+			primaryMedia->HandleMsg(*m);
+			}
 		}
 
 #ifdef __CONCURRENT_PAGING_INSTRUMENTATION__
@@ -4129,7 +4414,9 @@ void DMediaPagingDevice::SendToMainQueueDfcAndBlock(TThreadMessage* aMsg)
 	if ((m.Flags() & TLocDrvRequest::EBackgroundPaging) == 0)
 		iPrimaryMedia->RequestCountInc();
 	
+	iPrimaryMedia->iBody->RequestStart(m);
 	aMsg->SendReceive(&iMainQ);
+	iPrimaryMedia->iBody->RequestEnd();
 
 #ifdef __DEMAND_PAGING__
 	if ((m.Flags() & TLocDrvRequest::EBackgroundPaging) == 0)
@@ -5338,6 +5625,7 @@ EXPORT_C TInt LocDrv::RegisterPagingDevice(DPrimaryMediaBase* aPrimaryMedia, con
 	TInt dataPagingDriveNumber = KErrNotFound;
 	TInt swapSize = 0;
 	TInt blockSize = 0;
+	TInt readRequestCount = 0;
 	TUint16 flags = 0;
 
 	// find the local drive assocated with the primary media
@@ -5407,6 +5695,8 @@ EXPORT_C TInt LocDrv::RegisterPagingDevice(DPrimaryMediaBase* aPrimaryMedia, con
 
 		TLocalDriveCapsV6& caps = *(TLocalDriveCapsV6*)capsBuf.Ptr();
 		blockSize = caps.iBlockSize;
+		if (caps.iMaxConcurrentRequests > 1)
+			readRequestCount = caps.iMaxConcurrentRequests;
 		
 		TLocDrv* drive;
 		for (i=0; i<KMaxLocalDrives; ++i)
@@ -5477,6 +5767,8 @@ EXPORT_C TInt LocDrv::RegisterPagingDevice(DPrimaryMediaBase* aPrimaryMedia, con
 		
 	pagingDevice->iPreferredWriteShift = (blockSize) ? __e32_find_ms1_32(blockSize) : 0;
 
+	pagingDevice->iReadRequestCount = readRequestCount;
+
 #ifdef __DEBUG_DEMAND_PAGING__
 	Kern::Printf("PagingDevice :");
 	Kern::Printf("Name %S", firstLocalDriveNumber >= 0 && DriveNames[firstLocalDriveNumber] ? DriveNames[firstLocalDriveNumber] : &KNullDesC8);
@@ -5488,6 +5780,7 @@ EXPORT_C TInt LocDrv::RegisterPagingDevice(DPrimaryMediaBase* aPrimaryMedia, con
 	Kern::Printf("iDataPagingDriveNumber 0x%x", pagingDevice->iDataPagingDriveNumber);
 	Kern::Printf("iSwapSize 0x%x", pagingDevice->iSwapSize);
 	Kern::Printf("iPreferredWriteShift 0x%x\n", pagingDevice->iPreferredWriteShift);
+	Kern::Printf("iReadRequestCount %d\n", pagingDevice->iReadRequestCount);
 #endif
 
 
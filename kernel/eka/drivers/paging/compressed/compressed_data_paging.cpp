@@ -0,0 +1,560 @@
+// Copyright (c) 2010 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of the License "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+// e32/drivers/paging/compressed/compressed_data_paging.cpp
+// Data paging device which keeps swap pages compressed in a pool of RAM.
+//
+// Each page written is compressed with the LZ4 block codec and stored in a slot of the smallest
+// size class that fits it.  Pool pages are assigned to a size class when first needed and hold as
+// many slots of that size as will fit.  Pages which don't compress to less than three quarters of
+// their size are written to the backing data paging device if there is one, and otherwise kept
+// uncompressed in the pool.
+//
+
+#include <kernel/kern_priv.h>
+#include <kernel/kernel.h>
+#include <u32hal.h>
+
+#include <kernel/decompress.h>
+
+#define LZ4_COMPRESS_INCLUDE_IMPLEMENTATION
+#include <lz4_compress.h>
+
+
+class DCompressedDataPagingDevice : public DPagingDevice
+	{
+public:
+	static TInt Install();
+	~DCompressedDataPagingDevice();
+private:
+	enum
+		{
+		EPoolShare = 4,				///< Fraction of free RAM to use for the pool
+		EMaxPoolSize = 64 << 20,	///< Maximum size of the pool, in bytes
+		ESwapRatio = 3,				///< Size of swap relative to the pool
+
+		EGranuleShift = 8,			///< Log2 of the slot size granularity
+		EMaxCompressedClass = 12,	///< Largest slot size class for compressed pages
+		ERawClass = KPageSize >> EGranuleShift,	///< Slot size class for uncompressed pages
+
+		/** Largest compressed size worth keeping; slots start with a TUint16 length. */
+		EMaxCompressedSize = (EMaxCompressedClass << EGranuleShift) - sizeof(TUint16),
+
+		EEntrySlotShift = 4,
+		EEntrySlotMask = (1 << EEntrySlotShift) - 1,
+		};
+
+	/** iEntries value for a swap page which is empty. */
+	static const TUint32 KEntryEmpty = 0;
+	/** iEntries value for a swap page which is on the backing device. */
+	static const TUint32 KEntryBacking = KMaxTUint32;
+
+	TInt Construct();
+	TInt Read(TThreadMessage* aReq,TLinAddr aBuffer,TUint aOffset,TUint aSize,TInt aDrvNumber);
+	TInt Write(TThreadMessage* aReq,TLinAddr aBuffer,TUint aOffset,TUint aSize,TBool aBackground);
+	TInt DeleteNotify(TThreadMessage* aReq,TUint aOffset,TUint aSize);
+	TInt GetCompressionInfo(SVMSwapCompressionInfo& aInfo);
+
+	TInt ReadPage(TThreadMessage* aReq, TLinAddr aBuffer, TUint aSwapPage, TInt aDrvNumber);
+	TInt WritePage(TThreadMessage* aReq, TLinAddr aBuffer, TUint aSwapPage, TBool aBackground);
+
+	inline TUint8* SlotAddress(TUint32 aEntry);
+	inline TUint EntryClass(TUint32 aEntry);
+	inline DPagingDevice* BackingDevice(TUint aSwapPage);
+	TUint32 AllocSlot(TUint aClass);
+	void FreeSlot(TUint32 aEntry);
+	TUint32 ReleaseEntry(TUint aSwapPage);
+	void Account(TUint32 aEntry, TInt aDelta);
+	void Link(TInt aPage, TUint aClass);
+	void Unlink(TInt aPage, TUint aClass);
+	static TUint TicksToNs(TUint64 aTicks, TUint aCount);
+private:
+	NFastMutex iLock;			///< Protects all members below, except the pool contents
+	TUint32* iEntries;			///< For each swap page, KEntryEmpty, KEntryBacking, or its pool slot
+	TInt iPoolPages;			///< Number of pages in the pool
+	TUint8* iPageClass;			///< For each pool page, its slot size class, or 0 if free
+	TUint16* iPageUsed;			///< For each pool page, a bitmap of the slots in use
+	TInt* iPageNext;			///< Link to the next pool page in its list
+	TInt* iPagePrev;			///< Link to the previous pool page in its class list
+	TInt iFreePage;				///< Head of the list of free pool pages
+	TInt iPartialPage[ERawClass + 1];	///< For each class, head of the list of pages with free slots
+	TInt iPoolPagesUsed;
+
+	TUint iCompressedPages;
+	TUint64 iCompressedBytes;
+	TUint iUncompressedPages;
+	TUint iBackingPages;
+	TUint iWriteCount;
+	TUint iReadCount;
+	TUint64 iWriteTicks;
+	TUint64 iReadTicks;
+	TUint32 iMaxWriteTicks;
+	TUint32 iMaxReadTicks;
+
+	DChunk* iChunk;
+	TLinAddr iPool;
+	TUint8* iScratch;			///< Compression output, used only by Write
+	TUint16* iHashTable;		///< Compression work area, used only by Write
+	};
+
+
+TInt DCompressedDataPagingDevice::Install()
+	{
+	__KTRACE_OPT2(KPAGING,KBOOT,Kern::Printf(">DCompressedDataPagingDevice::Install"));
+	TInt r;
+	DCompressedDataPagingDevice* dataDevice = new DCompressedDataPagingDevice;
+	if(!dataDevice)
+		r = KErrNoMemory;
+	else
+		{
+		r = dataDevice->Construct();
+		if(r==KErrNone)
+			r = Kern::InstallPagingDevice(dataDevice);
+		if(r!=KErrNone)
+			delete dataDevice;
+		}
+	__KTRACE_OPT2(KPAGING,KBOOT,Kern::Printf("<DCompressedDataPagingDevice::Install returns %d",r));
+	return r;
+	}
+
+
+DCompressedDataPagingDevice::~DCompressedDataPagingDevice()
+	{
+	Kern::Free(iEntries);
+	Kern::Free(iPageClass);
+	Kern::Free(iPageUsed);
+	Kern::Free(iPageNext);
+	Kern::Free(iPagePrev);
+	Kern::Free(iScratch);
+	Kern::Free(iHashTable);
+	if (iChunk)
+		Kern::ChunkClose(iChunk);
+	}
+
+
+TInt DCompressedDataPagingDevice::Construct()
+	{
+	__KTRACE_OPT2(KPAGING,KBOOT,Kern::Printf(">DCompressedDataPagingDevice::Construct"));
+
+	// Initialise DPagingDevice base class
+	iType = EData;
+	iFlags = ESupportsCompressionInfo | ERequiresDeleteNotify | EStacksOnDataDevice;
+	iReadUnitShift = KPageShift; // whole pages
+	iName = "CompressedDataPagingDevice";
+
+	// Reads decompress outside iLock, so on SMP let one run on each CPU at once.
+	if (NKern::NumberOfCpus() > 2)
+		iReadRequestCount = NKern::NumberOfCpus();
+
+	// The pool is committed up front as the device can't allocate memory while writing pages.
+	// Swap is overcommitted relative to it, on the assumption that pages compress to a third of
+	// their size or better.
+	TInt poolSize = Kern::FreeRamInBytes() / EPoolShare;
+	if(poolSize>EMaxPoolSize)
+		poolSize = EMaxPoolSize;
+	iPoolPages = poolSize >> KPageShift;
+	if(!iPoolPages)
+		return KErrNoMemory;
+	poolSize = iPoolPages << KPageShift;
+	iSwapSize = iPoolPages * ESwapRatio;
+	__KTRACE_OPT2(KPAGING,KBOOT,Kern::Printf("DCompressedDataPagingDevice::Construct pool size 0x%x swap size 0x%x",poolSize,iSwapSize<<KPageShift));
+
+	iEntries = (TUint32*)Kern::AllocZ(iSwapSize * sizeof(TUint32));
+	iPageClass = (TUint8*)Kern::AllocZ(iPoolPages * sizeof(TUint8));
+	iPageUsed = (TUint16*)Kern::AllocZ(iPoolPages * sizeof(TUint16));
+	iPageNext = (TInt*)Kern::Alloc(iPoolPages * sizeof(TInt));
+	iPagePrev = (TInt*)Kern::Alloc(iPoolPages * sizeof(TInt));
+	iScratch = (TUint8*)Kern::Alloc(EMaxCompressedSize);
+	iHashTable = (TUint16*)Kern::Alloc(sizeof(TUint16) << KLz4HashBits);
+	if(!iEntries || !iPageClass || !iPageUsed || !iPageNext || !iPagePrev || !iScratch || !iHashTable)
+		return KErrNoMemory;
+
+	TChunkCreateInfo info;
+	info.iType = TChunkCreateInfo::ESharedKernelSingle;
+	info.iMaxSize = poolSize;
+	info.iMapAttr = EMapAttrCachedMax;
+	info.iOwnsMemory = ETrue;
+	TUint32 mapAttr;
+	TInt r = Kern::ChunkCreate(info,iChunk,iPool,mapAttr);
+	if(r!=KErrNone)
+		return r;
+	r = Kern::ChunkCommit(iChunk,0,poolSize);
+	if(r!=KErrNone)
+		return r;
+
+	// all pool pages start on the free list
+	TInt page;
+	for(page=0; page<iPoolPages; ++page)
+		iPageNext[page] = page + 1;
+	iPageNext[iPoolPages - 1] = -1;
+	iFreePage = 0;
+	for(TUint c=0; c<=ERawClass; ++c)
+		iPartialPage[c] = -1;
+
+	__KTRACE_OPT2(KPAGING,KBOOT,Kern::Printf("<DCompressedDataPagingDevice::Construct"));
+	return KErrNone;
+	}
+
+
+inline TUint DCompressedDataPagingDevice::EntryClass(TUint32 aEntry)
+	{
+	return iPageClass[(aEntry >> EEntrySlotShift) - 1];
+	}
+
+
+inline TUint8* DCompressedDataPagingDevice::SlotAddress(TUint32 aEntry)
+	{
+	TInt page = (aEntry >> EEntrySlotShift) - 1;
+	TUint slot = aEntry & EEntrySlotMask;
+	return (TUint8*)(iPool + (page << KPageShift) + ((slot * iPageClass[page]) << EGranuleShift));
+	}
+
+
+/**
+Return the backing device if it is large enough to hold the specified swap page, else NULL.
+*/
+inline DPagingDevice* DCompressedDataPagingDevice::BackingDevice(TUint aSwapPage)
+	{
+	DPagingDevice* backing = (DPagingDevice*)__e32_atomic_load_acq_ptr(&iBackingDevice);
+	if (backing && aSwapPage < ((TUint)backing->iSwapSize >> (KPageShift - backing->iReadUnitShift)))
+		return backing;
+	return NULL;
+	}
+
+
+void DCompressedDataPagingDevice::Link(TInt aPage, TUint aClass)
+	{
+	TInt next = iPartialPage[aClass];
+	iPageNext[aPage] = next;
+	iPagePrev[aPage] = -1;
+	if (next >= 0)
+		iPagePrev[next] = aPage;
+	iPartialPage[aClass] = aPage;
+	}
+
+
+void DCompressedDataPagingDevice::Unlink(TInt aPage, TUint aClass)
+	{
+	TInt next = iPageNext[aPage];
+	TInt prev = iPagePrev[aPage];
+	if (prev >= 0)
+		iPageNext[prev] = next;
+	else
+		iPartialPage[aClass] = next;
+	if (next >= 0)
+		iPagePrev[next] = prev;
+	}
+
+
+/**
+Allocate a slot of the specified size class.
+
+@return The entry for the slot, or KEntryEmpty if the pool is full.
+
+@pre iLock held.
+*/
+TUint32 DCompressedDataPagingDevice::AllocSlot(TUint aClass)
+	{
+	TInt page = iPartialPage[aClass];
+	if (page < 0)
+		{
+		page = iFreePage;
+		if (page < 0)
+			return KEntryEmpty;
+		iFreePage = iPageNext[page];
+		iPageClass[page] = (TUint8)aClass;
+		iPageUsed[page] = 0;
+		Link(page, aClass);
+		++iPoolPagesUsed;
+		}
+	const TUint full = (1 << (ERawClass / aClass)) - 1;
+	TUint slot = __e32_find_ls1_32(~(TUint32)iPageUsed[page]);
+	iPageUsed[page] |= (TUint16)(1 << slot);
+	if (iPageUsed[page] == full)
+		Unlink(page, aClass);
+	return ((page + 1) << EEntrySlotShift) | slot;
+	}
+
+
+/**
+@pre iLock held.
+*/
+void DCompressedDataPagingDevice::FreeSlot(TUint32 aEntry)
+	{
+	TInt page = (aEntry >> EEntrySlotShift) - 1;
+	TUint slot = aEntry & EEntrySlotMask;
+	TUint c = iPageClass[page];
+	const TUint full = (1 << (ERawClass / c)) - 1;
+	__NK_ASSERT_DEBUG(iPageUsed[page] & (1 << slot));
+	if (iPageUsed[page] == full)
+		Link(page, c);
+	iPageUsed[page] &= (TUint16)~(1 << slot);
+	if (iPageUsed[page] == 0)
+		{
+		Unlink(page, c);
+		iPageClass[page] = 0;
+		iPageNext[page] = iFreePage;
+		iFreePage = page;
+		--iPoolPagesUsed;
+		}
+	}
+
+
+/**
+Update the statistics for an entry being stored or released.
+
+@pre iLock held.
+*/
+void DCompressedDataPagingDevice::Account(TUint32 aEntry, TInt aDelta)
+	{
+	if (aEntry == KEntryBacking)
+		iBackingPages += aDelta;
+	else if (EntryClass(aEntry) == ERawClass)
+		iUncompressedPages += aDelta;
+	else
+		{
+		iCompressedPages += aDelta;
+		iCompressedBytes += aDelta * *(TUint16*)SlotAddress(aEntry);
+		}
+	}
+
+
+/**
+Forget the contents of a swap page, freeing any pool slot it uses.
+
+@return The entry the page had.
+
+@pre iLock held.
+*/
+TUint32 DCompressedDataPagingDevice::ReleaseEntry(TUint aSwapPage)
+	{
+	TUint32 entry = iEntries[aSwapPage];
+	if (entry != KEntryEmpty)
+		{
+		Account(entry, -1);
+		if (entry != KEntryBacking)
+			FreeSlot(entry);
+		iEntries[aSwapPage] = KEntryEmpty;
+		}
+	return entry;
+	}
+
+
+TInt DCompressedDataPagingDevice::Read(TThreadMessage* aReq,TLinAddr aBuffer,TUint aOffset,TUint aSize,TInt aDrvNumber)
+	{
+	for (TUint i = 0 ; i < aSize ; ++i)
+		{
+		TInt r = ReadPage(aReq, aBuffer + (i << KPageShift), aOffset + i, aDrvNumber);
+		if (r != KErrNone)
+			return r;
+		}
+	return KErrNone;
+	}
+
+
+TInt DCompressedDataPagingDevice::ReadPage(TThreadMessage* aReq, TLinAddr aBuffer, TUint aSwapPage, TInt aDrvNumber)
+	{
+	__NK_ASSERT_DEBUG(aSwapPage < (TUint)iSwapSize);
+	TUint32 start = NKern::FastCounter();
+
+	// The slot can only be reused while it is being read if the page is decommitted, in which case
+	// the paging system will discard what is read; the length is bounded by the slot size so the
+	// decompression stays within the pool.
+	NKern::FMWait(&iLock);
+	TUint32 entry = iEntries[aSwapPage];
+	const TUint8* slot = NULL;
+	TInt length = 0;
+	if (entry != KEntryEmpty && entry != KEntryBacking)
+		{
+		slot = SlotAddress(entry);
+		TUint c = EntryClass(entry);
+		if (c == ERawClass)
+			length = -1;
+		else
+			{
+			length = *(const TUint16*)slot;
+			TInt maxLength = (c << EGranuleShift) - sizeof(TUint16);
+			if (length > maxLength)
+				length = maxLength;
+			}
+		}
+	NKern::FMSignal(&iLock);
+
+	TInt r = KErrNone;
+	if (entry == KEntryEmpty)
+		r = KErrNotFound;
+	else if (entry == KEntryBacking)
+		{
+		DPagingDevice* backing = BackingDevice(aSwapPage);
+		if (!backing)
+			r = KErrNotFound;
+		else
+			{
+			const TUint shift = KPageShift - backing->iReadUnitShift;
+			r = backing->Read(aReq, aBuffer, aSwapPage << shift, 1 << shift, aDrvNumber);
+			}
+		}
+	else if (length < 0)
+		memcpy((TAny*)aBuffer, slot, KPageSize);
+	else
+		{
+		TUint8* srcNext = 0;
+		if (Lz4Decompress((TUint8*)aBuffer, KPageSize, (TUint8*)slot + sizeof(TUint16), length, srcNext) != KPageSize)
+			r = KErrCorrupt;
+		}
+
+	TUint32 ticks = NKern::FastCounter() - start;
+	NKern::FMWait(&iLock);
+	++iReadCount;
+	iReadTicks += ticks;
+	if (ticks > iMaxReadTicks)
+		iMaxReadTicks = ticks;
+	NKern::FMSignal(&iLock);
+	return r;
+	}
+
+
+TInt DCompressedDataPagingDevice::Write(TThreadMessage* aReq,TLinAddr aBuffer,TUint aOffset,TUint aSize,TBool aBackground)
+	{
+	// Writes are serialised by the paging system's page cleaning lock, so the scratch buffer and
+	// hash table need no further locking.
+	for (TUint i = 0 ; i < aSize ; ++i)
+		{
+		TInt r = WritePage(aReq, aBuffer + (i << KPageShift), aOffset + i, aBackground);
+		if (r != KErrNone)
+			return r;
+		}
+	return KErrNone;
+	}
+
+
+TInt DCompressedDataPagingDevice::WritePage(TThreadMessage* aReq, TLinAddr aBuffer, TUint aSwapPage, TBool aBackground)
+	{
+	__NK_ASSERT_DEBUG(aSwapPage < (TUint)iSwapSize);
+	TUint32 start = NKern::FastCounter();
+	TInt length = Lz4Compress(iScratch, EMaxCompressedSize, (const TUint8*)aBuffer, KPageSize, iHashTable);
+
+	NKern::FMWait(&iLock);
+	ReleaseEntry(aSwapPage);
+	TUint32 entry = KEntryEmpty;
+	if (length >= 0)
+		entry = AllocSlot((length + sizeof(TUint16) + (1 << EGranuleShift) - 1) >> EGranuleShift);
+	NKern::FMSignal(&iLock);
+
+	TInt r = KErrNone;
+	if (entry != KEntryEmpty)
+		{
+		TUint8* slot = SlotAddress(entry);
+		*(TUint16*)slot = (TUint16)length;
+		memcpy(slot + sizeof(TUint16), iScratch, length);
+		}
+	else
+		{
+		// The page is incompressible or there's no room for it compressed, so write it out to the
+		// backing device if there is one, else keep it uncompressed in the pool.
+		DPagingDevice* backing = BackingDevice(aSwapPage);
+		if (backing)
+			{
+			const TUint shift = KPageShift - backing->iReadUnitShift;
+			r = backing->Write(aReq, aBuffer, aSwapPage << shift, 1 << shift, aBackground);
+			entry = KEntryBacking;
+			}
+		else
+			{
+			NKern::FMWait(&iLock);
+			entry = AllocSlot(ERawClass);
+			NKern::FMSignal(&iLock);
+			if (entry == KEntryEmpty)
+				r = KErrDiskFull;
+			else
+				memcpy(SlotAddress(entry), (TAny*)aBuffer, KPageSize);
+			}
+		}
+
+	TUint32 ticks = NKern::FastCounter() - start;
+	NKern::FMWait(&iLock);
+	if (r != KErrNone)
+		{
+		if (entry != KEntryEmpty && entry != KEntryBacking)
+			FreeSlot(entry);
+		entry = KEntryEmpty;
+		}
+	iEntries[aSwapPage] = entry;
+	if (entry != KEntryEmpty)
+		Account(entry, 1);
+	++iWriteCount;
+	iWriteTicks += ticks;
+	if (ticks > iMaxWriteTicks)
+		iMaxWriteTicks = ticks;
+	NKern::FMSignal(&iLock);
+	return r;
+	}
+
+
+TInt DCompressedDataPagingDevice::DeleteNotify(TThreadMessage* aReq,TUint aOffset,TUint aSize)
+	{
+	for (TUint i = 0 ; i < aSize ; ++i)
+		{
+		NKern::FMWait(&iLock);
+		TUint32 entry = ReleaseEntry(aOffset + i);
+		NKern::FMSignal(&iLock);
+		DPagingDevice* backing = BackingDevice(aOffset + i);
+		if (entry == KEntryBacking && backing)
+			{
+			const TUint shift = KPageShift - backing->iReadUnitShift;
+			(void)backing->DeleteNotify(aReq, (aOffset + i) << shift, 1 << shift);
+			}
+		}
+	return KErrNone;
+	}
+
+
+TUint DCompressedDataPagingDevice::TicksToNs(TUint64 aTicks, TUint aCount)
+	{
+	if (!aCount)
+		return 0;
+	TUint64 ns = (aTicks / aCount) * UI64LIT(1000000000) / NKern::FastCounterFrequency();
+	return ns > KMaxTUint ? KMaxTUint : (TUint)ns;
+	}
+
+
+TInt DCompressedDataPagingDevice::GetCompressionInfo(SVMSwapCompressionInfo& aInfo)
+	{
+	NKern::FMWait(&iLock);
+	aInfo.iPoolSize = TUint64(iPoolPages) << KPageShift;
+	aInfo.iPoolUsed = TUint64(iPoolPagesUsed) << KPageShift;
+	aInfo.iOriginalSize = TUint64(iCompressedPages) << KPageShift;
+	aInfo.iCompressedSize = iCompressedBytes;
+	aInfo.iCompressedPages = iCompressedPages;
+	aInfo.iUncompressedPages = iUncompressedPages;
+	aInfo.iBackingPages = iBackingPages;
+	aInfo.iWriteCount = iWriteCount;
+	aInfo.iReadCount = iReadCount;
+	TUint64 writeTicks = iWriteTicks;
+	TUint64 readTicks = iReadTicks;
+	TUint32 maxWriteTicks = iMaxWriteTicks;
+	TUint32 maxReadTicks = iMaxReadTicks;
+	NKern::FMSignal(&iLock);
+
+	aInfo.iAverageWriteTime = TicksToNs(writeTicks, aInfo.iWriteCount);
+	aInfo.iAverageReadTime = TicksToNs(readTicks, aInfo.iReadCount);
+	aInfo.iMaxWriteTime = TicksToNs(maxWriteTicks, 1);
+	aInfo.iMaxReadTime = TicksToNs(maxReadTicks, 1);
+	return KErrNone;
+	}
+
+
+DECLARE_STANDARD_EXTENSION()
+	{
+	return DCompressedDataPagingDevice::Install();
+	}
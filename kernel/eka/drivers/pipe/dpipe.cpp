@@ -604,6 +604,17 @@ any synchronous calls through the  user side RPipe handle.
 		case RPipe::EWrite:
 			kumemget((TAny*)&aSize, a2, sizeof(TInt));
 			return Write (a1, aSize);
+
+		case RPipe::EReadV:
+			kumemget((TAny*)&aSize, a2, sizeof(TInt));
+			return ReadV (a1, aSize);
+
+		case RPipe::EWriteV:
+			kumemget((TAny*)&aSize, a2, sizeof(TInt));
+			return WriteV (a1, aSize);
+
+		case RPipe::ESpliceFrom:
+			return SpliceFrom (a1);
 				
 		case RPipe::ESize:
 			 return Size();
@@ -1050,6 +1061,173 @@ for Data Available notification, it will complete.
 	}
 
 
+TInt DPipeChannel::ReadV (TAny* aBuffs, TInt aCount)
+/**
+Synchronous, non-blocking read into several descriptors. The descriptors are
+filled in turn until the pipe is empty.
+
+@param	aBuffs			Array of pointers to the client's descriptors
+
+@param	aCount			Number of descriptors in the array
+
+@return:>0				Amount of data read  in octets.
+		 KErrArgument   aCount is not between 1 and KPipeMaxIoVectors
+		 KErrBadDescriptor	One of the descriptors is not modifiable
+		 KErrNotReady	If the write end is closed,
+		  				otherwise one of the other system wide error code  		
+*/
+	{
+	
+	if( iChannelType != RPipe::EReadChannel)
+		return KErrAccessDenied;
+
+	if(aCount <= 0 || aCount > KPipeMaxIoVectors)
+		return KErrArgument;
+
+	// Look at the client's descriptors before taking the mutex, as they may be paged out
+	TDes8* buffs[KPipeMaxIoVectors];
+	TInt maxSizes[KPipeMaxIoVectors];
+	kumemget((TAny*)buffs, aBuffs, aCount * sizeof(TDes8*));
+	for(TInt i = 0; i < aCount; ++i)
+		{
+		TInt length;
+		Kern::KUDesInfo(*buffs[i], length, maxSizes[i]);
+		if(maxSizes[i] < 0)
+			return KErrBadDescriptor;
+		}
+
+	TAutoWait<DMutex> outerAutoMutex(*iData->iReadMutex);
+	TAutoWait<DMutex> innerAutoMutex(iData->Mutex());
+	if(!iData->IsWriteEndOpened() && iData->IsBufferEmpty())
+		{
+		//it is ok to read from a broken pipe provided there is data in it
+		return KErrNotReady;	
+		}
+
+	return iData->ReadV(buffs, maxSizes, aCount);
+	}
+
+
+TInt DPipeChannel::WriteV (TAny* aBuffs, TInt aCount)
+/**
+Synchronous, non-blocking write of several descriptors. Either all of the
+data is written or none is.
+
+@param aBuffs			Array of pointers to the client's descriptors
+				
+@param aCount			Number of descriptors in the array
+	 
+@return >0				Amount of data written to the pipe, in octets.
+		KErrOverflow	Not enough space in the pipe, no data is written.
+		KErrArgument	aCount is not between 1 and KPipeMaxIoVectors
+		KErrNotReady	if the read end is not opened.
+						otherwise one of the other system wide error code
+*/
+	{
+	
+	if(iChannelType!= RPipe::EWriteChannel)
+		return KErrAccessDenied;
+
+	if(aCount <= 0 || aCount > KPipeMaxIoVectors)
+		return KErrArgument;
+
+	// Look at the client's descriptors before taking the mutex, as they may be paged out
+	const TDesC8* buffs[KPipeMaxIoVectors];
+	TInt sizes[KPipeMaxIoVectors];
+	kumemget((TAny*)buffs, aBuffs, aCount * sizeof(TDesC8*));
+	for(TInt i = 0; i < aCount; ++i)
+		{
+		TInt maxLength;
+		Kern::KUDesInfo(*buffs[i], sizes[i], maxLength);
+		}
+		
+	TAutoWait<DMutex> outerAutoMutex(*iData->iWriteMutex);
+	TAutoWait<DMutex> innerAutoMutex(iData->Mutex());
+	
+	if(!(iData->IsReadEndOpened()))
+		{
+		return KErrNotReady;
+		}
+
+	return iData->WriteV(buffs, sizes, aCount);	
+	}
+
+
+TInt DPipeChannel::SpliceFrom (TAny* aInfo)
+/**
+Synchronous, non-blocking write of part of a shared buffer. The data is
+copied straight from the kernel's mapping of the buffer, so the buffer need
+not be mapped into the client. Either all of the data is written or none is.
+
+The kernel only has a mapping of a page aligned buffer if it has opened the
+buffer's pool itself, with the buffers mapped. Otherwise nothing is copied and
+the client must write the data from its own mapping instead.
+
+@param aInfo			The client's RPipe::TSpliceInfo
+	 
+@return >0				Amount of data written to the pipe, in octets.
+		KErrOverflow	Not enough space in the pipe, no data is written.
+		KErrArgument	The region is not within the buffer
+		KErrBadHandle	The buffer handle is not valid
+		KErrNotSupported The kernel has no mapping of the buffer.
+		KErrNotReady	if the read end is not opened.
+						otherwise one of the other system wide error code
+*/
+	{
+	
+	if(iChannelType!= RPipe::EWriteChannel)
+		return KErrAccessDenied;
+
+	RPipe::TSpliceInfo info;
+	kumemget((TAny*)&info, aInfo, sizeof(info));
+	if(info.iOffset < 0 || info.iSize < 0)
+		return KErrArgument;
+
+	NKern::ThreadEnterCS();
+	TShBuf* buf;
+	TInt r = Kern::ShBufOpen(buf, &Kern::CurrentThread(), info.iHandle);
+	if(r == KErrNotFound)
+		{
+		// either the handle is bad or the buffer is page aligned and the kernel
+		// isn't a client of its pool
+		NKern::LockSystem();
+		DObject* obj = Kern::ObjectFromHandle(&Kern::CurrentThread(), info.iHandle, EShBuf);
+		NKern::UnlockSystem();
+		r = obj ? KErrNotSupported : KErrBadHandle;
+		}
+	if(r == KErrNone)
+		{
+		const TUint size = Kern::ShBufSize(buf);
+		const TUint8* base = Kern::ShBufPtr(buf);
+		if((TUint)info.iOffset > size || (TUint)info.iSize > size - info.iOffset)
+			{
+			r = KErrArgument;
+			}
+		else if(!base)
+			{
+			// the kernel is a client of the pool without its buffers mapped
+			r = KErrNotSupported;
+			}
+		else
+			{
+			TAutoWait<DMutex> outerAutoMutex(*iData->iWriteMutex);
+			TAutoWait<DMutex> innerAutoMutex(iData->Mutex());
+			if(!(iData->IsReadEndOpened()))
+				{
+				r = KErrNotReady;
+				}
+			else
+				{
+				r = iData->SpliceFrom(base + info.iOffset, info.iSize);
+				}
+			}
+		Kern::ShBufClose(buf);
+		}
+	NKern::ThreadLeaveCS();
+	return r;
+	}
+
+
 
 TInt DPipeChannel::CloseHandle()
 /**
@@ -1636,50 +1814,15 @@ for Data Available notification, it will complete.
 	//release mutex before IPC read
 	Signal();
 
-	//First half
-	const TDesC8*  pBuf = (const TDesC8*)aBuf;
+	TInt r = CopyFromClient((const TDesC8*)aBuf, iWritePointer, aSize);
 
-	const TInt distanceToEnd =  iSize - iWritePointer;
-	const TInt firstHalf = Min(distanceToEnd, aSize);
-	TPtr ptr(&iBuffer[iWritePointer], firstHalf);
-
-	DThread* const currThread = &Kern::CurrentThread();
-	TInt r=Kern::ThreadDesRead(currThread, pBuf, ptr, 0, KChunkShiftBy0);
+	Wait(); //reaquire mutex for state update
 	if(r!=KErrNone)
 		{
-		Wait(); //we must exit with mutex held
 		return r;
 		}
 
-	//Second half
-	const TInt secondHalf = aSize - firstHalf;
-	__NK_ASSERT_DEBUG( secondHalf >= 0);
-	if(secondHalf != 0)	
-		{
-		ptr.Set(&iBuffer[0], secondHalf, secondHalf);
-
-		r = Kern::ThreadDesRead(currThread, pBuf, ptr, firstHalf, KChunkShiftBy0);
-		if(r!=KErrNone)
-			{
-			Wait(); //we must exit with mutex held
-			return r;
-			}
-		}
-	
-	Wait(); //reaquire mutex for state update
-	iWritePointer = (iWritePointer + aSize)% iSize;	
-		
-	if(iWritePointer == iReadPointer)
-		{
-		iFull = ETrue;
-		}
-		
-	if(iDataAvailableRequest)
-		{
-		iReadChannel->DoRequestCallback();
-		iDataAvailableRequest = EFalse;		
-		}
-
+	WriteDone(aSize);
 	return aSize;
 	}
 
@@ -1723,46 +1866,294 @@ for the next DPipe::Write() operation.
 
 	Signal();
 
+	TInt r = CopyToClient((TDes8*)aBuf, iReadPointer, totalToRead);
+
+	Wait(); //Reaquire mutex for state update
+	if(r!=KErrNone)
+		{
+		return r;
+		}
+
+	ReadDone(totalToRead);
+		
+	__ASSERT_MUTEX(iReadMutex);
+	return totalToRead;			
+	}
+
+
+TInt DPipe::WriteV(const TDesC8* const* aBufs, const TInt* aSizes, TInt aCount)
+/**
+Synchronous, non-blocking write of several client descriptors with a single
+call. As with Write(), either all of the data is written or none is.
 
+@param	aBufs		Client descriptors from which data is to be written.
+@param	aSizes		Amount of data to be written from each descriptor.
+@param	aCount		Number of descriptors.
+
+@return >0			 Amount of data written to the pipe, in octets.
+		KErrNone	 All the descriptors were empty.
+		KErrOverflow Not enough space in the pipe for all of the data. 
+					 Otherwise one of the other system wide error code
+
+@pre iPipeMutex held
+@pre iWriteMutex held
+
+@note WriteV enters and exists with the pipe mutex held - but releases and reaquires internally
+*/
+	{
+	__KTRACE_OPT(KPIPE, Kern::Printf("DPipe::WriteV(aBufs=0x%08x, aCount=%d)", aBufs, aCount));
+	__ASSERT_MUTEX(iPipeMutex);
+	__ASSERT_MUTEX(iWriteMutex);
+
+	const TInt spaceavailable = (iSize - AvailableDataCount());
+	TInt total = 0;
+	TInt i;
+	for(i = 0; i < aCount; ++i)
+		{
+		if(aSizes[i] > spaceavailable - total)
+			{
+			return KErrOverflow;
+			}
+		total += aSizes[i];
+		}
+	if(total == 0)
+		{
+		return KErrNone;
+		}
+
+	//release mutex before IPC read
+	Signal();
+
+	TInt r = KErrNone;
+	TInt pos = iWritePointer;
+	for(i = 0; i < aCount && r == KErrNone; ++i)
+		{
+		r = CopyFromClient(aBufs[i], pos, aSizes[i]);
+		pos = (pos + aSizes[i]) % iSize;
+		}
+
+	Wait(); //reaquire mutex for state update
+	if(r!=KErrNone)
+		{
+		return r;
+		}
+
+	WriteDone(total);
+	return total;
+	}
+
+
+TInt DPipe::ReadV(TDes8* const* aBufs, const TInt* aMaxSizes, TInt aCount)
+/**
+Synchronous, non-blocking read into several client descriptors with a single
+call. Each descriptor is filled in turn, up to its maximum size, and the
+length of any descriptor for which no data remains is set to zero.
+
+@param	aBufs		Client descriptors to which data is to be written.
+@param	aMaxSizes	Maximum length of each descriptor.
+@param	aCount		Number of descriptors.
+
+@return	>0			 Amount of data read from the pipe, in octets.
+		KErrNone	 The pipe is empty, no data was read from the pipe.
+					 Otherwise one of the system wide error code
+@pre iPipeMutex held
+@pre iReadMutex held
+
+@note ReadV enters and exists with the pipe mutex held - but releases and reaquires internally
+*/
+	{
+	__KTRACE_OPT(KPIPE, Kern::Printf("DPipe::ReadV(aBufs=0x%08x, aCount=%d)", aBufs, aCount));
+	__ASSERT_MUTEX(iPipeMutex);
+	__ASSERT_MUTEX(iReadMutex);
+
+	const TInt available = AvailableDataCount();
+	if(available == 0)
+		return 0;
+
+	Signal();
+
+	TInt r = KErrNone;
+	TInt pos = iReadPointer;
+	TInt left = available;
+	for(TInt i = 0; i < aCount && r == KErrNone; ++i)
+		{
+		const TInt size = Min(aMaxSizes[i], left);
+		r = CopyToClient(aBufs[i], pos, size);
+		pos = (pos + size) % iSize;
+		left -= size;
+		}
+
+	Wait(); //Reaquire mutex for state update
+	if(r!=KErrNone)
+		{
+		return r;
+		}
+
+	const TInt totalRead = available - left;
+	ReadDone(totalRead);
+	return totalRead;
+	}
+
+
+TInt DPipe::SpliceFrom(const TUint8* aData, TInt aSize)
+/**
+Synchronous, non-blocking write of data which the kernel can access directly,
+such as a shared buffer. As with Write(), either all of the data is written or
+none is. The pipe mutex is not released, because the copy cannot fault.
+
+@param	aData		Kernel address of the data to be written.
+@param	aSize		Amount of data to be written to the pipe.
+
+@return >0			 Amount of data written to the pipe, in octets.
+		KErrNone	 No data written to the pipe.
+		KErrOverflow Not enough space in the pipe for the data. 
+
+@pre iPipeMutex held
+@pre iWriteMutex held
+*/
+	{
+	__KTRACE_OPT(KPIPE, Kern::Printf("DPipe::SpliceFrom(aData=0x%08x, aSize=%d)", aData, aSize));
+	__ASSERT_MUTEX(iPipeMutex);
+	__ASSERT_MUTEX(iWriteMutex);
+
+	if(aSize == 0)
+		{
+		return KErrNone;
+		}
+
+	if((iSize - AvailableDataCount()) < aSize)
+		{
+		return KErrOverflow;
+		}
+
+	const TInt firstHalf = Min(iSize - iWritePointer, aSize);
+	memcpy(&iBuffer[iWritePointer], aData, firstHalf);
+	memcpy(&iBuffer[0], aData + firstHalf, aSize - firstHalf);
+
+	WriteDone(aSize);
+	return aSize;
+	}
+
+
+TInt DPipe::CopyFromClient(const TDesC8* aBuf, TInt aPos, TInt aSize)
+/**
+Copy the start of a client descriptor into the ring buffer, wrapping round
+the end of the buffer if necessary.
+
+@param	aBuf		Client descriptor holding the data.
+@param	aPos		Position in the ring buffer at which to put the data.
+@param	aSize		Amount of data to copy.
+
+@return KErrNone if successful, otherwise one of the system wide error codes
+
+@pre iPipeMutex not held, as the client's memory may be paged out
+*/
+	{
+	//First half
+	const TInt distanceToEnd =  iSize - aPos;
+	const TInt firstHalf = Min(distanceToEnd, aSize);
+	TPtr8 ptr(&iBuffer[aPos], firstHalf);
+
+	DThread* const currThread = &Kern::CurrentThread();
+	TInt r=Kern::ThreadDesRead(currThread, aBuf, ptr, 0, KChunkShiftBy0);
+	if(r!=KErrNone)
+		{
+		return r;
+		}
+
+	//Second half
+	const TInt secondHalf = aSize - firstHalf;
+	__NK_ASSERT_DEBUG( secondHalf >= 0);
+	if(secondHalf != 0)	
+		{
+		ptr.Set(&iBuffer[0], secondHalf, secondHalf);
+
+		r = Kern::ThreadDesRead(currThread, aBuf, ptr, firstHalf, KChunkShiftBy0);
+		}
+	return r;
+	}
+
+
+TInt DPipe::CopyToClient(TDes8* aBuf, TInt aPos, TInt aSize)
+/**
+Copy data from the ring buffer into a client descriptor, wrapping round
+the end of the buffer if necessary, and set the length of the descriptor.
+
+@param	aBuf		Client descriptor to receive the data.
+@param	aPos		Position in the ring buffer of the data.
+@param	aSize		Amount of data to copy.
+
+@return KErrNone if successful, otherwise one of the system wide error codes
+
+@pre iPipeMutex not held, as the client's memory may be paged out
+*/
+	{
 	//! First half	
-	const TInt distanceToEnd = iSize - iReadPointer;
+	const TInt distanceToEnd = iSize - aPos;
 	__NK_ASSERT_DEBUG(distanceToEnd>=0);
-	const TInt firstHalf = Min(totalToRead, distanceToEnd);
+	const TInt firstHalf = Min(aSize, distanceToEnd);
 
-	TPtrC8 pipeBuffer(&iBuffer[iReadPointer], firstHalf);
-	TDes8* userBuffer = (TDes8*)aBuf;
+	TPtrC8 pipeBuffer(&iBuffer[aPos], firstHalf);
 
 	DThread* const currThread = &Kern::CurrentThread();
-	TInt r = Kern::ThreadDesWrite(currThread, userBuffer, pipeBuffer, 0, KChunkShiftBy0, NULL); 
+	TInt r = Kern::ThreadDesWrite(currThread, aBuf, pipeBuffer, 0, KChunkShiftBy0, NULL); 
 	if(r!=KErrNone)
 		{
-		Wait(); //we must exit with mutex held
 		return r;
 		}
 	
-	const TInt secondHalf=totalToRead-firstHalf;
+	const TInt secondHalf=aSize-firstHalf;
 	__NK_ASSERT_DEBUG(secondHalf>=0);
 	if(secondHalf!=0)
 		{
 	    //! Second half
 		pipeBuffer.Set(&iBuffer[0], secondHalf);
-		r = Kern::ThreadDesWrite(currThread, userBuffer, pipeBuffer, firstHalf, KChunkShiftBy0, NULL);
-		if(r!=KErrNone)
-			{
-			Wait(); //we must exit with mutex held
-			return r;
-			}
+		r = Kern::ThreadDesWrite(currThread, aBuf, pipeBuffer, firstHalf, KChunkShiftBy0, NULL);
 		}
-	__NK_ASSERT_DEBUG(firstHalf+secondHalf==totalToRead);
+	return r;
+	}
 
-	Wait(); //Reaquire mutex for state update
 
-	iReadPointer = (iReadPointer + totalToRead)% iSize;
+void DPipe::WriteDone(TInt aSize)
+/**
+Update the ring buffer state after data has been written into it, and tell
+the reader that data is available.
+
+@param	aSize		Amount of data written.
+
+@pre iPipeMutex held
+*/
+	{
+	__ASSERT_MUTEX(iPipeMutex);
+	iWritePointer = (iWritePointer + aSize)% iSize;	
+		
+	if(iWritePointer == iReadPointer)
+		{
+		iFull = ETrue;
+		}
+		
+	if(iDataAvailableRequest)
+		{
+		iReadChannel->DoRequestCallback();
+		iDataAvailableRequest = EFalse;		
+		}
+	}
+
+
+void DPipe::ReadDone(TInt aSize)
+/**
+Update the ring buffer state after data has been read from it, and tell
+the writer if space is available.
+
+@param	aSize		Amount of data read.
+
+@pre iPipeMutex held
+*/
+	{
+	__ASSERT_MUTEX(iPipeMutex);
+	iReadPointer = (iReadPointer + aSize)% iSize;
 	iFull = EFalse;
 	MaybeCompleteSpaceNotification();
-		
-	__ASSERT_MUTEX(iReadMutex);
-	return totalToRead;			
 	}
 
 TInt DPipe::AvailableDataCount()
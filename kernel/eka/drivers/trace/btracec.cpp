@@ -198,6 +198,11 @@ EXPORT_C TBool RBTrace::SetTimestamp2Enabled(TBool aEnable)
 	return (TBool)DoControl(ESetTimestamp2Enabled, (TAny*)aEnable);
 	}
 
+EXPORT_C TInt RBTrace::SetPerCpuBuffers(TInt aSize)
+	{
+	return DoControl(ESetPerCpuBuffers, (TAny*)aSize);
+	}
+
 /**
 Find out how much data is available.
 @param aData Set to the buffer offset where the available trace data is located.
@@ -98,6 +98,7 @@ TInt TBTraceBufferK::Create(TInt aSize)
 void TBTraceBufferK::Close()
 	{
 #ifdef __SMP__
+	SetPerCpu(0);
 	if(iOldBTraceHandler)
 		{
 		BTrace::THandler handler;
@@ -295,6 +296,10 @@ TBool TBTraceBufferK::Trace_Impl(TUint32 aHeader,TUint32 aHeader2,const TUint32
 		aHeader |= BTrace::ETimestampPresent<<BTrace::EFlagsIndex*8;
 		}
 #endif
+#endif
+#if defined(__SMP__) && defined(BTRACE_INCLUDE_TIMESTAMPS)
+	if(Buffer.iCpuRings)
+		return TraceCpu(aHeader,aHeader2,timeStamp,aContext,a1,a2,a3,aExtra,aPc);
 #endif
 	TUint size = (aHeader+3)&0xfc;
 
@@ -531,6 +536,374 @@ TBool TBTraceBufferK::Trace(TUint32 aHeader,TUint32 aHeader2,const TUint32 aCont
 #endif // BTRACE_DRIVER_MACHINE_CODED
 
 
+#ifdef __SMP__
+
+/**
+Period at which records are moved from the per-CPU rings into the trace buffer.
+*/
+const TInt KDrainPeriodMs = 10;
+
+/**
+Maximum number of records moved by Drain() for each acquisition of the BTrace lock.
+*/
+const TInt KDrainBatch = 32;
+
+/**
+Largest ring allowed for each CPU.
+*/
+const TInt KMaxCpuRingSize = 0x100000;
+
+TBool TBTraceBufferK::TraceCpu(TUint32 aHeader,TUint32 aHeader2,const TUint64 aTimestamp,const TUint32 aContext,const TUint32 a1,const TUint32 a2,const TUint32 a3,const TUint32 aExtra,const TUint32 aPc)
+	{
+	// Called with interrupts disabled, possibly without the BTrace lock, so only this CPU's ring may be written
+	TBTraceBufferK& buffer = Buffer;
+	if(!(((TBTraceBuffer*)buffer.iAddress)->iMode&RBTrace::EEnable))
+		return EFalse;
+
+	TBTraceCpuRing& ring = buffer.iCpuRings[NKern::CurrentCpu()];
+	TUint size = ((aHeader&0xff)+3)>>2; // in words
+	TUint head = ring.iHead;
+	TUint used = head-ring.iTail;
+	TUint mask = ring.iMask;
+	if(used+size>mask+1)
+		{
+		ring.iDropped = ETrue;
+		return ETrue;
+		}
+	TUint32* data = ring.iData;
+
+	TUint w = aHeader;
+	if(ring.iDropped)
+		{
+		ring.iDropped = 0;
+		w |= BTrace::EMissingRecord<<(BTrace::EFlagsIndex*8);
+		}
+	data[head++&mask] = w;
+	data[head++&mask] = aHeader2;
+	data[head++&mask] = TUint32(aTimestamp);
+	data[head++&mask] = TUint32(aTimestamp>>32);
+	size -= 4;
+
+	if(aHeader&(BTrace::EContextIdPresent<<(BTrace::EFlagsIndex*8)))
+		{
+		data[head++&mask] = aContext;
+		--size;
+		}
+	if(aHeader&(BTrace::EPcPresent<<(BTrace::EFlagsIndex*8)))
+		{
+		data[head++&mask] = aPc;
+		--size;
+		}
+	if(aHeader&(BTrace::EExtraPresent<<(BTrace::EFlagsIndex*8)))
+		{
+		data[head++&mask] = aExtra;
+		--size;
+		}
+
+	if(size)
+		{
+		data[head++&mask] = a1;
+		if(--size)
+			{
+			data[head++&mask] = a2;
+			if(--size)
+				{
+				if(size==1)
+					data[head++&mask] = a3;
+				else
+					{
+					const TUint32* src = (const TUint32*)a3;
+					do data[head++&mask] = *src++;
+					while(--size);
+					}
+				}
+			}
+		}
+
+	__e32_memory_barrier();	// make sure written data is observed before head pointer update
+	ring.iHead = head;
+
+	// wake the drain when the ring first passes half full
+	TUint half = (mask+1)>>1;
+	if(used<=half && head-ring.iTail>half)
+		buffer.iDrainDfc->RawAdd();
+	return ETrue;
+	}
+
+
+/**
+Append a record taken from a per-CPU ring to the trace buffer.
+Must be called with the BTrace lock held.
+*/
+void TBTraceBufferK::Append(const TUint32* aRecord, TUint aWords)
+	{
+	TLinAddr address = iAddress;
+	TBTraceBuffer& user_buffer = *(TBTraceBuffer*)address;
+	++user_buffer.iGeneration;	// atomic not required since only driver modifies iGeneration
+	__e32_memory_barrier();
+	TUint size = aWords<<2;
+	TUint start = iStart;
+	TUint end = iEnd;
+	TUint orig_head = iHead;
+	TInt requestDataSize = iRequestDataSize;
+	TUint8* recordOffsets = iRecordOffsets;
+	TUint32 orig_tail = user_buffer.iTail;
+	TUint32 newHead, head, tail;
+
+	if(!(user_buffer.iMode&RBTrace::EEnable))
+		goto done;
+
+retry:
+	head = orig_head;
+	tail = orig_tail &~ 1;
+	newHead = head+size;
+	if(newHead>end)
+		{
+		requestDataSize = 0; 
+		newHead = start+size;
+		if(head<tail || tail<newHead+1)
+			{
+			if(!(user_buffer.iMode&RBTrace::EFreeRunning))
+				goto dropped;
+			user_buffer.iWrap = head;
+			head = start;
+			tail = newHead+(recordOffsets[newHead>>2]<<2);
+			goto overwrite;
+			}
+		user_buffer.iWrap = head;
+		head = start;
+		}
+	else if(head<tail && tail<=newHead)
+		{
+		{
+		requestDataSize = 0; 
+		TUint wrap = user_buffer.iWrap;
+		if(!(user_buffer.iMode&RBTrace::EFreeRunning))
+			goto dropped;
+		if(newHead<end && newHead<wrap)
+			{
+			tail = newHead+(recordOffsets[newHead>>2]<<2);
+			if(tail>=end || tail>=wrap)
+				tail = start;
+			}
+		else
+			tail = start;
+		}
+overwrite:
+		*(TUint32*)(address+tail) |= BTrace::EMissingRecord<<(BTrace::EFlagsIndex*8);
+		if (!__e32_atomic_cas_ord32(&user_buffer.iTail, &orig_tail, tail|1))
+			goto retry;	// go round again if user side has already updated the tail pointer
+		}
+
+	iRequestDataSize = requestDataSize-size;
+
+	{
+	recordOffsets += head>>2;
+	TUint32* dst = (TUint32*)(address+head);
+	TUint w = aRecord[0];
+	if(iDropped)
+		{
+		iDropped = 0;
+		w |= BTrace::EMissingRecord<<(BTrace::EFlagsIndex*8); 
+		}
+	*recordOffsets++ = (TUint8)aWords;
+	*dst++ = w;
+	for(TUint i=1; i<aWords; ++i)
+		{
+		*recordOffsets++ = (TUint8)(aWords-i);
+		*dst++ = aRecord[i];
+		}
+	}
+	iHead = newHead;
+	__e32_memory_barrier();	// make sure written data is observed before head pointer update
+	user_buffer.iHead = newHead;
+
+	{
+	TDfc* dfc = (TDfc*)iWaitingDfc;
+	if(dfc && iRequestDataSize<=0)
+		{
+		iWaitingDfc = NULL;
+		dfc->RawAdd();
+		}
+	}
+	goto done;
+
+dropped:
+	iRequestDataSize = 0; 
+	iDropped = ETrue;
+done:
+	__e32_memory_barrier();
+	++user_buffer.iGeneration;	// atomic not required since only driver modifies iGeneration
+	}
+
+
+/**
+Move all records from the per-CPU rings to the trace buffer, merging them in
+timestamp order. Every record in a ring has a header2 word followed by a
+64 bit timestamp.
+*/
+void TBTraceBufferK::Drain()
+	{
+	TSpinLock* sl = BTrace::LockPtr();
+	TUint32 record[KMaxBTraceRecordSize>>2];
+	TInt n;
+	do
+		{
+		TInt irq = sl->LockIrqSave();
+		TBTraceCpuRing* rings = iCpuRings;
+		if(!rings)
+			{
+			sl->UnlockIrqRestore(irq);
+			return;
+			}
+		for(n=0; n<KDrainBatch; ++n)
+			{
+			TBTraceCpuRing* next = NULL;
+			TUint64 nextTimestamp = 0;
+			for(TInt cpu=0; cpu<iCpuRingCount; ++cpu)
+				{
+				TBTraceCpuRing& ring = rings[cpu];
+				TUint tail = ring.iTail;
+				if(tail==ring.iHead)
+					continue;
+				__e32_memory_barrier();	// read head pointer before record data
+				TUint64 timestamp = MAKE_TUINT64(ring.iData[(tail+3)&ring.iMask],ring.iData[(tail+2)&ring.iMask]);
+				if(!next || timestamp<nextTimestamp)
+					{
+					next = &ring;
+					nextTimestamp = timestamp;
+					}
+				}
+			if(!next)
+				break;
+
+			TUint tail = next->iTail;
+			TUint mask = next->iMask;
+			TUint words = ((next->iData[tail&mask]&0xff)+3)>>2;
+			for(TUint i=0; i<words; ++i)
+				record[i] = next->iData[(tail+i)&mask];
+			__e32_memory_barrier();	// finish reading the record before its space is reused
+			next->iTail = tail+words;
+			Append(record,words);
+			}
+		sl->UnlockIrqRestore(irq);
+		}
+	while(n==KDrainBatch);
+	}
+
+
+void TBTraceBufferK::StartDrainTimer()
+	{
+	iDrainTimer->OneShot(NKern::TimerTicks(KDrainPeriodMs));
+	}
+
+
+void TBTraceBufferK::DrainTimerFn(TAny*)
+	{
+	Buffer.iDrainDfc->Add();
+	}
+
+
+void TBTraceBufferK::DrainDfcFn(TAny*)
+	{
+	TBTraceBufferK& buffer = Buffer;
+	buffer.Drain();
+	// keep draining periodically while trace is enabled; if it is not, the
+	// next RequestData or a ring passing half full starts the drain again
+	TBTraceBuffer* userBuffer = (TBTraceBuffer*)buffer.iAddress;
+	if(buffer.iCpuRings && userBuffer && (userBuffer->iMode&RBTrace::EEnable))
+		buffer.StartDrainTimer();
+	}
+
+
+/**
+Switch between per-CPU buffer mode and single buffer mode.
+
+@param aSize Size in bytes of each CPU's ring, or zero for single buffer mode.
+@pre Calling thread must be in a critical section.
+*/
+TInt TBTraceBufferK::SetPerCpu(TInt aSize)
+	{
+#ifndef BTRACE_INCLUDE_TIMESTAMPS
+	if(aSize>0)
+		return KErrNotSupported;	// the rings can't be merged without timestamps
+#endif
+	if(aSize<0)
+		return KErrArgument;
+
+	if(iCpuRings)
+		{
+		// handler must take the lock again before it stops using the rings...
+		BTrace::SetLockFree(EFalse);
+		iDrainTimer->Cancel();
+		Drain();
+		TSpinLock* sl = BTrace::LockPtr();
+		TInt irq = sl->LockIrqSave();
+		TBTraceCpuRing* rings = iCpuRings;
+		iCpuRings = NULL;
+		sl->UnlockIrqRestore(irq);
+		// ...so now nothing else can be using them
+		for(TInt cpu=0; cpu<iCpuRingCount; ++cpu)
+			Kern::Free(rings[cpu].iData);
+		Kern::Free(rings);
+		iCpuRingCount = 0;
+		}
+	if(!aSize)
+		return KErrNone;
+	if(!iAddress)
+		return KErrNotReady;
+
+	// The timer and DFC are never freed since they may still be queued
+	if(!iDrainDfc)
+		{
+		iDrainDfc = new TDfc(DrainDfcFn,this,Kern::DfcQue1(),6);
+		if(!iDrainDfc)
+			return KErrNoMemory;
+		}
+	if(!iDrainTimer)
+		{
+		iDrainTimer = new NTimer(DrainTimerFn,this);
+		if(!iDrainTimer)
+			return KErrNoMemory;
+		}
+
+	// ring size is a power of 2 no smaller than the largest record
+	if(aSize<KMaxBTraceRecordSize*2)
+		aSize = KMaxBTraceRecordSize*2;
+	if(aSize>KMaxCpuRingSize)
+		aSize = KMaxCpuRingSize;
+	TUint words = 1u<<(__e32_find_ms1_32((aSize>>2)-1)+1);
+	TInt count = NKern::NumberOfCpus();
+	TBTraceCpuRing* rings = (TBTraceCpuRing*)Kern::AllocZ(count*sizeof(TBTraceCpuRing));
+	if(!rings)
+		return KErrNoMemory;
+	TInt cpu;
+	for(cpu=0; cpu<count; ++cpu)
+		{
+		rings[cpu].iMask = words-1;
+		rings[cpu].iData = (TUint32*)Kern::Alloc(words<<2);
+		if(!rings[cpu].iData)
+			break;
+		}
+	if(cpu<count)
+		{
+		while(--cpu>=0)
+			Kern::Free(rings[cpu].iData);
+		Kern::Free(rings);
+		return KErrNoMemory;
+		}
+
+	iCpuRingCount = count;
+	__e32_memory_barrier();	// rings must be initialised before the handler can see them
+	iCpuRings = rings;
+	BTrace::SetLockFree(ETrue);
+	StartDrainTimer();
+	return KErrNone;
+	}
+
+#endif // __SMP__
+
+
 TInt TBTraceBufferK::ControlFunction(BTrace::TControl aFunction, TAny* aArg1, TAny* aArg2)
 	{
 	switch(aFunction)
@@ -555,6 +928,25 @@ TInt TBTraceBufferK::ControlFunction(BTrace::TControl aFunction, TAny* aArg1, TA
 
 
 void TBTraceBufferK::CrashRead(TUint8*& aData, TUint& aSize)
+	{
+	// parts 0 and 1 are the trace buffer, followed on SMP by up to two parts
+	// for each per-CPU ring; skip empty parts as an empty part ends the dump
+	TUint lastPart = 1;
+#ifdef __SMP__
+	if(iCpuRings)
+		lastPart += iCpuRingCount*2;
+#endif
+	for(;;)
+		{
+		CrashReadPart(iCrashReadPart,aData,aSize);
+		if(aSize || iCrashReadPart>=lastPart)
+			return;
+		++iCrashReadPart;
+		}
+	}
+
+
+void TBTraceBufferK::CrashReadPart(TUint aPart, TUint8*& aData, TUint& aSize)
 	{
 	// start by assuming no data...
 	aData = 0;
@@ -564,6 +956,35 @@ void TBTraceBufferK::CrashRead(TUint8*& aData, TUint& aSize)
 	if(!userBuffer)
 		return; // no trace buffer, so end...
 
+#ifdef __SMP__
+	if(aPart>=2)
+		{
+		// records not yet merged from a per-CPU ring, in the order they were written...
+		TBTraceCpuRing* rings = iCpuRings;
+		TInt cpu = (aPart-2)>>1;
+		if(!rings || cpu>=iCpuRingCount)
+			return; // no more parts
+		TBTraceCpuRing& ring = rings[cpu];
+		TUint mask = ring.iMask;
+		TUint tail = ring.iTail;
+		TUint used = ring.iHead-tail;
+		TUint first = mask+1-(tail&mask); // words before the ring storage wraps
+		if(first>used)
+			first = used;
+		if(!(aPart&1))
+			{
+			aData = (TUint8*)(ring.iData+(tail&mask));
+			aSize = first<<2;
+			}
+		else
+			{
+			aData = (TUint8*)ring.iData;
+			aSize = (used-first)<<2;
+			}
+		return;
+		}
+#endif
+
 	TUint head = iHead;
 	TUint tail = userBuffer->iTail;
 	TUint8* data = (TUint8*)userBuffer;
@@ -571,7 +992,7 @@ void TBTraceBufferK::CrashRead(TUint8*& aData, TUint& aSize)
 	if(head>tail)
 		{
 		// data is in one part...
-		if(iCrashReadPart==0)
+		if(aPart==0)
 			{
 			aData = data+tail;
 			aSize = head-tail;
@@ -581,13 +1002,13 @@ void TBTraceBufferK::CrashRead(TUint8*& aData, TUint& aSize)
 	else if(head<tail)
 		{
 		// data is in two parts...
-		if(iCrashReadPart==0)
+		if(aPart==0)
 			{
 			// first part...
 			aData = data+tail;
 			aSize = userBuffer->iWrap-tail;
 			}
-		else if(iCrashReadPart==1)
+		else if(aPart==1)
 			{
 			// second part...
 			aData = data+iStart;
@@ -814,6 +1235,14 @@ TInt DBTraceChannel::Request(TInt aReqNo, TAny* a1, TAny* a2)
 	case RBTrace::ERequestData:
 		if (iWaitRequest->SetStatus((TRequestStatus*)a1) != KErrNone)
 			Kern::PanicCurrentThread(RBTrace::Name(),RBTrace::ERequestAlreadyPending);
+#ifdef __SMP__
+		if(buffer.iCpuRings)
+			{
+			// collect what the CPUs have written so far, and keep collecting until the request is satisfied
+			buffer.Drain();
+			buffer.StartDrainTimer();
+			}
+#endif
 		r = buffer.RequestData((TInt)a2,&iWaitDfc);
 		if (r!=KErrNone)
 			{
@@ -850,6 +1279,16 @@ TInt DBTraceChannel::Request(TInt aReqNo, TAny* a1, TAny* a2)
 		return old;
 		}
 
+	case RBTrace::ESetPerCpuBuffers:
+#ifdef __SMP__
+		NKern::ThreadEnterCS();
+		r = buffer.SetPerCpu((TInt)a1);
+		NKern::ThreadLeaveCS();
+		return r;
+#else
+		return KErrNotSupported;
+#endif
+
 	default:
 		break;
 		}
@@ -61,7 +61,10 @@ Typically, a derived class calls Cancel() in its destructor.
 	{
 	__ASSERT_ALWAYS(!(iStatus.iFlags&TRequestStatus::EActive),Panic(EReqStillActiveOnDestruct));
 	if (IsAdded())
+		{
+		CActiveScheduler::ForgetReady(this);
 		iLink.Deque();
+		}
 	}
 
 
@@ -113,6 +116,7 @@ any outstanding request.
 	{
 	__ASSERT_ALWAYS(IsAdded(),Panic(EActiveNotAdded));
 	Cancel();
+	CActiveScheduler::ForgetReady(this);
 	iLink.Deque();
 	iLink.iNext=NULL; // Must do this or object cannot be re-queued
 	}
@@ -705,6 +709,22 @@ which version of AsyncStop() you would want to call.
 
 
 
+/**
+@internalComponent
+
+Active objects whose requests are known to have completed, kept by an active
+scheduler using its ready queue.  Objects which don't fit are found by scanning.
+*/
+struct CActiveScheduler::TReadyQueue
+	{
+	enum {EMaxReady=32};
+	TInt iCount;
+	CActive* iReady[EMaxReady];
+	};
+
+
+
+
 EXPORT_C CActiveScheduler::CActiveScheduler()
 	: iActiveQ(_FOFF(CActive,iLink))
 /**
@@ -737,6 +757,7 @@ has returned.
 		iActiveQ.First()->Deque();
 	if (GetActiveScheduler()==this)
 		SetActiveScheduler(NULL);
+	User::Free(iSpare);
 	}
 
 
@@ -757,7 +778,10 @@ The current active scheduler can be uninstalled by passing a NULL pointer.
 */
 	{
 	if (aManager!=NULL)
+		{
 		__ASSERT_ALWAYS(GetActiveScheduler()==NULL,Panic(EReqManagerAlreadyExists));
+		aManager->ClearReady();
+		}
 	SetActiveScheduler(aManager);
 	}
 
@@ -792,6 +816,141 @@ destroying the active object or by using its Deque() member function.
 
 
 
+EXPORT_C void CActiveScheduler::EnableReadyQueueL()
+/**
+Makes the active scheduler dispatch requests completed by this thread without
+scanning all of its active objects.
+
+Each time a request completes, the active scheduler normally examines its active
+objects in priority order until it finds one whose request has completed, so the
+cost of handling an event grows with the number of active objects.  Once the ready
+queue is enabled, User::RequestComplete() marks the active object whose request it
+completes as ready.  When the thread's request semaphore count shows that every
+completed request belongs to a ready object, and one of them has a higher priority
+than the others, the active scheduler runs it without scanning.
+
+Only completions made by this thread with User::RequestComplete() are marked.
+Whenever a request completed by the kernel, such as a timer or a client-server
+request, or by another thread is outstanding, the active scheduler scans as before,
+so those completions gain nothing from the ready queue and each event costs an
+extra executive call to read the request count.  The same applies when the highest
+priority ready objects have equal priority.
+
+Active objects are run in the same order as without the ready queue.
+
+@leave KErrNoMemory if there is not enough memory for the ready queue.
+*/
+	{
+	if (iSpare==NULL)
+		iSpare=User::AllocZL(sizeof(TReadyQueue));
+	}
+
+
+
+
+void CActiveScheduler::AddReady(CActive* aActive)
+//
+// Note that aActive's request has completed, if there is room
+//
+	{
+	TReadyQueue& q=*(TReadyQueue*)iSpare;
+	if (q.iCount<TReadyQueue::EMaxReady)
+		q.iReady[q.iCount++]=aActive;
+	}
+
+
+
+
+CActive* CActiveScheduler::TakeReady(TInt aCompleted)
+//
+// Forget any active objects in the ready queue which have been run or cancelled
+// since they were added. If the rest account for all aCompleted completed requests
+// and one of them has the highest priority, remove and return it: it is the one
+// DoRunL() would find. Otherwise the order depends on objects the ready queue
+// doesn't know about, or on positions in the active queue, so return NULL.
+//
+	{
+	TReadyQueue& q=*(TReadyQueue*)iSpare;
+	CActive* best=NULL;
+	TInt bestIndex=0;
+	TBool tie=EFalse;
+	TInt n=0;
+	for (TInt i=0; i<q.iCount; ++i)
+		{
+		CActive* pR=q.iReady[i];
+		if (!pR->IsAdded() || !pR->IsActive() || pR->iStatus==KRequestPending)
+			continue;
+		if (best==NULL || pR->Priority()>best->Priority())
+			{
+			best=pR;
+			bestIndex=n;
+			tie=EFalse;
+			}
+		else if (pR->Priority()==best->Priority())
+			tie=ETrue;
+		q.iReady[n++]=pR;
+		}
+	q.iCount=n;
+	if (best==NULL || tie || n!=aCompleted)
+		return NULL;
+	q.iReady[bestIndex]=q.iReady[--q.iCount];
+	return best;
+	}
+
+
+
+
+void CActiveScheduler::ClearReady()
+	{
+	if (iSpare!=NULL)
+		((TReadyQueue*)iSpare)->iCount=0;
+	}
+
+
+
+
+void CActiveScheduler::RemoveReady(CActive* aActive)
+	{
+	TReadyQueue& q=*(TReadyQueue*)iSpare;
+	for (TInt i=q.iCount-1; i>=0; --i)
+		{
+		if (q.iReady[i]==aActive)
+			q.iReady[i]=q.iReady[--q.iCount];
+		}
+	}
+
+
+
+
+void CActiveScheduler::ForgetReady(CActive* aActive)
+//
+// Called when aActive is removed from the current active scheduler
+//
+	{
+	CActiveScheduler* pS=GetActiveScheduler();
+	if (pS!=NULL && pS->iSpare!=NULL)
+		pS->RemoveReady(aActive);
+	}
+
+
+
+
+void CActiveScheduler::RequestCompleted(TRequestStatus* aStatus)
+//
+// Called by User::RequestComplete() once it has completed aStatus
+//
+	{
+	// only an active object's request status is ever marked active
+	if (!(aStatus->iFlags&TRequestStatus::EActive))
+		return;
+	CActiveScheduler* pS=GetActiveScheduler();
+	if (pS!=NULL && pS->iSpare!=NULL)
+		pS->AddReady(_LOFF(aStatus,CActive,iStatus));
+	}
+
+
+
+
 EXPORT_C void CActiveScheduler::WaitForAnyRequest()
 /**
 Wait for an asynchronous request to complete.
@@ -958,7 +1117,7 @@ void CActiveScheduler::Run(TLoopOwner* const volatile& aLoop)
 				//and we check to make sure its still at the top.
 				ccleanup.PushL(TCleanupItem(DummyFunc, &(cleanupBundle.iDummyInt)));
 				
-				DoRunL(aLoop, curr_obj, &cleanupBundle);
+				DispatchL(aLoop, curr_obj, &cleanupBundle);
 
 				//Dummy Int must (will) be at the top
 				//Cleanup our stack
@@ -966,11 +1125,11 @@ void CActiveScheduler::Run(TLoopOwner* const volatile& aLoop)
 				} 
 			else // no cleanup stack installed
 				{
-				DoRunL(aLoop, curr_obj, NULL);
+				DispatchL(aLoop, curr_obj, NULL);
 				}
 			
 #else
-			DoRunL(aLoop, curr_obj, NULL);
+			DispatchL(aLoop, curr_obj, NULL);
 #endif
 			
 			User::UnMarkCleanupStack(t);
@@ -1041,7 +1200,7 @@ void CActiveScheduler::Run(TLoopOwner* const volatile& aLoop)
 				//and we check to make sure its still at the top.
 				ccleanup.PushL(TCleanupItem(DummyFunc, &(cleanupBundle.iDummyInt)));
 				
-				DoRunL(aLoop, curr_obj, &cleanupBundle);
+				DispatchL(aLoop, curr_obj, &cleanupBundle);
 
 				//Dummy Int must (will) be at the top
 				//Cleanup our stack
@@ -1049,10 +1208,10 @@ void CActiveScheduler::Run(TLoopOwner* const volatile& aLoop)
 				} 
 			else // no cleanup stack installed
 				{
-				DoRunL(aLoop, curr_obj, NULL);
+				DispatchL(aLoop, curr_obj, NULL);
 				}
 #else
-			DoRunL(aLoop, curr_obj, NULL);
+			DispatchL(aLoop, curr_obj, NULL);
 #endif
 			
 			TTrap::UnTrap();
@@ -1132,6 +1291,74 @@ extern "C" void PanicStrayEvent()
 
 
 
+void CActiveScheduler::DispatchL(TLoopOwner* const volatile& aLoop, CActive* volatile & aCurrentObj, TCleanupBundle* aCleanupBundlePtr)
+	{
+	if (iSpare!=NULL)
+		DoRunReadyL(aLoop, aCurrentObj, aCleanupBundlePtr);
+	else
+		DoRunL(aLoop, aCurrentObj, aCleanupBundlePtr);
+	}
+
+
+
+
+/**
+@internalComponent
+
+The inner active scheduler loop used once the ready queue is enabled. As DoRunL(),
+but the active object to run is taken from the ready queue when the request count
+shows that the ready queue holds every completed request.
+
+Stop when aLoop becomes 'Inactive'
+@panic EClnCheckFailed 90 This will panic when the RunL has left the cleanup stack in an unbalanced state.
+*/
+#ifdef _DEBUG
+void CActiveScheduler::DoRunReadyL(TLoopOwner* const volatile& aLoop, CActive* volatile & aCurrentObj, TCleanupBundle* aCleanupBundlePtr)
+#else
+void CActiveScheduler::DoRunReadyL(TLoopOwner* const volatile& aLoop, CActive* volatile & aCurrentObj, TCleanupBundle* /*aCleanupBundlePtr*/)
+#endif
+	{
+	TDblQueIter<CActive> q(iActiveQ);
+	do
+		{
+		WaitForAnyRequest();
+		// the signal just taken and any still outstanding are all completed requests
+		CActive* pR=TakeReady(RThread().RequestCount()+1);
+		if (pR==NULL)
+			{
+			q.SetToFirst();
+			do
+				{
+				pR=q++;
+				__ASSERT_ALWAYS(pR!=NULL,Panic(EReqStrayEvent));
+				__ASSERT_DEBUG(!(pR->iStatus.iFlags&TRequestStatus::EActive)==!(pR->iStatus.iFlags&TRequestStatus::ERequestPending),Panic(EReqStrayEvent));
+				} while (!pR->IsActive() || pR->iStatus==KRequestPending);
+			RemoveReady(pR);
+			}
+#ifdef __SMP__
+		__e32_memory_barrier();
+#endif
+		pR->iStatus.iFlags&=~(TRequestStatus::EActive | TRequestStatus::ERequestPending); //pR->iActive=EFalse;
+		aCurrentObj = pR;
+		pR->RunL();
+
+#ifdef _DEBUG
+		if(aCleanupBundlePtr!=NULL)
+			{
+			//If the following line panics, the RunL left the
+			//cleanup stack in an umbalanced state.
+			TInt* dummyInt = &(aCleanupBundlePtr->iDummyInt);
+			aCleanupBundlePtr->iCleanupPtr->Check(dummyInt);
+			}
+#endif
+
+		} while (aLoop != KLoopInactive);
+	return;		// exit level
+	}
+
+
+
+
 EXPORT_C void CActiveScheduler::Stop()
 /**
 Stops the wait loop started by the most recent call to Start().
@@ -1304,8 +1531,10 @@ objects.
 	__ASSERT_ALWAYS(aNewActiveScheduler!=NULL, Panic(EReqManagerDoesNotExist));
 	CActiveScheduler* oldActiveScheduler=GetActiveScheduler();
 	__ASSERT_ALWAYS(aNewActiveScheduler!=oldActiveScheduler, Panic(EActiveSchedulerReplacingSelf));
+	aNewActiveScheduler->ClearReady();
 	if (oldActiveScheduler!=NULL)
 		{
+		oldActiveScheduler->ClearReady();
 		// steal all the CActive objects from oldActiveScheduler (without canceling any of them)
 		TPriQue<CActive>& oldActiveQ=oldActiveScheduler->iActiveQ;
 		TPriQue<CActive>& newActiveQ=aNewActiveScheduler->iActiveQ;
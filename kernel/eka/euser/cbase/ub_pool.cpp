@@ -0,0 +1,461 @@
+// Copyright (c) 2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of the License "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+// e32\euser\cbase\ub_pool.cpp
+//
+//
+
+#include "ub_std.h"
+
+struct CActiveSchedulerPool::TTask
+	{
+	TDblQueLink iLink;
+	TCallBack iCallBack;
+	TInt iGroup;
+	};
+
+struct CActiveSchedulerPool::TWorker
+	{
+	TWorker();
+	CActiveSchedulerPool* iPool;
+	RThread iThread;
+	TRequestStatus* iInboxStatus;
+	TInt iGroups;				// protected by the pool's iGroupLock
+	RFastLock iLock;			// protects everything below
+	TDblQue<TTask> iTasks;
+	TInt iLoad;					// tasks queued or running
+	TBool iSignalled;			// iInboxStatus has been completed
+	TBool iStopping;
+	};
+
+class CActiveSchedulerPool::CInbox : public CActive
+	{
+public:
+	CInbox(TWorker& aWorker);
+	~CInbox();
+private:
+	void RunL();
+	void DoCancel();
+private:
+	TWorker& iWorker;
+	};
+
+
+
+
+CActiveSchedulerPool::TWorker::TWorker()
+	: iPool(NULL), iInboxStatus(NULL), iGroups(0), iTasks(_FOFF(TTask,iLink)),
+	  iLoad(0), iSignalled(EFalse), iStopping(EFalse)
+	{
+	}
+
+
+
+
+CActiveSchedulerPool::CInbox::CInbox(TWorker& aWorker)
+//
+// Below the standard priority, so that the active objects created by posted work
+// aren't starved by a busy queue
+//
+	: CActive(EPriorityLow), iWorker(aWorker)
+	{
+	CActiveScheduler::Add(this);
+	iStatus=KRequestPending;
+	SetActive();
+	aWorker.iInboxStatus=&iStatus;
+	}
+
+
+
+
+CActiveSchedulerPool::CInbox::~CInbox()
+	{
+	Cancel();
+	}
+
+
+
+
+void CActiveSchedulerPool::CInbox::DoCancel()
+	{
+	TRequestStatus* s=&iStatus;
+	User::RequestComplete(s,KErrCancel);
+	}
+
+
+
+
+void CActiveSchedulerPool::CInbox::RunL()
+//
+// Run one task, so that the worker's own active objects get a look in between
+// tasks, and signal ourselves again if there are more.  When our own queue is
+// empty, take a task from another worker's.
+//
+	{
+	TWorker& w=iWorker;
+	w.iLock.Wait();
+	if (w.iStopping)
+		{
+		w.iLock.Signal();
+		CActiveScheduler::Stop();
+		return;
+		}
+	TTask* t=NULL;
+	if (!w.iTasks.IsEmpty())
+		{
+		t=w.iTasks.First();
+		t->iLink.Deque();
+		}
+	iStatus=KRequestPending;
+	SetActive();
+	w.iSignalled=!w.iTasks.IsEmpty();
+	TBool more=w.iSignalled;
+	w.iLock.Signal();
+	if (more)
+		{
+		TRequestStatus* s=&iStatus;
+		User::RequestComplete(s,KErrNone);
+		}
+
+	if (!t)
+		{
+		t=w.iPool->Steal(w);
+		if (!t)
+			return;
+		}
+	if (t->iCallBack.CallBack())
+		{
+		// asked to be called again; a stolen task is only ever in EAnyGroup so
+		// it may stay here
+		Queue(w,t);
+		return;
+		}
+	delete t;
+	w.iLock.Wait();
+	--w.iLoad;
+	// if nothing has been posted here meanwhile, come back to look for work to steal
+	more=!w.iSignalled;
+	if (more)
+		w.iSignalled=ETrue;
+	w.iLock.Signal();
+	if (more)
+		{
+		TRequestStatus* s=&iStatus;
+		User::RequestComplete(s,KErrNone);
+		}
+	}
+
+
+
+
+/**
+Creates a pool of threads, each running its own active scheduler.
+
+@param aThreads The number of threads in the pool.  This is typically the
+                number of CPUs.
+
+@return A pointer to the new pool.
+
+@leave KErrNoMemory, or any of the system-wide error codes if a thread can't
+       be created.
+
+@panic E32USER-CBase 107 if aThreads is not positive.
+*/
+EXPORT_C CActiveSchedulerPool* CActiveSchedulerPool::NewL(TInt aThreads)
+	{
+	__ASSERT_ALWAYS(aThreads>0,Panic(EActivePoolBadArgument));
+	CActiveSchedulerPool* p=new(ELeave) CActiveSchedulerPool;
+	CleanupStack::PushL(p);
+	p->ConstructL(aThreads);
+	CleanupStack::Pop(p);
+	return p;
+	}
+
+
+
+
+CActiveSchedulerPool::CActiveSchedulerPool()
+	{
+	}
+
+
+
+
+void CActiveSchedulerPool::ConstructL(TInt aThreads)
+	{
+	User::LeaveIfError(iGroupLock.CreateLocal());
+	iWorkers=new(ELeave) TWorker[aThreads];
+	iSize=aThreads;
+	for (TInt i=0; i<aThreads; ++i)
+		{
+		TWorker& w=iWorkers[i];
+		w.iPool=this;
+		User::LeaveIfError(w.iLock.CreateLocal());
+		User::LeaveIfError(w.iThread.Create(KNullDesC,WorkerThread,KDefaultStackSize,&User::Allocator(),&w,EOwnerProcess));
+		TRequestStatus s;
+		w.iThread.Rendezvous(s);
+		w.iThread.Resume();
+		User::WaitForRequest(s);
+		User::LeaveIfError(s.Int());
+		++iCount;
+		}
+	}
+
+
+
+
+/**
+Destructor.
+
+Stops all the threads in the pool and waits for them to exit.  Work which has
+been posted but not yet run is discarded.
+
+Any active objects which work posted to the pool has created should be
+destroyed, by posting more work, before the pool is.  The pool must not be
+destroyed by one of its own threads.
+*/
+EXPORT_C CActiveSchedulerPool::~CActiveSchedulerPool()
+	{
+	TInt i;
+	for (i=0; i<iCount; ++i)
+		{
+		TWorker& w=iWorkers[i];
+		w.iLock.Wait();
+		w.iStopping=ETrue;
+		TBool signal=!w.iSignalled;
+		w.iSignalled=ETrue;
+		w.iLock.Signal();
+		if (signal)
+			{
+			TRequestStatus* s=w.iInboxStatus;
+			w.iThread.RequestComplete(s,KErrNone);
+			}
+		}
+	for (i=0; i<iCount; ++i)
+		{
+		TRequestStatus s;
+		iWorkers[i].iThread.Logon(s);
+		User::WaitForRequest(s);
+		}
+	for (i=0; i<iSize; ++i)
+		{
+		TWorker& w=iWorkers[i];
+		while (!w.iTasks.IsEmpty())
+			{
+			TTask* t=w.iTasks.First();
+			t->iLink.Deque();
+			delete t;
+			}
+		w.iThread.Close();
+		w.iLock.Close();
+		}
+	delete[] iWorkers;
+	iGroupLock.Close();
+	}
+
+
+
+
+/**
+Opens an affinity group.
+
+Work posted to the group runs in a single thread of the pool.  Groups are
+spread evenly across the threads.
+
+@return The group number, to pass to Post() and CloseGroup().
+
+@see CActiveSchedulerPool::Post
+*/
+EXPORT_C TInt CActiveSchedulerPool::OpenGroup()
+	{
+	iGroupLock.Wait();
+	TInt best=0;
+	for (TInt i=1; i<iCount; ++i)
+		{
+		if (iWorkers[i].iGroups<iWorkers[best].iGroups)
+			best=i;
+		}
+	++iWorkers[best].iGroups;
+	iGroupLock.Signal();
+	return best+1;
+	}
+
+
+
+
+/**
+Closes an affinity group which is no longer needed.
+
+Work already posted to the group still runs.
+
+@param aGroup The group number returned by OpenGroup().
+
+@panic E32USER-CBase 107 if aGroup is not a group in this pool.
+*/
+EXPORT_C void CActiveSchedulerPool::CloseGroup(TInt aGroup)
+	{
+	__ASSERT_ALWAYS(aGroup>EAnyGroup && aGroup<=iCount,Panic(EActivePoolBadArgument));
+	iGroupLock.Wait();
+	--iWorkers[aGroup-1].iGroups;
+	iGroupLock.Signal();
+	}
+
+
+
+
+/**
+Posts work to the pool.
+
+The callback function is called in one of the pool's threads, from the RunL()
+of an active object in that thread's active scheduler.  If it returns non-zero
+it is called again later, as CIdle does, which lets long computations be split
+into pieces.
+
+Work posted to the same group is run in the order in which it was posted.
+
+@param aGroup    A group number returned by OpenGroup(), or EAnyGroup if the
+                 work may run in any thread.
+@param aCallBack The work to run.
+
+@return KErrNone if successful, KErrNoMemory if there is not enough memory.
+
+@panic E32USER-CBase 107 if aGroup is not a group in this pool.
+*/
+EXPORT_C TInt CActiveSchedulerPool::Post(TInt aGroup, const TCallBack& aCallBack)
+	{
+	__ASSERT_ALWAYS(aGroup>=EAnyGroup && aGroup<=iCount,Panic(EActivePoolBadArgument));
+	TTask* t=new TTask;
+	if (!t)
+		return KErrNoMemory;
+	t->iCallBack=aCallBack;
+	t->iGroup=aGroup;
+	TWorker* w;
+	if (aGroup==EAnyGroup)
+		{
+		// the load is only a hint, so there is no need to lock
+		w=iWorkers;
+		for (TInt i=1; i<iCount && w->iLoad; ++i)
+			{
+			if (iWorkers[i].iLoad<w->iLoad)
+				w=iWorkers+i;
+			}
+		}
+	else
+		w=iWorkers+aGroup-1;
+	w->iLock.Wait();
+	++w->iLoad;
+	w->iLock.Signal();
+	Queue(*w,t);
+	return KErrNone;
+	}
+
+
+
+
+/**
+Gets the number of threads in the pool.
+
+@return The number of threads.
+*/
+EXPORT_C TInt CActiveSchedulerPool::Count() const
+	{
+	return iCount;
+	}
+
+
+
+
+void CActiveSchedulerPool::Queue(TWorker& aWorker, TTask* aTask)
+//
+// Add a task to the end of a worker's queue, and wake the worker if needed
+//
+	{
+	aWorker.iLock.Wait();
+	aWorker.iTasks.AddLast(*aTask);
+	TBool signal=!aWorker.iSignalled;
+	aWorker.iSignalled=ETrue;
+	aWorker.iLock.Signal();
+	if (signal)
+		{
+		TRequestStatus* s=aWorker.iInboxStatus;
+		aWorker.iThread.RequestComplete(s,KErrNone);
+		}
+	}
+
+
+
+
+CActiveSchedulerPool::TTask* CActiveSchedulerPool::Steal(TWorker& aThief)
+//
+// Take the most recently queued task in EAnyGroup from another worker
+//
+	{
+	TInt thief=&aThief-iWorkers;
+	for (TInt i=1; i<iCount; ++i)
+		{
+		TWorker& w=iWorkers[(thief+i)%iCount];
+		if (w.iLoad<2)
+			continue;	// nothing waiting behind the task it is running
+		w.iLock.Wait();
+		TDblQueIter<TTask> iter(w.iTasks);
+		iter.SetToLast();
+		TTask* t;
+		while ((t=iter--)!=NULL && t->iGroup!=EAnyGroup)
+			{
+			}
+		if (t)
+			{
+			t->iLink.Deque();
+			--w.iLoad;
+			}
+		w.iLock.Signal();
+		if (t)
+			{
+			aThief.iLock.Wait();
+			++aThief.iLoad;
+			aThief.iLock.Signal();
+			return t;
+			}
+		}
+	return NULL;
+	}
+
+
+
+
+TInt CActiveSchedulerPool::WorkerThread(TAny* aWorker)
+	{
+	TWorker& w=*(TWorker*)aWorker;
+	TInt r=KErrNoMemory;
+	CTrapCleanup* cleanup=CTrapCleanup::New();
+	CActiveScheduler* s=NULL;
+	CInbox* inbox=NULL;
+	if (cleanup)
+		s=new CActiveScheduler;
+	if (s)
+		{
+		CActiveScheduler::Install(s);
+		// active objects created by posted work may well complete each other
+		TRAP_IGNORE(s->EnableReadyQueueL());
+		inbox=new CInbox(w);
+		if (inbox)
+			r=KErrNone;
+		}
+	RThread::Rendezvous(r);
+	if (r==KErrNone)
+		CActiveScheduler::Start();
+	delete inbox;
+	delete s;
+	delete cleanup;
+	return r;
+	}
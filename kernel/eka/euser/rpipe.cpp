@@ -20,6 +20,7 @@
 
 #include <e32def.h>
 #include <e32def_private.h>
+#include <e32shbuf.h>
 #include "rpipe.h"
 
 EXPORT_C TInt RPipe::Init()
@@ -771,6 +772,175 @@ the data will be split into multiple atomic writes of pipe size
 	}
 
 
+EXPORT_C TInt RPipe::ReadV(TDes8** aData, TInt aCount)
+/**
+This is a non-blocking synchronous method to read from the pipe into several
+descriptors with a single call. Each descriptor is filled to its maximum length
+in turn, until the pipe is empty; the length of any descriptor for which no data
+remained is set to zero.
+
+@param	aData		Array of descriptors to receive data
+@param	aCount		Number of descriptors in aData, at most KPipeMaxIoVectors
+
+@return 	>0					Amount of data read from the pipe, in bytes.
+			0					No Data is available
+			KErrArgument		aCount is not between 1 and KPipeMaxIoVectors.
+			KErrAccessDenied	An attempt has been made to read from a handle 
+								has been opened for writing.
+			KErrBadHandle		An attempt has been made to read from a handle
+								that has not been opened.
+			KErrNotReady	    Write end is closed and Pipe is empty.
+								otherwise one of the other system wide error code.
+*/
+	{
+	if (!iHandle)
+		return KErrBadHandle;
+
+	if(aCount <= 0 || aCount > KPipeMaxIoVectors)
+		return KErrArgument;
+
+	if(iHandleType != EReadChannel)
+		return KErrAccessDenied;
+
+	return DoControl(EReadV, (TAny*)aData, (TAny*)&aCount);
+	}
+
+
+EXPORT_C TInt RPipe::WriteV(const TDesC8** aData, TInt aCount)
+/**
+This is a non-blocking synchronous method to write the contents of several
+descriptors to the pipe with a single call. As with Write(), either all of the
+data is written or, if there is not enough space in the pipe for it, none is.
+
+@param	aData		Array of descriptors holding the data to be written
+@param	aCount		Number of descriptors in aData, at most KPipeMaxIoVectors
+
+@return	>0					Amount of data written to the pipe, in bytes
+		0					All the descriptors were empty.
+		KErrArgument		aCount is not between 1 and KPipeMaxIoVectors.
+		KErrAccessDenied	An attempt has been made to write to a handle that
+							has been opened for reading.
+		KErrOverflow		There is not enough space in the pipe for all of
+							the data. No data was inserted into the pipe.
+		KErrBadHandle		An attempt has been made to write to a handle that
+							has not been opened.
+		KErrNotReady	    Read end is closed.
+							otherwise one of the other system wide error code.
+*/
+	{
+	if (!iHandle)
+		return KErrBadHandle;
+
+	if(aCount <= 0 || aCount > KPipeMaxIoVectors)
+		return KErrArgument;
+
+	if(iHandleType == EReadChannel)
+		return KErrAccessDenied;
+
+	return DoControl(EWriteV, (TAny*)aData, (TAny*)&aCount);
+	}
+
+
+EXPORT_C TInt RPipe::SpliceTo(RShBuf& aBuf, TInt aOffset, TInt aSize)
+/**
+This is a non-blocking synchronous method to move up to aSize bytes from the
+pipe into a shared buffer. It is a Read() into the calling thread's own mapping
+of the buffer, so the thread must be able to write to the buffer, and it saves
+nothing over Read() unless the buffer is then passed to a driver or server that
+takes shared buffers.
+
+The File Server does not take shared buffers, so writing the data to a file
+with RFile::Write() copies it again, as it would for any other descriptor.
+
+@param	aBuf		The shared buffer to receive data
+@param	aOffset		Offset in the buffer at which to put the data
+@param	aSize		Maximum number of bytes to move
+
+@return 	>0					Amount of data moved from the pipe, in bytes.
+			0					No Data is available
+			KErrArgument		The region is not within the buffer.
+			KErrAccessDenied	An attempt has been made to read from a handle 
+								has been opened for writing.
+			KErrBadHandle		The pipe or buffer handle has not been opened.
+			KErrNotReady	    Write end is closed and Pipe is empty.
+								otherwise one of the other system wide error code.
+*/
+	{
+	if (!iHandle || !aBuf.Handle())
+		return KErrBadHandle;
+
+	if(iHandleType != EReadChannel)
+		return KErrAccessDenied;
+
+	if(aOffset < 0 || aSize < 0 || (TUint)aOffset > aBuf.Size() || (TUint)aSize > aBuf.Size() - aOffset)
+		return KErrArgument;
+
+	TUint8* ptr = aBuf.Ptr();
+	if (!ptr)
+		return KErrNotReady;	// the buffer is not mapped into this process
+
+	TPtr8 data(ptr + aOffset, aSize);
+	return DoControl(ERead, (TAny*)&data, (TAny*)&aSize);
+	}
+
+
+EXPORT_C TInt RPipe::SpliceFrom(const RShBuf& aBuf, TInt aOffset, TInt aSize)
+/**
+This is a non-blocking synchronous method to move aSize bytes from a shared
+buffer into the pipe. As with Write(), either all of the data is written or, if
+there is not enough space in the pipe for it, none is.
+
+If the kernel has a mapping of the buffer, the data is copied from it, so the
+buffer need not be mapped into the calling process. The kernel has no mapping
+of a page aligned buffer unless it has opened the buffer's pool itself; in that
+case the data is written from the calling process's mapping of the buffer, as
+Write() would, and KErrNotSupported is returned if there is none.
+
+@param	aBuf		The shared buffer holding the data
+@param	aOffset		Offset of the data in the buffer
+@param	aSize		Number of bytes to move
+
+@return	>0					Amount of data written to the pipe, in bytes
+		KErrNone			aSize was zero.
+		KErrArgument		The region is not within the buffer.
+		KErrAccessDenied	An attempt has been made to write to a handle that
+							has been opened for reading.
+		KErrOverflow		There is not enough space in the pipe for the data.
+		KErrBadHandle		The pipe or buffer handle has not been opened.
+		KErrNotSupported	Neither the kernel nor the calling process has a
+							mapping of the buffer.
+		KErrNotReady	    Read end is closed.
+							otherwise one of the other system wide error code.
+*/
+	{
+	if (!iHandle || !aBuf.Handle())
+		return KErrBadHandle;
+
+	if(iHandleType == EReadChannel)
+		return KErrAccessDenied;
+
+	TSpliceInfo info;
+	info.iHandle = aBuf.Handle();
+	info.iOffset = aOffset;
+	info.iSize = aSize;
+	TInt r = DoControl(ESpliceFrom, (TAny*)&info);
+	if (r != KErrNotSupported)
+		return r;
+
+	// the kernel has no mapping of the buffer, so write from ours
+	RShBuf& buf = const_cast<RShBuf&>(aBuf);
+	if(aOffset < 0 || aSize < 0 || (TUint)aOffset > buf.Size() || (TUint)aSize > buf.Size() - aOffset)
+		return KErrArgument;
+	TUint8* ptr = buf.Ptr();
+	if (!ptr)
+		return KErrNotSupported;
+	if (aSize == 0)
+		return KErrNone;
+	TPtrC8 data(ptr + aOffset, aSize);
+	return DoControl(EWrite, (TAny*)&data, (TAny*)&aSize);
+	}
+
+
 EXPORT_C void RPipe::NotifyDataAvailable(TRequestStatus& aStatus)
 /**
 This method registers the request status object to be completed when data become
@@ -1597,8 +1597,10 @@ to be decided between the service requester and the service provider.
 */
 EXPORT_C void User::RequestComplete(TRequestStatus * &aStatus,TInt aReason)
 	{
+	TRequestStatus* status=aStatus;
 	*aStatus=KRequestPending;
 	RThread().RequestComplete(aStatus,aReason);
+	CActiveScheduler::RequestCompleted(status);
 	}
 
 
@@ -1757,6 +1757,37 @@ EXPORT_C void RMessagePtr2::Complete(TInt aReason) const
 
 
 
+EXPORT_C void RMessagePtr2::CompleteBatch(RMessagePtr2* aMessages, const TInt* aReasons, TInt aCount)
+/**
+Completes a number of messages with one executive call.
+
+This is equivalent to calling Complete() on each message in turn, but is
+cheaper for a server which has accepted several messages before replying,
+for example after handling a batch sent with RSessionBase::SendReceiveBatch().
+
+@param aMessages The messages to complete; each one is set to null.
+@param aReasons  The completion code for each message.
+@param aCount    The number of messages, at most KMaxIpcBatchMessages.
+
+@panic USER 70 if any of the messages is null or aCount is too large.
+@panic KERN-EXEC 44 if any of the messages is a disconnect message.
+*/
+	{
+	__ASSERT_ALWAYS(TUint(aCount)<=TUint(KMaxIpcBatchMessages),::Panic(ETMesCompletion));
+	TInt i;
+	for (i=0; i<aCount; ++i)
+		{
+		if (aMessages[i].IsNull())
+			::Panic(ETMesCompletion);
+		}
+	Exec::MessageCompleteBatch((const TInt*)aMessages,aReasons,aCount);
+	for (i=0; i<aCount; ++i)
+		aMessages[i].iHandle=0;
+	}
+
+
+
+
 /**
 Duplicates the specified handle in the client thread, and returns this
 handle as a message completion code
@@ -87,6 +87,58 @@ EXPORT_C void RSessionBase::DoSendReceive(TInt aFunction,const TIpcArgs* aArgs,T
 
 
 
+EXPORT_C TInt TIpcBatch::Add(TInt aFunction, const TIpcArgs& aArgs, TRequestStatus& aStatus)
+/**
+Adds a message to the batch.
+
+@param aFunction The opcode specifying the requested service.
+@param aArgs     The message arguments.
+@param aStatus   The request status to be completed when the server has
+                 finished with the message.
+
+@return KErrNone if the message was added;
+        KErrOverflow if the batch already holds KMaxMessages messages.
+
+@panic USER 72 if aFunction is negative.
+*/
+	{
+	if (TUint(aFunction)>TUint(KMaxTInt))
+		Panic(ETMesBadFunctionNumber);
+	if (iCount==KMaxMessages)
+		return KErrOverflow;
+	SIpcBatchItem& item=iItems[iCount++];
+	item.iFunction=aFunction;
+	item.iStatus=&aStatus;
+	item.iArgs=aArgs;
+	return KErrNone;
+	}
+
+
+
+EXPORT_C void RSessionBase::SendReceiveBatch(const TIpcBatch& aBatch) const
+/**
+Sends all the messages in a batch to the server with one executive call.
+
+Each message is handled as if it had been sent with the asynchronous
+SendReceive(), so each takes a message slot and each request status is
+completed separately, either by the server or with an error if the message
+could not be sent. The messages are delivered to the server in order, as
+they would be by separate calls; only the executive call per message is
+saved.
+
+Connect and disconnect messages can't be batched.
+
+@param aBatch The messages to send.
+*/
+	{
+	TInt i;
+	for (i=0; i<aBatch.iCount; ++i)
+		*aBatch.iItems[i].iStatus=KRequestPending;
+	Exec::SessionSendBatch(iHandle,aBatch.iItems,aBatch.iCount);
+	}
+
+
+
 TInt RSubSessionBase::DoCreateSubSession(RSessionBase& aSession,TInt aFunction,const TIpcArgs* aArgs, TBool aAutoClose)
 	{
 	TIpcArgs a;
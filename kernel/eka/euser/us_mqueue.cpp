@@ -386,3 +386,294 @@ Opens a message queue using the handle passed in during process creation.
 	{
 	return SetReturnedHandle(Exec::ProcessGetHandleParameter(aArgumentIndex, EMsgQueue, aType));
 	}
+
+
+
+
+TInt RSharedMsgQueueBase::MapRing(TInt aResult)
+//
+// Complete creating or opening a shared queue by finding its slot ring. The
+// kernel keeps the ring mapped for as long as the process has a handle to the
+// queue, so closing the handle is all that is needed to release it.
+//
+	{
+	TInt r = SetReturnedHandle(aResult);
+	if (r != KErrNone)
+		return r;
+	iRing = (SMsgQueueRing*)Exec::MsgQueueRing(iHandle);
+	if (!iRing)
+		{
+		Close();
+		return KErrNotSupported;
+		}
+	return KErrNone;
+	}
+
+
+
+
+EXPORT_C TInt RSharedMsgQueueBase::CreateLocal(TInt aSize, TInt aMsgLength, TOwnerType aType)
+/**
+Creates a shared message queue that is private to the current process,
+and opens a handle to it.
+
+@param aSize      The minimum number of message 'slots' in the queue.
+                  This must be a positive value, i.e. greater than zero.
+@param aMsgLength The size of each message for the queue, this cannot exceed
+                  KMaxLength.
+@param aType      The type of handle to be created.
+                  EOwnerProcess is the default value, if not explicitly specified.
+
+@return KErrNone if the queue is created sucessfully, otherwise one of
+        the other system wide error codes.
+
+@panic KERN-EXEC 49 if aSize is less than or equal to zero.
+@panic KERN-EXEC 48 if aMsgLength is not a multiple of 4 bytes,
+                    is less than 4, or is greater than KMaxLength.
+
+@see RMsgQueueBase::CreateLocal
+*/
+	{
+	return MapRing(Exec::MsgQueueCreateShared(NULL, aSize, aMsgLength, aType));
+	}
+
+
+
+
+EXPORT_C TInt RSharedMsgQueueBase::CreateGlobal(const TDesC& aName, TInt aSize, TInt aMsgLength, TOwnerType aType)
+/**
+Creates a global shared message queue, and opens a handle to it.
+
+The queue can be opened by other processes by name with OpenGlobal(), or,
+if the name is empty, by passing the handle as a process parameter or via IPC.
+
+@param aName      The name to be assigned to the message queue.
+@param aSize      The minimum number of message 'slots' in the queue.
+                  This must be a positive value, i.e. greater than zero.
+@param aMsgLength The size of each message for the queue, this cannot exceed
+                  KMaxLength.
+@param aType      The type of handle to be created.
+                  EOwnerProcess is the default value, if not explicitly specified.
+
+@return KErrNone if the queue is created sucessfully, otherwise one of
+        the other system wide error codes.
+
+@panic KERN-EXEC 49 if aSize is less than or equal to zero.
+@panic KERN-EXEC 48 if aMsgLength is not a multiple of 4 bytes,
+                    is less than 4, or is greater than KMaxLength.
+
+@see RMsgQueueBase::CreateGlobal
+*/
+	{
+	TInt r = User::ValidateName(aName);
+	if(KErrNone!=r)
+		return r;
+	TBuf8<KMaxKernelName> name8;
+	name8.Copy(aName);
+	return MapRing(Exec::MsgQueueCreateShared(&name8, aSize, aMsgLength, aType));
+	}
+
+
+
+
+EXPORT_C TInt RSharedMsgQueueBase::OpenGlobal(const TDesC& aName, TOwnerType aType)
+/**
+Opens a global shared message queue by name.
+
+@param aName The name of the message queue.
+@param aType The type of handle to be created.
+             EOwnerProcess is the default value, if not explicitly specified.
+
+@return KErrNone if queue opened sucessfully;
+        KErrNotSupported if the queue was not created as a shared queue;
+        otherwise one of the other system wide error codes.
+*/
+	{
+	TInt r = OpenByName(aName,aType,EMsgQueue);
+	return r==KErrNone ? MapRing(iHandle) : r;
+	}
+
+
+
+
+EXPORT_C TInt RSharedMsgQueueBase::Open(RMessagePtr2 aMessage, TInt aParam, TOwnerType aType)
+/**
+Opens a shared message queue using a handle passed in a server message.
+
+@param aMessage The server message.
+@param aParam   The number of the message parameter which holds the handle.
+@param aType    The type of handle to be created.
+		        EOwnerProcess is the default value, if not explicitly specified.
+
+@return KErrNone if queue opened sucessfully;
+        KErrNotSupported if the queue was not created as a shared queue;
+        otherwise one of the other system wide error codes.
+*/
+	{
+	return MapRing(Exec::MessageOpenObject(aMessage.Handle(),EMsgQueue,aParam,aType));
+	}
+
+
+
+
+EXPORT_C TInt RSharedMsgQueueBase::Open(TInt aArgumentIndex, TOwnerType aType)
+/**
+Opens a shared message queue using the handle passed in during process creation.
+
+@param aArgumentIndex The number on the parameter which holds the handle.
+@param aType          The type of handle to be created.
+                      EOwnerProcess is the default value, if not explicitly
+                      specified.
+
+@return KErrNone, if successful;
+		KErrArgument, if aArgumentIndex doesn't contain a message queue handle;
+		KErrNotFound, if aArgumentIndex is empty;
+        KErrNotSupported if the queue was not created as a shared queue.
+*/
+	{
+	return MapRing(Exec::ProcessGetHandleParameter(aArgumentIndex, EMsgQueue, aType));
+	}
+
+
+
+
+//realtime
+EXPORT_C TInt RSharedMsgQueueBase::Send(const TAny* aPtr, TInt aLength)
+/**
+Sends a message through this queue.
+
+The function does not wait (i.e. block), if the queue is full. It only
+enters the kernel if a thread is waiting for data to become available.
+
+@param aPtr    A pointer to the message data
+@param aLength The length of the message data, this must not exceed
+               the queue's message size.
+
+@return  KErrNone, if successful;
+         KErrOverflow, if queue is full,
+
+@panic KERN-EXEC 48 if aLength is greater than the message length specified
+       when the queue was created, or if aLength is less than or equal to zero.
+*/
+	{
+	SMsgQueueRing* ring = iRing;
+	if (TUint(aLength-1) >= ring->iMsgLength)
+		return Exec::MsgQueueSend(iHandle, aPtr, aLength);	// panics the caller
+
+	// claim the slot at the head of the ring, racing with any other senders
+	TUint32 pos = ring->iHead;
+	TUint32* slot;
+	FOREVER
+		{
+		slot = ring->Slot(pos);
+		TInt diff = TInt(__e32_atomic_load_acq32(slot) - pos);
+		if (diff == 0)
+			{
+			if (__e32_atomic_cas_rlx32(&ring->iHead, &pos, pos+1))
+				break;
+			}
+		else if (diff < 0)
+			return KErrOverflow;	// slot still holds an unread message
+		else
+			pos = ring->iHead;		// another sender claimed it first
+		}
+	memcpy(slot+1, aPtr, aLength);
+	__e32_atomic_store_ord32(slot, pos+1);
+	if (ring->iWaiters & SMsgQueueRing::EDataWaiter)
+		Exec::MsgQueueSignal(iHandle, SMsgQueueRing::EDataWaiter);
+	return KErrNone;
+	}
+
+
+
+
+EXPORT_C void RSharedMsgQueueBase::SendBlocking(const TAny* aPtr, TInt aLength)
+/**
+Sends a message through this queue, and waits for space to become available
+if the queue is full.
+
+As with RMsgQueueBase::SendBlocking(), only one thread at a time may wait
+for space to become available.
+
+@param aPtr    A pointer to the message data.
+@param aLength The length of the message data, this must not exceed
+               the queue's message size.
+
+@panic KERN-EXEC 48 if aLength is greater than the message length specified
+       when the queue was created, or if aLength is less than or equal to zero.
+@panic KERN-EXEC 47 if another thread is already waiting for space.
+*/
+	{
+	TRequestStatus stat;
+	while (Send(aPtr, aLength) == KErrOverflow)
+		{
+		stat = KRequestPending;
+		Exec::MsgQueueNotifySpaceAvailable(iHandle, stat);
+		User::WaitForRequest(stat);
+		}
+	}
+
+
+
+
+//realtime
+EXPORT_C TInt RSharedMsgQueueBase::Receive(TAny* aPtr, TInt aLength)
+/**
+Retrieves the first message in the queue.
+
+The function does not wait (i.e. block), if the queue is empty. It only
+enters the kernel if a thread is waiting for space to become available.
+
+Only one thread at a time may receive from a shared queue.
+
+@param aPtr    A pointer to a buffer to receive the message data.
+@param aLength The length of the buffer for the message, this must match
+               the queue's message size.
+
+@return KErrNone, ifsuccessful;
+        KErrUnderflow, if the queue is empty.
+
+@panic KERN-EXEC 48 if aLength is not equal to the message length
+       specified when the queue was created.
+*/
+	{
+	SMsgQueueRing* ring = iRing;
+	if (TUint(aLength) != ring->iMsgLength)
+		return Exec::MsgQueueReceive(iHandle, aPtr, aLength);	// panics the caller
+
+	TUint32 pos = ring->iTail;
+	TUint32* slot = ring->Slot(pos);
+	if (__e32_atomic_load_acq32(slot) != pos+1)
+		return KErrUnderflow;
+	memcpy(aPtr, slot+1, aLength);
+	ring->iTail = pos+1;
+	__e32_atomic_store_ord32(slot, pos+ring->iSlotCount);
+	if (ring->iWaiters & SMsgQueueRing::ESpaceWaiter)
+		Exec::MsgQueueSignal(iHandle, SMsgQueueRing::ESpaceWaiter);
+	return KErrNone;
+	}
+
+
+
+
+EXPORT_C void RSharedMsgQueueBase::ReceiveBlocking(TAny* aPtr, TInt aLength)
+/**
+Retrieves the first message in the queue, and waits if the queue is empty.
+
+@param aPtr    A pointer to a buffer to receive the message data.
+@param aLength The length of the buffer for the message, this must match
+               the queue's message size.
+
+@panic KERN-EXEC 48 if aLength is not equal to the message length
+       specified when the queue was created.
+*/
+	{
+	TRequestStatus stat;
+	while (Receive(aPtr, aLength) == KErrUnderflow)
+		{
+		stat = KRequestPending;
+		Exec::MsgQueueNotifyDataAvailable(iHandle, stat);
+		User::WaitForRequest(stat);
+		}
+	}
+
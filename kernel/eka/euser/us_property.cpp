@@ -752,3 +752,140 @@ EXPORT_C TInt RProperty::Set(const TDesC16& aDes)
 	{
 	return(Exec::PropertySetB(iHandle, (TUint8*) aDes.Ptr(), aDes.Size()));
 	}
+
+
+
+
+/**
+Adds an integer value to the batch.
+
+The value is published when Commit() is called.
+
+@param aCategory The UID that identifies the property category.
+@param aKey      The property sub-key, i.e. the key that identifies the
+                 specific property within the category.
+@param aValue    The new property value. 
+
+@return KErrNone, if successful;
+        KErrOverflow, if the batch already holds KMaxItems values.
+*/
+EXPORT_C TInt TPropertyBatch::Set(TUid aCategory, TUint aKey, TInt aValue)
+	{
+	if (iCount >= KMaxItems)
+		return KErrOverflow;
+	SPropertyBatchItem& item = iItems[iCount++];
+	item.iCategory = TUint(aCategory.iUid);
+	item.iKey = aKey;
+	item.iSize = -1;
+	item.iValue = aValue;
+	item.iBuf = NULL;
+	return KErrNone;
+	}
+
+
+
+
+/**
+Adds a byte-array (binary) value to the batch.
+
+The value is published when Commit() is called. The descriptor is not
+copied, so it must remain valid until then.
+
+@param aCategory The UID that identifies the property category.
+@param aKey      The property sub-key, i.e. the key that identifies the
+                 specific property within the category.
+@param aDes      A reference to the descriptor containing the
+                 new property value.
+
+@return KErrNone, if successful;
+        KErrOverflow, if the batch already holds KMaxItems values;
+        KErrTooBig, if the value is larger than RProperty::KMaxPropertySize.
+*/
+EXPORT_C TInt TPropertyBatch::Set(TUid aCategory, TUint aKey, const TDesC8& aDes)
+	{
+	if (aDes.Size() > RProperty::KMaxPropertySize)
+		return KErrTooBig;
+	if (iCount >= KMaxItems)
+		return KErrOverflow;
+	SPropertyBatchItem& item = iItems[iCount++];
+	item.iCategory = TUint(aCategory.iUid);
+	item.iKey = aKey;
+	item.iSize = aDes.Size();
+	item.iValue = 0;
+	item.iBuf = aDes.Ptr();
+	return KErrNone;
+	}
+
+
+
+
+/**
+Adds a text value to the batch.
+
+The value is published when Commit() is called. The descriptor is not
+copied, so it must remain valid until then.
+
+@param aCategory The UID that identifies the property category.
+@param aKey      The property sub-key, i.e. the key that identifies the
+                 specific property within the category.
+@param aDes      A reference to the descriptor containing the
+                 new property value.
+
+@return KErrNone, if successful;
+        KErrOverflow, if the batch already holds KMaxItems values;
+        KErrTooBig, if the value is larger than RProperty::KMaxPropertySize.
+*/
+EXPORT_C TInt TPropertyBatch::Set(TUid aCategory, TUint aKey, const TDesC16& aDes)
+	{
+	if (aDes.Size() > RProperty::KMaxPropertySize)
+		return KErrTooBig;
+	if (iCount >= KMaxItems)
+		return KErrOverflow;
+	SPropertyBatchItem& item = iItems[iCount++];
+	item.iCategory = TUint(aCategory.iUid);
+	item.iKey = aKey;
+	item.iSize = aDes.Size();
+	item.iValue = 0;
+	item.iBuf = (const TUint8*) aDes.Ptr();
+	return KErrNone;
+	}
+
+
+
+
+/**
+Publishes all the values in the batch.
+
+Every property is checked before any value is published, and if any check
+fails no property is changed. Otherwise all the values are published
+together, and each pending subscription to any of the properties is
+completed once.
+
+If the same property is set more than once in the batch, the last value is
+the one published.
+
+Whether or not the commit succeeds, the batch is emptied.
+
+The Platform Security attributes of the current process are checked against
+the Write Policy of each property. If a check fails the action taken is
+determined by the system wide Platform Security configuration, as for
+RProperty::Set().
+
+@return KErrNone, if successful;
+        KErrPermissionDenied, if the caller process doesn't pass the Write Policy
+                              of one of the properties;
+		KErrNotFound, if one of the properties has not been defined;
+		KErrArgument, if a value doesn't match the type of its property;
+        KErrNoMemory, if memory allocation is required, and there is
+                      insufficient available.
+
+@see RProperty::Set()
+*/
+EXPORT_C TInt TPropertyBatch::Commit()
+	{
+	TInt count = iCount;
+	iCount = 0;
+	if (count == 0)
+		return KErrNone;
+	return(Exec::PropertySetMany(iItems, count));
+	}
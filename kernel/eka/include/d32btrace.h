@@ -265,6 +265,22 @@ public:
 	*/
 	IMPORT_C TBool SetTimestamp2Enabled(TBool aEnable);
 
+	/**
+	Select per-CPU buffer mode, in which each CPU writes trace records to a ring of its
+	own without taking a lock shared with the other CPUs. The driver merges the rings
+	into the trace buffer in timestamp order, so GetData() and RequestData() are used
+	exactly as before, but records may reach the trace buffer a few milliseconds after
+	they were generated.
+
+	ResizeBuffer() returns the driver to single buffer mode.
+
+	@param aSize The size in bytes of each CPU's ring, or zero to return to single buffer mode.
+	@return KErrNone if successful,
+			KErrNotSupported if the kernel is not an SMP kernel,
+			otherwise one of the other system wide error codes.
+	*/
+	IMPORT_C TInt SetPerCpuBuffers(TInt aSize);
+
 #endif
 
 	/**
@@ -293,6 +309,7 @@ private:
 		ECancelRequestData,
 		ESetSerialPortOutput,
 		ESetTimestamp2Enabled,
+		ESetPerCpuBuffers,
 		};
 #ifndef __KERNEL_MODE__
 	RChunk iDataChunk;
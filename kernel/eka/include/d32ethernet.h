@@ -26,6 +26,9 @@
 #define __D32ETHERNET_H__
 #include <e32cmn.h>
 #include <e32ver.h>
+#ifndef __KLIB_H__
+#include <e32shbuf.h>
+#endif
 
 
 /** @addtogroup enet Ethernet Drivers
@@ -108,6 +111,111 @@ class TEthernetCapsV01
     };
 typedef TPckgBuf<TEthernetCapsV01> TEthernetCaps;
 
+/** Number of frame descriptors in each ring of a channel in batch mode */
+const TInt KEthernetRingSlots = 64;
+
+/** Size of the buffer holding each frame of a channel in batch mode */
+const TInt KEthernetFrameBufferSize = 2048;
+
+/**
+ * A frame descriptor in a ring shared between a client and the driver
+ * @see TEthernetRing
+ */
+class TEthernetSlot
+    {
+    public:
+    /**
+     * Offset of the frame from the start of the TEthernetRings in the
+     * transmit ring, or from the start of the receive frames buffer in the
+     * receive ring. Set by the driver.
+     */
+    TInt32 iOffset;
+    /**
+     * Length of the frame in bytes
+     */
+    TUint16 iLength;
+    /**
+     * KErrNone, or the error with which the driver failed to send the frame
+     */
+    TInt16 iStatus;
+    };
+
+/**
+ * A ring of frame descriptors with a single producer and a single consumer.
+ * The producer fills in the slot at iHead%KEthernetRingSlots and then
+ * increments iHead; the consumer finishes with the slot at
+ * iTail%KEthernetRingSlots and then increments iTail.  Only the producer
+ * writes iHead and only the consumer writes iTail.
+ */
+class TEthernetRing
+    {
+    public:
+    /**
+     * Count of frames added to the ring
+     */
+    TUint32 iHead;
+    /**
+     * Count of frames removed from the ring
+     */
+    TUint32 iTail;
+    /**
+     * The frame descriptors
+     */
+    TEthernetSlot iSlots[KEthernetRingSlots];
+    };
+
+/**
+ * The rings of a channel in batch mode, which are held in a buffer of the
+ * channel's shared buffer pool
+ */
+class TEthernetRings
+    {
+    public:
+    /**
+     * Frames received. The driver produces and the client consumes.
+     */
+    TEthernetRing iRx;
+    /**
+     * Frames to send. The client produces and the driver consumes.
+     */
+    TEthernetRing iTx;
+    };
+
+/**
+ * The parameters for starting batch mode on a channel
+ */
+class TEthernetBatchV01
+    {
+    public:
+    /**
+     * A ReceiveBatch() request completes once this many frames are waiting...
+     */
+    TInt iRxCoalesceFrames;
+    /**
+     * ...or this many microseconds after the first frame arrives, if sooner
+     */
+    TInt iRxCoalesceTime;
+    /**
+     * Returns the handle of the shared buffer pool
+     */
+    TInt iPoolHandle;
+    /**
+     * Returns the handle of the buffer holding the TEthernetRings
+     */
+    TInt iRingsHandle;
+    /**
+     * Returns the handle of the shared buffer pool holding the received
+     * frames, which is mapped read-only in the client
+     */
+    TInt iRxPoolHandle;
+    /**
+     * Returns the handle of the first buffer of the receive pool, from
+     * which the offsets in the receive ring are measured
+     */
+    TInt iRxFramesHandle;
+    };
+typedef TPckgBuf<TEthernetBatchV01> TEthernetBatch;
+
 /**
  * The Ethernet device capibility class
  */
@@ -170,7 +278,9 @@ class RBusDevEthernet : public RBusLogicalChannel
 	ERequestRead=0x0,         /**< Read request */
         ERequestReadCancel=0x1,   /**< Cancel read request */
 	ERequestWrite=0x1,        /**< Write request */
-        ERequestWriteCancel=0x2   /**< Cancel write request */
+        ERequestWriteCancel=0x2,  /**< Cancel write request */
+        ERequestReceiveBatch=0x4, /**< Wait for frames in batch mode */
+        ERequestReceiveBatchCancel=0x4 /**< Cancel wait for frames */
 #ifdef ETH_CHIP_IO_ENABLED
     ,EChipDiagIOCtrl=0x3
 #endif
@@ -184,7 +294,9 @@ class RBusDevEthernet : public RBusLogicalChannel
 	EControlConfig,    /**< Get the current configuration */
         EControlSetConfig, /**< Set the current configuration */
         EControlSetMac,    /**< Set the MAC address */
-        EControlCaps       /**< Get ethernet capibilites */
+        EControlCaps,      /**< Get ethernet capibilites */
+        EControlStartBatch, /**< Start batch mode */
+        EControlSendBatch  /**< Send the frames in the transmit ring */
 	};
 
     public:
@@ -257,6 +369,37 @@ class RBusDevEthernet : public RBusLogicalChannel
      * @param aCaps Buffer to contain the capibilites object
      */
     inline void Caps(TDes8 &aCaps);
+
+    /**
+     * Put the channel into batch mode.
+     * In batch mode frames are passed in rings held in a shared buffer
+     * pool, and many frames are received or sent with each call, rather
+     * than one with each request. Received frames are written straight
+     * into a second pool, which the client can read but not write.
+     * Read() and Write() are not supported in batch mode.
+     * @param aBatch Buffer containing the batch parameters, which also
+     * returns the handles
+     * @param aPool Set to the channel's shared buffer pool
+     * @param aRings Set to the buffer holding the TEthernetRings
+     * @param aRxPool Set to the read-only pool the driver receives into
+     * @param aRxFrames Set to the first buffer of aRxPool
+     * @return KErrNone if batch mode started
+     */
+    inline TInt StartBatch(TEthernetBatch &aBatch, RShPool &aPool, RShBuf &aRings, RShPool &aRxPool, RShBuf &aRxFrames);
+    /**
+     * Wait for frames to arrive in the receive ring in batch mode
+     * @param aStatus The callback status
+     */
+    inline void ReceiveBatch(TRequestStatus &aStatus);
+    /**
+     * Cancel a pending wait for frames
+     */
+    inline void ReceiveBatchCancel();
+    /**
+     * Send the frames added to the transmit ring in batch mode
+     * @return The number of frames sent, or an error
+     */
+    inline TInt SendBatch();
     
 #ifdef ETH_CHIP_IO_ENABLED    
     inline void ChipIOCtrl(TRequestStatus &aStatus,TPckgBuf<TChipIOInfo> &aDes);
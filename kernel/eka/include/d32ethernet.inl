@@ -63,6 +63,28 @@ inline TInt RBusDevEthernet::SetMAC(const TDesC8 &aConfig)
 inline void RBusDevEthernet::Caps(TDes8 &aCaps)
 	{DoControl(EControlCaps,&aCaps);}
 
+inline TInt RBusDevEthernet::StartBatch(TEthernetBatch &aBatch, RShPool &aPool, RShBuf &aRings, RShPool &aRxPool, RShBuf &aRxFrames)
+	{
+	TInt r=DoControl(EControlStartBatch,&aBatch);
+	if (r==KErrNone)
+		{
+		aPool.SetReturnedHandle(aBatch().iPoolHandle);
+		aRings.SetReturnedHandle(aBatch().iRingsHandle);
+		aRxPool.SetReturnedHandle(aBatch().iRxPoolHandle);
+		aRxFrames.SetReturnedHandle(aBatch().iRxFramesHandle);
+		}
+	return r;
+	}
+
+inline void RBusDevEthernet::ReceiveBatch(TRequestStatus &aStatus)
+	{DoRequest(ERequestReceiveBatch,aStatus);}
+
+inline void RBusDevEthernet::ReceiveBatchCancel()
+	{DoCancel(ERequestReceiveBatchCancel);}
+
+inline TInt RBusDevEthernet::SendBatch()
+	{return(DoControl(EControlSendBatch));}
+
 #ifdef ETH_CHIP_IO_ENABLED
 inline void RBusDevEthernet::ChipIOCtrl(TRequestStatus &aStatus,TPckgBuf<TChipIOInfo> &aDes)
     {DoRequest(EChipDiagIOCtrl,aStatus,(TAny *)&aDes);}
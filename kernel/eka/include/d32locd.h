@@ -323,12 +323,21 @@ public:
 	driver's Caps() function.
 	*/
     TUint 	iBlockSize;
+
+	/**
+	The number of requests the media driver can usefully have in progress at once,
+	for example on media with a command queue, or zero if it services one request
+	at a time.
+	For paging media this sets how many page-in requests the kernel will issue
+	to the media concurrently.
+	*/
+	TUint32	iMaxConcurrentRequests;
     
 private:
     /**
     Reserved space for future use.
     */
-    TUint32	iSpare[4];
+    TUint32	iSpare[3];
 	};
 typedef TPckgBuf<TLocalDriveCapsV6> TLocalDriveCapsV6Buf;
 
@@ -511,6 +520,41 @@ public:
 	};
 typedef TPckgBuf<TPageDeviceInfo> TPageDeviceInfoBuf;
 
+/**
+Local media I/O scheduler settings and statistics - for testing purposes only.
+This is a structure used to read the per-media request statistics gathered
+by the local media subsystem and to change its scheduling window.
+
+The counts cover every request made on any of the drives on the media.
+The scheduler counts only change for media which have their own DFC queue, as
+requests for other media are passed straight through to the media driver.
+
+@see RLocalDrive::EQueryIoSchedulerInfo
+
+@internalTechnology
+@prototype
+*/
+class TLocalDriveIoSchedulerInfo
+	{
+public:
+	enum {ENoChange=-1};
+public:
+	TInt	iWindow;			// in: new scheduling window, 0 or 1 for arrival order, or ENoChange; out: current window
+	TBool	iReset;				// in: reset the counts after reading them
+	TUint32	iReadCount;			// number of read requests, including paging reads
+	TUint32	iWriteCount;		// number of write requests, including paging writes
+	TUint32	iOtherCount;		// number of other requests
+	TInt	iMaxInFlight;		// maximum number of requests in progress at once
+	TUint32	iBatchCount;		// number of batches of requests scheduled together
+	TUint32	iScheduledCount;	// number of requests scheduled in a batch with others
+	TInt	iMaxBatch;			// largest number of requests scheduled together
+	TUint32	iReorderedCount;	// number of requests dispatched ahead of an earlier request
+	TUint32	iSequentialCount;	// number of requests dispatched straight after a contiguous request of the same kind
+	TUint32	iPromotedCount;		// number of paging reads dispatched ahead of other requests
+	TBool	iBatching;			// out: requests on this media can be batched, i.e. it has its own DFC queue and isn't paging
+	};
+typedef TPckgBuf<TLocalDriveIoSchedulerInfo> TLocalDriveIoSchedulerInfoBuf;
+
 class TLocalDriveFinaliseInfo
 /**
 @internalTechnology
@@ -588,6 +632,7 @@ public:
 		EQueryFinaliseDrive					= EQuerySymbianPublishedPartnerFirst + 0,	// @internalTechnology
 
 		EQueryPageDeviceInfo = EQuerySymbianTestFirst,	/**< @see TPageDeviceInfo */
+		EQueryIoSchedulerInfo = EQuerySymbianTestFirst+1,	/**< @see TLocalDriveIoSchedulerInfo */
 		
 		// NFE test driver
 		EQuerySymbianNfeTestFirst = EQuerySymbianTestFirst+0x10,
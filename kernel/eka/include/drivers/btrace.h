@@ -15,6 +15,26 @@
 
 #include <d32btrace.h>
 
+#ifdef __SMP__
+/**
+Trace ring owned by one CPU in per-CPU buffer mode.
+
+Only the owning CPU writes records, with interrupts disabled, and only
+TBTraceBufferK::Drain() removes them, so neither side needs a lock.
+Indices are free running word counts.
+*/
+class TBTraceCpuRing
+	{
+public:
+	TUint32*			iData;
+	TUint				iMask;			// ring size in words, less one
+	volatile TUint		iHead;			// written only by the owning CPU
+	volatile TUint		iTail;			// written only by Drain()
+	TUint				iDropped;		// written only by the owning CPU
+	TUint32				iPadding[11];	// keep each ring in its own cache line
+	};
+#endif
+
 class TBTraceBufferK
 	{
 public:
@@ -31,6 +51,12 @@ public:
 	BTrace::TControlFunction	iOldBTraceControl;
 	TBool				iTimestamp2Enabled;
 	TUint				iCrashReadPart;
+#ifdef __SMP__
+	TBTraceCpuRing* volatile	iCpuRings;	// non-null in per-CPU buffer mode
+	TInt				iCpuRingCount;
+	TDfc*				iDrainDfc;
+	NTimer*				iDrainTimer;
+#endif
 public:
 	TInt Create(TInt aSize);
 	void Close();
@@ -40,7 +66,19 @@ public:
 	static TBool TraceWithTimestamp2(TUint32 aHeader,TUint32 aHeader2,const TUint32 aContext,const TUint32 a1,const TUint32 a2,const TUint32 a3,const TUint32 aExtra,const TUint32 aPc);	
 	static TInt ControlFunction(BTrace::TControl aFunction, TAny* aArg1, TAny* aArg2);
 	void CrashRead(TUint8*& aData, TUint& aSize);
+#ifdef __SMP__
+	TInt SetPerCpu(TInt aSize);
+	void Drain();
+	void StartDrainTimer();
+#endif
 private:
+	void CrashReadPart(TUint aPart, TUint8*& aData, TUint& aSize);
+#ifdef __SMP__
+	void Append(const TUint32* aRecord, TUint aWords);
+	static TBool TraceCpu(TUint32 aHeader,TUint32 aHeader2,const TUint64 aTimestamp,const TUint32 aContext,const TUint32 a1,const TUint32 a2,const TUint32 a3,const TUint32 aExtra,const TUint32 aPc);
+	static void DrainDfcFn(TAny* aPtr);
+	static void DrainTimerFn(TAny* aPtr);
+#endif
 	static TBool Trace_Impl(TUint32 aHeader,TUint32 aHeader2,const TUint32 aContext,const TUint32 a1,const TUint32 a2,const TUint32 a3,const TUint32 aExtra, const TUint32 aPc, const TBool aIncTimestamp2);
 	};
 
@@ -171,6 +171,12 @@ private:
     TInt Read (TAny* aBuff, TInt aSize);
 
     TInt Write (TAny* aBuff, TInt aSize);
+
+    TInt ReadV (TAny* aBuffs, TInt aCount);
+
+    TInt WriteV (TAny* aBuffs, TInt aCount);
+
+    TInt SpliceFrom (TAny* aInfo);
     
     TInt Size();
 
@@ -250,6 +256,15 @@ public:
 
 	// Read to Buffer
 	TInt Read(TAny* aBuf, TInt aSize);
+
+	// Write several client descriptors to Buffer
+	TInt WriteV(const TDesC8* const* aBufs, const TInt* aSizes, TInt aCount);
+
+	// Read from Buffer to several client descriptors
+	TInt ReadV(TDes8* const* aBufs, const TInt* aMaxSizes, TInt aCount);
+
+	// Write kernel memory to Buffer
+	TInt SpliceFrom(const TUint8* aData, TInt aSize);
 	
 	void SetReadEnd(DPipeChannel * aChannel);
 	
@@ -314,6 +329,14 @@ private:
 
 	void MaybeCompleteSpaceNotification();
 
+	TInt CopyFromClient(const TDesC8* aBuf, TInt aPos, TInt aSize);
+
+	TInt CopyToClient(TDes8* aBuf, TInt aPos, TInt aSize);
+
+	void WriteDone(TInt aSize);
+
+	void ReadDone(TInt aSize);
+
 	inline DMutex& Mutex()
 		{
 		return *iPipeMutex;
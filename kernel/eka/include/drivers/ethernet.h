@@ -277,6 +277,10 @@ class DChannelEthernetFIFO
      * Move on to the next full buffer
      */
     void SetNext();
+    /**
+     * @return ETrue if no full buffers are waiting
+     */
+    inline TBool IsEmpty() const;
 
     private:
     /**
@@ -323,6 +327,7 @@ class DChannelEthernet : public DLogicalChannel
         {
         ERx=1,      /**< Receive a frame */
         ETx=2,      /**< Transmit a frame */
+        EBatch=4,   /**< Wait for frames in batch mode */
         EAll=0xff   /**< Complete/cancel all outstanding requests */
         };
 
@@ -488,6 +493,48 @@ class DChannelEthernet : public DLogicalChannel
      * @param aPtr A pointer to the channel object
      */
     static void CompleteRxDfc(TAny* aPtr);
+    /**
+     * The DFC called when the receive coalescing time has passed
+     * @param aPtr A pointer to the channel object
+     */
+    static void CoalesceDfc(TAny* aPtr);
+
+    /**
+     * Create the shared buffer pool and rings and put the channel in batch mode
+     * @param aBatch The batch parameters, which also returns the handles
+     * @return KErrNone if batch mode started
+     */
+    TInt StartBatch(TEthernetBatchV01& aBatch);
+    /**
+     * Leave batch mode and release the shared buffer pool
+     */
+    void StopBatch();
+    /**
+     * Send the frames in the transmit ring
+     * @return The number of frames sent, or an error
+     */
+    TInt SendBatch();
+    /**
+     * Find the receive ring slot for the next frame. Called with the PDD's
+     * interrupts disabled.
+     * @return The slot, or KErrNotFound if the ring is full
+     */
+    TInt FreeRxSlot();
+    /**
+     * Move frames from the receive FIFO into the receive ring, and pass
+     * the client the frames received into the ring
+     */
+    void FillRxRing();
+    /**
+     * @return The number of frames in the receive ring the client hasn't
+     * taken, or 0 if the client's tail is not in the ring
+     */
+    TInt RxWaiting();
+    /**
+     * Complete a ReceiveBatch() request, or start the coalescing timer,
+     * according to the number of frames waiting in the receive ring
+     */
+    void CheckRxBatch();
 
     /**
      * Start a read request
@@ -557,6 +604,54 @@ class DChannelEthernet : public DLogicalChannel
 	//Write request to store user request status for WDP
 	TClientRequest* iWriteRequest;
 
+    /**
+     * The ReceiveBatch() request
+     */
+	TClientRequest* iBatchRequest;
+    /**
+     * The shared buffer pool holding the rings and the frames to send, or
+     * NULL if the channel is not in batch mode
+     */
+    TShPool* iPool;
+    /**
+     * The shared buffer pool holding the received frames, which the client
+     * can only read
+     */
+    TShPool* iRxPool;
+    /**
+     * The buffer holding the rings, and its kernel address. The address is
+     * only set while the receive ring is ready for use from ReceiveIsr().
+     */
+    TShBuf* iRingsBuf;
+    TEthernetRings* iRings;
+    /**
+     * The buffers holding the frames in the receive and transmit rings, the
+     * descriptors the PDD receives into and the kernel addresses of the
+     * frames to send
+     */
+    TShBuf* iFrameBufs[2*KEthernetRingSlots];
+    TBuf8<KMaxEthernetPacket+32>* iRxBufs[KEthernetRingSlots];
+    TUint8* iTxFrames[KEthernetRingSlots];
+    /**
+     * The driver's copies of the counts it produces, so that nothing the
+     * client writes to the rings can make it overrun them. iRxFill counts
+     * the frames received into the ring and iRxHead those passed to the
+     * client.
+     */
+    TUint32 iRxFill;
+    TUint32 iRxHead;
+    TUint32 iTxTail;
+    /**
+     * The receive coalescing thresholds
+     */
+    TInt iRxCoalesceFrames;
+    TInt iRxCoalesceTicks;
+    /**
+     * Times receive coalescing, and the DFC it queues
+     */
+    NTimer iCoalesceTimer;
+    TDfc iCoalesceDfc;
+
 #ifdef ETH_CHIP_IO_ENABLED
 	TPckgBuf<TChipIOInfo> iChipInfo;
 #endif
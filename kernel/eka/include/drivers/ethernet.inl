@@ -26,6 +26,9 @@
 inline void DEthernet::ReceiveIsr()
 	{ iLdd->ReceiveIsr(); }
 
+inline TBool DChannelEthernetFIFO::IsEmpty() const
+	{ return iNumFree == KNumRXBuffers; }
+
 inline TInt DChannelEthernet::DisableIrqs()
 	{ return ((DEthernet*)iPdd)->DisableIrqs(); }
 
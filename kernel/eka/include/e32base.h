@@ -2832,6 +2832,7 @@ public:
 	IMPORT_C virtual void Error(TInt aError) const;
 	IMPORT_C void Halt(TInt aExitCode) const;
 	IMPORT_C TInt StackDepth() const;
+	IMPORT_C void EnableReadyQueueL();
 private:
 	class TCleanupBundle
 	{
@@ -2846,7 +2847,18 @@ private:
 	IMPORT_C virtual void Reserved_1();
 	IMPORT_C virtual void Reserved_2();
 	void Run(TLoopOwner* const volatile& aLoop);
+	void DispatchL(TLoopOwner* const volatile& aLoop, CActive* volatile & aCurrentObj, TCleanupBundle* aCleanupBundle);
 	void DoRunL(TLoopOwner* const volatile& aLoop, CActive* volatile & aCurrentObj, TCleanupBundle* aCleanupBundle);
+	void DoRunReadyL(TLoopOwner* const volatile& aLoop, CActive* volatile & aCurrentObj, TCleanupBundle* aCleanupBundle);
+	struct TReadyQueue;
+	void AddReady(CActive* aActive);
+	CActive* TakeReady(TInt aCompleted);
+	void RemoveReady(CActive* aActive);
+	void ClearReady();
+	static void ForgetReady(CActive* aActive);
+	static void RequestCompleted(TRequestStatus* aStatus);
+	friend class CActive;
+	friend class User;
 protected:
 	IMPORT_C virtual TInt Extension_(TUint aExtensionId, TAny*& a0, TAny* a1);
 protected:
@@ -2854,7 +2866,7 @@ protected:
 private:
 	TLoop* iStack;
 	TPriQue<CActive> iActiveQ;
-	TAny* iSpare;
+	TAny* iSpare;					// TReadyQueue, once enabled
 	};
 
 
@@ -2891,6 +2903,71 @@ private:
 
 
 
+class CActiveSchedulerPool : public CBase
+/**
+@publishedAll
+@released
+
+A pool of threads, each running its own active scheduler, on which work posted
+from any thread in the process is run.
+
+Work is posted as a callback function, either to an affinity group or to the
+pool as a whole.  All the work posted to a group, and all the active objects
+created by that work, run in a single worker thread, so they are serialised
+with respect to each other and need no locking between themselves.  Each group
+stays with its worker for its lifetime, because an asynchronous request is
+always completed to the thread which made it.
+
+Work posted with EAnyGroup goes to the least busy worker.  A worker which runs
+out of work of its own takes such work from the queues of the other workers,
+so a long-running callback or RunL() in one group doesn't hold up work which
+could run elsewhere.
+
+Posted work runs at a lower priority than the standard priority, so active
+objects of standard priority or above in a worker run ahead of work queued to it.
+
+A server can, for instance, open a group for each session and post the handling
+of each message to the session's group, so that different sessions are serviced
+on different CPUs.  CServer2 has no mode which does this itself: ServiceL() is
+always called in the server's own thread, which must post the work.  The message
+may then be completed from the worker thread, since any thread in the server's
+process may complete it.
+
+All the threads in the pool share the heap of the thread which created it.
+
+@see CActiveScheduler
+@see TCallBack
+*/
+	{
+public:
+	/** The group used to post work which may run on any worker. */
+	enum {EAnyGroup=0};
+public:
+	IMPORT_C static CActiveSchedulerPool* NewL(TInt aThreads);
+	IMPORT_C ~CActiveSchedulerPool();
+	IMPORT_C TInt OpenGroup();
+	IMPORT_C void CloseGroup(TInt aGroup);
+	IMPORT_C TInt Post(TInt aGroup, const TCallBack& aCallBack);
+	IMPORT_C TInt Count() const;
+private:
+	CActiveSchedulerPool();
+	void ConstructL(TInt aThreads);
+	struct TTask;
+	struct TWorker;
+	class CInbox;
+	static TInt WorkerThread(TAny* aWorker);
+	static void Queue(TWorker& aWorker, TTask* aTask);
+	TTask* Steal(TWorker& aThief);
+private:
+	TWorker* iWorkers;
+	TInt iSize;
+	TInt iCount;
+	RFastLock iGroupLock;
+	};
+
+
+
+
 class CleanupStack
 /**
 @publishedAll
@@ -568,6 +568,13 @@ public:
 		*/
 		ENKern = 27,
 
+		/**
+		Trace generated by the loader while loading executables and their dependencies.
+		@see TLoader
+		@prototype 9.6
+		*/
+		ELoader = 28,
+
 		/**
 		First category value in the range reserved for platform specific use;
 		the end of this range is #EPlatformSpecificLast.
@@ -3508,6 +3515,39 @@ public:
 		ELbDone = 0,
 		};
 
+	/**
+	Enumeration of sub-category values for trace category ELoader.
+	Times are in User::FastCounter() ticks.
+	@see ELoader
+	@prototype 9.6
+	*/
+	enum TLoader
+		{
+		/**
+		Trace output for each executable or DLL loaded into RAM as part of a load,
+		when its dependencies have been fixed up.
+		Trace data format:
+		- 4 bytes containing the kernel's handle for the code segment
+		- 4 bytes containing the time spent searching for the image
+		- 4 bytes containing the time spent reading the image file
+		- 4 bytes containing the time spent decompressing the image
+		- 4 bytes containing the time spent relocating code and data
+		- 4 bytes containing the time spent fixing up imports
+		*/
+		ELoaderImageTimes = 0,
+
+		/**
+		Trace output when the loader has loaded the dependencies of an executable
+		or DLL and fixed up their imports, before they are finalised.
+		Trace data format:
+		- 4 bytes containing the kernel's handle for the main code segment
+		- 4 bytes containing the time taken to load and fix up the dependencies
+		- 4 bytes containing the number of images which were loaded into RAM
+		- 4 bytes containing the number of threads which loaded them
+		*/
+		ELoaderLoadDone = 1,
+		};
+
 	/**
 	Calculate the address of the next trace record.
 	@param aCurrentRecord A pointer to a trace record.
@@ -3748,6 +3788,16 @@ public:
 	*/
 	IMPORT_C static TSpinLock* LockPtr();
 
+#ifdef __SMP__
+	/**
+	Set whether the trace handler is called with the lock returned by LockPtr() held,
+	or only with interrupts disabled on the current CPU. Only a handler which writes
+	nothing but per-CPU state may be called without the lock.
+
+	@internalTechnology
+	*/
+	IMPORT_C static TBool SetLockFree(TBool aLockFree);
+#endif
 
 	/**
 	Enumeration of control functions which can be implemented by the BTrace handler.
@@ -3041,6 +3041,7 @@ public:
 	IMPORT_C TUint ClientProcessFlags() const;
 	IMPORT_C const TRequestStatus* ClientStatus() const;
 	IMPORT_C TBool ClientIsRealtime() const;
+	IMPORT_C static void CompleteBatch(RMessagePtr2* aMessages, const TInt* aReasons, TInt aCount);
 	
 	/**
 	Return the Secure ID of the process which sent this message.
@@ -6520,6 +6521,29 @@ public:
 	TInt iFlags;
 	};
 
+/**
+@internalComponent
+
+The largest number of messages which can be sent, or completed, with one
+executive call.
+
+@see TIpcBatch
+@see RMessagePtr2::CompleteBatch()
+*/
+const TInt KMaxIpcBatchMessages = 32;
+
+/**
+@internalComponent
+
+One message of a batch sent with RSessionBase::SendReceiveBatch().
+*/
+struct SIpcBatchItem
+	{
+	TInt iFunction;
+	TRequestStatus* iStatus;
+	TIpcArgs iArgs;
+	};
+
 // Structures for passing 64 bit integers and doubles across GCC/EABI boundaries
 
 /**
@@ -399,6 +399,14 @@ const TUint KUidCompressionDeflate=0x101F7AFC;
 
 const TUint KUidCompressionBytePair=0x102822AA;
 
+/**
+Code and data are compressed a page at a time as independent LZ4 blocks, held in the same
+paged container as byte-pair compressed images.
+
+@internalTechnology
+*/
+const TUint KUidCompressionLz4=0x10286C7E;
+
 
 #endif // __E32LDR_PRIVATE_H__
 
@@ -86,6 +86,70 @@ public:
 	void ReceiveBlocking(T& aMsg);
 	};
 
+struct SMsgQueueRing;
+
+class RSharedMsgQueueBase : public RMsgQueueBase
+/**
+@publishedPartner
+@prototype
+
+A message queue whose slots live in memory shared by every process with a
+handle to the queue.
+
+Messages are sent and received without an executive call; the kernel is only
+entered to block, or to wake a thread which is blocked in SendBlocking(),
+ReceiveBlocking() or a notification request. Any number of threads may send
+on the queue, but only one thread at a time may receive from it.
+
+The number of slots is rounded up to a power of 2. A shared queue can only
+be used through this class: RMsgQueueBase::Send() and RMsgQueueBase::Receive()
+return KErrNotSupported for it, but the notification functions work as usual.
+The slots stay mapped into a process for as long as it has a handle to the
+queue, so the queue is closed with RHandleBase::Close() like any other handle.
+*/
+	{
+public:
+	inline RSharedMsgQueueBase();
+	IMPORT_C TInt CreateLocal(TInt aSize, TInt aMsgLength, TOwnerType aType=EOwnerProcess);
+	IMPORT_C TInt CreateGlobal(const TDesC& aName, TInt aSize, TInt aMsgLength, TOwnerType aType=EOwnerProcess);
+	IMPORT_C TInt OpenGlobal(const TDesC& aName, TOwnerType aType=EOwnerProcess);
+	IMPORT_C TInt Open(RMessagePtr2 aMessage, TInt aParam, TOwnerType aType=EOwnerProcess);
+	IMPORT_C TInt Open(TInt aArgumentIndex, TOwnerType aType=EOwnerProcess);
+	IMPORT_C TInt Send(const TAny* aPtr, TInt aLength);
+	IMPORT_C void SendBlocking(const TAny* aPtr, TInt aLength);
+	IMPORT_C TInt Receive(TAny* aPtr, TInt aLength);
+	IMPORT_C void ReceiveBlocking(TAny* aPtr, TInt aLength);
+private:
+	TInt MapRing(TInt aResult);
+private:
+	SMsgQueueRing* iRing;
+	};
+
+
+
+
+/**
+@publishedPartner
+@prototype
+
+A handle to a message queue whose slots live in shared memory.
+
+The templated class adds a type-checking interface to RSharedMsgQueueBase.
+
+@see RSharedMsgQueueBase
+*/
+template <typename T>
+class RSharedMsgQueue : public RSharedMsgQueueBase
+	{
+public:
+	TInt CreateLocal(TInt aSize, TOwnerType aType=EOwnerProcess);
+	TInt CreateGlobal(const TDesC& aName, TInt aSize, TOwnerType aType=EOwnerProcess);
+	TInt Send(const T& aMsg);
+	void SendBlocking(const T& aMsg);
+	TInt Receive(T& aMsg);
+	void ReceiveBlocking(T& aMsg);
+	};
+
 #include <e32msgqueue.inl>
 
 #endif
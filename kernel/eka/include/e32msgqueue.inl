@@ -171,3 +171,95 @@ RMsgQueueBase::ReceiveBlocking().
 */
 	{RMsgQueueBase::ReceiveBlocking(&aMessage, sizeof(T));}
 
+
+
+
+inline RSharedMsgQueueBase::RSharedMsgQueueBase()
+	: iRing(NULL)
+/**
+Default constructor.
+*/
+	{}
+
+
+
+
+template <typename T>
+inline TInt RSharedMsgQueue<T>::CreateLocal(TInt aSize, TOwnerType aOwner)
+/**
+Creates a shared message queue that is private to the current process,
+and opens a handle to it.
+
+The size of each message in the queue is the size of the template
+parameter type.
+
+@see RSharedMsgQueueBase::CreateLocal
+*/
+	{return RSharedMsgQueueBase::CreateLocal(aSize, sizeof(T), aOwner);}
+
+
+
+
+template <typename T>
+inline TInt RSharedMsgQueue<T>::CreateGlobal(const TDesC& aName, TInt aSize, TOwnerType aOwner)
+/**
+Creates a global shared message queue, and opens a handle to it.
+
+The size of each message in the queue is the size of the template
+parameter type.
+
+@see RSharedMsgQueueBase::CreateGlobal
+*/
+	{return RSharedMsgQueueBase::CreateGlobal(aName, aSize, sizeof(T), aOwner);}
+
+
+
+
+//realtime
+template <typename T>
+inline TInt RSharedMsgQueue<T>::Send(const T& aMessage)
+/**
+Sends a message through this queue without waiting if the queue is full.
+
+@see RSharedMsgQueueBase::Send
+*/
+	{return RSharedMsgQueueBase::Send(&aMessage, sizeof(T));}
+
+
+
+
+template <typename T>
+inline void RSharedMsgQueue<T>::SendBlocking(const T& aMessage)
+/**
+Sends a message through this queue, and waits for space to become available
+if the queue is full.
+
+@see RSharedMsgQueueBase::SendBlocking
+*/
+	{RSharedMsgQueueBase::SendBlocking(&aMessage, sizeof(T));}
+
+
+
+
+//realtime
+template <typename T>
+inline TInt RSharedMsgQueue<T>::Receive(T& aMessage)
+/**
+Retrieves the first message in the queue without waiting if the queue
+is empty.
+
+@see RSharedMsgQueueBase::Receive
+*/
+	{return RSharedMsgQueueBase::Receive(&aMessage, sizeof(T));}
+
+
+
+
+template <typename T>
+inline void RSharedMsgQueue<T>::ReceiveBlocking(T& aMessage)
+/**
+Retrieves the first message in the queue, and waits if the queue is empty.
+
+@see RSharedMsgQueueBase::ReceiveBlocking
+*/
+	{RSharedMsgQueueBase::ReceiveBlocking(&aMessage, sizeof(T));}
@@ -3063,6 +3063,14 @@ enum TBasePanic
 	CServer2::Start() has been invoked on a CServer2 object.
 	*/
 	ECServer2InvalidSetPin = 106,
+
+	/**
+	This panic is raised by CActiveSchedulerPool::NewL() if the number of
+	threads is not positive, and by the other member functions of
+	CActiveSchedulerPool if they are passed a group number which the pool
+	did not return from OpenGroup().
+	*/
+	EActivePoolBadArgument = 107,
     };
 
 #endif
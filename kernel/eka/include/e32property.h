@@ -176,4 +176,85 @@ public:
 #endif
 	};
 
+
+/**
+@internalComponent
+
+A single property value held by a TPropertyBatch.
+*/
+struct SPropertyBatchItem
+	{
+	TUint			iCategory;
+	TUint			iKey;
+	TInt			iSize;		///< size of a byte-array value, -1 for an integer value
+	TInt			iValue;		///< integer value
+	const TUint8*	iBuf;		///< byte-array value
+	};
+
+
+/**
+@publishedAll
+@prototype
+
+Publishes a group of property values together.
+
+Values are collected with Set() and published with Commit(). Either all
+the values are published or, if any of them can't be, none of them are.
+Other threads never see some of the values updated and others not, and
+each pending subscription to the properties is completed once for the whole
+batch instead of once per value.
+
+Byte-array values are not copied until Commit(), so the descriptors passed
+to Set() must remain valid until then.
+
+@see RProperty
+*/
+class TPropertyBatch
+	{
+public:
+	/**
+	The maximum number of values that a batch can hold.
+	*/
+	enum { KMaxItems = 64 };
+
+	inline TPropertyBatch();
+	inline void Begin();
+	inline TInt Count() const;
+
+	IMPORT_C TInt Set(TUid aCategory, TUint aKey, TInt aValue);
+	IMPORT_C TInt Set(TUid aCategory, TUint aKey, const TDesC8& aValue);
+#ifndef __KERNEL_MODE__
+	IMPORT_C TInt Set(TUid aCategory, TUint aKey, const TDesC16& aValue);
+#endif
+	IMPORT_C TInt Commit();
+private:
+	TInt				iCount;
+	SPropertyBatchItem	iItems[KMaxItems];
+	};
+
+
+/**
+Constructs an empty batch.
+*/
+inline TPropertyBatch::TPropertyBatch()
+	: iCount(0)
+	{}
+
+
+/**
+Discards any values collected since the batch was constructed or last
+committed, and starts a new batch.
+*/
+inline void TPropertyBatch::Begin()
+	{ iCount = 0; }
+
+
+/**
+Gets the number of values collected in the batch.
+
+@return The number of values that will be published by Commit().
+*/
+inline TInt TPropertyBatch::Count() const
+	{ return iCount; }
+
 #endif
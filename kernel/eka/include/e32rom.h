@@ -63,7 +63,8 @@ struct SDemandPagingConfig
 	TUint16 iMaxPages;
 	TUint16 iYoungOldRatio;
 	TUint16 iSpare[3];		// iSpare[0:1] are used for emulated rom paging, 
-							// iSpare[2] is used for the old to oldest ratio.
+							// iSpare[2] bits 0-7 are used for the old to oldest ratio,
+							// bits 8-15 for the page replacement policy (TVMReplacementPolicy).
 	};
 
 /**
@@ -80,6 +81,7 @@ struct SRomPageInfo
 		{
 		ENoCompression,
 		EBytePair,
+		ELz4,
 		};
 	TUint32 iDataStart;
 	TUint16 iDataSize;
@@ -4259,6 +4259,38 @@ public:
 
 
 
+/**
+@publishedAll
+@prototype
+
+A batch of asynchronous messages to be sent to a server with one executive
+call.
+
+Each message takes one of the session's message slots, exactly as if it had
+been sent with RSessionBase::SendReceive(), and each is completed individually
+through its own TRequestStatus. The whole batch is sent with one executive
+call rather than one per message.
+
+@see RSessionBase::SendReceiveBatch()
+*/
+class TIpcBatch
+	{
+public:
+	enum {KMaxMessages = KMaxIpcBatchMessages};
+public:
+	inline TIpcBatch();
+	inline void Reset();
+	inline TInt Count() const;
+	IMPORT_C TInt Add(TInt aFunction, const TIpcArgs& aArgs, TRequestStatus& aStatus);
+private:
+	TInt iCount;
+	SIpcBatchItem iItems[KMaxMessages];
+	friend class RSessionBase;
+	};
+
+
+
+
 /**
 @publishedAll
 @released
@@ -4351,6 +4383,7 @@ protected:
 	inline TInt Send(TInt aFunction) const;
 	inline void SendReceive(TInt aFunction,TRequestStatus& aStatus) const;
 	inline TInt SendReceive(TInt aFunction) const;
+	IMPORT_C void SendReceiveBatch(const TIpcBatch& aBatch) const;
 private:
 	IMPORT_C TInt DoSend(TInt aFunction,const TIpcArgs* aArgs) const;
 	IMPORT_C void DoSendReceive(TInt aFunction,const TIpcArgs* aArgs,TRequestStatus& aStatus) const;
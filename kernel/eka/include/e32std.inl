@@ -4024,6 +4024,37 @@ inline TBool RProcess::HasCapability(TCapability aCapability1, TCapability aCapa
 
 
 
+// Class TIpcBatch
+inline TIpcBatch::TIpcBatch()
+	: iCount(0)
+/**
+Constructs an empty batch.
+*/
+	{}
+
+
+
+
+inline void TIpcBatch::Reset()
+/**
+Empties the batch so that it can be reused.
+*/
+	{iCount=0;}
+
+
+
+
+inline TInt TIpcBatch::Count() const
+/**
+Gets the number of messages in the batch.
+
+@return The number of messages.
+*/
+	{return iCount;}
+
+
+
+
 // Class RSessionBase
 
 
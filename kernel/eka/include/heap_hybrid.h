@@ -128,6 +128,16 @@ public:
 	                  2^n is smallest size allocated in paged allocator (14-31 = 16 Kb --> )
 	                  */
 		TInt   iPagePower;
+					  /**
+	                  Number of thread magazines cached in front of the slab
+	                  allocator (0 = disabled, rounded down to a power of 2)
+	                  */
+		TInt   iMagazineCount;
+					  /**
+	                  Largest cell size allocated from page sized big slabs
+	                  (0 = disabled, 57-1016 bytes)
+	                  */
+		TInt   iBigSlabSize;
 
 		};
 
@@ -155,7 +165,7 @@ public:
 
 	Commands used by test code for configuring the allocators and obtaining information them them
 	*/
-	enum TTestCommand { EGetConfig, ESetConfig, EHeapMetaData, ETestData };
+	enum TTestCommand { EGetConfig, ESetConfig, EHeapMetaData, ETestData, ESetMagazineConfig, ESetBigSlabConfig };
 
 	virtual TAny* Alloc(TInt aSize);
 	virtual void Free(TAny* aPtr);
@@ -301,6 +311,28 @@ private:
 	static void SlabEmptyInfo(slab* s, struct HeapInfo* i, SWalkInfo* wi);
 	static void TreeWalk(slab* const* root, void (*f)(slab*, struct HeapInfo*, SWalkInfo*), struct HeapInfo* i, SWalkInfo* wi);
 
+	void BigSlabInit();
+	void BigSlabConfig(TInt aMaxSize);
+	void* BigSlabAllocate(TInt aSize);
+	void BigSlabFree(void* p);
+	bigslab* AllocNewBigSlab(TInt aClass);
+	void BigSlabInfo(struct HeapInfo* i, SWalkInfo* wi) const;
+	void DoCheckBigSlab(bigslab* aSlab, TAny* aBfr=NULL);
+	void DoCheckBigSlabs();
+	static void BigSlabLink(bigslab* s, bigslab** r);
+	static void BigSlabUnlink(bigslab* s);
+	static inline unsigned BigSlabHeaderSize(unsigned h)
+	{return (h&0x0000ffff);}
+	static inline unsigned BigSlabHeaderClass(unsigned h)
+	{return (h&0x00ff0000)>>16;}
+
+	void MagazineInit();
+	TInt MagazineConfig(TInt aCount);
+	void MagazineFlush();
+	magazine* MagazineLock();
+	void* MagazineAllocate(TInt aSize);
+	TBool MagazineFree(void* p);
+
 	static void WalkPartialFullSlab(SWalkInfo* aInfo, slab* aSlab, TCellType aBfrType, TInt aLth);
 	static void WalkFullSlab(SWalkInfo* aInfo, slab* aSlab, TCellType aBfrType, TInt aLth);
 	void DoCheckSlab(slab* aSlab, TAllocatorType aSlabType, TAny* aBfr=NULL);
@@ -345,6 +377,12 @@ private:
 	page*		iSparePage;							// cached, to avoid kernel exec calls for unmapping/remapping
 	TUint8		iSizeMap[(MAXSLABSIZE>>2)+1];		// index of slabset indexes based on size class
 	slabset		iSlabAlloc[MAXSLABSIZE>>2];			// array of pointers to slabsets
+	TInt		iBigSlabThreshold;					// allocations > MAXSLABSIZE and < than this are done by the big slab allocator
+	TInt		iBigSlabSize;						// largest cell size configured for big slabs, 0 = disabled
+	TUint8		iBigSizeMap[(MAXBIGSLABSIZE>>3)+1];	// index of big slabset indexes based on size class
+	bigslabset	iBigSlabAlloc[BIGSLABCLASSES];		// array of big slabsets
+	magazine*	iMagazines;							// thread magazines (page mapped on first use)
+	TInt		iMagazineCount;						// number of magazines in use, 0 = disabled
 
 #endif // __KERNEL_MODE__	
 };
@@ -1780,6 +1780,7 @@ public:
 	static TInt New(DSession*& aS, TInt aMsgSlots, TInt aMode);
 	static TInt Send(TInt aHandle, TInt aFunction, const TInt* aPtr, TRequestStatus* aStatus);
 	static TInt SendSync(TInt aHandle, TInt aFunction, const TInt* aPtr, TRequestStatus* aStatus);
+	static TInt SendBatch(TInt aHandle, const SIpcBatchItem* aItems, TInt aCount);
 
 private:
 	TInt Send(RMessageK* aMsg, TInt aFunction, const RMessageK::TMsgArgs* aArgs, TRequestStatus* aStatus);
@@ -2767,6 +2767,7 @@ private:
 
 
 class DPagingRequestPool;
+struct SVMSwapCompressionInfo;
 
 /**
 Base class for Paging Devices.
@@ -2797,6 +2798,9 @@ public:
 	enum TFlags
 		{
 		ESupportsPhysicalAccess = 1<<0,  /**< Supports ReadPhysical and WritePhysical methods. */
+		ESupportsCompressionInfo = 1<<1, /**< Supports the GetCompressionInfo method. */
+		ERequiresDeleteNotify = 1<<2,	 /**< DeleteNotify must be called whenever swap is freed. */
+		EStacksOnDataDevice = 1<<3,		 /**< Uses another data paging device as backing store, see iBackingDevice. */
 		};
 
 	/**
@@ -2897,6 +2901,20 @@ public:
 	@return KErrNone or standard error code.
 	*/
 	inline virtual TInt WritePhysical(TThreadMessage* aReq, TPhysAddr* aPageArray, TUint aPageCount, TUint aOffset, TBool aBackground);
+
+	/**
+	Called by the paging system to get statistics from a data paging device which compresses the
+	pages written to it.
+
+	If this method is implemented, the ESupportsCompressionInfo flag in iFlags must be set as well.
+
+	The default implementation of this method just returns KErrNotSupported.
+
+	@param aInfo	The structure to fill in.
+
+	@return KErrNone or standard error code.
+	*/
+	inline virtual TInt GetCompressionInfo(SVMSwapCompressionInfo& aInfo);
 	
 	/**
 	Called by the paging device to notify the kernel that the device has just become idle and is not
@@ -2976,9 +2994,27 @@ public:
 	*/
 	TUint32 iPreferredWriteShift;
 
+	/** For a data paging device with the EStacksOnDataDevice flag set, the data paging device
+		it uses as backing store, or NULL if there is none.
+
+		This is set by Kern::InstallPagingDevice(), either to the data paging device already
+		installed when this device is installed, or to one installed later.
+	*/
+	DPagingDevice* iBackingDevice;
+
+	/** The number of read requests the paging system should be able to have outstanding on this
+		device at once.
+
+		A device which can service several reads in parallel, for example one whose media driver
+		can queue commands, should set this to the number of reads it can usefully have in
+		progress.  If this is zero, a small default number is used.  The kernel may limit the
+		value set.
+	*/
+	TInt iReadRequestCount;
+
 	/** Reserved for future use.
 	*/
-	TInt iSpare[3];
+	TInt iSpare[1];
 	};
 
 inline TInt DPagingDevice::Write(TThreadMessage*, TLinAddr, TUint, TUint, TBool)
@@ -3005,6 +3041,12 @@ inline TInt DPagingDevice::DeleteNotify(TThreadMessage*,TUint,TUint)
 	return KErrNotSupported;
 	}
 
+inline TInt DPagingDevice::GetCompressionInfo(SVMSwapCompressionInfo&)
+	{
+	// Default implementation, may be overriden by derived classes
+	return KErrNotSupported;
+	}
+
 extern "C" { extern TInt __Variant_Flags__; }
 
 /********************************************
@@ -30,7 +30,7 @@ public:
 	enum {KMaxLength = 256};
 public:
 	~DMsgQueue();
-	TInt Create(DObject* aOwner, const TDesC* aName, TInt aMsgLength, TInt aSlotCount, TBool aVisible = ETrue);
+	TInt Create(DObject* aOwner, const TDesC* aName, TInt aMsgLength, TInt aSlotCount, TBool aVisible = ETrue, TBool aShared = EFalse);
 	TInt Send(const TAny* aPtr, TInt aLength);
 	TInt Receive(TAny* aPtr, TInt aLength);
 	void NotifySpaceAvailable(TRequestStatus* aStatus);
@@ -38,8 +38,14 @@ public:
 	void CancelSpaceAvailable();
 	void CancelDataAvailable();
 	TInt MessageSize() const;
+	TUint8* RingBase();
+	void Signal(TInt aWaiters);
+	virtual TInt AddToProcess(DProcess* aProcess);
+	virtual TInt Close(TAny* aPtr);
 private:
 	enum TNotification {ESpaceAvailable, EDataAvailable};
+	TInt CreateRing(TInt aSlotCount);
+	TBool RingReady(TNotification aNotification);
 	void CompleteRequestIfPending(DThread*& aThread, TClientRequest* aRequest, TInt aCompletionVal);
 	void RequestNotification(TNotification aNotification, TRequestStatus* aStatus, DThread*& aThread, TClientRequest* aRequest);
 private:
@@ -54,6 +60,9 @@ private:
 	TUint16 iMaxMsgLength;		//max message length in bytes
 	TUint8 iState;				//whether the queue is empty, full or in between
 	TUint8 iSpare;
+	DChunk* iRingChunk;			//shared chunk holding the slot ring, NULL unless created shared
+	SMsgQueueRing* iRing;		//kernel address of the ring header
+	TUint32 iRingMask;			//slot count - 1, kept here since the ring header is writable by user side
 public:
 	friend class Monitor;
 	};
@@ -0,0 +1,154 @@
+// Copyright (c) 2010 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of the License "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+// e32\include\lz4_compress.h
+// This header file contains both the prototype and implementation for the LZ4 block compressor.
+// This is done to facilitate sharing the code between the kernel, the e32 test code and the
+// tools.  The implementation is only included if the macro LZ4_COMPRESS_INCLUDE_IMPLEMENTATION
+// is defined.  The matching decompressor is Lz4Decompress() in e32\kernel\lz4.cpp.
+//
+// WARNING: This file contains some APIs which are internal and are subject
+//          to change without notice. Such APIs should therefore not be used
+//          outside the Kernel and Hardware Services package.
+//
+
+#ifndef __LZ4_COMPRESS_H__
+#define __LZ4_COMPRESS_H__
+
+#include <e32cmn.h>
+
+/**
+ * @internalTechnology
+ *
+ * Log2 of the number of entries in the hash table used by Lz4Compress.
+ */
+const TInt KLz4HashBits = 12;
+
+/**
+ * @internalTechnology
+ *
+ * The largest size data of aSize bytes can compress to, i.e. when it is stored as literals.
+ */
+#define LZ4_COMPRESS_BOUND(aSize)	((aSize) + (aSize)/255 + 16)
+
+/**
+ * @internalTechnology
+ *
+ * Compress a block of up to 64KB of data in the LZ4 block format.  The block can be
+ * decompressed without reference to any other data.
+ *
+ * @param aDest      Destination buffer.
+ * @param aDestMax   Size of the destination buffer.
+ * @param aSrc       Source data to compress.
+ * @param aSize      The size of the source data.
+ * @param aHashTable Work area of (1<<KLz4HashBits) entries.
+ *
+ * @return The compressed size, or KErrOverflow if it would be more than aDestMax.
+ */
+extern TInt Lz4Compress(TUint8* aDest, TInt aDestMax, const TUint8* aSrc, TInt aSize, TUint16* aHashTable);
+
+#ifdef LZ4_COMPRESS_INCLUDE_IMPLEMENTATION
+
+const TInt KLz4CompressMinMatch = 4;
+
+static TUint8* Lz4PutLength(TUint8* aOp, TInt aLength)
+	{
+	if (aLength >= 15)
+		{
+		aLength -= 15;
+		while (aLength >= 255)
+			{
+			*aOp++ = 255;
+			aLength -= 255;
+			}
+		*aOp++ = (TUint8)aLength;
+		}
+	return aOp;
+	}
+
+// Write a run of literals followed by a match, unless aMatchLength is zero.
+// Returns the end of the sequence, or NULL if it wouldn't fit before aOpEnd.
+static TUint8* Lz4PutSequence(TUint8* aOp, TUint8* aOpEnd, const TUint8* aLiterals, TInt aLiteralLength, TInt aOffset, TInt aMatchLength)
+	{
+	if (aOpEnd - aOp < 1 + aLiteralLength/255 + 1 + aLiteralLength + 2 + aMatchLength/255 + 1)
+		return NULL;
+	TInt matchCode = aMatchLength ? aMatchLength - KLz4CompressMinMatch : 0;
+	*aOp++ = (TUint8)(((aLiteralLength < 15 ? aLiteralLength : 15) << 4) | (matchCode < 15 ? matchCode : 15));
+	aOp = Lz4PutLength(aOp, aLiteralLength);
+	memcpy(aOp, aLiterals, aLiteralLength);
+	aOp += aLiteralLength;
+	if (aMatchLength)
+		{
+		*aOp++ = (TUint8)aOffset;
+		*aOp++ = (TUint8)(aOffset >> 8);
+		aOp = Lz4PutLength(aOp, matchCode);
+		}
+	return aOp;
+	}
+
+inline TUint32 Lz4Read32(const TUint8* aPtr)
+	{
+	return aPtr[0] | (aPtr[1] << 8) | (aPtr[2] << 16) | (aPtr[3] << 24);
+	}
+
+TInt Lz4Compress(TUint8* aDest, TInt aDestMax, const TUint8* aSrc, TInt aSize, TUint16* aHashTable)
+	{
+	memset(aHashTable, 0, sizeof(TUint16) << KLz4HashBits);
+	const TUint8* ip = aSrc;
+	const TUint8* anchor = aSrc;
+	const TUint8* end = aSrc + aSize;
+	const TUint8* matchLimit = end - KLz4CompressMinMatch;
+	TUint8* op = aDest;
+	TUint8* opEnd = aDest + aDestMax;
+
+	while (ip <= matchLimit)
+		{
+		TUint32 sequence = Lz4Read32(ip);
+		TUint hash = (sequence * 2654435761u) >> (32 - KLz4HashBits);
+		const TUint8* ref = aSrc + aHashTable[hash];
+		aHashTable[hash] = (TUint16)(ip - aSrc);
+		if (ref >= ip || Lz4Read32(ref) != sequence)
+			{
+			// skip faster through data which isn't compressing
+			ip += 1 + ((ip - anchor) >> 6);
+			continue;
+			}
+
+		// extend the match backwards over literals and then forwards...
+		while (ip > anchor && ref > aSrc && ip[-1] == ref[-1])
+			{
+			--ip;
+			--ref;
+			}
+		const TUint8* matchEnd = ip + KLz4CompressMinMatch;
+		const TUint8* refEnd = ref + KLz4CompressMinMatch;
+		while (matchEnd < end && *matchEnd == *refEnd)
+			{
+			++matchEnd;
+			++refEnd;
+			}
+		op = Lz4PutSequence(op, opEnd, anchor, ip - anchor, ip - ref, matchEnd - ip);
+		if (!op)
+			return KErrOverflow;
+		ip = anchor = matchEnd;
+		}
+
+	op = Lz4PutSequence(op, opEnd, anchor, end - anchor, 0, 0);
+	if (!op)
+		return KErrOverflow;
+	return op - aDest;
+	}
+
+#endif // LZ4_COMPRESS_INCLUDE_IMPLEMENTATION
+
+#endif // __LZ4_COMPRESS_H__
@@ -31,7 +31,7 @@
 // It may not be possible to build the kernel if any of these macros are undefined
 //#define __SCHEDULER_MACHINE_CODED__
 //#define __DFC_MACHINE_CODED__
-//#define __MSTIM_MACHINE_CODED__
+//#define __MSTIM_MACHINE_CODED__		// not supported, the timer queue is C++ only
 #define __PRI_LIST_MACHINE_CODED__
 #define __FAST_SEM_MACHINE_CODED__
 #define __FAST_MUTEX_MACHINE_CODED__
@@ -751,9 +751,13 @@ extern TSubScheduler TheSubSchedulers[KMaxCpus];
 
 #ifdef __USE_BTRACE_LOCK__
 extern TSpinLock BTraceLock;
+extern volatile TUint32 BTraceLockFree;		// nonzero if handler only needs interrupts disabled, see BTrace::SetLockFree()
 
-#define	__ACQUIRE_BTRACE_LOCK()			TInt _btrace_irq = BTraceLock.LockIrqSave()
-#define	__RELEASE_BTRACE_LOCK()			BTraceLock.UnlockIrqRestore(_btrace_irq)
+extern "C" TInt BTraceLockIrqSave();
+extern "C" void BTraceUnlockIrqRestore(TInt aIrq);
+
+#define	__ACQUIRE_BTRACE_LOCK()			TInt _btrace_irq = BTraceLockIrqSave()
+#define	__RELEASE_BTRACE_LOCK()			BTraceUnlockIrqRestore(_btrace_irq)
 
 #else
 
@@ -874,12 +878,47 @@ public:
 	typedef void (*TDebugFn)(TAny* aPtr, TInt aPos);	/**< @internalComponent */
 	enum { ETimerQMask=31, ENumTimerQueues=32 };		/**< @internalComponent */	// these are not easily modifiable
 
+	/** @internalComponent */
+	enum
+		{
+		EWheelStepShift=4,			// timers are cascaded onto the final queues in steps of 16 ticks
+		EWheelStep=16,
+		EWheelLevelShift=5,			// each wheel level has 32 slots
+		EWheelSlots=32,
+		EWheelSlotMask=31,
+		ENumWheelLevels=6,			// 6 levels cover the full 32 bit tick count
+		};
+
 	/** @internalComponent */
 	struct STimerQ
 		{
 		SDblQue iIntQ;
 		SDblQue iDfcQ;
 		};
+
+	/**
+	Per-CPU timer queue. A timer is queued on the queue of the CPU its tied
+	thread/group runs on, or of the CPU which started it if untied, so that
+	starting and cancelling timers on different CPUs doesn't contend.
+	@internalComponent
+	*/
+	struct SCpuTimerQ
+		{
+		SCpuTimerQ();
+
+		TSpinLock		iTimerSpinLock;			// protects this queue and the timers on it
+		STimerQ			iTickQ[ENumTimerQueues];
+		TUint32			iPresent;				// bit n set if iTickQ[n] nonempty
+		TUint32			iWheelTime;				// first tick of next wheel step to cascade
+		TUint32			iWheelPresent[ENumWheelLevels];	// bit n set if wheel slot n nonempty
+		SDblQue			iCompletedQ;
+		TUint8			iCpuNum;
+		TUint8			iCascadePending;
+		TUint8			iPad1;
+		TUint8			iPad2;
+		TUint32			iPad3;
+		SDblQue			iWheel[ENumWheelLevels][EWheelSlots];
+		};
 public:
 	NTimerQ();
 	static void Init1(TInt aTickPeriod);
@@ -891,12 +930,14 @@ public:
 private:
 	static void DfcFn(TAny* aPtr);
 	void Dfc();
-	void Add(NTimer* aTimer);
-	void AddFinal(NTimer* aTimer);
+	SCpuTimerQ* LockQ(NTimer* aTimer);
+	SCpuTimerQ* Start(SCpuTimerQ* aQ, NTimer* aTimer);
+	void Add(SCpuTimerQ& aQ, NTimer* aTimer);
+	void AddFinal(SCpuTimerQ& aQ, NTimer* aTimer);
+	TBool SkipWheelSteps(SCpuTimerQ& aQ);
+	void TakeWheelStep(SCpuTimerQ& aQ, SDblQue& aSteps);
+	TBool TickQ(SCpuTimerQ& aQ, TInt aSlot);
 public:
-	STimerQ			iTickQ[ENumTimerQueues];	/**< @internalComponent */	// NOTE: the order of member data is important
-	TUint32			iPresent;					/**< @internalComponent */	// The assembler code relies on it
-
 	/**
 	This member is intended for use by ASSP/variant interrupt code as a convenient
 	location to store the value of a free running counter at the point where the
@@ -910,12 +951,9 @@ public:
 		TUint32			iMsCount;				/**< @internalComponent */
 		TUint64			iMsCount64;				/**< @internalComponent */
 		};
-	SDblQue			iHoldingQ;					/**< @internalComponent */
-	SDblQue			iOrderedQ;					/**< @internalComponent */
-	SDblQue			iCompletedQ;				/**< @internalComponent */
 	TDfc			iDfc;						/**< @internalComponent */
-	TUint8			iTransferringCancelled;		/**< @internalComponent */
-	TUint8			iCriticalCancelled;			/**< @internalComponent */
+	TUint8			iTransferringCancelled;		/**< @internalComponent */	// not used by the timing wheel
+	TUint8			iCriticalCancelled;			/**< @internalComponent */	// not used by the timing wheel
 	TUint8			iPad1;						/**< @internalComponent */
 	TUint8			iPad2;						/**< @internalComponent */
 	TDebugFn		iDebugFn;					/**< @internalComponent */
@@ -931,10 +969,13 @@ public:
 	*/
 	TInt			iRounding;
 	TInt			iDfcCompleteCount;			/**< @internalComponent */
-	TSpinLock		iTimerSpinLock;				/**< @internalComponent */
+	TSpinLock		iTimerSpinLock;				/**< @internalComponent */	// protects iMsCount updates
+	SCpuTimerQ		iCpuQ[KMaxCpus];			/**< @internalComponent */
 	};
 
 __ASSERT_COMPILE(!(_FOFF(NTimerQ,iTimerSpinLock)&7));
+__ASSERT_COMPILE(!(_FOFF(NTimerQ,iCpuQ)&7));
+__ASSERT_COMPILE(!(sizeof(NTimerQ::SCpuTimerQ)&7));
 
 
 GLREF_D NTimerQ TheTimerQ;
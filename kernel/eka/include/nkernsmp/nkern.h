@@ -616,16 +616,18 @@ public:
 		{
 		EIdle=0,			// not queued
 							// 1 skipped so as not to clash with DFC states
-		ETransferring=2,	// being transferred from holding to ordered queue
-		EHolding=3,			// on holding queue
-		EOrdered=4,			// on ordered queue
-		ECritical=5,		// on ordered queue and in use by queue walk routine
+		ETransferring=2,	// being transferred to another CPU's timer queue
+		EHolding=3,			// on timing wheel
+		EOrdered=4,			// not used (was: on ordered queue)
+		ECritical=5,		// not used (was: on ordered queue and in use by queue walk routine)
 		EFinal=6,			// on final queue
 		EEventQ=32,			// 32+n = on event queue of CPU n (for tied timers)
 		};
 public:
 	TUint32 iTriggerTime;	/**< @internalComponent */
-	TUint32	iNTimerSpare1;	/**< @internalComponent */
+	TUint8	iWheelSlot;		/**< @internalComponent */	// timing wheel level and slot while EHolding
+	TUint8	iTimerCpu;		/**< @internalComponent */	// CPU whose timer queue this timer is on
+	TUint16	iNTimerSpare1;	/**< @internalComponent */	// used by NThreadWaitState to count outstanding expiries
 
 	/** This field is available for use by the timer client provided that
 		the timer isn't a mutating-into-DFC timer.
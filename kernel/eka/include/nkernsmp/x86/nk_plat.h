@@ -72,7 +72,7 @@ extern "C" TSubScheduler* SubSchedulerLookupTable[256];		// look up subscheduler
 
 //#define __SCHEDULER_MACHINE_CODED__
 //#define __DFC_MACHINE_CODED__
-//#define __MSTIM_MACHINE_CODED__
+//#define __MSTIM_MACHINE_CODED__		// not supported, the timer queue is C++ only
 //#define __PRI_LIST_MACHINE_CODED__
 //#define __FAST_SEM_MACHINE_CODED__
 //#define __FAST_MUTEX_MACHINE_CODED__
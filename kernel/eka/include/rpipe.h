@@ -36,6 +36,15 @@
 #define DATAPAGING_TEST(s)
 #endif
 
+class RShBuf;
+
+/**
+The largest number of descriptors which may be passed to RPipe::ReadV() or
+RPipe::WriteV().
+@internalTechnology
+*/
+const TInt KPipeMaxIoVectors = 16;
+
 
 class RPipe: public RBusLogicalChannel
 /**
@@ -84,6 +93,17 @@ public:
         };
     typedef TPckgBuf<TPipeInfo> TPipeInfoBuf;
 
+	/**
+	The shared buffer and the region of it to splice into the pipe.
+	*/
+	class TSpliceInfo
+		{
+	public:
+		TInt iHandle;
+		TInt iOffset;
+		TInt iSize;
+		};
+
 
 public:
 
@@ -141,6 +161,20 @@ public:
 
 	IMPORT_C TInt WriteBlocking (const TDesC8& aBuf, TInt aSize);
 
+	/**
+	 Non-blocking vectored read/write operations
+	 */
+	IMPORT_C TInt ReadV(TDes8** aData, TInt aCount);
+
+	IMPORT_C TInt WriteV(const TDesC8** aData, TInt aCount);
+
+	/**
+	 Non-blocking transfer of data between the pipe and a shared buffer
+	 */
+	IMPORT_C TInt SpliceTo(RShBuf& aBuf, TInt aOffset, TInt aSize);
+
+	IMPORT_C TInt SpliceFrom(const RShBuf& aBuf, TInt aOffset, TInt aSize);
+
 	IMPORT_C TInt Size();
 
 	IMPORT_C void NotifySpaceAvailable( TInt aSize, TRequestStatus&);
@@ -197,7 +231,10 @@ public:
 		ECancelWaitNotification,
 		EFlushPipe,
 		EClosePipe,
-		EGetPipeInfo
+		EGetPipeInfo,
+		EReadV,
+		EWriteV,
+		ESpliceFrom
 	   };
 	/*
      Enumeration of Wait Request.
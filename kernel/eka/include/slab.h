@@ -97,5 +97,60 @@ inline page* page::PageFor(slab* s)
 	return reinterpret_cast<page*>((unsigned(s))&~(PAGESIZE-1));
 }
 
+#define MAXBIGSLABSIZE		1016					// largest cell in a big slab (4 cells per page)
+#define BIGSLABCLASSES		22						// number of big slab size classes
+#define BIGSLAB_BIT			0x40000000				// marks a big slab page, always zero in a slab iHeader
+
+class bigslab
+{
+	public:
+		unsigned iHeader;
+		// made up of
+		// bits   |  31  |   30   | 29..24 | 23..16 |  15..0   |
+		//        +------+--------+--------+--------+----------+
+		// field  | zero | bigsl. |  zero  | class  |   size   |
+		//
+		unsigned iUsed;			// number of allocated cells
+		unsigned iMap[2];		// bitmap of allocated cells, bits beyond the last cell are set
+		bigslab** iPrev;		// reference to the pointer to this slab in its list
+		bigslab* iNext;			// next slab in the partial or full list
+		unsigned iReserved[2];	// keeps the first cell 8 byte aligned
+		inline static bigslab* BigSlabFor(const void* p);
+		inline static unsigned IsBigSlab(const void* p);
+};
+
+const TInt KBigSlabPayload = PAGESIZE - sizeof(bigslab);
+
+class bigslabset
+{
+	public:
+		bigslab* iPartial;		// slabs with free cells
+		bigslab* iFull;			// slabs with no free cells (so we can find them when walking)
+};
+
+inline bigslab* bigslab::BigSlabFor(const void* p)
+{
+	return reinterpret_cast<bigslab*>((unsigned(p))&~(PAGESIZE-1));
+}
+
+inline unsigned bigslab::IsBigSlab(const void* p)
+{
+	return BigSlabFor(p)->iHeader & BIGSLAB_BIT;
+}
+
+#define MAGAZINESIZE	8						// cells cached per size class in a magazine
+#define MAGAZINEBATCH	(MAGAZINESIZE>>1)		// cells moved to/from the slabsets at a time
+#define MAXMAGAZINES	8						// magazines that fit in the magazine page
+
+class magazine
+{
+	public:
+		unsigned iLock;							// non-zero while a thread is using the magazine
+		unsigned char iCount[MAXSLABSIZE>>2];	// number of cached cells for each slabset
+		void* iCells[MAXSLABSIZE>>2][MAGAZINESIZE];
+};
+
+__ASSERT_COMPILE(sizeof(magazine)*MAXMAGAZINES <= PAGESIZE);
+
 
 #endif   // __KERNEL_MODE__
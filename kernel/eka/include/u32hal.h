@@ -2693,7 +2693,7 @@ enum TVMHalFunction
 	/**
 	Get paging event information.
 	The first argument (a1) is a pointer to a descriptor whose contents will be filled
-	with a #SVMEventInfo object.
+	with a #SVMEventInfo or #SVMEventInfoV2 object, depending on the descriptor's maximum length.
 	The second argument (a2) must be zero.
 	@test
 	*/
@@ -2867,6 +2867,114 @@ enum TVMHalFunction
 	not support this.
 	*/
 	EVMHalDebugSetFail,
+
+	/**
+	Gets information about how the pages written to swap are being compressed, if the data paging
+	device compresses them.
+	The first argument (a1) should be a pointer to the SVMSwapCompressionInfo structure to write.
+	@return KErrNone if successful, or KErrNotSupported if data paging is not supported or the
+	data paging device does not compress pages.
+	@internalTechnology
+	@prototype
+	*/
+	EVMHalGetSwapCompressionInfo,
+
+	/**
+	Gets the page replacement policy used by the paging cache.
+
+	@return One of TVMReplacementPolicy, or KErrNotSupported on memory models that do not support
+	this.
+	@internalTechnology
+	@prototype
+	*/
+	EVMHalGetReplacementPolicy,
+
+	/**
+	@internalTechnology
+	@test
+
+	Sets the page replacement policy used by the paging cache.  The policy is normally set at boot
+	from the ROM's demand paging configuration.
+
+	The first argument (a1) contains one of TVMReplacementPolicy.
+
+	@return KErrArgument if the value is out of range, KErrNoMemory if there isn't enough memory to
+	track evicted pages, or KErrNotSupported on memory models that do not support this.
+	*/
+	EVMHalSetReplacementPolicy,
+
+	/**
+	@internalTechnology
+	@test
+
+	Sets whether code segments loaded from now on record which of their pages are accessed.
+	Profiling can also be enabled at boot with the CODEPAGINGPROFILE kernelconfig flag.
+
+	The first argument (a1) is ETrue to enable profiling or EFalse to disable it.
+
+	@return KErrNone, or KErrNotSupported on memory models that do not support code paging.
+	*/
+	EVMHalSetCodePageProfiling,
+
+	/**
+	@internalTechnology
+	@prototype
+
+	Gets the profile of accessed pages recorded for a demand paged code segment.
+
+	The first argument (a1) is an address within the code segment, in the current process.
+	The second argument (a2) is a pointer to a descriptor (TDes8) which receives the profile.
+	This is a bitmap with one bit for each page of the code segment, stored as an array of TUint32
+	with the bit for page n in bit n&31 of word n>>5.  Only pages accessed after the code segment
+	finished loading are recorded.
+
+	@return The number of pages in the code segment, KErrNotFound if the address isn't in demand
+	paged code, KErrNotReady if profiling wasn't enabled when the code segment was loaded, or
+	KErrNotSupported on memory models that do not support code paging.
+	*/
+	EVMHalGetCodePageProfile,
+
+	/**
+	@internalTechnology
+	@prototype
+
+	Reads into RAM the pages of a demand paged code segment marked in a profile, for example one
+	saved from EVMHalGetCodePageProfile on a previous boot.  Runs of marked pages are read
+	with as few paging device requests as possible.
+
+	The first argument (a1) is an address within the code segment, in the current process.
+	The second argument (a2) is a pointer to a descriptor (TDesC8) containing the profile, in the
+	format returned by EVMHalGetCodePageProfile.
+
+	@return KErrNone if successful, KErrNotFound if the address isn't in demand paged code,
+	KErrArgument if the profile is larger than the code segment requires, or KErrNotSupported on
+	memory models that do not support code paging.
+	*/
+	EVMHalPrefetchCodePages,
+	};
+
+
+/**
+Page replacement policies for the paging cache.
+@internalTechnology
+@prototype
+*/
+enum TVMReplacementPolicy
+	{
+	/**
+	Pages enter the live list as the youngest page, approximating least recently used.
+	*/
+	EVMReplacementPolicyLru,
+
+	/**
+	Newly paged in pages enter the live list as old pages and are only made young when they are
+	accessed again, so a single scan through a large amount of paged memory doesn't flush
+	the working set.  Recently evicted pages are remembered, and enter as young pages if they
+	are paged in again soon enough that they would have stayed in a larger cache.
+	*/
+	EVMReplacementPolicyScanResistant,
+
+	EVMMaxReplacementPolicy
 	};
 
 
@@ -2892,6 +3000,31 @@ struct SVMEventInfo
 	// instead, derive a new SVMEventInfoV2 class from this and add new members to that.
 	};
 
+
+/**
+Paging event information, including page in latencies.
+@publishedPartner
+@test
+*/
+struct SVMEventInfoV2 : public SVMEventInfo
+	{
+	enum
+		{
+		/** The number of buckets in iPageInLatency. */
+		EPageInLatencyBuckets = 16
+		};
+
+	/**
+	A histogram of the time taken to service page faults which read from storage media, from
+	requesting the read until the data was available.  Element n counts the faults which took
+	from 2^n to 2^(n+1)-1 microseconds, except element 0 also counts faults which took less
+	than one microsecond and the last element counts all faults which took longer.
+	*/
+	TUint32 iPageInLatency[EPageInLatencyBuckets];
+
+	// do not add new members to this struct.
+	};
+
 	
 /**
 VM cache information.
@@ -3276,6 +3409,69 @@ struct SVMSwapInfo
 
 
 
+/**
+Compressed swap information, for a data paging device which compresses the pages written to it.
+@internalAll
+@prototype
+*/
+struct SVMSwapCompressionInfo
+	{
+	/**
+	The size of the RAM pool holding compressed pages, in bytes.
+	*/
+	TUint64 iPoolSize;
+
+	/**
+	The amount of the pool currently in use, in bytes.
+	*/
+	TUint64 iPoolUsed;
+
+	/**
+	The uncompressed size of the pages currently held in the pool, in bytes.
+	*/
+	TUint64 iOriginalSize;
+
+	/**
+	The compressed size of the pages currently held in the pool, in bytes.
+	*/
+	TUint64 iCompressedSize;
+
+	/**
+	The number of pages currently held compressed in the pool.
+	*/
+	TUint iCompressedPages;
+
+	/**
+	The number of incompressible pages currently held uncompressed in the pool.
+	*/
+	TUint iUncompressedPages;
+
+	/**
+	The number of incompressible pages currently written to the backing media.
+	*/
+	TUint iBackingPages;
+
+	/**
+	The total number of pages written and read since boot.
+	*/
+	TUint iWriteCount;
+	TUint iReadCount;
+
+	/**
+	The average time taken to write and read a page, in nanoseconds.
+	*/
+	TUint iAverageWriteTime;
+	TUint iAverageReadTime;
+
+	/**
+	The longest time taken to write and read a page, in nanoseconds.
+	*/
+	TUint iMaxWriteTime;
+	TUint iMaxReadTime;
+	};
+
+
+
 /**
 Free swap notification thresholds.
 @internalAll
@@ -362,6 +362,37 @@ struct SIpcCopyInfo
 	TInt iFlags;
 	};
 
+/**
+Header of the slot ring used by a message queue created with
+RSharedMsgQueueBase. The ring lives in a shared chunk which is mapped into
+every process with a handle to the queue, and the slots follow the header.
+
+Each slot is a sequence word followed by the message. Producers claim a slot
+by advancing iHead, copy the message in and then publish it by setting the
+sequence word to position+1; the consumer frees it again by setting the
+sequence word to position+iSlotCount. The kernel only reads the ring, to
+decide whether a notification request can complete at once.
+
+@internalComponent
+*/
+struct SMsgQueueRing
+	{
+	enum TWaiter {EDataWaiter=1, ESpaceWaiter=2};
+	inline TUint32* Slot(TUint32 aPos)
+		{ return (TUint32*)((TUint8*)(this+1) + (aPos&(iSlotCount-1))*iSlotSize); }
+
+	TUint32 iSlotCount;			// number of slots, a power of 2
+	TUint32 iSlotSize;			// bytes per slot, sequence word plus message
+	TUint32 iMsgLength;			// message length in bytes
+	TUint32 iSpare1;
+	volatile TUint32 iWaiters;	// TWaiter bits, set by the kernel when a notification is pending
+	TUint32 iSpare2[3];
+	volatile TUint32 iHead;		// next position to be claimed by a producer
+	TUint32 iSpare3[7];			// keep producers and consumer on different cache lines
+	volatile TUint32 iTail;		// next position to be read by the consumer
+	TUint32 iSpare4[7];
+	};
+
 enum TChunkAdjust
 	{
 	EChunkAdjust=0,
@@ -510,6 +541,8 @@ enum TKernelConfigFlags
 
 	EKernelConfigSMPLockKernelThreadsCore0 = 1<< 15,    // locks all kernel side threads to CPU 0
 
+	EKernelConfigCodePagingProfile = 1<<16,				// Record which pages of paged code are accessed, see EVMHalGetCodePageProfile
+
 	EKernelConfigDisableAPs = 1u<<30,
 
 	EKernelConfigTest = 1u<<31,							// Only used by test code for __PLATSEC_UNLOCKED__
@@ -12,6 +12,10 @@
 //
 // Description:
 // e32\kernel\byte_pair.cpp
+// The data is a table of up to 255 tokens, each standing for a pair of bytes or tokens, followed by
+// the token stream.  A token is expanded by walking its pairs the first time it is seen, which
+// records where its expansion was written; the output is memoised that way so later occurrences of
+// the same token are copied straight from earlier output instead of walking the pairs again.
 // 
 //
 
@@ -32,6 +36,10 @@ TInt BytePairDecompress(TUint8* dst, TInt dstSize, TUint8* src, TInt srcSize, TU
 	TUint8* stackStart = stack+sizeof(stack);
 	TUint8* sp = stackStart;
 
+	// first expansion of each token, once it has been seen...
+	TUint16 tokenStart[0x100];	// offset of the expansion from dstStart
+	TUint8 tokenLength[0x100];	// length of the expansion, zero if not seen or too long to record
+
 	TUint32 marker = ~0u;
 	TInt numTokens;
 	TUint32 p1;
@@ -56,6 +64,7 @@ TInt BytePairDecompress(TUint8* dst, TInt dstSize, TUint8* src, TInt srcSize, TU
 			goto error;
 		marker = *src++;
 		LUT0[marker] = (TUint8)~marker;
+		tokenLength[marker] = 0;
 
 		if(numTokens<32)
 			{
@@ -69,6 +78,7 @@ TInt BytePairDecompress(TUint8* dst, TInt dstSize, TUint8* src, TInt srcSize, TU
 				TInt p2 = *src++;
 				LUT0[b] = (TUint8)p1;
 				LUT1[b] = (TUint8)p2;
+				tokenLength[b] = 0;
 				}
 			while(src<tokenEnd);
 			}
@@ -91,7 +101,8 @@ TInt BytePairDecompress(TUint8* dst, TInt dstSize, TUint8* src, TInt srcSize, TU
 						goto error;
 					TInt p2 = *src++;
 					LUT0[b] = (TUint8)p1;
-					LUT1[b] = (TUint8)p2;		
+					LUT1[b] = (TUint8)p2;
+					tokenLength[b] = 0;
 					--numTokens;
 					}
 				++b;
@@ -102,69 +113,104 @@ TInt BytePairDecompress(TUint8* dst, TInt dstSize, TUint8* src, TInt srcSize, TU
 			}
 		}
 
-	if(src>=srcEnd)
-		goto error;
-	b = *src++;
-	if(dst>=dstEnd)
-		goto error;
-	p1 = LUT0[b];
-	if(p1!=b)
-		goto not_single;
-next:
-	if(src>=srcEnd)
-		goto done_s;
-	b = *src++;
-	*dst++ = (TUint8)p1;
-	if(dst>=dstEnd)
-		goto done_d;
-	p1 = LUT0[b];
-	if(p1==b)
-		goto next;
-
-not_single:
-	if(b==marker)
-		goto do_marker;
-
-do_pair:
-	p2 = LUT1[b];
-	b = p1;
-	p1 = LUT0[b];
-	if(sp<=stack)
+	if(src>=srcEnd || dst>=dstEnd)
 		goto error;
-	*--sp = (TUint8)p2;
+	do
+		{
+		b = *src++;
+		p1 = LUT0[b];
+		if(p1==b)
+			{
+			// literal byte...
+			*dst++ = (TUint8)p1;
+			continue;
+			}
+		if(b==marker)
+			{
+			// escaped literal byte...
+			if(src>=srcEnd)
+				goto error;
+			*dst++ = *src++;
+			continue;
+			}
 
-recurse:
-	if(b!=p1)
-		goto do_pair;
+		TUint len = tokenLength[b];
+		if(len)
+			{
+			// token seen before, copy its earlier expansion...
+			if(len>TUint(dstEnd-dst))
+				goto error;
+			TUint8* ref = dstStart+tokenStart[b];
+			if(len<=8 && srcEnd-src>=16 && dstEnd-dst>=8)
+				{
+				// Most expansions are short, so copy a fixed 8 bytes.  Any written past the
+				// expansion are overwritten by what follows, as the 16 source bytes left will
+				// produce at least 8 more output bytes, fill the output, or fail.
+				TUint32 w0, w1;
+				memcpy(&w0,ref,4);
+				memcpy(&w1,ref+4,4);
+				memcpy(dst,&w0,4);
+				memcpy(dst+4,&w1,4);
+				dst += len;
+				continue;
+				}
+			do *dst++ = *ref++;
+			while(--len);
+			continue;
+			}
 
-	if(sp==stackStart)
-		goto next;
-	b = *sp++;
-	*dst++ = (TUint8)p1;
-	if(dst>=dstEnd)
-		goto error;
-	p1 = LUT0[b];
-	goto recurse;
+		// first occurrence of this token, expand it by walking its pairs...
+		{
+		TUint8* tokenDst = dst;
+		TUint token = b;
+		for(;;)
+			{
+			if(b!=p1)
+				{
+				len = tokenLength[b];
+				if(!len)
+					{
+					// push the second half of the pair and expand the first...
+					p2 = LUT1[b];
+					b = p1;
+					p1 = LUT0[b];
+					if(sp<=stack)
+						goto error;
+					*--sp = (TUint8)p2;
+					continue;
+					}
+				if(len>TUint(dstEnd-dst))
+					goto error;
+				TUint8* ref = dstStart+tokenStart[b];
+				do *dst++ = *ref++;
+				while(--len);
+				}
+			else
+				{
+				if(dst>=dstEnd)
+					goto error;
+				*dst++ = (TUint8)p1;
+				}
+			if(sp==stackStart)
+				break;
+			b = *sp++;
+			p1 = LUT0[b];
+			}
+		len = dst-tokenDst;
+		TUint start = tokenDst-dstStart;
+		if(len<0x100 && start<0x10000)
+			{
+			tokenStart[token] = (TUint16)start;
+			tokenLength[token] = (TUint8)len;
+			}
+		}
+		}
+	while(src<srcEnd && dst<dstEnd);
 
-do_marker:
-	if(src>=srcEnd)
-		goto error;
-	p1 = *src++;
-	goto next;
+	srcNext = src;
+	return dst-dstStart;
 
 error:
 	srcNext = 0;
 	return KErrCorrupt;
-
-done_s:
-	*dst++ = (TUint8)p1;
-	srcNext = src;
-	return dst-dstStart;
-
-done_d:
-	--src;
-	srcNext = src;
-	return dst-dstStart;
 	}
-
-
@@ -0,0 +1,101 @@
+// Copyright (c) 2010 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of the License "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+// e32\kernel\lz4.cpp
+// Decompressor for blocks in the LZ4 block format, as produced by Lz4Compress() in
+// lz4_compress.h.  Each block is a series of sequences, each made of a token byte, a run of
+// literals and, except for the last sequence, a match against earlier output.  Blocks don't
+// refer to data outside themselves so each page of an image can be decompressed independently.
+//
+
+#include "u32std.h"
+
+const TInt KLz4MinMatch = 4;
+
+TInt Lz4Decompress(TUint8* dst, TInt dstSize, TUint8* src, TInt srcSize, TUint8*& srcNext)
+	{
+	TUint8* dstStart = dst;
+	TUint8* dstEnd = dst+dstSize;
+	TUint8* srcEnd = src+srcSize;
+
+	while(src<srcEnd)
+		{
+		TUint token = *src++;
+
+		// literals...
+		TInt length = token>>4;
+		if(length==15)
+			{
+			TUint b;
+			do
+				{
+				if(src>=srcEnd)
+					goto error;
+				b = *src++;
+				length += b;
+				}
+			while(b==255);
+			}
+		if(length>srcEnd-src || length>dstEnd-dst)
+			goto error;
+		memcpy(dst,src,length);
+		dst += length;
+		src += length;
+		if(src==srcEnd)
+			{
+			// the last sequence has no match...
+			srcNext = src;
+			return dst-dstStart;
+			}
+
+		// match...
+		if(srcEnd-src<2)
+			goto error;
+		TInt offset = src[0]|(src[1]<<8);
+		src += 2;
+		if(offset==0 || offset>dst-dstStart)
+			goto error;
+		length = token&15;
+		if(length==15)
+			{
+			TUint b;
+			do
+				{
+				if(src>=srcEnd)
+					goto error;
+				b = *src++;
+				length += b;
+				}
+			while(b==255);
+			}
+		length += KLz4MinMatch;
+		if(length>dstEnd-dst)
+			goto error;
+		TUint8* ref = dst-offset;
+		if(offset>=length)
+			{
+			memcpy(dst,ref,length);
+			dst += length;
+			}
+		else
+			{
+			// overlapping match repeats the last offset bytes...
+			TUint8* end = dst+length;
+			do *dst++ = *ref++;
+			while(dst<end);
+			}
+		}
+
+error:
+	return KErrCorrupt;
+	}
@@ -1522,6 +1522,71 @@ TInt DSession::SendSync(TInt aHandle, TInt aFunction, const TInt* aPtr, TRequest
 	return r;
 	}
 
+TInt DSession::SendBatch(TInt aHandle, const SIpcBatchItem* aItems, TInt aCount)
+//
+// Send a batch of asynchronous messages to a server with one executive call.
+// Each message is delivered as it is sent, exactly as by Send(), so it keeps its
+// place relative to other clients' messages and a server waiting in Receive() is
+// woken by the first one. A message which can't be sent has its request
+// completed with the error, as RSessionBase::SendReceive() does for one message.
+// The client stays in a critical section for the whole batch, so it can't be
+// killed with part of the batch sent.
+// Enter and return with system unlocked.
+//
+	{
+	if (TUint(aCount) > TUint(KMaxIpcBatchMessages))
+		return KErrArgument;
+
+	// keep the session while the system lock is released between messages
+	NKern::LockSystem();
+	DSession* session = (DSession*)K::ObjectFromHandle(aHandle, ESession);
+	session->TotalAccessInc();
+	NKern::ThreadEnterCS();
+	NKern::UnlockSystem();
+
+	TInt r = KErrNone;
+	for (TInt i = 0; i < aCount; ++i)
+		{
+		SIpcBatchItem item;
+		XTRAP(r, XT_DEFAULT, kumemget32(&item, aItems + i, sizeof(item)));
+		if (r != KErrNone)
+			{
+			r = KErrBadDescriptor;
+			break;
+			}
+		TInt s = KErrArgument;
+		if (item.iFunction >= 0)	// no connect or disconnect messages
+			{
+			RMessageK::TMsgArgs msgArgs;
+			msgArgs.ReadDesHeaders((const TInt*)&item.iArgs);
+
+			NKern::LockSystem();
+			RMessageK* m = NULL;
+			if (TheCurrentThread->ObjectFromHandle(aHandle, ESession) != session)
+				s = KErrBadHandle;		// closed by another thread since the batch started
+			else if ((m = session->GetNextFreeMessage()) == NULL)
+				s = KErrServerBusy;
+			if (m)
+				{
+				__ASSERT_DEBUG(m->IsFree(), K::Fault(K::EMessageNotFree));
+				s = session->Send(m, item.iFunction, &msgArgs, item.iStatus);
+				}
+			else
+				NKern::UnlockSystem();
+			}
+		if (s != KErrNone)
+			Kern::RequestComplete(item.iStatus, s);
+		}
+
+	NKern::LockSystem();
+	session->TotalAccessDecRel();
+	NKern::ThreadLeaveCS();
+
+	if (r == KErrBadDescriptor)
+		K::PanicKernExec(ECausedException);
+	return KErrNone;
+	}
+
 TInt DSession::Send(RMessageK* aMsg, TInt aFunction, const RMessageK::TMsgArgs* aArgs, TRequestStatus* aStatus)
 //
 // Send a message to a server.
@@ -1725,6 +1790,15 @@ TInt ExecHandler::SessionSendSync(TInt aHandle, TInt aFunction, TAny* aPtr, TReq
 	return DSession::SendSync(aHandle, aFunction, (const TInt*)aPtr, aStatus);
 	}
 
+TInt ExecHandler::SessionSendBatch(TInt aHandle, const SIpcBatchItem* aItems, TInt aCount)
+//
+// Enter and return with system unlocked.
+//
+	{
+	__KTRACE_OPT(KEXEC,Kern::Printf("Exec::SessionSendBatch"));
+	return DSession::SendBatch(aHandle, aItems, aCount);
+	}
+
 #ifndef __MESSAGE_MACHINE_CODED__
 void ExecHandler::MessageComplete(RMessageK* aMsg, TInt aReason)
 //
@@ -2107,3 +2181,27 @@ void ExecHandler::MessageCompleteWithHandle(RMessageK* aMsg, TInt aHandle)
 	RMessageK::MessageK((TInt)aMsg);
 	ExecHandler::MessageComplete(aMsg,r);
 	}
+
+void ExecHandler::MessageCompleteBatch(const TInt* aHandles, const TInt* aReasons, TInt aCount)
+//
+// Complete a number of messages with one executive call.
+// Enter and leave with system unlocked.
+//
+	{
+	__KTRACE_OPT(KEXEC,Kern::Printf("Exec::MessageCompleteBatch"));
+	if (TUint(aCount) > TUint(KMaxIpcBatchMessages))
+		K::PanicKernExec(EBadMessageHandle);
+	TInt handles[KMaxIpcBatchMessages];
+	TInt reasons[KMaxIpcBatchMessages];
+	kumemget32(handles, aHandles, aCount * sizeof(TInt));
+	kumemget32(reasons, aReasons, aCount * sizeof(TInt));
+
+	NKern::LockSystem();
+	for (TInt i = 0; i < aCount; ++i)
+		{
+		RMessageK* m = RMessageK::MessageK(handles[i]);	// disconnect messages aren't allowed
+		ExecHandler::MessageComplete(m, reasons[i]);
+		NKern::FlashSystem();
+		}
+	NKern::UnlockSystem();
+	}
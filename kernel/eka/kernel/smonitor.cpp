@@ -516,6 +516,9 @@ void Monitor::DumpMessageQueueData(DMsgQueue* aQueue)
 	Printf("StartOfPool %08x, EndOfPool %08x\r\n", aQueue->iMsgPool, aQueue->iEndOfPool);
 	Printf("FirstFullSlot %08x, FirstFreeSlot %08x\r\n", aQueue->iFirstFullSlot, aQueue->iFirstFreeSlot);
 	Printf("MaxMsgLength %d\r\n", aQueue->iMaxMsgLength);
+	if (aQueue->iRing)
+		Printf("Ring %08x, Head %08x, Tail %08x, Waiters %x\r\n", aQueue->iRing,
+			   aQueue->iRing->iHead, aQueue->iRing->iTail, aQueue->iRing->iWaiters);
 	TBuf8<80> buf=_L8("MessageQueue state ");
 	switch (aQueue->iState)
 		{
@@ -23,11 +23,8 @@
  * Asynchronous message queues
  ********************************************/
 
-TInt ExecHandler::MsgQueueCreate(const TDesC8* aName, TInt aSize, TInt aLength, TOwnerType aType)
+static TInt DoMsgQueueCreate(const TDesC8* aName, TInt aSize, TInt aLength, TOwnerType aType, TBool aShared)
 	{
-
-	__KTRACE_OPT(KEXEC,Kern::Printf("Exec::MsgQueueCreate")); 	
-	
 	//validate params
 	//length must be multiple of 4, greater than 0 and < kmaxlength
 	if ((aLength & 3) || (aLength > DMsgQueue::KMaxLength) || (aLength < 4))
@@ -57,7 +54,7 @@ TInt ExecHandler::MsgQueueCreate(const TDesC8* aName, TInt aSize, TInt aLength,
 	DMsgQueue* pMQ=new DMsgQueue;
 	if (pMQ)
 		{
-		ret = pMQ->Create(pOwner, pName, aLength, aSize);
+		ret = pMQ->Create(pOwner, pName, aLength, aSize, ETrue, aShared);
 
 		if (KErrNone == ret)
 			{
@@ -73,6 +70,18 @@ TInt ExecHandler::MsgQueueCreate(const TDesC8* aName, TInt aSize, TInt aLength,
 	return ret;
 	}
 
+TInt ExecHandler::MsgQueueCreate(const TDesC8* aName, TInt aSize, TInt aLength, TOwnerType aType)
+	{
+	__KTRACE_OPT(KEXEC,Kern::Printf("Exec::MsgQueueCreate")); 	
+	return DoMsgQueueCreate(aName, aSize, aLength, aType, EFalse);
+	}
+
+TInt ExecHandler::MsgQueueCreateShared(const TDesC8* aName, TInt aSize, TInt aLength, TOwnerType aType)
+	{
+	__KTRACE_OPT(KEXEC,Kern::Printf("Exec::MsgQueueCreateShared")); 	
+	return DoMsgQueueCreate(aName, aSize, aLength, aType, ETrue);
+	}
+
 TInt ExecHandler::MsgQueueSend(TInt aMsgQueueHandle, const TAny* aPtr, TInt aLength)
 	{
 	__KTRACE_OPT(KEXEC,Kern::Printf("Exec::MsgQueueSend")); 	
@@ -128,8 +137,20 @@ TInt ExecHandler::MsgQueueSize(DMsgQueue* aMsgQueue)
 	return aMsgQueue->MessageSize();
 	}
 
+TUint8* ExecHandler::MsgQueueRing(DMsgQueue* aMsgQueue)
+	{
+	__KTRACE_OPT(KEXEC,Kern::Printf("Exec::MsgQueueRing")); 	
+	return aMsgQueue->RingBase();
+	}
+
+void ExecHandler::MsgQueueSignal(DMsgQueue* aMsgQueue, TInt aWaiters)
+	{
+	__KTRACE_OPT(KEXEC,Kern::Printf("Exec::MsgQueueSignal")); 	
+	aMsgQueue->Signal(aWaiters);
+	}
+
 
-TInt DMsgQueue::Create(DObject* aOwner, const TDesC* aName, TInt aMsgLength, TInt aSlotCount, TBool aVisible)
+TInt DMsgQueue::Create(DObject* aOwner, const TDesC* aName, TInt aMsgLength, TInt aSlotCount, TBool aVisible, TBool aShared)
 // Enter and leave with system unlocked
 	{
 
@@ -150,6 +171,15 @@ TInt DMsgQueue::Create(DObject* aOwner, const TDesC* aName, TInt aMsgLength, TIn
 	if (ret != KErrNone)
 		return ret;
 
+	iMaxMsgLength = (TUint16)aMsgLength;
+	if (aShared)
+		{
+		ret = CreateRing(aSlotCount);
+		if (ret == KErrNone && aVisible)
+			ret = K::AddObject(this,EMsgQueue);
+		return ret;
+		}
+
 	//Kern::Alloc asserts if the size is > KMaxTint/2 so guard against this
 	if (aSlotCount > (KMaxTInt/2) / aMsgLength)
 		return KErrNoMemory;
@@ -159,7 +189,6 @@ TInt DMsgQueue::Create(DObject* aOwner, const TDesC* aName, TInt aMsgLength, TIn
 	if (!iMsgPool)	
 		return KErrNoMemory;
 
-	iMaxMsgLength = (TUint16)aMsgLength;
 	iFirstFreeSlot = iMsgPool;
 	iFirstFullSlot = iMsgPool;
 	iEndOfPool = iMsgPool + iMaxMsgLength * aSlotCount;
@@ -170,6 +199,46 @@ TInt DMsgQueue::Create(DObject* aOwner, const TDesC* aName, TInt aMsgLength, TIn
 	return ret;
 	}
 
+TInt DMsgQueue::CreateRing(TInt aSlotCount)
+// Enter and leave with system unlocked, in a critical section
+//
+// The slot ring of a shared queue lives in a shared chunk so that user side
+// can send and receive without an executive call. The slot count is rounded
+// up to a power of 2 so that positions can wrap freely.
+	{
+	TUint32 slots = 1u << __e32_find_ms1_32(aSlotCount);
+	if (slots < TUint32(aSlotCount))
+		slots <<= 1;
+	TInt slotSize = iMaxMsgLength + sizeof(TUint32);
+	if (slots > TUint32((KMaxTInt/2) / slotSize))
+		return KErrNoMemory;
+	TInt size = Kern::RoundToPageSize(sizeof(SMsgQueueRing) + slots * slotSize);
+
+	TChunkCreateInfo info;
+	info.iType = TChunkCreateInfo::ESharedKernelMultiple;
+	info.iMaxSize = size;
+	info.iMapAttr = EMapAttrUserRw | EMapAttrCachedMax;
+	info.iOwnsMemory = ETrue;
+	TLinAddr kernAddr;
+	TUint32 mapAttr;
+	TInt r = Kern::ChunkCreate(info, iRingChunk, kernAddr, mapAttr);
+	if (r != KErrNone)
+		return r;
+	r = Kern::ChunkCommit(iRingChunk, 0, size);
+	if (r != KErrNone)
+		return r;	// chunk is closed by the destructor
+
+	iRing = (SMsgQueueRing*)kernAddr;
+	iRingMask = slots - 1;
+	memclr(iRing, sizeof(SMsgQueueRing));
+	iRing->iSlotCount = slots;
+	iRing->iSlotSize = slotSize;
+	iRing->iMsgLength = iMaxMsgLength;
+	for (TUint32 i=0; i<slots; ++i)
+		*iRing->Slot(i) = i;
+	return KErrNone;
+	}
+
 DMsgQueue::~DMsgQueue()
 	{
 	//no problem with race condition here, don't need temporary copy of thread ptrs
@@ -184,6 +253,8 @@ DMsgQueue::~DMsgQueue()
 		iThreadWaitingOnSpaceAvail->Close(NULL);
 		}
 	Kern::Free(iMsgPool);
+	if (iRingChunk)
+		Kern::ChunkClose(iRingChunk);
 	Kern::DestroyClientRequest(iDataAvailRequest);
 	Kern::DestroyClientRequest(iSpaceAvailRequest);
 	}
@@ -195,6 +266,13 @@ TInt DMsgQueue::Send(const TAny* aPtr, TInt aLength)
 	if (aLength > iMaxMsgLength || aLength <= 0)
 		K::PanicCurrentThread(EMsgQueueInvalidLength);
 
+	if (iRing)
+		{
+		//shared queues are only accessed through RSharedMsgQueueBase
+		NKern::UnlockSystem();
+		return KErrNotSupported;
+		}
+
 	if (iState == EFull)
 		{
 		NKern::UnlockSystem();
@@ -223,6 +301,12 @@ TInt DMsgQueue::Receive(TAny* aPtr, TInt aLength)
 	if (aLength != iMaxMsgLength)
 		K::PanicCurrentThread(EMsgQueueInvalidLength);
 
+	if (iRing)
+		{
+		NKern::UnlockSystem();
+		return KErrNotSupported;
+		}
+
 	if (iState == EEmpty)
 		{
 		NKern::UnlockSystem();
@@ -274,8 +358,21 @@ void DMsgQueue::RequestNotification(TNotification aNotification, TRequestStatus*
 		aThread = NULL;
 		aRequest->Reset();
 		}
-	if ((aNotification == ESpaceAvailable && iState != EFull) ||
-		(aNotification == EDataAvailable  && iState != EEmpty))
+	TBool ready;
+	if (iRing)
+		{
+		//Tell user side a waiter must be signalled before looking at the ring,
+		//so that a message sent concurrently either is seen here or signals us.
+		TUint32 waiter = (aNotification == EDataAvailable) ? SMsgQueueRing::EDataWaiter : SMsgQueueRing::ESpaceWaiter;
+		__e32_atomic_ior_ord32(&iRing->iWaiters, waiter);
+		ready = RingReady(aNotification);
+		if (ready)
+			__e32_atomic_and_ord32(&iRing->iWaiters, ~waiter);
+		}
+	else
+		ready = (aNotification == ESpaceAvailable && iState != EFull) ||
+				(aNotification == EDataAvailable  && iState != EEmpty);
+	if (ready)
 		Kern::RequestComplete(aStatus, KErrNone);
 	else
 		{
@@ -298,15 +395,38 @@ void DMsgQueue::RequestNotification(TNotification aNotification, TRequestStatus*
 	}
  
 
+TBool DMsgQueue::RingReady(TNotification aNotification)
+// Enter and leave with system locked
+//
+// The ring header is writable by user side so only the positions are taken
+// from it, and they are masked with our own copy of the slot count.
+	{
+	TUint8* slots = (TUint8*)(iRing + 1);
+	TInt slotSize = iMaxMsgLength + sizeof(TUint32);
+	if (aNotification == EDataAvailable)
+		{
+		TUint32 pos = iRing->iTail;
+		return __e32_atomic_load_acq32(slots + (pos & iRingMask) * slotSize) == pos + 1;
+		}
+	//a slot ahead of iHead means another producer has just claimed it, so
+	//report space and let the sender retry
+	TUint32 pos = iRing->iHead;
+	return TInt(__e32_atomic_load_acq32(slots + (pos & iRingMask) * slotSize) - pos) >= 0;
+	}
+
 void DMsgQueue::CancelSpaceAvailable()
 // Enter with system locked, leave with system unlocked
 	{
+	if (iRing)
+		__e32_atomic_and_ord32(&iRing->iWaiters, ~SMsgQueueRing::ESpaceWaiter);
 	CompleteRequestIfPending(iThreadWaitingOnSpaceAvail, iSpaceAvailRequest, KErrCancel);
 	}
 
 void DMsgQueue::CancelDataAvailable()
 // Enter with system locked, leave with system unlocked
 	{
+	if (iRing)
+		__e32_atomic_and_ord32(&iRing->iWaiters, ~SMsgQueueRing::EDataWaiter);
 	CompleteRequestIfPending(iThreadWaitingOnDataAvail, iDataAvailRequest, KErrCancel);
 	}
 
@@ -338,3 +458,51 @@ TInt DMsgQueue::MessageSize() const
 // Enter with system locked, leave with system locked
 	return iMaxMsgLength;
 	}
+
+TUint8* DMsgQueue::RingBase()
+// Enter with system locked, leave with system locked
+//
+// Returns the address of the slot ring in the current process, NULL unless
+// the queue is shared.
+	{
+	return iRingChunk ? iRingChunk->Base(&Kern::CurrentProcess()) : NULL;
+	}
+
+TInt DMsgQueue::AddToProcess(DProcess* aProcess)
+// Enter and leave with system unlocked, in a critical section
+//
+// The slot ring of a shared queue is mapped into a process for as long as the
+// process has a handle to the queue, so user side never holds a handle to it.
+	{
+	if (!iRingChunk)
+		return KErrNone;
+	iRingChunk->Open();		// balanced in Close(aProcess), even if this fails
+	return iRingChunk->AddToProcess(aProcess);
+	}
+
+TInt DMsgQueue::Close(TAny* aPtr)
+	{
+	if (aPtr && iRingChunk)
+		iRingChunk->Close(aPtr);	// a handle has been closed, unmap the ring from the process
+	return DObject::Close(aPtr);
+	}
+
+void DMsgQueue::Signal(TInt aWaiters)
+// Enter with system locked, leave with system unlocked
+//
+// Called by user side after sending or receiving on a shared queue, when it
+// sees that a waiter must be woken.
+	{
+	if (iRing && aWaiters == SMsgQueueRing::EDataWaiter)
+		{
+		__e32_atomic_and_ord32(&iRing->iWaiters, ~SMsgQueueRing::EDataWaiter);
+		CompleteRequestIfPending(iThreadWaitingOnDataAvail, iDataAvailRequest, KErrNone);
+		}
+	else if (iRing && aWaiters == SMsgQueueRing::ESpaceWaiter)
+		{
+		__e32_atomic_and_ord32(&iRing->iWaiters, ~SMsgQueueRing::ESpaceWaiter);
+		CompleteRequestIfPending(iThreadWaitingOnSpaceAvail, iSpaceAvailRequest, KErrNone);
+		}
+	else
+		NKern::UnlockSystem();
+	}
@@ -59,6 +59,7 @@ public:
 
 	static TInt FindGetI(TUint aCategory, TUint aKey, TInt* aValue, DProcess*);
 	static TInt FindSetI(TUint aCategory, TUint aKey, TInt aValue, DProcess*);
+	static TInt SetMany(const SPropertyBatchItem* aItems, TInt aCount, DProcess*);
 
 	// Called with system or feature locked
 	TBool IsDefined()
@@ -124,9 +125,11 @@ private:
 	static void CompleteDfcByKErrNotFound(TAny* aQue);
 	static void CompleteCancellationQDfc(TAny* aQue);
 	
-	static TUint Hash(TUint aCategory, TUint aKey);
+	static TUint Hash(TUint aCategory, TUint aKey, TUint aMask);
 	static TProperty** Lookup(TUint aCategory, TUint aKey);
 	static TInt LookupOrCreate(TUint aCategory, TUint aKey, TProperty**);
+	static TProperty* LookupAndUse(TUint aCategory, TUint aKey);
+	static void GrowTable();
 
 	TAny* operator new(TUint aSize) __NO_THROW
 		{ return Kern::AllocZ(aSize); }
@@ -212,8 +215,18 @@ private:
 	static DMutex*	FeatureLock;			///< Order KMutexOrdPubSub
 
 	// hash table collision lists
-	enum { KHashTableLimit = 32 };	// must be power of 2
-	static TProperty*	Table[KHashTableLimit];	// protected by the feature lock
+	// The table is only changed with the feature lock held, and the bucket
+	// heads, Table, TableMask and TableGen are only written with TableLock
+	// also held for writing. Lookups that only need to take a reference on
+	// a property hold TableLock for reading instead of the feature lock, so
+	// concurrent FindGetI()/FindSetI()/Open() calls don't serialise.
+	enum { KHashTableInitial = 32 };	// must be power of 2
+	enum { KHashTableLoad = 2 };		// grow when average chain length exceeds this
+	static TProperty**	Table;
+	static TUint		TableMask;		// number of buckets - 1
+	static TUint		TableCount;		// number of properties - protected by the feature lock
+	static TUint		TableGen;		// index of the iNext link used by the current table
+	static TRWSpinLock	TableLock;
 	
 #ifdef __DEMAND_PAGING__
 	static DMutex*	PagingLockMutex;		///< Mutex used to protect demand paging lock, order KMutexOrdPubSub2
@@ -231,9 +244,9 @@ private:
 	TCompiledSecurityPolicy iWritePolicy;
 	TUint32	iOwner;
 
-	TUint		iRefCount;	// protected by the feature lock
-	TProperty*	iNext;		// hash table collision list link -
-							//		protected by the feature lock
+	TUint		iRefCount;	// atomic; dropping to zero requires the feature lock
+	TProperty*	iNext[2];	// hash table collision list links - protected by the
+							//		feature lock and TableLock, see GrowTable()
 
 	class TBuf
 		{ // Viraiable-size buffer for  byte array property values
@@ -299,7 +312,11 @@ TDfc		TProperty::CancellationDfc(TProperty::CompleteCancellationQDfc, &TProperty
 SDblQue		TProperty::CancellationQue;
 
 DMutex*		TProperty::FeatureLock;	
-TProperty*	TProperty::Table[KHashTableLimit];
+TProperty**	TProperty::Table;
+TUint		TProperty::TableMask;
+TUint		TProperty::TableCount;
+TUint		TProperty::TableGen;
+TRWSpinLock	TProperty::TableLock(TSpinLock::EOrderGenericIrqLow2);
 
 #ifdef __DEMAND_PAGING__
 DMutex*		TProperty::PagingLockMutex;
@@ -317,6 +334,10 @@ TInt TProperty::Init()
 	TInt r = Kern::MutexCreate(FeatureLock, KPubSubMutexName, KMutexOrdPubSub);
 	if (r != KErrNone)
 		return r;
+	Table = (TProperty**)Kern::AllocZ(KHashTableInitial * sizeof(TProperty*));
+	if (!Table)
+		return KErrNoMemory;
+	TableMask = KHashTableInitial - 1;
 	CompletionDfc.SetDfcQ(K::SvMsgQ);
 	CompletionDfcPermissionDenied.SetDfcQ(K::SvMsgQ);
 	CompletionDfcNotFound.SetDfcQ(K::SvMsgQ);
@@ -340,23 +361,27 @@ TInt TProperty::Init()
 TProperty::TProperty(TUint aCategory, TUint aKey) : iCategory(aCategory), iKey(aKey)
 	{ SetNotDefined(); }
 
-TUint TProperty::Hash(TUint aCategory, TUint aKey)
-	{ // a naive hash function 
-	TUint code = (aCategory ^ aKey) & (KHashTableLimit - 1);
-	__PS_ASSERT(code < KHashTableLimit);	// KHashTableLimit must be a power of 2
-	return code;
+TUint TProperty::Hash(TUint aCategory, TUint aKey, TUint aMask)
+	{ // static
+	// Categories are usually UIDs and keys small integers, so mix the
+	// category so that properties with the same key spread over the table.
+	TUint code = (aCategory * 0x9E3779B1u) ^ aKey;
+	code ^= code >> 16;
+	return code & aMask;
 	}
 
 // Called feature locked.
 TProperty** TProperty::Lookup(TUint aCategory, TUint aKey)
 	{ // static
-	TProperty** propP = &Table[Hash(aCategory, aKey)];
+	__ASSERT_MUTEX(FeatureLock);
+	TUint gen = TableGen;
+	TProperty** propP = &Table[Hash(aCategory, aKey, TableMask)];
 	for (;;)
 		{
 		TProperty* prop = *propP;
 		if (!prop) break;
 		if ((prop->iCategory == aCategory) && (prop->iKey == aKey)) break;
-		propP = &prop->iNext;
+		propP = &prop->iNext[gen];
 		}
 	return propP;
 	}
@@ -373,12 +398,67 @@ TInt TProperty::LookupOrCreate(TUint aCategory, TUint aKey, TProperty** aProp)
 			{
 			return KErrNoMemory;
 			}
-		*propP = prop;			
+		__SPIN_LOCK_IRQ_W(TableLock);
+		*propP = prop;
+		__SPIN_UNLOCK_IRQ_W(TableLock);
+		if (++TableCount > (TableMask + 1) * KHashTableLoad)
+			GrowTable();
 		}
 	*aProp = prop;
 	return KErrNone;
 	}
 
+// Find a property and take a reference on it without the feature lock.
+// A property is removed from the table with TableLock held for writing at
+// the same time as its reference count drops to zero, so any property
+// found while holding TableLock for reading can safely be used.
+// Called in CS.
+TProperty* TProperty::LookupAndUse(TUint aCategory, TUint aKey)
+	{ // static
+	__SPIN_LOCK_IRQ_R(TableLock);
+	TUint gen = TableGen;
+	TProperty* prop = Table[Hash(aCategory, aKey, TableMask)];
+	while (prop && ((prop->iCategory != aCategory) || (prop->iKey != aKey)))
+		prop = prop->iNext[gen];
+	if (prop)
+		__e32_atomic_add_ord32(&prop->iRefCount, 1);
+	__SPIN_UNLOCK_IRQ_R(TableLock);
+	return prop;
+	}
+
+// Double the number of hash buckets.
+// The new table is threaded through the iNext link which the current table
+// doesn't use, so lookups can continue through the current table while it
+// is built and TableLock only has to be held to switch tables.
+// Called feature locked, in CS.
+void TProperty::GrowTable()
+	{ // static
+	__ASSERT_MUTEX(FeatureLock);
+	TUint mask = (TableMask << 1) | 1;
+	TProperty** table = (TProperty**)Kern::AllocZ((mask + 1) * sizeof(TProperty*));
+	if (!table)
+		return;		// carry on with longer collision lists
+	TUint gen = TableGen;
+	TUint newGen = gen ^ 1;
+	for (TUint i = 0; i <= TableMask; ++i)
+		{
+		for (TProperty* prop = Table[i]; prop; prop = prop->iNext[gen])
+			{
+			TProperty** head = &table[Hash(prop->iCategory, prop->iKey, mask)];
+			prop->iNext[newGen] = *head;
+			*head = prop;
+			}
+		}
+	TProperty** oldTable = Table;
+	__SPIN_LOCK_IRQ_W(TableLock);
+	Table = table;
+	TableMask = mask;
+	TableGen = newGen;
+	__SPIN_UNLOCK_IRQ_W(TableLock);
+	// No lookup can still be using the old table once we've had the write lock
+	Kern::Free(oldTable);
+	}
+
 #ifndef __REMOVE_PLATSEC_DIAGNOSTIC_STRINGS__
 TBool TProperty::DoCheckDefineRights(DProcess* aProcess, const char* aDiagnostic)
 	{
@@ -581,8 +661,13 @@ TInt TProperty::Define(const TPropertyInfo* aInfo, DProcess* aProcess)
 // Called in CS
 TInt TProperty::Attach(TUint aCategory, TUint aKey, TProperty** aProp)
 	{ //static 
+	TProperty* prop = LookupAndUse(aCategory, aKey);
+	if (prop)
+		{
+		*aProp = prop;
+		return KErrNone;
+		}
 	Lock();
-	TProperty* prop;
 	// Attach can create a non defined property.
 	TInt r = LookupOrCreate(aCategory, aKey, &prop);
 	if (r != KErrNone) 
@@ -599,22 +684,21 @@ TInt TProperty::Attach(TUint aCategory, TUint aKey, TProperty** aProp)
 // Called in CS
 TInt TProperty::Open(TUint aCategory, TUint aKey, TProperty** aProp)
 	{ //static 
-	Lock();
-	TProperty* prop = *Lookup(aCategory, aKey);
+	TProperty* prop = LookupAndUse(aCategory, aKey);
 	if (!prop) 
 		{
-		Unlock();
 		return KErrNotFound;
 		}
-	prop->Use();
 	*aProp = prop;
-	Unlock();
 	return KErrNone;
 	}
 
 // Called in CS
 void TProperty::Close()
 	{
+	// Only the last reference needs the feature lock
+	if (__e32_atomic_tas_ord32(&iRefCount, 2, -1, 0) >= 2)
+		return;
 	Lock();
 	Release();
 	// '*this' may do not exist any more
@@ -666,7 +750,7 @@ TInt TProperty::Delete(DProcess* aProcess)
 inline void TProperty::Use()
 	{
 	__ASSERT_MUTEX(FeatureLock);
-	++iRefCount;
+	__e32_atomic_add_ord32(&iRefCount, 1);
 	}
 
 // Enter feature locked.
@@ -674,13 +758,21 @@ inline void TProperty::Use()
 void TProperty::Release()
 	{
 	__ASSERT_MUTEX(FeatureLock);
+	// Lookup to find the previous element in the simply linked collision list.
+	TProperty** propP = Lookup(iCategory, iKey);
+	__PS_ASSERT(*propP == this);
+	// Drop the reference and remove the property from the table atomically
+	// with respect to LookupAndUse()
+	__SPIN_LOCK_IRQ_W(TableLock);
 	__PS_ASSERT(iRefCount);
-	if (--iRefCount == 0)
+	TBool last = (__e32_atomic_add_ord32(&iRefCount, TUint32(-1)) == 1);
+	if (last)
+		*propP = iNext[TableGen];
+	__SPIN_UNLOCK_IRQ_W(TableLock);
+	if (last)
 		{
 		__PS_ASSERT(!IsDefined()); // property must not be defined.
-		// Lookup to find the previous element in the simply linked collision list.
-		TProperty** propP = Lookup(iCategory, iKey);
-		*propP = iNext;
+		--TableCount;
 		delete this;
 		}
 	}
@@ -885,35 +977,106 @@ TInt TProperty::GetI(TInt* aValue, DProcess* aProcess)
 	return KErrNone;
 	}
 
+// Called in CS
 TInt TProperty::FindGetI(TUint aCategory, TUint aKey, TInt* aValue, DProcess* aProcess)
 	{
-	Lock();
-	TProperty* prop = *TProperty::Lookup(aCategory, aKey);
-	TInt r;
+	TProperty* prop = LookupAndUse(aCategory, aKey);
 	if (!prop) 
-		r = KErrNotFound;
-	else
-		{
-		NKern::LockSystem();
-		r = prop->GetI(aValue, aProcess);
-		}
-	Unlock();
+		return KErrNotFound;
+	NKern::LockSystem();
+	TInt r = prop->GetI(aValue, aProcess);
+	prop->Close();
 	return r;
 	}
 
+// Called in CS
 TInt TProperty::FindSetI(TUint aCategory, TUint aKey, TInt aValue, DProcess* aProcess)
 	{
-	Lock();
-	TProperty* prop = *TProperty::Lookup(aCategory, aKey);
-	TInt r;
+	TProperty* prop = LookupAndUse(aCategory, aKey);
 	if (!prop) 
-		r = KErrNotFound;
-	else
+		return KErrNotFound;
+	NKern::LockSystem();
+	TInt r = prop->SetI(aValue, aProcess);
+	prop->Close();
+	return r;
+	}
+
+// Set the values of a batch of properties, all or none of them.
+// All the properties are checked with the feature lock held, which stops any
+// of them being defined or deleted or having their buffers replaced, then all
+// the values are set and their pending subscriptions moved to the completion
+// queue within one hold of the system lock, so the completion DFC runs once
+// for the whole batch.
+// aItems must be a kernel copy of the batch, with byte-array values in kernel memory.
+// Called in CS
+TInt TProperty::SetMany(const SPropertyBatchItem* aItems, TInt aCount, DProcess* aProcess)
+	{ // static
+	__ASSERT_CRITICAL;
+	TProperty** props = (TProperty**)Kern::AllocZ(aCount * (sizeof(TProperty*) + sizeof(TBuf*)));
+	if (!props)
+		return KErrNoMemory;
+	TBuf** bufs = (TBuf**)(props + aCount);
+	TInt r = KErrNone;
+	TInt i;
+	Lock();
+	for (i = 0; i < aCount && r == KErrNone; ++i)
+		{
+		const SPropertyBatchItem& item = aItems[i];
+		TProperty* prop = *Lookup(item.iCategory, item.iKey);
+		props[i] = prop;
+		if (!prop || !prop->IsDefined())
+			r = KErrNotFound;
+		else if (aProcess && !prop->CheckSetRights(aProcess, __PLATSEC_DIAGNOSTIC_STRING("Checked whilst trying to Set a Publish and Subscribe Property")))
+			r = KErrPermissionDenied;
+		else if ((prop->iType == RProperty::EInt) != (item.iSize < 0))
+			r = KErrArgument;
+		else if (item.iSize > RProperty::KMaxPropertySize)
+			r = KErrTooBig;
+		else if (item.iSize > prop->BufSize())
+			{
+			// Buffers are replaced in order, so any buffer this property has
+			// by the time this value is set is at least this size
+			bufs[i] = TBuf::New(item.iSize);
+			if (!bufs[i])
+				r = KErrNoMemory;
+			}
+		}
+	if (r == KErrNone)
 		{
+		TBool complete = EFalse;
 		NKern::LockSystem();
-		r = prop->SetI(aValue, aProcess);
+		for (i = 0; i < aCount; ++i)
+			{
+			const SPropertyBatchItem& item = aItems[i];
+			TProperty* prop = props[i];
+			if (item.iSize < 0)
+				prop->iValue = item.iValue;
+			else
+				{
+				if (bufs[i])
+					{ // the old buffer is deleted once the locks are released
+					TBuf* oldBuf = prop->iBuf;
+					prop->iBuf = bufs[i];
+					bufs[i] = oldBuf;
+					}
+				memcpy(prop->Buf(), item.iBuf, item.iSize);
+				prop->SetSize(item.iSize);
+				}
+			if (!prop->iPendingQue.IsEmpty())
+				{
+				CompletionQue.MoveFrom(&prop->iPendingQue);
+				complete = ETrue;
+				}
+			}
+		if (complete)
+			CompletionDfc.Enque(SYSTEM_LOCK);
+		else
+			NKern::UnlockSystem();
 		}
 	Unlock();
+	for (i = 0; i < aCount; ++i)
+		delete bufs[i];
+	Kern::Free(props);
 	return r;
 	}
 
@@ -1716,6 +1879,65 @@ TInt ExecHandler::PropertyFindSetB(TUint aCategory, TUint aKey, TUint8* aBuf,
 	return r;
 	}
 
+// Enter and return system unlocked.
+TInt ExecHandler::PropertySetMany(const SPropertyBatchItem* aItems, TInt aCount)
+	{
+	if (TUint(aCount) > TUint(TPropertyBatch::KMaxItems))
+		return KErrArgument;
+
+	NKern::ThreadEnterCS();
+
+	// Take a kernel copy of the batch, and then of all its byte-array values
+	TInt r = KErrNoMemory;
+	TInt i;
+	SPropertyBatchItem* items = (SPropertyBatchItem*)Kern::Alloc(aCount * sizeof(SPropertyBatchItem));
+	if (items)
+		{
+		XTRAP(r, XT_DEFAULT, kumemget32(items, aItems, aCount * sizeof(SPropertyBatchItem)));
+		if (r != KErrNone)
+			r = KErrBadDescriptor;
+		}
+	TInt bytesSize = 0;
+	for (i = 0; i < aCount && r == KErrNone; ++i)
+		{
+		if (items[i].iSize > RProperty::KMaxPropertySize)
+			r = KErrTooBig;
+		else if (items[i].iSize > 0)
+			bytesSize += items[i].iSize;
+		}
+	TUint8* bytes = NULL;
+	if (r == KErrNone && bytesSize)
+		{
+		bytes = (TUint8*)Kern::Alloc(bytesSize);
+		if (!bytes)
+			r = KErrNoMemory;
+		}
+	TUint8* p = bytes;
+	for (i = 0; i < aCount && r == KErrNone; ++i)
+		{
+		SPropertyBatchItem& item = items[i];
+		if (item.iSize > 0)
+			{
+			XTRAP(r, XT_DEFAULT, kumemget(p, item.iBuf, item.iSize));
+			if (r != KErrNone)
+				r = KErrBadDescriptor;
+			item.iBuf = p;
+			p += item.iSize;
+			}
+		}
+
+	if (r == KErrNone)
+		r = TProperty::SetMany(items, aCount, CurProcess());
+
+	Kern::Free(bytes);
+	Kern::Free(items);
+	NKern::ThreadLeaveCS();
+
+	if (r == KErrBadDescriptor)
+		K::PanicKernExec(ECausedException);
+	return r;
+	}
+
 /** Attaches to a property.
 
 	This performs the same action as RPropertyRef::Open(). However, if the property does
@@ -562,6 +562,7 @@ TInt TPagedCodeInfo::ReadBlockMap(const TCodeSegCreateInfo& aInfo)
 		break;
 
 	case KUidCompressionBytePair:
+	case KUidCompressionLz4:
 		{
 		if(!aInfo.iCodePageOffsets)
 			return KErrArgument;
@@ -15,6 +15,7 @@
 
 #include <plat_priv.h>
 #include "cache_maintenance.h"
+#include "memmodel.h"
 #include "mm.h"
 #include "mmu.h"
 #include "mmanager.h"
@@ -42,6 +43,8 @@ private:
 	virtual void Destruct(DMemoryObject* aMemory);
 	virtual void Free(DMemoryObject* aMemory, TUint aIndex, TUint aCount);
 	virtual TInt CleanPage(DMemoryObject* aMemory, SPageInfo* aPageInfo, TPhysAddr*& aPageArrayEntry);
+	virtual TInt HandleFault(	DMemoryObject* aMemory, TUint aIndex, DMemoryMapping* aMapping, 
+								TUint aMapInstanceCount, TUint aAccessPermissions);
 
 	// from DPagedMemoryManager...
 	virtual void Init3();
@@ -49,6 +52,7 @@ private:
 	virtual TInt AcquirePageReadRequest(DPageReadRequest*& aRequest, DMemoryObject* aMemory, TUint aIndex, TUint aCount);
 	virtual TInt ReadPages(DMemoryObject* aMemory, TUint aIndex, TUint aCount, TPhysAddr* aPages, DPageReadRequest* aRequest);
 	virtual TBool IsAllocated(DMemoryObject* aMemory, TUint aIndex, TUint aCount);
+	virtual TUint ReadAheadLimit(DMemoryObject* aMemory, TUint aIndex);
 
 private:
 	/**
@@ -58,6 +62,12 @@ private:
 	*/
 	DPagingDevice* iDevice[KMaxLocalDrives];
 
+	/**
+	True if code segments created now should record which of their pages are accessed.
+	@see SetCodePageProfiling
+	*/
+	TBool iProfiling;
+
 public:
 	/**
 	The single instance of this manager class.
@@ -65,6 +75,7 @@ public:
 	static DCodePagedMemoryManager TheManager;
 
 	friend DPagingDevice* CodePagingDevice(TInt aDriveNum);
+	friend void SetCodePageProfiling(TBool aEnable);
 	};
 
 
@@ -83,6 +94,9 @@ DMemoryObject::iManagerData member.
 class DPagedCodeInfo : public DReferenceCountedObject
 	{
 public:
+	~DPagedCodeInfo()
+		{ Kern::Free(iProfile); }
+
 	/**
 	Return a reference to the embedded #TPagedCodeInfo.
 	*/
@@ -93,6 +107,13 @@ private:
 	@copybrief TPagedCodeInfo
 	*/
 	TPagedCodeInfo iInfo;
+public:
+	/**
+	Bitmap with a bit set for each page of code which has been accessed since the code was
+	loaded, or the null pointer if this isn't being recorded.
+	Access to this is protected by #MmuLock.
+	*/
+	TUint32* iProfile;
 	};
 
 
@@ -110,6 +131,7 @@ DPagingDevice* CodePagingDevice(TInt aDriveNum)
 void DCodePagedMemoryManager::Init3()
 	{
 	TRACEB(("DCodePagedMemoryManager::Init3()"));
+	iProfiling = (TheSuperPage().KernelConfigFlags() & EKernelConfigCodePagingProfile) != 0;
 	}
 
 
@@ -176,6 +198,10 @@ TInt DCodePagedMemoryManager::New(DMemoryObject*& aMemory, TUint aSizeInPages, T
 	if(!pagedCodeInfo)
 		return KErrNoMemory;
 
+	// if profiling, this code isn't essential so carry on without it if there's no memory...
+	if(iProfiling)
+		pagedCodeInfo->iProfile = (TUint32*)Kern::AllocZ(((aSizeInPages+31)>>5)*sizeof(TUint32));
+
 	TInt r = DPagedMemoryManager::New(aMemory, aSizeInPages, aAttributes, aCreateFlags);
 	if(r!=KErrNone)
 		pagedCodeInfo->Close();
@@ -327,6 +353,23 @@ done:
 	}
 
 
+TInt DCodePagedMemoryManager::HandleFault(	DMemoryObject* aMemory, TUint aIndex, DMemoryMapping* aMapping, 
+											TUint aMapInstanceCount, TUint aAccessPermissions)
+	{
+	if(iProfiling)
+		{
+		// record the access, ignoring any made by the loader before the code is loaded...
+		MmuLock::Lock();
+		DPagedCodeInfo* pagedCodeInfo = (DPagedCodeInfo*)aMemory->iManagerData;
+		if(pagedCodeInfo && pagedCodeInfo->iProfile && pagedCodeInfo->Info().iLoaded)
+			pagedCodeInfo->iProfile[aIndex>>5] |= 1u<<(aIndex&31);
+		MmuLock::Unlock();
+		}
+
+	return DPagedMemoryManager::HandleFault(aMemory, aIndex, aMapping, aMapInstanceCount, aAccessPermissions);
+	}
+
+
 TBool DCodePagedMemoryManager::IsAllocated(DMemoryObject* aMemory, TUint aIndex, TUint aCount)
 	{
 	// all pages allocated if memory not destroyed (iManagerData!=0)...
@@ -334,6 +377,13 @@ TBool DCodePagedMemoryManager::IsAllocated(DMemoryObject* aMemory, TUint aIndex,
 	}
 
 
+TUint DCodePagedMemoryManager::ReadAheadLimit(DMemoryObject* aMemory, TUint aIndex)
+	{
+	TUint limit = aMemory->iSizeInPages-aIndex-1;
+	return Min(limit,(TUint)DPageReadRequest::EMaxPages-1);
+	}
+
+
 TInt MM::PagedCodeNew(DMemoryObject*& aMemory, TUint aPageCount, TPagedCodeInfo*& aInfo)
 	{
 	TRACE(("MM::PagedCodeNew(?,0x%08x,0x%08x)",aPageCount,aInfo));
@@ -406,3 +456,117 @@ void MM::PagedCodeLoaded(DMemoryObject* aMemory, TLinAddr aLoadAddress)
 	aMemory->iPages.FindEnd(0,aMemory->iSizeInPages);
 	info.iLoaded = true; // allow ReadPage to start applying fixups when handling page faults
 	}
+
+
+//
+// Code page profiling
+//
+
+void SetCodePageProfiling(TBool aEnable)
+	{
+	DCodePagedMemoryManager::TheManager.iProfiling = aEnable;
+	}
+
+
+/**
+Find the demand paged code segment in the current process which contains a specified address,
+and open a reference on its memory object.
+
+@return The memory object, or the null pointer if the address isn't in demand paged code.
+
+@pre Calling thread must be in a critical section.
+*/
+static DMemoryObject* OpenPagedCodeMemory(TLinAddr aCodeAddress)
+	{
+	__ASSERT_CRITICAL;
+	DMemoryObject* memory = 0;
+	Kern::AccessCode();
+	DMemModelCodeSeg* seg = (DMemModelCodeSeg*)Kern::CodeSegFromAddress(aCodeAddress, TheCurrentThread->iOwningProcess);
+	if(seg && !seg->iXIP && seg->Memory() && seg->Memory()->iPagedCodeInfo)
+		{
+		memory = seg->Memory()->iCodeMemoryObject;
+		memory->Open();
+		}
+	Kern::EndAccessCode();
+	return memory;
+	}
+
+
+TInt GetCodePageProfile(TLinAddr aCodeAddress, TDes8* aProfileOut)
+	{
+	NKern::ThreadEnterCS();
+	TInt r = KErrNotFound;
+	DMemoryObject* memory = OpenPagedCodeMemory(aCodeAddress);
+	if(memory)
+		{
+		TUint size = ((memory->iSizeInPages+31)>>5)*sizeof(TUint32);
+		TUint32* profile = (TUint32*)Kern::Alloc(size);
+		r = KErrNoMemory;
+		if(profile)
+			{
+			MmuLock::Lock();
+			DPagedCodeInfo* pagedCodeInfo = (DPagedCodeInfo*)memory->iManagerData;
+			r = KErrNotReady;
+			if(pagedCodeInfo && pagedCodeInfo->iProfile)
+				{
+				memcpy(profile,pagedCodeInfo->iProfile,size);
+				r = memory->iSizeInPages;
+				}
+			MmuLock::Unlock();
+
+			if(r>=0)
+				Kern::KUDesPut(*aProfileOut,TPtrC8((TUint8*)profile,size));
+			Kern::Free(profile);
+			}
+		memory->AsyncClose();
+		}
+	NKern::ThreadLeaveCS();
+	return r;
+	}
+
+
+TInt PrefetchCodePages(TLinAddr aCodeAddress, const TDesC8* aProfile)
+	{
+	NKern::ThreadEnterCS();
+	TInt r = KErrNotFound;
+	DMemoryObject* memory = OpenPagedCodeMemory(aCodeAddress);
+	if(memory)
+		{
+		TUint pageCount = memory->iSizeInPages;
+		TUint size = ((pageCount+31)>>5)*sizeof(TUint32);
+		TUint32* profile = (TUint32*)Kern::AllocZ(size);
+		r = KErrNoMemory;
+		if(profile)
+			{
+			TInt length;
+			TInt maxLength;
+			Kern::KUDesInfo(*aProfile,length,maxLength);
+			r = KErrArgument;
+			if((TUint)length<=size)
+				{
+				TPtr8 profileDes((TUint8*)profile,size);
+				Kern::KUDesGet(profileDes,*aProfile);
+
+				// read in each run of pages marked in the profile...
+				r = KErrNone;
+				TUint i = 0;
+				while(i<pageCount && r==KErrNone)
+					{
+					if(!(profile[i>>5]&(1u<<(i&31))))
+						{
+						++i;
+						continue;
+						}
+					TUint start = i;
+					do ++i;
+					while(i<pageCount && (profile[i>>5]&(1u<<(i&31))));
+					r = TheCodePagedMemoryManager->Prefetch(memory,start,i-start);
+					}
+				}
+			Kern::Free(profile);
+			}
+		memory->AsyncClose();
+		}
+	NKern::ThreadLeaveCS();
+	return r;
+	}
@@ -23,4 +23,25 @@
 
 extern DPagingDevice* CodePagingDevice(TInt aDriveNum);
 
+/**
+Set whether code segments loaded from now on record which of their pages are accessed.
+*/
+extern void SetCodePageProfiling(TBool aEnable);
+
+/**
+Copy to a user descriptor the bitmap of accessed pages recorded for the demand paged code segment
+containing a specified address in the current process.
+
+@return The number of pages in the code segment, KErrNotFound if the address isn't in demand
+		paged code, or KErrNotReady if no profile was recorded for it.
+*/
+extern TInt GetCodePageProfile(TLinAddr aCodeAddress, TDes8* aProfileOut);
+
+/**
+Read into RAM the pages marked in a user supplied bitmap, in the format returned by
+#GetCodePageProfile, of the demand paged code segment containing a specified address in the
+current process.
+*/
+extern TInt PrefetchCodePages(TLinAddr aCodeAddress, const TDesC8* aProfile);
+
 #endif
@@ -144,6 +144,7 @@ private:
 
 public:
 	void GetSwapInfo(SVMSwapInfo& aInfoOut);
+	TInt GetSwapCompressionInfo(SVMSwapCompressionInfo& aInfoOut);
 	TInt SetSwapThresholds(const SVMSwapThresholds& aThresholds);
 	TBool PhysicalAccessSupported();
 	TBool UsePhysicalAccess();
@@ -692,11 +693,16 @@ TInt DSwapManager::DoWriteSwapPages(DMemoryObject** aMemory, TUint* aIndex, TUin
 
 /**
 Notify the media driver that the page written to swap is no longer required.
+
+This is always done for devices which need it to reclaim storage, e.g. compressed RAM swap.
 */
 void DSwapManager::DoDeleteNotify(TUint aSwapIndex)
 	{
 	__ASSERT_CRITICAL;  // so we can pass the paging device a stack-allocated TThreadMessage
-#ifdef __PAGING_DELETE_NOTIFY_ENABLED
+#ifndef __PAGING_DELETE_NOTIFY_ENABLED
+	if (!(iDevice->iFlags & DPagingDevice::ERequiresDeleteNotify))
+		return;
+#endif
 	const TUint readUnitShift = iDevice->iReadUnitShift;
 	const TUint size = KPageSize >> readUnitShift;
 	TUint offset = (aSwapIndex << KPageShift) >> readUnitShift;
@@ -706,7 +712,6 @@ void DSwapManager::DoDeleteNotify(TUint aSwapIndex)
 	// Ignore the return value as this is just an optimisation that is not supported on all media.
 	(void)iDevice->DeleteNotify(&msg, offset, size);
 	END_PAGING_BENCHMARK(EPagingBmDeleteNotifyDataPage);
-#endif
 	}
 
 
@@ -818,9 +823,33 @@ TInt DDataPagedMemoryManager::InstallPagingDevice(DPagingDevice* aDevice)
 		return KErrNone;
 		}
 
+	// A device which stacks on another data paging device gets the one installed after it as its
+	// backing store, or a media extension device in place of its existing backing store.
+	DPagingDevice* device = iDevice;
+	if (device && (device->iFlags & DPagingDevice::EStacksOnDataDevice) &&
+		!(aDevice->iFlags & DPagingDevice::EStacksOnDataDevice))
+		{
+		if (device->iBackingDevice && !(aDevice->iType & DPagingDevice::EMediaExtension))
+			{
+			__KTRACE_OPT2(KPAGING,KBOOT,Kern::Printf("**** Attempt to install more than one backing data paging device !!!!!!!! ****"));
+			return KErrAlreadyExists;
+			}
+		TRACEB(("DDataPagedMemoryManager::InstallPagingDevice backing store for 0x%08x",device));
+		__e32_atomic_store_ord_ptr(&device->iBackingDevice, aDevice);
+		return KErrNone;
+		}
+
 	// Store the device, blocking any other devices from installing.
-	// unless the device is a media extension device
-	if(aDevice->iType & DPagingDevice::EMediaExtension)
+	// unless the device is a media extension device, or stacks on the installed device
+	if(aDevice->iFlags & DPagingDevice::EStacksOnDataDevice)
+		{
+		aDevice->iBackingDevice = device;
+		delete iSwapManager;
+		iSwapManager = NULL;
+		TAny* null = 0;
+		__e32_atomic_store_ord_ptr(&iDevice, null);
+		}
+	else if(aDevice->iType & DPagingDevice::EMediaExtension)
 		{
 		delete iSwapManager;
 		iSwapManager = NULL;
@@ -1066,6 +1095,14 @@ void DDataPagedMemoryManager::GetSwapInfo(SVMSwapInfo& aInfoOut)
 	}
 
 
+TInt DDataPagedMemoryManager::GetSwapCompressionInfo(SVMSwapCompressionInfo& aInfoOut)
+	{
+	if (!(iDevice->iFlags & DPagingDevice::ESupportsCompressionInfo))
+		return KErrNotSupported;
+	return iDevice->GetCompressionInfo(aInfoOut);
+	}
+
+
 TInt DDataPagedMemoryManager::SetSwapThresholds(const SVMSwapThresholds& aThresholds)
 	{
 	return iSwapManager->SetSwapThresholds(aThresholds);
@@ -1078,6 +1115,12 @@ void GetSwapInfo(SVMSwapInfo& aInfoOut)
 	}
 
 
+TInt GetSwapCompressionInfo(SVMSwapCompressionInfo& aInfoOut)
+	{
+	return ((DDataPagedMemoryManager*)TheDataPagedMemoryManager)->GetSwapCompressionInfo(aInfoOut);
+	}
+
+
 TInt SetSwapThresholds(const SVMSwapThresholds& aThresholds)
 	{
 	return ((DDataPagedMemoryManager*)TheDataPagedMemoryManager)->SetSwapThresholds(aThresholds);
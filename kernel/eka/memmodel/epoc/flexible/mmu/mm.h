@@ -1156,7 +1156,7 @@ public:
 	TUint32 iDataDelta;					///< Delta to apply to relocate words referring to the data section.
 
 	TUint iCodeSize;					///< Size, in bytes, of the code section.
-	TUint32 iCompressionType;			///< Compression scheme in use, (KUidCompressionBytePair or KFormatNotCompressed).
+	TUint32 iCompressionType;			///< Compression scheme in use, (KUidCompressionBytePair, KUidCompressionLz4 or KFormatNotCompressed).
 	TInt32* iCodePageOffsets;			///< Array of compressed page offsets within the file.
 	TInt iCodeLocalDrive;				///< Local drive number.
 	TInt iCodeStartInFile;				///< Offset of (possibly compressed) code from start of file.
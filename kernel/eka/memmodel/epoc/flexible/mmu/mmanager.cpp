@@ -1579,6 +1579,50 @@ fail:
 TInt DPagedMemoryManager::HandleFault(	DMemoryObject* aMemory, TUint aIndex, DMemoryMapping* aMapping, 
 										TUint aMapInstanceCount, TUint aAccessPermissions)
 	{
+	TUint readAhead = EReadAheadAdaptive;
+	return DoHandleFault(aMemory,aIndex,aMapping,aMapInstanceCount,aAccessPermissions,readAhead);
+	}
+
+
+TUint DPagedMemoryManager::ReadAheadLimit(DMemoryObject* /*aMemory*/, TUint /*aIndex*/)
+	{
+	return 0;
+	}
+
+
+TUint DPagedMemoryManager::ReadAheadCount(DMemoryObject* aMemory, TUint aIndex, TUint aReadAhead)
+	{
+	__NK_ASSERT_DEBUG(MmuLock::IsHeld());
+
+	TUint count = aReadAhead;
+	if(count==EReadAheadAdaptive)
+		{
+		count = aMemory->iReadAheadCount;
+		if(aIndex==aMemory->iReadAheadNext)
+			{
+			// fault follows on from the last pages read, so read more this time...
+			count = count ? count<<1 : 1;
+			if(count>DPageReadRequest::EMaxPages-1)
+				count = DPageReadRequest::EMaxPages-1;
+			}
+		else
+			count >>= 1;
+		aMemory->iReadAheadCount = count;
+		}
+
+	TUint limit = ReadAheadLimit(aMemory,aIndex);
+	if(count>limit)
+		count = limit;
+
+	if(aReadAhead==EReadAheadAdaptive)
+		aMemory->iReadAheadNext = aIndex+1+count;
+	return count;
+	}
+
+
+TInt DPagedMemoryManager::DoHandleFault(DMemoryObject* aMemory, TUint aIndex, DMemoryMapping* aMapping, 
+										TUint aMapInstanceCount, TUint aAccessPermissions, TUint& aReadAhead)
+	{
 	TPinArgs pinArgs;
 	pinArgs.iReadOnly = !(aAccessPermissions&EReadWrite);
 
@@ -1589,6 +1633,7 @@ TInt DPagedMemoryManager::HandleFault(	DMemoryObject* aMemory, TUint aIndex, DMe
 	__NK_ASSERT_ALWAYS(p); // we should never run out of memory handling a paging fault
 
 	TInt r = 1; // positive value to indicate nothing done
+	TUint readAhead = 0;
 
 	// if memory object already has page, then we can use it...
 	MmuLock::Lock();
@@ -1597,17 +1642,35 @@ TInt DPagedMemoryManager::HandleFault(	DMemoryObject* aMemory, TUint aIndex, DMe
 		r = PageInDone(aMemory,aIndex,0,p);
 		__NK_ASSERT_DEBUG(r<=0); // can't return >0 as we didn't supply a new page
 		}
+	else
+		readAhead = ReadAheadCount(aMemory,aIndex,aReadAhead);
 	MmuLock::Unlock();
 
-	if(r>0)
+	// get array entries for any following pages to read with this one...
+	RPageArray::TIter readAheadList;
+	TPhysAddr* readAheadPages = 0;
+	TUint readAheadAdded = 0;
+	if(readAhead)
+		{
+		// memory for the page array of demand paged memory is preallocated, so this can't fail...
+		r = aMemory->iPages.AddStart(aIndex+1,readAhead,readAheadList,true);
+		__NK_ASSERT_ALWAYS(r==KErrNone);
+		readAheadAdded = readAhead;
+		readAhead = readAheadList.Pages(readAheadPages,readAhead);
+		r = 1;
+		}
+
+	TUint32 startTime = NKern::FastCounter();
+	while(r>0)
 		{
-		// need to read page from backing store...
+		// need to read page from backing store, and any pages after it...
+		TUint count = 1+readAhead;
 
 		// get paging request object...
 		DPageReadRequest* req;
 		do
 			{
-			r = AcquirePageReadRequest(req,aMemory,aIndex,1);
+			r = AcquirePageReadRequest(req,aMemory,aIndex,count);
 			__NK_ASSERT_DEBUG(r!=KErrNoMemory); // not allowed to allocated memory, therefore can't fail with KErrNoMemory
 			if(r==KErrNone)
 				{
@@ -1619,34 +1682,73 @@ TInt DPagedMemoryManager::HandleFault(	DMemoryObject* aMemory, TUint aIndex, DMe
 					r = PageInDone(aMemory,aIndex,0,p);
 					__NK_ASSERT_DEBUG(r<=0); // can't return >0 as we didn't supply a new page
 					}
+				else
+					{
+					// don't read ahead past any page someone else has since read...
+					for(TUint i=1; i<count; ++i)
+						if(RPageArray::IsPresent(readAheadPages[i-1]))
+							{
+							readAhead = i-1;
+							break;
+							}
+					}
 				MmuLock::Unlock();
 				}
 			}
 		while(r>0 && !req); // while not paged in && don't have a request object
 
+		if(r>0 && count!=1+readAhead)
+			{
+			// request object is for the wrong number of pages, so retry...
+			req->Release();
+			continue;
+			}
+
+		TBool retry = EFalse;
 		if(r>0)
 			{
 			// still need to read page from backing store...
 
-			// get RAM page...
-			TPhysAddr pagePhys;
-			r = ThePager.PageInAllocPages(&pagePhys,1,aMemory->RamAllocFlags());
+			// get RAM pages...
+			TPhysAddr pagePhys[DPageReadRequest::EMaxPages];
+			__NK_ASSERT_DEBUG(count<=DPageReadRequest::EMaxPages);
+			r = ThePager.PageInAllocPages(pagePhys,count,aMemory->RamAllocFlags());
 			__NK_ASSERT_DEBUG(r!=KErrNoMemory);
 			if(r==KErrNone)
 				{
-				// read data for page...
-				r = ReadPages(aMemory,aIndex,1,&pagePhys,req);
+				// read data for pages...
+				r = ReadPages(aMemory,aIndex,count,pagePhys,req);
 				__NK_ASSERT_DEBUG(r!=KErrNoMemory); // not allowed to allocated memory, therefore can't fail with KErrNoMemory
 				if(r!=KErrNone)
 					{
 					// error, so free unused pages...
-					ThePager.PageInFreePages(&pagePhys,1);
+					ThePager.PageInFreePages(pagePhys,count);
+					if(count>1)
+						{
+						// the error may only affect pages being read ahead, so retry without them...
+						readAhead = 0;
+						r = 1;
+						retry = ETrue;
+						}
 					}
 				else
 					{
-					// use new page...
+					// use pages read ahead, any which can't be used are freed by PageInDone...
+					TUint readAheadUsed = 0;
+					for(TUint i=1; i<count; ++i)
+						{
+						MmuLock::Lock();
+						if(PageInDone(aMemory,aIndex+i,SPageInfo::FromPhysAddr(pagePhys[i]),readAheadPages+i-1)>0)
+							++readAheadUsed;
+						MmuLock::Unlock();
+						}
+					if(count>1)
+						readAheadList.Added(count-1,readAheadUsed);
+
+					// use new page, last so it is the youngest of those read...
 					MmuLock::Lock();
-					r = PageInDone(aMemory,aIndex,SPageInfo::FromPhysAddr(pagePhys),p);
+					ThePager.RecordPageInLatency(startTime);
+					r = PageInDone(aMemory,aIndex,SPageInfo::FromPhysAddr(pagePhys[0]),p);
 					MmuLock::Unlock();
 					if(r>0)
 						{
@@ -1661,6 +1763,9 @@ TInt DPagedMemoryManager::HandleFault(	DMemoryObject* aMemory, TUint aIndex, DMe
 		// done with paging request object...
 		if(req)
 			req->Release();
+
+		if(!retry)
+			break;
 		}
 
 	// map page...
@@ -1673,14 +1778,38 @@ TInt DPagedMemoryManager::HandleFault(	DMemoryObject* aMemory, TUint aIndex, DMe
 		#endif
 		}
 
-	// finished with this page...
+	// finished with these pages...
 	aMemory->iPages.AddPageEnd(aIndex,usedNew);
+	if(readAheadAdded)
+		aMemory->iPages.AddEnd(aIndex+1,readAheadAdded);
+
+	aReadAhead = usedNew ? readAhead : 0;
 
 	__NK_ASSERT_ALWAYS(r!=KErrNoMemory); // we should never run out of memory handling a paging fault
 	return r;
 	}
 
 
+TInt DPagedMemoryManager::Prefetch(DMemoryObject* aMemory, TUint aIndex, TUint aCount)
+	{
+	__ASSERT_CRITICAL;
+	__NK_ASSERT_DEBUG(aIndex+aCount<=aMemory->iSizeInPages);
+
+	TUint end = aIndex+aCount;
+	while(aIndex<end)
+		{
+		TUint readAhead = end-aIndex-1;
+		if(readAhead>DPageReadRequest::EMaxPages-1)
+			readAhead = DPageReadRequest::EMaxPages-1;
+		TInt r = DoHandleFault(aMemory,aIndex,0,0,ESupervisorReadOnly,readAhead);
+		if(r!=KErrNone)
+			return r;
+		aIndex += 1+readAhead;
+		}
+	return KErrNone;
+	}
+
+
 TInt DPagedMemoryManager::Pin(DMemoryObject* aMemory, DMemoryMappingBase* aMapping, TPinArgs& aPinArgs)
 	{
 	__ASSERT_CRITICAL;
@@ -1907,7 +2036,7 @@ TInt DPagedMemoryManager::PageInDone(DMemoryObject* aMemory, TUint aIndex, SPage
 	TInt r = DoPageInDone(aMemory,aIndex,aPageInfo,aPageArrayEntry,false);
 
 	if(r>=0)
-		ThePager.PagedIn(aPageInfo);
+		ThePager.PagedInNew(aPageInfo);
 
 	// check page assigned correctly...
 #ifdef _DEBUG
@@ -2051,6 +2180,21 @@ TInt DPagedMemoryManager::Decompress(TUint32 aCompressionType, TLinAddr aDst, TU
 		}
 		break;
 
+	case SRomPageInfo::ELz4:
+	case KUidCompressionLz4:
+		{
+		TUint8* srcNext = 0;
+		START_PAGING_BENCHMARK;
+		r = Lz4Decompress((TUint8*)aDst, aDstBytes, (TUint8*)aSrc, aSrcBytes, srcNext);
+		END_PAGING_BENCHMARK(EPagingBmDecompress);
+		if (r > 0)
+			{
+			// decompression successful so check srcNext points to the end of the compressed data...
+			__NK_ASSERT_ALWAYS((TLinAddr)srcNext == aSrc + aSrcBytes);
+			}
+		}
+		break;
+
 	default:
 		r = KErrNotSupported;
 		break;
@@ -534,6 +534,22 @@ public:
 	*/
 	virtual TInt InstallPagingDevice(DPagingDevice* aDevice) = 0;
 
+	/**
+	Read a region of a memory object into RAM, without mapping it, so that later accesses to
+	it don't need to wait for the backing store.
+
+	Pages are read in batches of up to DPageReadRequest::EMaxPages and added to the live list
+	as if they had been read ahead of a page fault.
+
+	@param aMemory	A memory object associated with this manager.
+	@param aIndex	Page index for the start of the region.
+	@param aCount	Number of pages in the region.
+
+	@return KErrNone if successful,
+			otherwise one of the system wide error codes.
+	*/
+	TInt Prefetch(DMemoryObject* aMemory, TUint aIndex, TUint aCount);
+
 protected:
 
 	/**
@@ -609,6 +625,20 @@ protected:
 	*/
 	virtual TBool IsAllocated(DMemoryObject* aMemory, TUint aIndex, TUint aCount) =0;
 
+	/**
+	Return the maximum number of pages following a faulting page which may be read in along
+	with it, i.e. pages which exist in the backing store and are in the same memory object.
+
+	The default implementation returns zero, which disables read-ahead for the manager.
+
+	@param aMemory	A memory object associated with this manager.
+	@param aIndex	Page index of the faulting page.
+
+	@pre #MmuLock held.
+	@post #MmuLock held and must not have been released by this function.
+	*/
+	virtual TUint ReadAheadLimit(DMemoryObject* aMemory, TUint aIndex);
+
 protected:
 	/**
 	Do the action of #Pin for a subregion of a memory mapping.
@@ -695,6 +725,8 @@ protected:
 	The compression types supported are:
 	- Byte-Pair, specified with a compression type of
 	  SRomPageInfo::EBytePair or KUidCompressionBytePair.
+	- LZ4, specified with a compression type of
+	  SRomPageInfo::ELz4 or KUidCompressionLz4.
 	- No Compression, specified with a compression type of zero.
 
 	@param aCompressionType 	The type of decompression to use.
@@ -735,6 +767,41 @@ private:
 	@pre #MmuLock held.
 	*/
 	TInt PageInDone(DMemoryObject* aMemory, TUint aIndex, SPageInfo* aPageInfo, TPhysAddr* aPageArrayEntry);
+
+	/**
+	Do the action of #HandleFault, optionally reading a number of the following pages along
+	with the faulting page.
+
+	This is an implementation factor used to implement #HandleFault and #Prefetch.
+
+	@param aReadAhead	On entry, the number of following pages to read if the page needs
+						reading, or #EReadAheadAdaptive to choose this from the pattern of
+						previous page faults. On return, the number of following pages which
+						were read.
+
+	Other parameters are as for #HandleFault, except that \a aMapping may be the null
+	pointer if the page is not to be mapped.
+	*/
+	TInt DoHandleFault(	DMemoryObject* aMemory, TUint aIndex, DMemoryMapping* aMapping,
+						TUint aMapInstanceCount, TUint aAccessPermissions, TUint& aReadAhead);
+
+	/**
+	Work out how many pages to read following a page which needs to be read in by a page fault.
+
+	For #EReadAheadAdaptive, the number doubles, up to DPageReadRequest::EMaxPages-1, on each
+	fault which follows on from the pages read by the last one, and halves on any other fault.
+	So a memory object being accessed sequentially is read in increasingly large batches while
+	one accessed randomly is read a page at a time.
+
+	@pre #MmuLock held.
+	*/
+	TUint ReadAheadCount(DMemoryObject* aMemory, TUint aIndex, TUint aReadAhead);
+
+	enum
+		{
+		/** Value for the aReadAhead argument of #DoHandleFault. */
+		EReadAheadAdaptive = ~0u
+		};
 	};
 
 
@@ -192,6 +192,12 @@ struct SPageInfo
 		and is does not increase free page count when returned to the live list.
 		*/
 		EPinnedReserve	= 1<<0,
+
+		/**
+		When #iPagedState==#EPagedOld this indicates the page was added to the live list by the
+		scan-resistant replacement policy and has not yet had its access restricted.
+		*/
+		EProbation		= 1<<1,
 		};
 
 private:
@@ -902,6 +908,30 @@ public:
 		return oldFlags2&EPinnedReserve;
 		}
 
+	/**
+	Set the #EProbation flag.
+	@pre #MmuLock held.
+	@see EProbation.
+	*/
+	void SetProbation()
+		{
+		CheckAccess("SetProbation");
+		iFlags2 |= EProbation;
+		}
+
+	/**
+	Clear the #EProbation flag.
+	@pre #MmuLock held.
+	@see EProbation.
+	*/
+	TBool ClearProbation()
+		{
+		CheckAccess("ClearProbation");
+		TUint oldFlags2 = iFlags2;
+		iFlags2 = oldFlags2&~EProbation;
+		return oldFlags2&EProbation;
+		}
+
 	/**
 	Set #iPagingManagerData to the specified value.
 	@pre #MmuLock held.
@@ -424,6 +424,20 @@ public:
 	*/
 	TUint32			iCleanupFlags;
 
+	/**
+	For use by DPagedMemoryManager::HandleFault to detect sequential page faults; the index of
+	the page following the last pages read in by a fault.
+	Access to this is protected by #MmuLock.
+	*/
+	TUint			iReadAheadNext;
+
+	/**
+	For use by DPagedMemoryManager::HandleFault; the number of pages to read ahead of the next
+	page fault which follows on sequentially from the last.
+	Access to this is protected by #MmuLock.
+	*/
+	TUint			iReadAheadCount;
+
 	/**
 	Bit flags stored in #iFlags giving various state and attributes of the object.
 	*/
@@ -23,6 +23,7 @@
 #include "mmapping.h"
 #include "maddressspace.h"
 #include "mmanager.h"
+#include "mcodepaging.h"
 #include "mptalloc.h"
 #include "mpagearray.h"
 #include "mswap.h"
@@ -70,7 +71,8 @@ DPager::DPager() :
 	iNumberOfFreePages(0),
 	iReservePageCount(0),
 	iMinimumPageLimit(0),
-	iPagesToClean(1)
+	iPagesToClean(1),
+	iReplacementPolicy(EVMReplacementPolicyLru)
 #ifdef __DEMAND_PAGING_BENCHMARKS__
 	, iBenchmarkLock(TSpinLock::EOrderGenericIrqHigh3)
 #endif	  
@@ -138,8 +140,13 @@ void DPager::InitCache()
 	if(config.iYoungOldRatio)
 		iYoungOldRatio = config.iYoungOldRatio;
 	iOldOldestRatio = KDefaultOldOldestRatio;
-	if(config.iSpare[2])
-		iOldOldestRatio = config.iSpare[2];
+	if(config.iSpare[2] & 0xff)
+		iOldOldestRatio = config.iSpare[2] & 0xff;
+
+	// Set the replacement policy, the table of evicted pages it may need is allocated by Init3()
+	iReplacementPolicy = config.iSpare[2] >> 8;
+	if(iReplacementPolicy >= EVMMaxReplacementPolicy)
+		iReplacementPolicy = EVMReplacementPolicyLru;
 
 	// Set the minimum page counts...
 	iMinimumPageLimit = iMinYoungPages * (1 + iYoungOldRatio) / iYoungOldRatio
@@ -300,6 +307,19 @@ void DPager::AddAsYoungestPage(SPageInfo* aPageInfo)
 	}
 
 
+void DPager::AddAsProbationPage(SPageInfo* aPageInfo)
+	{
+	__NK_ASSERT_DEBUG(MmuLock::IsHeld());
+	__NK_ASSERT_DEBUG(CheckLists());
+	__NK_ASSERT_DEBUG(aPageInfo->PagedState()==SPageInfo::EUnpaged);
+
+	aPageInfo->SetPagedState(SPageInfo::EPagedOld);
+	aPageInfo->SetProbation();
+	iOldList.AddHead(&aPageInfo->iLink);
+	++iOldCount;
+	}
+
+
 void DPager::AddAsFreePage(SPageInfo* aPageInfo)
 	{
 	__NK_ASSERT_DEBUG(MmuLock::IsHeld());
@@ -610,9 +630,15 @@ try_steal_from_page_info:
 		goto restart;
 		}
 	
-	// try to steal it from owning object...
+	// try to steal it from owning object, remembering which page it held...
+	{
+	DMemoryObject* memory = pageInfo->Type()==SPageInfo::EManaged ? pageInfo->Owner() : NULL;
+	TUint index = pageInfo->Index();
 	if (StealPage(pageInfo) != KErrNone)
 		goto restart;
+	if (memory)
+		RecordGhost(memory, index);
+	}
 	
 	BalanceAges();
 	
@@ -1393,6 +1419,8 @@ void DPager::Init3()
 	TInt r = Kern::AddHalEntry(EHalGroupVM, VMHalFunction, 0);
 	__NK_ASSERT_ALWAYS(r==KErrNone);
 	PageCleaningLock::Init();
+	if (SetReplacementPolicy(iReplacementPolicy) != KErrNone)
+		SetReplacementPolicy(EVMReplacementPolicyLru);
 #ifdef __DEMAND_PAGING_BENCHMARKS__
 	for (TInt i = 0 ; i < EMaxPagingBm ; ++i)
 		ResetBenchmarkData((TPagingBenchmark)i);
@@ -1406,6 +1434,92 @@ void DPager::Fault(TFault aFault)
 	}
 
 
+/**
+Log2 of the number of RAM pages per entry in the table of evicted pages, and limits on the log2
+size of the table.
+*/
+const TUint KGhostRamShift = 3;
+const TUint KMinGhostShift = 8;
+const TUint KMaxGhostShift = 14;
+
+TInt DPager::SetReplacementPolicy(TUint aPolicy)
+	{
+	if (aPolicy >= EVMMaxReplacementPolicy)
+		return KErrArgument;
+
+	if (aPolicy == EVMReplacementPolicyScanResistant && !iGhosts)
+		{
+		TUint shift = __e32_find_ms1_32(TheMmu.TotalPhysicalRamPages());
+		shift = shift > KGhostRamShift ? shift - KGhostRamShift : 0;
+		if (shift < KMinGhostShift)
+			shift = KMinGhostShift;
+		if (shift > KMaxGhostShift)
+			shift = KMaxGhostShift;
+		NKern::ThreadEnterCS();
+		SGhost* ghosts = (SGhost*)Kern::AllocZ(sizeof(SGhost) << shift);
+		if (!ghosts)
+			{
+			NKern::ThreadLeaveCS();
+			return KErrNoMemory;
+			}
+		iGhostShift = 32 - shift;
+		TAny* null = NULL;
+		if (!__e32_atomic_cas_ord_ptr(&iGhosts, &null, ghosts))
+			Kern::Free(ghosts);	// another thread got there first
+		NKern::ThreadLeaveCS();
+		}
+
+	TRACEB(("DPager::SetReplacementPolicy %d", aPolicy));
+	MmuLock::Lock();
+	iReplacementPolicy = aPolicy;
+	MmuLock::Unlock();
+	return KErrNone;
+	}
+
+
+/**
+Hash a page's memory object and index to a non-zero tag for the table of evicted pages.
+*/
+static inline TUint32 GhostTag(DMemoryObject* aMemory, TUint aIndex)
+	{
+	TUint32 tag = ((TUint32)aMemory ^ (aIndex * 0x9e3779b9u)) * 0x85ebca6bu;
+	return tag ? tag : 1;
+	}
+
+
+void DPager::RecordGhost(DMemoryObject* aMemory, TUint aIndex)
+	{
+	__NK_ASSERT_DEBUG(MmuLock::IsHeld());
+	++iEvictionCount;
+	if (!iGhosts)
+		return;
+	// The table is direct mapped so a newer eviction can overwrite an older one, which just loses
+	// the older page's chance to be made young straight away.
+	TUint32 tag = GhostTag(aMemory, aIndex);
+	SGhost& ghost = iGhosts[tag >> iGhostShift];
+	ghost.iTag = tag;
+	ghost.iEvicted = iEvictionCount;
+	}
+
+
+TBool DPager::CheckGhost(DMemoryObject* aMemory, TUint aIndex)
+	{
+	__NK_ASSERT_DEBUG(MmuLock::IsHeld());
+	if (!iGhosts)
+		return EFalse;
+	TUint32 tag = GhostTag(aMemory, aIndex);
+	SGhost& ghost = iGhosts[tag >> iGhostShift];
+	if (ghost.iTag != tag)
+		return EFalse;
+	ghost.iTag = 0;
+
+	// The number of pages evicted since this one is how much larger the live list would have had
+	// to be to keep it.
+	TUint distance = iEvictionCount - ghost.iEvicted;
+	return distance <= iYoungCount + iOldCount + iOldestCleanCount + iOldestDirtyCount;
+	}
+
+
 void DPager::BalanceAges()
 	{
 	__NK_ASSERT_DEBUG(MmuLock::IsHeld());
@@ -1415,6 +1529,7 @@ void DPager::BalanceAges()
 		retry = EFalse;
 		TBool restrictPage = EFalse;
 		SPageInfo* pageInfo = NULL;
+		SPageInfo* probationPageInfo = NULL;
 		TUint oldestCount = iOldestCleanCount + iOldestDirtyCount;
 		if((iOldCount + oldestCount) * iYoungOldRatio < iYoungCount)
 			{
@@ -1445,6 +1560,8 @@ void DPager::BalanceAges()
 			--iOldCount;
 
 			SPageInfo* oldestPageInfo = SPageInfo::FromLink(link);
+			if (oldestPageInfo->ClearProbation())
+				probationPageInfo = oldestPageInfo;
 			if (oldestPageInfo->IsDirty())
 				{
 				oldestPageInfo->SetOldestPage(SPageInfo::EPagedOldestDirty);
@@ -1490,6 +1607,17 @@ void DPager::BalanceAges()
 					}
 				}
 			}
+
+		if (probationPageInfo)
+			{
+			// A page added by the scan-resistant policy has reached the oldest list without having
+			// been restricted.  Restrict it now so that it is made young if it is accessed again
+			// before being evicted.  The MmuLock may have been released above, but it is always safe
+			// to restrict a page in an oldest state.  If this fails the page just stays accessible.
+			SPageInfo::TPagedState state = probationPageInfo->PagedState();
+			if (state == SPageInfo::EPagedOldestClean || state == SPageInfo::EPagedOldestDirty)
+				RestrictPage(probationPageInfo,ERestrictPagesNoAccessForOldPage);
+			}
 		}
 	while (retry);
 	}
@@ -1783,6 +1911,22 @@ void DPager::PagedIn(SPageInfo* aPageInfo)
 	}
 
 
+void DPager::PagedInNew(SPageInfo* aPageInfo)
+	{
+	__NK_ASSERT_DEBUG(MmuLock::IsHeld());
+	if (iReplacementPolicy == EVMReplacementPolicyScanResistant &&
+		aPageInfo->PagedState() == SPageInfo::EUnpaged &&
+		aPageInfo->Type() == SPageInfo::EManaged &&
+		!CheckGhost(aPageInfo->Owner(), aPageInfo->Index()))
+		{
+		AddAsProbationPage(aPageInfo);
+		BalanceAges();
+		}
+	else
+		PagedIn(aPageInfo);
+	}
+
+
 void DPager::PagedInPinned(SPageInfo* aPageInfo, TPinArgs& aPinArgs)
 	{
 	__NK_ASSERT_DEBUG(MmuLock::IsHeld());
@@ -2495,7 +2639,7 @@ void DPager::GetLiveListInfo(SVMCacheInfo& aInfo)
 	}
 
 
-void DPager::GetEventInfo(SVMEventInfo& aInfoOut)
+void DPager::GetEventInfo(SVMEventInfoV2& aInfoOut)
 	{
 	MmuLock::Lock(); // ensure consistent set of values are read...
 	aInfoOut = iEventInfo;
@@ -2511,6 +2655,26 @@ void DPager::ResetEventInfo()
 	}
 
 
+void DPager::RecordPageInLatency(TUint32 aStartTime)
+	{
+	__NK_ASSERT_DEBUG(MmuLock::IsHeld());
+	TUint32 now = NKern::FastCounter();
+#if !defined(HIGH_RES_TIMER) || defined(HIGH_RES_TIMER_COUNTS_UP)
+	TUint64 elapsed = now - aStartTime;
+#else
+	TUint64 elapsed = aStartTime - now;
+#endif
+	TUint64 us = elapsed * 1000000 / TUint(NKern::FastCounterFrequency());
+	TUint bucket = SVMEventInfoV2::EPageInLatencyBuckets-1;
+	if(us < (1u<<bucket))
+		{
+		TInt msb = __e32_find_ms1_32(TUint32(us));
+		bucket = msb>0 ? msb : 0;
+		}
+	++iEventInfo.iPageInLatency[bucket];
+	}
+
+
 TInt TestPageState(TLinAddr aAddr)
 	{
 	DMemModelProcess* process = (DMemModelProcess*)TheCurrentThread->iOwningProcess;
@@ -2599,7 +2763,7 @@ TInt VMHalFunction(TAny*, TInt aFunction, TAny* a1, TAny* a2)
 
 	case EVMHalGetEventInfo:
 		{
-		SVMEventInfo info;
+		SVMEventInfoV2 info;
 		ThePager.GetEventInfo(info);
 		Kern::InfoCopy(*(TDes8*)a1,(TUint8*)&info,sizeof(info));
 		}
@@ -2628,6 +2792,47 @@ TInt VMHalFunction(TAny*, TInt aFunction, TAny* a1, TAny* a2)
 		}
 		return KErrNone;
 
+	case EVMHalGetReplacementPolicy:
+		return ThePager.ReplacementPolicy();
+
+	case EVMHalSetReplacementPolicy:
+		if(!TheCurrentThread->HasCapability(ECapabilityWriteDeviceData,__PLATSEC_DIAGNOSTIC_STRING("Checked by VMHalFunction(EVMHalSetReplacementPolicy)")))
+			K::UnlockedPlatformSecurityPanic();
+		return ThePager.SetReplacementPolicy((TUint)a1);
+
+	case EVMHalSetCodePageProfiling:
+		if(!TheCurrentThread->HasCapability(ECapabilityWriteDeviceData,__PLATSEC_DIAGNOSTIC_STRING("Checked by VMHalFunction(EVMHalSetCodePageProfiling)")))
+			K::UnlockedPlatformSecurityPanic();
+		if ((K::MemModelAttributes & EMemModelAttrCodePaging) == 0)
+			return KErrNotSupported;
+		SetCodePageProfiling((TBool)a1);
+		return KErrNone;
+
+	case EVMHalGetCodePageProfile:
+		if(!TheCurrentThread->HasCapability(ECapabilityReadDeviceData,__PLATSEC_DIAGNOSTIC_STRING("Checked by VMHalFunction(EVMHalGetCodePageProfile)")))
+			K::UnlockedPlatformSecurityPanic();
+		if ((K::MemModelAttributes & EMemModelAttrCodePaging) == 0)
+			return KErrNotSupported;
+		return GetCodePageProfile((TLinAddr)a1,(TDes8*)a2);
+
+	case EVMHalPrefetchCodePages:
+		if(!TheCurrentThread->HasCapability(ECapabilityWriteDeviceData,__PLATSEC_DIAGNOSTIC_STRING("Checked by VMHalFunction(EVMHalPrefetchCodePages)")))
+			K::UnlockedPlatformSecurityPanic();
+		if ((K::MemModelAttributes & EMemModelAttrCodePaging) == 0)
+			return KErrNotSupported;
+		return PrefetchCodePages((TLinAddr)a1,(const TDesC8*)a2);
+
+	case EVMHalGetSwapCompressionInfo:
+		{
+		if ((K::MemModelAttributes & EMemModelAttrDataPaging) == 0)
+			return KErrNotSupported;
+		SVMSwapCompressionInfo info;
+		TInt r = GetSwapCompressionInfo(info);
+		if (r == KErrNone)
+			kumemput32(a1,&info,sizeof(info));
+		return r;
+		}
+
 	case EVMHalGetThrashLevel:
 		return TheThrashMonitor.ThrashLevel();
 
@@ -3139,7 +3344,13 @@ EXPORT_C TInt Kern::InstallPagingDevice(DPagingDevice* aDevice)
 
 	// create the pools of page out and page in requests...
 	const TBool writeReq = (aDevice->iType & DPagingDevice::EData) != 0;
-	aDevice->iRequestPool = new DPagingRequestPool(KPagingRequestsPerDevice, writeReq);
+	TInt numReadRequests = aDevice->iReadRequestCount;
+	if(numReadRequests<=0)
+		numReadRequests = KPagingRequestsPerDevice;
+	else if(numReadRequests>KMaxPagingReadRequestsPerDevice)
+		numReadRequests = KMaxPagingReadRequestsPerDevice;
+	TRACEB(("Kern::InstallPagingDevice using %d read requests",numReadRequests));
+	aDevice->iRequestPool = new DPagingRequestPool(numReadRequests, writeReq);
 	if(!aDevice->iRequestPool)
 		{
 		r = KErrNoMemory;
@@ -140,6 +140,22 @@ public:
 	*/
 	TInt ResizeLiveList(TUint aMinimumPageCount, TUint aMaximumPageCount);
 
+	/**
+	Get the page replacement policy, one of TVMReplacementPolicy.
+	*/
+	inline TUint ReplacementPolicy()
+		{ return iReplacementPolicy; }
+
+	/**
+	Set the page replacement policy.
+
+	@param aPolicy	One of TVMReplacementPolicy.
+
+	@return KErrNone, KErrArgument if the policy is invalid, or KErrNoMemory if the table used to
+	remember evicted pages could not be allocated.
+	*/
+	TInt SetReplacementPolicy(TUint aPolicy);
+
 	/**
 	Recalculate live list size.
 	*/
@@ -220,6 +236,20 @@ public:
 	*/
 	void PagedIn(SPageInfo* aPageInfo);
 
+	/**
+	Called to add a page to the live list after it has been newly paged in, as opposed to put
+	back on the live list after an access.
+
+	With the scan-resistant replacement policy, the page is added as an old page unless it was
+	evicted recently, otherwise this is the same as #PagedIn.
+
+	@param aPageInfo		The page.
+
+	@pre MmuLock held
+	@post MmuLock held (but may have been released by this function)
+	*/
+	void PagedInNew(SPageInfo* aPageInfo);
+
 	/**
 	@param aPageInfo		The page.
 	@param aPinArgs			Owner of a replacement page which will be used to substitute for the pinned page.
@@ -339,7 +369,16 @@ public:
 	/**
 	Get the pager's event info data.
 	*/
-	void GetEventInfo(SVMEventInfo& aInfoOut);
+	void GetEventInfo(SVMEventInfoV2& aInfoOut);
+
+	/**
+	Record the time taken to read pages in from a paging device for a page fault.
+
+	@param aStartTime	The value of NKern::FastCounter() when the read was requested.
+
+	@pre MmuLock held.
+	*/
+	void RecordPageInLatency(TUint32 aStartTime);
 
 	/**
 	Reset the pager's event info data.
@@ -604,6 +643,27 @@ private:
 	*/
 	TInt SelectOldestPagesToClean(SPageInfo** aPageInfosOut);
 
+	/**
+	Add a page to the head of the old list, without restricting access to it.
+
+	This is how the scan-resistant replacement policy adds newly paged in pages, marked with
+	SPageInfo::EProbation.  Such a page is restricted when it reaches the oldest list, so it only
+	becomes young if it is accessed again before being evicted, or if it is paged in again soon
+	after being evicted (see #CheckGhost).
+	*/
+	void AddAsProbationPage(SPageInfo* aPageInfo);
+
+	/**
+	Remember that a page belonging to a memory object has been evicted.
+	*/
+	void RecordGhost(DMemoryObject* aMemory, TUint aIndex);
+
+	/**
+	Check whether a newly paged in page was evicted recently enough that it would still have been
+	in the live list if the list had been twice its size, and forget it if so.
+	*/
+	TBool CheckGhost(DMemoryObject* aMemory, TUint aIndex);
+
 	/**
 	If the number of young pages exceeds that specified by iYoungOldRatio then a
 	single page is made 'old'. Call this after adding a new 'young' page.
@@ -735,7 +795,19 @@ private:
 	TUint iPagesToClean;        /**< Preferred number of pages to attempt to clean in one go. */
 	TBool iCleanInSequence;     /**< Pages to be cleaned must have sequential page colour. */
 
-	SVMEventInfo iEventInfo;
+	TUint iReplacementPolicy;	/**< Page replacement policy, one of TVMReplacementPolicy */
+
+	/** A recently evicted page, see #RecordGhost. */
+	struct SGhost
+		{
+		TUint32 iTag;			/**< Hash of the page's memory object and index, or 0 if unused */
+		TUint32 iEvicted;		/**< Value of iEvictionCount when the page was evicted */
+		};
+	SGhost* iGhosts;			/**< Direct mapped table of recently evicted pages. Protected by MmuLock */
+	TUint iGhostShift;			/**< 32 - log2 of the number of entries in iGhosts */
+	TUint32 iEvictionCount;		/**< Number of pages evicted from the live list. Protected by MmuLock */
+
+	SVMEventInfoV2 iEventInfo;
 
 #ifdef __DEMAND_PAGING_BENCHMARKS__
 public:
@@ -943,6 +1015,13 @@ Multiplier for number of request objects in pool per drive that supports paging.
 */
 const TInt KPagingRequestsPerDevice = 2;
 
+/**
+Maximum number of page read request objects in the pool for a paging device which sets
+DPagingDevice::iReadRequestCount.  Each one reserves DPageReadRequest::EMaxPages pages of RAM
+and a temporary mapping.
+*/
+const TInt KMaxPagingReadRequestsPerDevice = 8;
+
 
 class DPageReadRequest;
 class DPageWriteRequest;
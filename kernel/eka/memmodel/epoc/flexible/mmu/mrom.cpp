@@ -171,6 +171,7 @@ private:
 	virtual TInt AcquirePageReadRequest(DPageReadRequest*& aRequest, DMemoryObject* aMemory, TUint aIndex, TUint aCount);
 	virtual TInt ReadPages(DMemoryObject* aMemory, TUint aIndex, TUint aCount, TPhysAddr* aPages, DPageReadRequest* aRequest);
 	virtual TBool IsAllocated(DMemoryObject* aMemory, TUint aIndex, TUint aCount);
+	virtual TUint ReadAheadLimit(DMemoryObject* aMemory, TUint aIndex);
 	virtual void DoUnpin(DMemoryObject* aMemory, TUint aIndex, TUint aCount, DMemoryMappingBase* aMapping, TPinArgs& aPinArgs);
 
 	/**
@@ -628,6 +629,16 @@ TBool DRomMemoryManager::IsAllocated(DMemoryObject* aMemory, TUint aIndex, TUint
 	}
 
 
+TUint DRomMemoryManager::ReadAheadLimit(DMemoryObject* aMemory, TUint aIndex)
+	{
+	// only read ahead pages within the paged part of the ROM...
+	TUint pagedEnd = (iPagedStart+iPagedSize+KPageMask)>>KPageShift;
+	if(aIndex+1>=pagedEnd)
+		return 0;
+	return Min(pagedEnd-aIndex-1,(TUint)DPageReadRequest::EMaxPages-1);
+	}
+
+
 TInt DRomMemoryManager::HandleFault(DMemoryObject* aMemory, TUint aIndex, DMemoryMapping* aMapping, 
 									TUint aMapInstanceCount, TUint aAccessPermissions)
 	{
@@ -22,6 +22,7 @@
 #define MSWAP_H
 
 extern void GetSwapInfo(SVMSwapInfo& aInfoOut);
+extern TInt GetSwapCompressionInfo(SVMSwapCompressionInfo& aInfoOut);
 extern TInt SetSwapThresholds(const SVMSwapThresholds& aThresholds);
 extern TBool GetPhysicalAccessSupported();
 extern TBool GetUsePhysicalAccess();
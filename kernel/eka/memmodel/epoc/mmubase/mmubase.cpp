@@ -3604,6 +3604,17 @@ TInt DemandPaging::Decompress(TInt aCompressionType,TLinAddr aDst,TLinAddr aSrc,
 		}
 		break;
 
+	case SRomPageInfo::ELz4:
+		{
+		START_PAGING_BENCHMARK;
+		TUint8* srcNext=0;
+		r=Lz4Decompress((TUint8*)aDst,KPageSize,(TUint8*)aSrc,aSrcSize,srcNext);
+		if (r > 0)
+			__NK_ASSERT_ALWAYS((TLinAddr)srcNext == aSrc + aSrcSize);
+		END_PAGING_BENCHMARK(this, EPagingBmDecompress);
+		}
+		break;
+
 	default:
 		r = KErrNotSupported;
 		break;
@@ -4832,8 +4843,9 @@ TInt DMmuCodeSegMemory::ReadBlockMap(const TCodeSegCreateInfo& aInfo)
 			break;
 
 		case KUidCompressionBytePair:
+		case KUidCompressionLz4:
 			{
-			iCompressionType = SRomPageInfo::EBytePair;
+			iCompressionType = aInfo.iCompressionType == KUidCompressionLz4 ? SRomPageInfo::ELz4 : SRomPageInfo::EBytePair;
 			if (!aInfo.iCodePageOffsets)
 				return KErrArgument;
 			TInt size = sizeof(TInt32) * (iPageCount + 1);
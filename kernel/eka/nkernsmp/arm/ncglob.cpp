@@ -37,6 +37,7 @@ SFullArmRegSet DefaultRegSet;
 
 #ifdef __USE_BTRACE_LOCK__
 TSpinLock BTraceLock(TSpinLock::EOrderBTrace);
+volatile TUint32 BTraceLockFree = 0;
 #endif
 
 SBTraceData BTraceData = { {0}, 0, 0 };
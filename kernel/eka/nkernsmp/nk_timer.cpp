@@ -247,10 +247,12 @@ EXPORT_C TInt NTimer::OneShot(TInt aTime, TBool aDfc)
 	Call-back mechanism cannot be changed in the life time of a timer. */
 	__NK_ASSERT_DEBUG(iFn!=NULL);
 
-	TInt irq = TheTimerQ.iTimerSpinLock.LockIrqSave();
+	TInt irq = NKern::DisableAllInterrupts();
+	NTimerQ::SCpuTimerQ* q = TheTimerQ.LockQ(this);
 	if (!IsValid())
 		{
-		TheTimerQ.iTimerSpinLock.UnlockIrqRestore(irq);
+		q->iTimerSpinLock.UnlockOnly();
+		NKern::RestoreInterrupts(irq);
 		return KErrDied;
 		}
 	TUint16 state = i8816.iHState16;
@@ -260,14 +262,16 @@ EXPORT_C TInt NTimer::OneShot(TInt aTime, TBool aDfc)
 		aDfc = FALSE;	// mutating timers start as ISR completion
 	if (state!=EIdle)
 		{
-		TheTimerQ.iTimerSpinLock.UnlockIrqRestore(irq);
+		q->iTimerSpinLock.UnlockOnly();
+		NKern::RestoreInterrupts(irq);
 		return KErrInUse;
 		}
 	mb();	// ensure that if we observe an idle state all accesses to the NTimer have also been observed
 	i_NTimer_iCompleteInDfc=TUint8(aDfc?1:0);
 	iTriggerTime=TheTimerQ.iMsCount+(TUint32)aTime;
-	TheTimerQ.Add(this);
-	TheTimerQ.iTimerSpinLock.UnlockIrqRestore(irq);
+	q = TheTimerQ.Start(q, this);
+	q->iTimerSpinLock.UnlockOnly();
+	NKern::RestoreInterrupts(irq);
 	return KErrNone;
 	}
 
@@ -296,15 +300,18 @@ EXPORT_C TInt NTimer::OneShot(TInt aTime, TDfc& aDfc)
 	{
 	__NK_ASSERT_DEBUG(!IsMutating());
 	__NK_ASSERT_DEBUG(aTime>=0);
-	TInt irq = TheTimerQ.iTimerSpinLock.LockIrqSave();
+	TInt irq = NKern::DisableAllInterrupts();
+	NTimerQ::SCpuTimerQ* q = TheTimerQ.LockQ(this);
 	if (iHType != EEventHandlerNTimer)
 		{
-		TheTimerQ.iTimerSpinLock.UnlockIrqRestore(irq);
+		q->iTimerSpinLock.UnlockOnly();
+		NKern::RestoreInterrupts(irq);
 		return KErrDied;
 		}
 	if (i_NTimer_iState!=EIdle)
 		{
-		TheTimerQ.iTimerSpinLock.UnlockIrqRestore(irq);
+		q->iTimerSpinLock.UnlockOnly();
+		NKern::RestoreInterrupts(irq);
 		return KErrInUse;
 		}
 	mb();	// ensure that if we observe an idle state all accesses to the NTimer have also been observed
@@ -312,8 +319,9 @@ EXPORT_C TInt NTimer::OneShot(TInt aTime, TDfc& aDfc)
 	iFn = NULL;
 	iPtr = (TAny*) &aDfc;
 	iTriggerTime=TheTimerQ.iMsCount+(TUint32)aTime;
-	TheTimerQ.Add(this);
-	TheTimerQ.iTimerSpinLock.UnlockIrqRestore(irq);
+	q = TheTimerQ.Start(q, this);
+	q->iTimerSpinLock.UnlockOnly();
+	NKern::RestoreInterrupts(irq);
 	return KErrNone;
 	}
 
@@ -345,10 +353,12 @@ EXPORT_C TInt NTimer::Again(TInt aTime)
 // Wait aTime from last trigger time - used for periodic timers
 //
 	{
-	TInt irq = TheTimerQ.iTimerSpinLock.LockIrqSave();
+	TInt irq = NKern::DisableAllInterrupts();
+	NTimerQ::SCpuTimerQ* q = TheTimerQ.LockQ(this);
 	if (!IsValid())
 		{
-		TheTimerQ.iTimerSpinLock.UnlockIrqRestore(irq);
+		q->iTimerSpinLock.UnlockOnly();
+		NKern::RestoreInterrupts(irq);
 		return KErrDied;
 		}
 	TUint16 state = i8816.iHState16;
@@ -356,7 +366,8 @@ EXPORT_C TInt NTimer::Again(TInt aTime)
 		state &= 0xFF;
 	if (state!=EIdle)
 		{
-		TheTimerQ.iTimerSpinLock.UnlockIrqRestore(irq);
+		q->iTimerSpinLock.UnlockOnly();
+		NKern::RestoreInterrupts(irq);
 		return KErrInUse;
 		}
 	mb();	// ensure that if we observe an idle state all accesses to the NTimer have also been observed
@@ -365,12 +376,14 @@ EXPORT_C TInt NTimer::Again(TInt aTime)
 	TUint32 d=trigger-nextTick;
 	if (d>=0x80000000)
 		{
-		TheTimerQ.iTimerSpinLock.UnlockIrqRestore(irq);
+		q->iTimerSpinLock.UnlockOnly();
+		NKern::RestoreInterrupts(irq);
 		return KErrArgument;		// requested time is in the past
 		}
 	iTriggerTime=trigger;
-	TheTimerQ.Add(this);
-	TheTimerQ.iTimerSpinLock.UnlockIrqRestore(irq);
+	q = TheTimerQ.Start(q, this);
+	q->iTimerSpinLock.UnlockOnly();
+	NKern::RestoreInterrupts(irq);
 	return KErrNone;
 	}
 
@@ -400,14 +413,15 @@ EXPORT_C TBool NTimer::Cancel()
 	}
 
 void NTimer::DoCancel0(TUint aState)
+//
+//	Enter and return with the spin lock of the timer queue which owns this timer held.
+//
 	{
 	if (aState>ETransferring && aState<=EFinal)	// idle or transferring timers are not on a queue
 		Deque();
+	NTimerQ::SCpuTimerQ& cq=TheTimerQ.iCpuQ[iTimerCpu & (KMaxCpus-1)];
 	switch (aState)
 		{
-		case ETransferring:	// signal DFC to abort this iteration
-			TheTimerQ.iTransferringCancelled=TRUE;
-			break;
 		case ECritical:		// signal DFC to abort this iteration
 			TheTimerQ.iCriticalCancelled=TRUE;
 			break;
@@ -417,13 +431,24 @@ void NTimer::DoCancel0(TUint aState)
 			// NOTE: Timer might actually be on the completed queue rather than the final queue
 			//		 but the check is harmless in any case.
 			TInt i=iTriggerTime & NTimerQ::ETimerQMask;
-			NTimerQ::STimerQ& q=TheTimerQ.iTickQ[i];
+			NTimerQ::STimerQ& q=cq.iTickQ[i];
 			if (q.iIntQ.IsEmpty() && q.iDfcQ.IsEmpty())
-				TheTimerQ.iPresent &= ~(1<<i);
+				cq.iPresent &= ~(1<<i);
+			break;
+			}
+		case EHolding:
+			{
+			// Need to clear bit in iWheelPresent if the wheel slot is now empty
+			// NOTE: Timer might actually be on the DFC's cascade queue rather than
+			//		 the wheel but the check is harmless in any case.
+			TInt level=iWheelSlot >> NTimerQ::EWheelLevelShift;
+			TInt i=iWheelSlot & NTimerQ::EWheelSlotMask;
+			if (cq.iWheel[level][i].IsEmpty())
+				cq.iWheelPresent[level] &= ~(1u<<i);
 			break;
 			}
 		case EIdle:			// nothing to do
-		case EHolding:		// just deque
+		case ETransferring:	// not on a queue, the transfer will see the timer is idle
 		case EOrdered:		// just deque
 			break;
 		default:
@@ -435,7 +460,7 @@ TUint NTimer::DoCancel(TUint aFlags)
 	{
 	NSchedulable* tied = 0;
 	TInt irq = NKern::DisableAllInterrupts();
-	TheTimerQ.iTimerSpinLock.LockOnly();
+	NTimerQ::SCpuTimerQ* q = TheTimerQ.LockQ(this);
 	TUint state = i_NTimer_iState;
 	mb();
 	if (IsNormal() && state>=EEventQ)
@@ -465,7 +490,7 @@ TUint NTimer::DoCancel(TUint aFlags)
 end:
 	if (aFlags & ECancelDestroy)
 		iHType = EEventHandlerDummy;
-	TheTimerQ.iTimerSpinLock.UnlockOnly();
+	q->iTimerSpinLock.UnlockOnly();
 	if (tied)
 		tied->EndTiedEvent();	// FIXME - Could be called in thread context
 	NKern::RestoreInterrupts(irq);
@@ -484,7 +509,8 @@ TBool NTimer::DoCancelMutating(TUint aFlags)
 	TDfcQue* q = iDfcQ;
 	NThreadBase* t = q->iThread;
 	t->AcqSLock();
-	TheTimerQ.iTimerSpinLock.LockIrq();
+	TInt irq = NKern::DisableAllInterrupts();
+	NTimerQ::SCpuTimerQ* tq = TheTimerQ.LockQ(this);
 
 	// 0000->0000, XX00->ZZ00, xxYY->zzYY
 	TUint state = d->CancelInitialStateChange();
@@ -527,7 +553,8 @@ reset:
 end:
 	if (aFlags & ECancelDestroy)
 		iHType = EEventHandlerDummy;
-	TheTimerQ.iTimerSpinLock.UnlockIrq();
+	tq->iTimerSpinLock.UnlockOnly();
+	NKern::RestoreInterrupts(irq);
 	t->RelSLock();
 	if (cpu>=0)
 		{
@@ -572,6 +599,14 @@ NTimerQ::NTimerQ()
 	{
 	// NOTE: All other members are initialised to zero since the single instance
 	//		 of NTimerQ resides in .bss
+	TInt i;
+	for (i=0; i<KMaxCpus; ++i)
+		iCpuQ[i].iCpuNum = (TUint8)i;
+	}
+
+NTimerQ::SCpuTimerQ::SCpuTimerQ()
+	:	iTimerSpinLock(TSpinLock::EOrderNTimerQ)
+	{
 	}
 
 void NTimerQ::Init1(TInt aTickPeriod)
@@ -590,24 +625,95 @@ void NTimerQ::Init3(TDfcQue* aDfcQ)
 	}
 
 #ifndef __MSTIM_MACHINE_CODED__
-void NTimerQ::Add(NTimer* aTimer)
+NTimerQ::SCpuTimerQ* NTimerQ::LockQ(NTimer* aTimer)
 //
-//	Internal function to add a timer to the queue.
-//	Enter and return with timer queue spin lock held.
+//	Internal function to lock the timer queue which owns a timer.
+//	A timer only changes queue with the spin lock of its current queue held,
+//	so recheck the owner once the lock is held. Any queue will do for a timer
+//	which has never been started.
+//	Enter with interrupts disabled, return with the owning queue's spin lock held.
 //
 	{
-	TInt t=TInt(aTimer->iTriggerTime-iMsCount);
-	if (t<ENumTimerQueues)
-		AddFinal(aTimer);
+	FOREVER
+		{
+		TInt cpu=aTimer->iTimerCpu & (KMaxCpus-1);
+		SCpuTimerQ* q=&iCpuQ[cpu];
+		q->iTimerSpinLock.LockOnly();
+		if ((aTimer->iTimerCpu & (KMaxCpus-1))==cpu)
+			return q;
+		q->iTimerSpinLock.UnlockOnly();
+		}
+	}
+
+NTimerQ::SCpuTimerQ* NTimerQ::Start(SCpuTimerQ* aQ, NTimer* aTimer)
+//
+//	Internal function to queue a timer which is being started.
+//	The timer goes on the queue of the CPU its tied thread/group runs on, or
+//	of the current CPU if it isn't tied, so that timers follow their threads
+//	when these are moved by the load balancer.
+//	Enter with the spin lock of the queue owning the timer held, return with
+//	the spin lock of the queue it is now on held.
+//
+	{
+	TInt cpu;
+	NSchedulable* tied=aTimer->IsNormal() ? aTimer->iTied : 0;
+	if (tied)
+		cpu=tied->iEventState & NSchedulable::EEventCpuMask;
 	else
+		cpu=NKern::CurrentCpu();
+	if (cpu==aQ->iCpuNum)
+		{
+		Add(*aQ, aTimer);
+		return aQ;
+		}
+
+	// Move the timer to the new queue. It is marked as transferring while
+	// neither lock is held, so it can't be started again meanwhile; if it is
+	// cancelled it will have gone idle by the time the new queue is locked.
+	aTimer->i_NTimer_iState=NTimer::ETransferring;
+	aTimer->iTimerCpu=(TUint8)cpu;
+	aQ->iTimerSpinLock.UnlockOnly();
+	aQ=&iCpuQ[cpu];
+	aQ->iTimerSpinLock.LockOnly();
+	if (aTimer->i_NTimer_iState==NTimer::ETransferring && aTimer->iTimerCpu==cpu)
+		Add(*aQ, aTimer);
+	return aQ;
+	}
+
+void NTimerQ::Add(SCpuTimerQ& aQ, NTimer* aTimer)
+//
+//	Internal function to add a timer to a queue.
+//	Enter and return with timer queue spin lock held.
+//
+	{
+	TUint32 trigger=aTimer->iTriggerTime;
+	if (TInt(trigger-iMsCount)<ENumTimerQueues)
 		{
-		// >=32ms to expiry, so put on holding queue
-		aTimer->i_NTimer_iState=NTimer::EHolding;
-		iHoldingQ.Add(aTimer);
+		AddFinal(aQ, aTimer);
+		return;
 		}
+
+	// >=32 ticks to expiry, so put it on the timing wheel.
+	// Level n holds timers due less than 32^(n+1) steps after the wheel time,
+	// in slots covering 32^n steps each. Since iWheelTime<=iMsCount+32 the
+	// timer can't be due before the wheel time.
+	TUint32 d=(trigger-aQ.iWheelTime)>>EWheelStepShift;
+	TInt shift=EWheelStepShift;
+	TInt level=0;
+	while (d>=(TUint32)EWheelSlots && level<ENumWheelLevels-1)
+		{
+		d>>=EWheelLevelShift;
+		shift+=EWheelLevelShift;
+		++level;
+		}
+	TInt i=(trigger>>shift) & EWheelSlotMask;
+	aQ.iWheelPresent[level] |= (1u<<i);
+	aTimer->iWheelSlot=TUint8((level<<EWheelLevelShift)|i);
+	aTimer->i_NTimer_iState=NTimer::EHolding;
+	aQ.iWheel[level][i].Add(aTimer);
 	}
 
-void NTimerQ::AddFinal(NTimer* aTimer)
+void NTimerQ::AddFinal(SCpuTimerQ& aQ, NTimer* aTimer)
 //
 //	Internal function to add a timer to the corresponding final queue.
 //	Enter and return with timer queue spin lock held.
@@ -616,14 +722,69 @@ void NTimerQ::AddFinal(NTimer* aTimer)
 	TInt i=aTimer->iTriggerTime & ETimerQMask;
 	SDblQue* pQ;
 	if (aTimer->i_NTimer_iCompleteInDfc)
-		pQ=&iTickQ[i].iDfcQ;
+		pQ=&aQ.iTickQ[i].iDfcQ;
 	else
-		pQ=&iTickQ[i].iIntQ;
-	iPresent |= (1<<i);
+		pQ=&aQ.iTickQ[i].iIntQ;
+	aQ.iPresent |= (1<<i);
 	aTimer->i_NTimer_iState=NTimer::EFinal;
 	pQ->Add(aTimer);
 	}
 
+TBool NTimerQ::SkipWheelSteps(SCpuTimerQ& aQ)
+//
+//	Internal function to advance the wheel time past any steps which are due
+//	to be cascaded but have no timers on them.
+//	Return TRUE if a due step has timers on it, in which case the timer DFC
+//	must cascade it.
+//	Enter and return with timer queue spin lock held.
+//
+	{
+	// A step is cascaded no earlier than 16 ticks before it starts, so that
+	// the timers on it are within 32 ticks of expiry and can go straight to
+	// the final queues. This allows a DFC latency of up to 16 ticks.
+	while (TInt(aQ.iWheelTime-iMsCount)<=EWheelStep)
+		{
+		TUint32 t=aQ.iWheelTime>>EWheelStepShift;
+		TInt level;
+		for (level=0; level<ENumWheelLevels; ++level)
+			{
+			TInt i=t & EWheelSlotMask;
+			if (aQ.iWheelPresent[level] & (1u<<i))
+				return TRUE;
+			if (i)
+				break;		// higher levels only cascade when this level wraps
+			t>>=EWheelLevelShift;
+			}
+		aQ.iWheelTime+=EWheelStep;
+		}
+	return FALSE;
+	}
+
+void NTimerQ::TakeWheelStep(SCpuTimerQ& aQ, SDblQue& aSteps)
+//
+//	Internal function to remove from the wheel all timers which must be
+//	requeued when the step at iWheelTime is cascaded, and advance the wheel
+//	time to the next step.
+//	Enter and return with timer queue spin lock held.
+//
+	{
+	TUint32 t=aQ.iWheelTime>>EWheelStepShift;
+	TInt level;
+	for (level=0; level<ENumWheelLevels; ++level)
+		{
+		TInt i=t & EWheelSlotMask;
+		if (aQ.iWheelPresent[level] & (1u<<i))
+			{
+			aSteps.MoveFrom(&aQ.iWheel[level][i]);
+			aQ.iWheelPresent[level] &= ~(1u<<i);
+			}
+		if (i)
+			break;
+		t>>=EWheelLevelShift;
+		}
+	aQ.iWheelTime+=EWheelStep;
+	}
+
 void NTimerQ::DfcFn(TAny* aPtr)
 	{
 	((NTimerQ*)aPtr)->Dfc();
@@ -634,101 +795,58 @@ void NTimerQ::Dfc()
 // Do deferred timer queue processing and/or DFC completions
 //
 	{
-	// First transfer entries on the Ordered queue to the Final queues
-	FOREVER
+	TInt ncpus=TheScheduler.iNumCpus;
+	TInt cpu;
+	for (cpu=0; cpu<ncpus; ++cpu)
 		{
-		iTimerSpinLock.LockIrq();
-		if (iOrderedQ.IsEmpty())
-			break;
-		NTimer* pC=(NTimer*)iOrderedQ.First();
-		TInt remain=pC->iTriggerTime-iMsCount;
-		if (remain>=ENumTimerQueues)
-			break;
-
-		// If remaining time <32 ticks, add it to final queue;
-		// also if remain < 0 we've 'missed it' so add to final queue.
-		pC->Deque();
-		AddFinal(pC);
-		iTimerSpinLock.UnlockIrq();
-		__DEBUG_CALLBACK(0);
-		}
-	iTimerSpinLock.UnlockIrq();
-	__DEBUG_CALLBACK(1);
+		SCpuTimerQ& cq=iCpuQ[cpu];
 
-	// Next transfer entries on the Holding queue to the Ordered queue or final queue
-	FOREVER
-		{
-		iTimerSpinLock.LockIrq();
-		if (iHoldingQ.IsEmpty())
-			break;
-		NTimer* pC=(NTimer*)iHoldingQ.First();
-		pC->Deque();
-		pC->i_NTimer_iState=NTimer::ETransferring;
-		iTransferringCancelled=FALSE;
-		TUint32 trigger=pC->iTriggerTime;
-		if (TInt(trigger-iMsCount)<ENumTimerQueues)
+		// First cascade due steps of the timing wheel. Timers on the step itself
+		// go to the final queues and timers on higher level slots which wrap at
+		// this step are spread over the lower levels.
+		FOREVER
 			{
-			// <32ms remaining so put it on final queue
-			AddFinal(pC);
-			}
-		else
-			{
-			FOREVER
+			cq.iTimerSpinLock.LockIrq();
+			if (TInt(cq.iWheelTime-iMsCount)>EWheelStep)
 				{
-				iTimerSpinLock.UnlockIrq();
-				__DEBUG_CALLBACK(2);
-
-				// we now need to walk ordered queue to find correct position for pC
-				SDblQueLink* anchor=&iOrderedQ.iA;
-				iCriticalCancelled=FALSE;
-				iTimerSpinLock.LockIrq();
-				NTimer* pN=(NTimer*)iOrderedQ.First();
-				while (pN!=anchor && !iTransferringCancelled)
-					{
-					if ((pN->iTriggerTime-trigger)<0x80000000u)
-						break;	// insert before pN
-					pN->i_NTimer_iState=NTimer::ECritical;
-					iTimerSpinLock.UnlockIrq();
-					__DEBUG_CALLBACK(3);
-					iTimerSpinLock.LockIrq();
-					if (iCriticalCancelled)
-						break;
-					pN->i_NTimer_iState=NTimer::EOrdered;
-					pN=(NTimer*)pN->iNext;
-					}
-
-				if (iTransferringCancelled)
-					break;		// this one has been cancelled, go on to next one
-				if (!iCriticalCancelled)
-					{
-					pC->InsertBefore(pN);
-					pC->i_NTimer_iState=NTimer::EOrdered;
-					break;		// done this one
-					}
+				cq.iCascadePending=FALSE;
+				break;
 				}
+			SDblQue q;
+			TakeWheelStep(cq, q);
+			while (!q.IsEmpty())
+				{
+				// careful here - other CPUs could dequeue timers!
+				NTimer* pC=(NTimer*)q.First();
+				pC->Deque();
+				Add(cq, pC);
+				cq.iTimerSpinLock.UnlockIrq();
+				__DEBUG_CALLBACK(0);
+				cq.iTimerSpinLock.LockIrq();
+				}
+			cq.iTimerSpinLock.UnlockIrq();
+			__DEBUG_CALLBACK(1);
 			}
-		iTimerSpinLock.UnlockIrq();
-		__DEBUG_CALLBACK(4);
-		}
-	iTimerSpinLock.UnlockIrq();
-	__DEBUG_CALLBACK(5);
+		cq.iTimerSpinLock.UnlockIrq();
+		__DEBUG_CALLBACK(5);
 
-	// Finally do call backs for timers which requested DFC callback
-	FOREVER
-		{
-		iTimerSpinLock.LockIrq();
-		if (iCompletedQ.IsEmpty())
-			break;
-		NTimer* pC=(NTimer*)iCompletedQ.First();
-		pC->Deque();
-		pC->i_NTimer_iState=NTimer::EIdle;
-		TAny* p=pC->iPtr;
-		NTimerFn f=pC->iFn;
-		iTimerSpinLock.UnlockIrq();
-		__DEBUG_CALLBACK(7);
-		(*f)(p);
+		// Then do call backs for timers which requested DFC callback
+		FOREVER
+			{
+			cq.iTimerSpinLock.LockIrq();
+			if (cq.iCompletedQ.IsEmpty())
+				break;
+			NTimer* pC=(NTimer*)cq.iCompletedQ.First();
+			pC->Deque();
+			pC->i_NTimer_iState=NTimer::EIdle;
+			TAny* p=pC->iPtr;
+			NTimerFn f=pC->iFn;
+			cq.iTimerSpinLock.UnlockIrq();
+			__DEBUG_CALLBACK(7);
+			(*f)(p);
+			}
+		cq.iTimerSpinLock.UnlockIrq();
 		}
-	iTimerSpinLock.UnlockIrq();
 	__e32_atomic_add_rel32(&iDfcCompleteCount, 2);
 	}
 
@@ -744,53 +862,65 @@ EXPORT_C void NTimerQ::Tick()
 	{
 	TInt irq = iTimerSpinLock.LockIrqSave();
 	TInt i = TInt(__e32_atomic_add_rlx64(&iMsCount64, 1)) & ETimerQMask;
-	STimerQ* pQ=iTickQ+i;
-	iPresent &= ~(1<<i);
+	iTimerSpinLock.UnlockIrqRestore(irq);
+
+	// Each CPU's queue is locked after the tick count has been updated, so a
+	// timer started concurrently either sees the new count or is already on
+	// the queue when the slot for the old count is processed.
+	TBool doDfc=FALSE;
+	TInt ncpus=TheScheduler.iNumCpus;
+	TInt cpu;
+	for (cpu=0; cpu<ncpus; ++cpu)
+		{
+		if (TickQ(iCpuQ[cpu], i))
+			doDfc=TRUE;
+		}
+	if (doDfc)
+		iDfc.Add();
+	}
+
+TBool NTimerQ::TickQ(SCpuTimerQ& aQ, TInt aSlot)
+//
+//	Internal function to expire the timers on one CPU's queue which are due
+//	on the tick just counted.
+//	Return TRUE if the timer DFC is required.
+//
+	{
+	TInt irq = aQ.iTimerSpinLock.LockIrqSave();
+	STimerQ* pQ=aQ.iTickQ+aSlot;
+	aQ.iPresent &= ~(1<<aSlot);
 	TBool doDfc=FALSE;
 	if (!pQ->iDfcQ.IsEmpty())
 		{
 		// transfer DFC completions to completed queue and queue DFC
-		iCompletedQ.MoveFrom(&pQ->iDfcQ);
+		aQ.iCompletedQ.MoveFrom(&pQ->iDfcQ);
 		doDfc=TRUE;
 		}
-	if ((i&(ETimerQMask>>1))==0)
+	if (!aQ.iCascadePending && SkipWheelSteps(aQ))
 		{
-		// Every 16 ticks we check if a DFC is required.
-		// This allows a DFC latency of up to 16 ticks before timers are missed.
-		if (!iHoldingQ.IsEmpty())
-			{
-			doDfc=TRUE;				// if holding queue nonempty, queue DFC to sort
-			}
-		else if (!iOrderedQ.IsEmpty())
-			{
-			// if first ordered queue entry expires in <32ms, queue the DFC to transfer
-			NTimer* pC=(NTimer*)iOrderedQ.First();
-			TUint x = pC->iTriggerTime - iMsCount;
-			if (x < (TUint)ENumTimerQueues)
-				{
-				doDfc=TRUE;
-				}
-			}
+		// a wheel step with timers on it is due, queue DFC to cascade it
+		aQ.iCascadePending=TRUE;
+		doDfc=TRUE;
 		}
 	if (!pQ->iIntQ.IsEmpty())
 		{
 		// transfer ISR completions to a temporary queue
 		// careful here - other CPUs could dequeue timers!
 		SDblQue q(&pQ->iIntQ,0);
-		for (; !q.IsEmpty(); iTimerSpinLock.LockIrqSave())
+		for (; !q.IsEmpty(); aQ.iTimerSpinLock.LockIrqSave())
 			{
 			NTimer* pC=(NTimer*)q.First();
 			pC->Deque();
 			if (pC->IsMutating())
 				{
 				pC->AddAsDFC();			//mutate NTimer into TDfc and Add() it
-				iTimerSpinLock.UnlockIrqRestore(irq);
+				aQ.iTimerSpinLock.UnlockIrqRestore(irq);
 				continue;
 				}
 			if (!pC->iFn)
 				{
 				pC->i_NTimer_iState=NTimer::EIdle;
-				iTimerSpinLock.UnlockIrqRestore(irq);
+				aQ.iTimerSpinLock.UnlockIrqRestore(irq);
 				((TDfc*)(pC->iPtr))->Add();
 				continue;
 				}
@@ -803,7 +933,7 @@ EXPORT_C void NTimerQ::Tick()
 					pC->i_NTimer_iState = TUint8(NTimer::EEventQ + cpu);
 					TSubScheduler* ss = TheSubSchedulers + cpu;
 					TInt kick = ss->QueueEvent(pC);
-					iTimerSpinLock.UnlockIrqRestore(irq);
+					aQ.iTimerSpinLock.UnlockIrqRestore(irq);
 					if (kick)
 						send_irq_ipi(ss, kick);
 					continue;
@@ -812,15 +942,14 @@ EXPORT_C void NTimerQ::Tick()
 			pC->i_NTimer_iState=NTimer::EIdle;
 			TAny* p = pC->iPtr;
 			NTimerFn f = pC->iFn;
-			iTimerSpinLock.UnlockIrqRestore(irq);
+			aQ.iTimerSpinLock.UnlockIrqRestore(irq);
 			(*f)(p);
 			if (tied)
 				tied->EndTiedEvent();
 			}
 		}
-	iTimerSpinLock.UnlockIrqRestore(irq);
-	if (doDfc)
-		iDfc.Add();
+	aQ.iTimerSpinLock.UnlockIrqRestore(irq);
+	return doDfc;
 	}
 
 
@@ -876,32 +1005,43 @@ EXPORT_C TInt NTimerQ::IdleTime()
 	CHECK_PRECONDITIONS(MASK_INTERRUPTS_DISABLED,"NTimerQ::IdleTime");	
 	NTimerQ& m=TheTimerQ;
 	TUint32 next=m.iMsCount;	// number of next tick
-	TUint32 p=m.iPresent;
 	TInt r=KMaxTInt;
-	if (p)
-		{
-		// Final queues nonempty
-		TInt nx=next&0x1f;				// number of next tick modulo 32
-		p=(p>>nx)|(p<<(32-nx));			// rotate p right by nx (so lsb corresponds to next tick)
-		r=__e32_find_ls1_32(p);	// find number of zeros before LS 1
-		}
-	if (!m.iHoldingQ.IsEmpty())
-		{
-		// Sort operation required - need to process next tick divisible by 16
-		TInt nx=next&0x0f;				// number of next tick modulo 16
-		TInt r2=nx?(16-nx):0;			// number of ticks before next divisible by 16
-		if (r2<r)
-			r=r2;
-		}
-	if (!m.iOrderedQ.IsEmpty())
+	TInt ncpus=TheScheduler.iNumCpus;
+	TInt cpu;
+	for (cpu=0; cpu<ncpus; ++cpu)
 		{
-		// Timers present on ordered queue
-		NTimer* pC=(NTimer*)m.iOrderedQ.First();
-		TUint32 tt=pC->iTriggerTime;
-		tt=(tt&~0x0f)-16;				// time at which transfer to final queue would occur
-		TInt r3=(TInt)(tt-next);
-		if (r3<r)
-			r=r3;
+		NTimerQ::SCpuTimerQ& cq=m.iCpuQ[cpu];
+		TUint32 p=cq.iPresent;
+		if (p)
+			{
+			// Final queues nonempty
+			TInt nx=next&0x1f;				// number of next tick modulo 32
+			p=(p>>nx)|(p<<(32-nx));			// rotate p right by nx (so lsb corresponds to next tick)
+			TInt r1=__e32_find_ls1_32(p);	// find number of zeros before LS 1
+			if (r1<r)
+				r=r1;
+			}
+		TInt level;
+		TInt shift=NTimerQ::EWheelStepShift;
+		for (level=0; level<NTimerQ::ENumWheelLevels; ++level, shift+=NTimerQ::EWheelLevelShift)
+			{
+			p=cq.iWheelPresent[level];
+			if (!p)
+				continue;
+			// Timers present on this wheel level. Slots are cascaded when the
+			// wheel time reaches a multiple of the slot size, so find the first
+			// such wheel time whose slot is nonempty.
+			TUint32 wt=cq.iWheelTime+(1u<<shift)-1;
+			wt&=~((1u<<shift)-1);			// first wheel time at which this level cascades
+			TInt nx=(wt>>shift)&NTimerQ::EWheelSlotMask;
+			p=(p>>nx)|(p<<(32-nx));			// rotate p right by nx (so lsb corresponds to wt)
+			wt+=TUint32(__e32_find_ls1_32(p))<<shift;
+			TInt r2=(TInt)(wt-NTimerQ::EWheelStep-next);	// cascade occurs 16 ticks before the step starts
+			if (r2<0)
+				r2=0;
+			if (r2<r)
+				r=r2;
+			}
 		}
 	return r;
 	}
@@ -922,7 +1062,23 @@ EXPORT_C TInt NTimerQ::IdleTime()
 EXPORT_C void NTimerQ::Advance(TInt aTicks)
 	{
 	CHECK_PRECONDITIONS(MASK_INTERRUPTS_DISABLED,"NTimerQ::Advance");
-	__e32_atomic_add_rlx64(&TheTimerQ.iMsCount64, TUint64(TUint32(aTicks)));
+	NTimerQ& m=TheTimerQ;
+	m.iTimerSpinLock.LockOnly();
+	__e32_atomic_add_rlx64(&m.iMsCount64, TUint64(TUint32(aTicks)));
+	m.iTimerSpinLock.UnlockOnly();
+
+	// Bring the wheel times up to date. Any step which has timers on it is
+	// left for the timer DFC, which the next tick will queue.
+	TInt ncpus=TheScheduler.iNumCpus;
+	TInt cpu;
+	for (cpu=0; cpu<ncpus; ++cpu)
+		{
+		NTimerQ::SCpuTimerQ& cq=m.iCpuQ[cpu];
+		cq.iTimerSpinLock.LockOnly();
+		if (!cq.iCascadePending)
+			m.SkipWheelSteps(cq);
+		cq.iTimerSpinLock.UnlockOnly();
+		}
 	}
 
 
@@ -531,6 +531,85 @@ EXPORT_C TSpinLock* BTrace::LockPtr()
 #endif
 	}
 
+#ifdef __USE_BTRACE_LOCK__
+// Set in the value returned by BTraceLockIrqSave() if BTraceLock was taken
+const TInt KBTraceLockHeld = (TInt)0x80000000u;
+
+/** Called before each call to the trace handler.
+
+	Disables interrupts and, unless the handler has declared itself lock free,
+	acquires BTraceLock.
+
+	@return Value to pass to BTraceUnlockIrqRestore()
+	@internalComponent
+ */
+extern "C" TInt BTraceLockIrqSave()
+	{
+	if (BTraceLockFree)
+		return NKern::DisableAllInterrupts();
+	return BTraceLock.LockIrqSave() | KBTraceLockHeld;
+	}
+
+/** Called after each call to the trace handler to undo BTraceLockIrqSave().
+
+	@internalComponent
+ */
+extern "C" void BTraceUnlockIrqRestore(TInt aIrq)
+	{
+	if (aIrq & KBTraceLockHeld)
+		BTraceLock.UnlockIrqRestore(aIrq &~ KBTraceLockHeld);
+	else
+		NKern::RestoreInterrupts(aIrq);
+	}
+
+static void btrace_ipi_dummy(TGenericIPI*)
+	{
+	}
+
+/** Wait until no CPU is running the trace handler with state sampled before
+	this function was called. Since the handler always runs with interrupts
+	disabled, it is sufficient for every other CPU to have taken an IPI.
+ */
+static void BTraceSync()
+	{
+	TGenericIPI ipi;
+	NKern::Lock();
+	ipi.QueueAllOther(&btrace_ipi_dummy);
+	NKern::Unlock();
+	ipi.WaitCompletion();
+	}
+#endif
+
+/**	Set whether the trace handler is called with BTrace::LockPtr() held.
+
+	A handler which only writes to per-CPU state may be declared lock free, in
+	which case it is called with interrupts disabled on the current CPU but
+	without the lock, so trace output on one CPU never waits for another.
+
+	On return no CPU is still running the handler under the previous setting.
+
+	@param aLockFree	True to call the handler without the lock.
+	@return The previous setting.
+
+	@pre Call in a thread context.
+	@pre Interrupts must be enabled.
+	@pre Kernel must be unlocked.
+	@internalTechnology
+ */
+EXPORT_C TBool BTrace::SetLockFree(TBool aLockFree)
+	{
+#ifdef __USE_BTRACE_LOCK__
+	CHECK_PRECONDITIONS(MASK_THREAD_STANDARD,"BTrace::SetLockFree");
+	BTraceSync();
+	TBool old = __e32_atomic_swp_ord32(&BTraceLockFree, aLockFree ? 1 : 0);
+	BTraceSync();
+	return old;
+#else
+	(void)aLockFree;
+	return ETrue;
+#endif
+	}
+
 TDfcQue* TScheduler::RebalanceDfcQ()
 	{
 	return TheScheduler.iRebalanceDfcQ;
@@ -36,6 +36,7 @@ TSubScheduler* SubSchedulerLookupTable[256];
 
 #ifdef __USE_BTRACE_LOCK__
 TSpinLock BTraceLock(TSpinLock::EOrderBTrace);
+volatile TUint32 BTraceLockFree = 0;
 #endif
 
 SBTraceData BTraceData = { {0}, 0, 0 };
@@ -289,10 +289,10 @@ TInt BTraceDefaultControl(BTrace::TControl /*aFunction*/, TAny* /*aArg1*/, TAny*
 EXPORT_C void BTrace::SetHandlers(BTrace::THandler aNewHandler, BTrace::TControlFunction aNewControl, BTrace::THandler& aOldHandler, BTrace::TControlFunction& aOldControl)
 	{
 	BTrace::TControlFunction nc = aNewControl ? aNewControl : &BTraceDefaultControl;
-	__ACQUIRE_BTRACE_LOCK();
+	TInt irq = BTraceLock.LockIrqSave();
 	BTrace::THandler oldh = (BTrace::THandler)__e32_atomic_swp_ord_ptr(&BTraceData.iHandler, aNewHandler);
 	BTrace::TControlFunction oldc = (BTrace::TControlFunction)__e32_atomic_swp_ord_ptr(&BTraceData.iControl, nc);
-	__RELEASE_BTRACE_LOCK();
+	BTraceLock.UnlockIrqRestore(irq);
 	aOldHandler = oldh;
 	aOldControl = oldc;
 	}
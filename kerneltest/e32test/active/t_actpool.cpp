@@ -0,0 +1,328 @@
+// Copyright (c) 2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of the License "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+// e32test\active\t_actpool.cpp
+// Overview:
+// Test CActiveSchedulerPool.
+// API Information:
+// CActiveSchedulerPool
+// Details:
+// - Create a pool and check the number of threads.
+// - Post work to any thread and check it all runs.
+// - Post work to an affinity group and check it runs in order, one piece at a
+// time, in a single thread.
+// - Post a callback which asks to be called again, and check it is.
+// - Create an active object from work posted to a group, and check its RunL()
+// runs in the group's thread.
+// - Keep a group's queue busy with work which asks to be called again, and
+// check an active object in the group whose request is completed by the kernel
+// still runs.
+// - Block one thread of a two thread pool and check work queued behind the
+// blocked work is taken and run by the other thread.
+// Platforms/Drives/Compatibility:
+// All.
+// Assumptions/Requirement/Pre-requisites:
+// Failures and causes:
+// Base Port information:
+//
+//
+
+#define __E32TEST_EXTENSION__
+
+#include <e32test.h>
+#include <e32atomics.h>
+
+LOCAL_D RTest test(_L("T_ACTPOOL"));
+
+const TInt KThreads = 4;
+const TInt KTimeout = 10000000;
+
+LOCAL_D RSemaphore Done;
+LOCAL_D RSemaphore Gate;
+LOCAL_D volatile TUint32 Counter;
+
+LOCAL_C void WaitForDone(TInt aCount)
+	{
+	while (aCount--)
+		test_KErrNone(Done.Wait(KTimeout));
+	}
+
+LOCAL_C TInt Count(TAny*)
+	{
+	__e32_atomic_add_ord32(&Counter, 1);
+	Done.Signal();
+	return EFalse;
+	}
+
+//
+// Work posted to a group
+//
+struct SGroupState
+	{
+	TBool iBusy;
+	TInt iNext;
+	TThreadId iThread;
+	TBool iFailed;
+	};
+
+struct SGroupWork
+	{
+	SGroupState* iState;
+	TInt iIndex;
+	};
+
+LOCAL_C TInt GroupWork(TAny* aPtr)
+	{
+	SGroupWork& w = *(SGroupWork*)aPtr;
+	SGroupState& s = *w.iState;
+	if (s.iBusy || s.iNext != w.iIndex)
+		s.iFailed = ETrue;
+	if (w.iIndex == 0)
+		s.iThread = RThread().Id();
+	else if (s.iThread != RThread().Id())
+		s.iFailed = ETrue;
+	s.iBusy = ETrue;
+	for (TInt i = 0; i < 1000; ++i)
+		User::AfterHighRes(0);
+	s.iBusy = EFalse;
+	++s.iNext;
+	Done.Signal();
+	return EFalse;
+	}
+
+LOCAL_C TInt Again(TAny* aPtr)
+	{
+	TInt& calls = *(TInt*)aPtr;
+	if (++calls < 5)
+		return ETrue;
+	Done.Signal();
+	return EFalse;
+	}
+
+LOCAL_C TInt Block(TAny*)
+	{
+	Gate.Wait();
+	Done.Signal();
+	return EFalse;
+	}
+
+//
+// An active object created by work posted to a group
+//
+class CGroupTimer : public CTimer
+	{
+public:
+	static TInt Create(TAny* aPtr);
+	static TInt Destroy(TAny* aPtr);
+private:
+	CGroupTimer();
+	virtual void RunL();
+public:
+	TThreadId iCreator;
+	TBool iRanInCreator;
+	volatile TBool iRan;
+	};
+
+LOCAL_D CGroupTimer* GroupTimer;
+
+CGroupTimer::CGroupTimer()
+	: CTimer(EPriorityStandard)
+	{
+	}
+
+TInt CGroupTimer::Create(TAny*)
+	{
+	CGroupTimer* t = new CGroupTimer;
+	test_NotNull(t);
+	TRAPD(r, t->ConstructL());
+	test_KErrNone(r);
+	CActiveScheduler::Add(t);
+	t->iCreator = RThread().Id();
+	GroupTimer = t;
+	t->After(1000);
+	return EFalse;
+	}
+
+TInt CGroupTimer::Destroy(TAny*)
+	{
+	delete GroupTimer;
+	GroupTimer = NULL;
+	Done.Signal();
+	return EFalse;
+	}
+
+void CGroupTimer::RunL()
+	{
+	iRanInCreator = (RThread().Id() == iCreator);
+	iRan = ETrue;
+	Done.Signal();
+	}
+
+//
+// Work which keeps its group's queue busy until the group's timer has run
+//
+const TInt KMaxSpins = 10000;
+
+LOCAL_C TInt Spin(TAny* aPtr)
+	{
+	TInt& spins = *(TInt*)aPtr;
+	if (!GroupTimer->iRan && ++spins < KMaxSpins)
+		{
+		User::AfterHighRes(100);
+		return ETrue;
+		}
+	Done.Signal();
+	return EFalse;
+	}
+
+LOCAL_C void TestAnyGroup(CActiveSchedulerPool* aPool)
+	{
+	const TInt KWork = 200;
+	Counter = 0;
+	for (TInt i = 0; i < KWork; ++i)
+		test_KErrNone(aPool->Post(CActiveSchedulerPool::EAnyGroup, TCallBack(Count)));
+	WaitForDone(KWork);
+	test_Equal(KWork, Counter);
+	}
+
+LOCAL_C void TestGroups(CActiveSchedulerPool* aPool)
+	{
+	const TInt KGroups = 3;
+	const TInt KWork = 20;
+	SGroupState state[KGroups];
+	SGroupWork work[KGroups][KWork];
+	TInt group[KGroups];
+	TInt g;
+	for (g = 0; g < KGroups; ++g)
+		{
+		group[g] = aPool->OpenGroup();
+		test(group[g] != CActiveSchedulerPool::EAnyGroup);
+		state[g].iBusy = EFalse;
+		state[g].iNext = 0;
+		state[g].iFailed = EFalse;
+		}
+	for (TInt i = 0; i < KWork; ++i)
+		{
+		for (g = 0; g < KGroups; ++g)
+			{
+			work[g][i].iState = &state[g];
+			work[g][i].iIndex = i;
+			test_KErrNone(aPool->Post(group[g], TCallBack(GroupWork, &work[g][i])));
+			}
+		}
+	WaitForDone(KGroups * KWork);
+	for (g = 0; g < KGroups; ++g)
+		{
+		test(!state[g].iFailed);
+		test_Equal(KWork, state[g].iNext);
+		aPool->CloseGroup(group[g]);
+		}
+	// three groups in a four thread pool each get a thread to themselves
+	test(state[0].iThread != state[1].iThread);
+	test(state[1].iThread != state[2].iThread);
+	test(state[0].iThread != state[2].iThread);
+	}
+
+LOCAL_C void TestCallAgain(CActiveSchedulerPool* aPool)
+	{
+	TInt calls = 0;
+	test_KErrNone(aPool->Post(CActiveSchedulerPool::EAnyGroup, TCallBack(Again, &calls)));
+	WaitForDone(1);
+	test_Equal(5, calls);
+	}
+
+LOCAL_C void TestActiveObject(CActiveSchedulerPool* aPool)
+	{
+	TInt group = aPool->OpenGroup();
+	test_KErrNone(aPool->Post(group, TCallBack(CGroupTimer::Create)));
+	WaitForDone(1);
+	test(GroupTimer->iRanInCreator);
+	test_KErrNone(aPool->Post(group, TCallBack(CGroupTimer::Destroy)));
+	WaitForDone(1);
+	aPool->CloseGroup(group);
+	}
+
+LOCAL_C void TestBusyQueue(CActiveSchedulerPool* aPool)
+	{
+	TInt group = aPool->OpenGroup();
+	TInt spins = 0;
+	test_KErrNone(aPool->Post(group, TCallBack(CGroupTimer::Create)));
+	test_KErrNone(aPool->Post(group, TCallBack(Spin, &spins)));
+	WaitForDone(2);
+	test(GroupTimer->iRan);
+	test_Compare(spins, <, KMaxSpins);
+	test_KErrNone(aPool->Post(group, TCallBack(CGroupTimer::Destroy)));
+	WaitForDone(1);
+	aPool->CloseGroup(group);
+	}
+
+LOCAL_C void TestSteal()
+	{
+	CActiveSchedulerPool* pool = NULL;
+	TRAPD(r, pool = CActiveSchedulerPool::NewL(2));
+	test_KErrNone(r);
+	TInt group = pool->OpenGroup();
+	test_KErrNone(pool->Post(group, TCallBack(Block)));
+
+	// about half of these are queued behind the blocked work
+	const TInt KWork = 20;
+	Counter = 0;
+	for (TInt i = 0; i < KWork; ++i)
+		test_KErrNone(pool->Post(CActiveSchedulerPool::EAnyGroup, TCallBack(Count)));
+	WaitForDone(KWork);
+	test_Equal(KWork, Counter);
+
+	Gate.Signal();
+	WaitForDone(1);
+	pool->CloseGroup(group);
+	delete pool;
+	}
+
+GLDEF_C TInt E32Main()
+	{
+	test.Title();
+	test_KErrNone(Done.CreateLocal(0));
+	test_KErrNone(Gate.CreateLocal(0));
+
+	test.Start(_L("Create a pool"));
+	CActiveSchedulerPool* pool = NULL;
+	TRAPD(r, pool = CActiveSchedulerPool::NewL(KThreads));
+	test_KErrNone(r);
+	test_Equal(KThreads, pool->Count());
+
+	test.Next(_L("Post work to any thread"));
+	TestAnyGroup(pool);
+
+	test.Next(_L("Post work to affinity groups"));
+	TestGroups(pool);
+
+	test.Next(_L("Post work which asks to be called again"));
+	TestCallAgain(pool);
+
+	test.Next(_L("Run an active object in a group"));
+	TestActiveObject(pool);
+
+	test.Next(_L("Run an active object while its group's queue is busy"));
+	TestBusyQueue(pool);
+
+	test.Next(_L("Destroy the pool"));
+	delete pool;
+
+	test.Next(_L("Work is taken from a blocked thread"));
+	TestSteal();
+
+	Gate.Close();
+	Done.Close();
+	test.End();
+	return KErrNone;
+	}
@@ -0,0 +1,402 @@
+// Copyright (c) 2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of the License "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+// e32test\active\t_actready.cpp
+// Overview:
+// Test the active scheduler's ready queue, and compare the rate at which
+// events are dispatched with and without it.
+// API Information:
+// CActiveScheduler::EnableReadyQueueL, User::RequestComplete
+// Details:
+// - Complete requests of several priorities with User::RequestComplete and
+// check the active objects run in priority order.
+// - Complete a request of higher priority through the kernel after marking a
+// lower priority object ready, and check the higher priority object runs first.
+// - Complete requests of equal priority, with User::RequestComplete and through
+// the kernel, in the reverse of the order the objects were added, and check
+// they run in the order they were added.
+// - Cancel and delete an active object which has been marked ready, and check
+// the scheduler carries on normally.
+// - Pass a single event around a ring of 10, 100 and 1000 active objects of
+// equal priority, with and without the ready queue, and print the number of
+// events dispatched per second. Do this with User::RequestComplete and again
+// with the requests completed by the kernel, which the ready queue can't see.
+// Platforms/Drives/Compatibility:
+// All.
+// Assumptions/Requirement/Pre-requisites:
+// Failures and causes:
+// Base Port information:
+//
+//
+
+#define __E32TEST_EXTENSION__
+
+#include <e32test.h>
+
+LOCAL_D RTest test(_L("T_ACTREADY"));
+
+const TInt KMaxRecorded = 8;
+LOCAL_D TInt RunOrder[KMaxRecorded];
+LOCAL_D TInt RunCount;
+
+class CTestScheduler : public CActiveScheduler
+	{
+public:
+	virtual void Error(TInt aError) const;
+	};
+
+void CTestScheduler::Error(TInt aError) const
+	{
+	test.Panic(aError,_L("CTestScheduler::Error"));
+	}
+
+//
+// An active object which records that it has run, and stops the scheduler
+// once the expected number of objects have run.
+//
+class CRecorder : public CActive
+	{
+public:
+	CRecorder(TInt aPriority, TInt aId, TInt aStopAfter);
+	~CRecorder();
+	void Wait();
+	void Complete();
+private:
+	virtual void RunL();
+	virtual void DoCancel();
+private:
+	TInt iId;
+	TInt iStopAfter;
+	};
+
+CRecorder::CRecorder(TInt aPriority, TInt aId, TInt aStopAfter)
+	: CActive(aPriority), iId(aId), iStopAfter(aStopAfter)
+	{
+	CActiveScheduler::Add(this);
+	}
+
+CRecorder::~CRecorder()
+	{
+	Cancel();
+	}
+
+void CRecorder::Wait()
+	{
+	iStatus = KRequestPending;
+	SetActive();
+	}
+
+void CRecorder::Complete()
+	{
+	TRequestStatus* s = &iStatus;
+	User::RequestComplete(s, KErrNone);
+	}
+
+void CRecorder::RunL()
+	{
+	test(RunCount < KMaxRecorded);
+	RunOrder[RunCount++] = iId;
+	if (RunCount == iStopAfter)
+		CActiveScheduler::Stop();
+	}
+
+void CRecorder::DoCancel()
+	{
+	if (iStatus == KRequestPending)
+		{
+		TRequestStatus* s = &iStatus;
+		User::RequestComplete(s, KErrCancel);
+		}
+	}
+
+//
+// One of a ring of active objects passing a single event round.  Each one waits
+// again and completes the next when it runs.
+//
+class CRingObject : public CActive
+	{
+public:
+	CRingObject(TInt& aEvents, TInt aMaxEvents, TBool aKernel);
+	~CRingObject();
+	void Wait();
+	void Complete();
+public:
+	CRingObject* iNext;
+private:
+	virtual void RunL();
+	virtual void DoCancel();
+private:
+	TInt& iEvents;
+	TInt iMaxEvents;
+	TBool iKernel;			// complete through the kernel rather than User::RequestComplete()
+	};
+
+CRingObject::CRingObject(TInt& aEvents, TInt aMaxEvents, TBool aKernel)
+	: CActive(EPriorityStandard), iEvents(aEvents), iMaxEvents(aMaxEvents), iKernel(aKernel)
+	{
+	CActiveScheduler::Add(this);
+	}
+
+CRingObject::~CRingObject()
+	{
+	Cancel();
+	}
+
+void CRingObject::Wait()
+	{
+	iStatus = KRequestPending;
+	SetActive();
+	}
+
+void CRingObject::Complete()
+	{
+	TRequestStatus* s = &iStatus;
+	if (iKernel)
+		RThread().RequestComplete(s, KErrNone);
+	else
+		User::RequestComplete(s, KErrNone);
+	}
+
+void CRingObject::RunL()
+	{
+	Wait();
+	if (++iEvents == iMaxEvents)
+		CActiveScheduler::Stop();
+	else
+		iNext->Complete();
+	}
+
+void CRingObject::DoCancel()
+	{
+	if (iStatus == KRequestPending)
+		{
+		TRequestStatus* s = &iStatus;
+		User::RequestComplete(s, KErrCancel);
+		}
+	}
+
+
+LOCAL_C CTestScheduler* InstallScheduler(TBool aReadyQueue)
+	{
+	CTestScheduler* s = new CTestScheduler;
+	test_NotNull(s);
+	CActiveScheduler::Install(s);
+	if (aReadyQueue)
+		{
+		TRAPD(r, s->EnableReadyQueueL());
+		test_KErrNone(r);
+		}
+	return s;
+	}
+
+LOCAL_C void RemoveScheduler(CTestScheduler* aScheduler)
+	{
+	CActiveScheduler::Install(NULL);
+	delete aScheduler;
+	}
+
+LOCAL_C void TestPriorityOrder()
+	{
+	CTestScheduler* s = InstallScheduler(ETrue);
+	CRecorder* low = new CRecorder(CActive::EPriorityLow, 1, 3);
+	CRecorder* standard = new CRecorder(CActive::EPriorityStandard, 2, 3);
+	CRecorder* high = new CRecorder(CActive::EPriorityHigh, 3, 3);
+	test(low && standard && high);
+	low->Wait();
+	standard->Wait();
+	high->Wait();
+	low->Complete();
+	standard->Complete();
+	high->Complete();
+
+	RunCount = 0;
+	CActiveScheduler::Start();
+	test_Equal(3, RunCount);
+	test_Equal(3, RunOrder[0]);
+	test_Equal(2, RunOrder[1]);
+	test_Equal(1, RunOrder[2]);
+
+	delete high;
+	delete standard;
+	delete low;
+	RemoveScheduler(s);
+	}
+
+LOCAL_C void TestCompletedElsewhere()
+	{
+	CTestScheduler* s = InstallScheduler(ETrue);
+	CRecorder* low = new CRecorder(CActive::EPriorityLow, 1, 2);
+	CRecorder* high = new CRecorder(CActive::EPriorityHigh, 2, 2);
+	test(low && high);
+	low->Wait();
+	high->Wait();
+
+	// complete the high priority request through the kernel, so it isn't marked ready...
+	RThread thread;
+	TRequestStatus* hs = &high->iStatus;
+	thread.RequestComplete(hs, KErrNone);
+	low->Complete();
+
+	RunCount = 0;
+	CActiveScheduler::Start();
+	test_Equal(2, RunCount);
+	test_Equal(2, RunOrder[0]);
+	test_Equal(1, RunOrder[1]);
+
+	delete high;
+	delete low;
+	RemoveScheduler(s);
+	}
+
+LOCAL_C void TestEqualPriority()
+	{
+	CTestScheduler* s = InstallScheduler(ETrue);
+	CRecorder* first = new CRecorder(CActive::EPriorityStandard, 1, 2);
+	CRecorder* second = new CRecorder(CActive::EPriorityStandard, 2, 2);
+	CRecorder* third = new CRecorder(CActive::EPriorityStandard, 3, 2);
+	test(first && second && third);
+
+	// two marked ready in the reverse of the order they were added...
+	second->Wait();
+	third->Wait();
+	third->Complete();
+	second->Complete();
+	RunCount = 0;
+	CActiveScheduler::Start();
+	test_Equal(2, RunCount);
+	test_Equal(2, RunOrder[0]);
+	test_Equal(3, RunOrder[1]);
+
+	// ...and one marked ready behind one completed by the kernel
+	first->Wait();
+	second->Wait();
+	second->Complete();
+	RThread thread;
+	TRequestStatus* fs = &first->iStatus;
+	thread.RequestComplete(fs, KErrNone);
+	RunCount = 0;
+	CActiveScheduler::Start();
+	test_Equal(2, RunCount);
+	test_Equal(1, RunOrder[0]);
+	test_Equal(2, RunOrder[1]);
+
+	delete third;
+	delete second;
+	delete first;
+	RemoveScheduler(s);
+	}
+
+LOCAL_C void TestCancelReady()
+	{
+	CTestScheduler* s = InstallScheduler(ETrue);
+	CRecorder* cancelled = new CRecorder(CActive::EPriorityHigh, 1, 1);
+	CRecorder* deleted = new CRecorder(CActive::EPriorityHigh, 2, 1);
+	CRecorder* other = new CRecorder(CActive::EPriorityStandard, 3, 1);
+	test(cancelled && deleted && other);
+
+	// mark two objects ready, then cancel one and delete the other...
+	cancelled->Wait();
+	deleted->Wait();
+	other->Wait();
+	cancelled->Complete();
+	deleted->Complete();
+	cancelled->Cancel();
+	deleted->Cancel();
+	delete deleted;
+
+	other->Complete();
+	RunCount = 0;
+	CActiveScheduler::Start();
+	test_Equal(1, RunCount);
+	test_Equal(3, RunOrder[0]);
+
+	delete other;
+	delete cancelled;
+	RemoveScheduler(s);
+	}
+
+LOCAL_C TInt EventsPerSecond(TInt aObjects, TBool aReadyQueue, TBool aKernel)
+	{
+	const TInt KEvents = 100000;
+	CTestScheduler* s = InstallScheduler(aReadyQueue);
+	TInt events = 0;
+	CRingObject** ring = new CRingObject*[aObjects];
+	test_NotNull(ring);
+	TInt i;
+	for (i = 0; i < aObjects; ++i)
+		{
+		ring[i] = new CRingObject(events, KEvents, aKernel);
+		test_NotNull(ring[i]);
+		ring[i]->Wait();
+		}
+	for (i = 0; i < aObjects; ++i)
+		ring[i]->iNext = ring[(i + 1) % aObjects];
+
+	TTime start;
+	start.UniversalTime();
+	ring[0]->Complete();
+	CActiveScheduler::Start();
+	TTime end;
+	end.UniversalTime();
+	test_Equal(KEvents, events);
+
+	for (i = 0; i < aObjects; ++i)
+		delete ring[i];
+	delete[] ring;
+	RemoveScheduler(s);
+
+	TInt64 us = end.MicroSecondsFrom(start).Int64();
+	if (us <= 0)
+		us = 1;
+	return (TInt)((TInt64)KEvents * 1000000 / us);
+	}
+
+LOCAL_C void Benchmark(TBool aKernel)
+	{
+	const TInt KObjects[] = { 10, 100, 1000 };
+	for (TUint i = 0; i < sizeof(KObjects) / sizeof(KObjects[0]); ++i)
+		{
+		TInt n = KObjects[i];
+		TInt scan = EventsPerSecond(n, EFalse, aKernel);
+		TInt ready = EventsPerSecond(n, ETrue, aKernel);
+		test.Printf(_L("%4d active objects: %8d events/s scanning, %8d events/s with ready queue\n"), n, scan, ready);
+		}
+	}
+
+GLDEF_C TInt E32Main()
+	{
+	test.Title();
+	__UHEAP_MARK;
+
+	test.Start(_L("Ready objects run in priority order"));
+	TestPriorityOrder();
+
+	test.Next(_L("Requests completed elsewhere are still found"));
+	TestCompletedElsewhere();
+
+	test.Next(_L("Equal priority objects run in the order they were added"));
+	TestEqualPriority();
+
+	test.Next(_L("Cancelled and deleted ready objects are forgotten"));
+	TestCancelReady();
+
+	test.Next(_L("Events per second with and without the ready queue"));
+	Benchmark(EFalse);
+
+	test.Next(_L("Events per second completed by the kernel"));
+	Benchmark(ETrue);
+
+	__UHEAP_MARKEND;
+	test.End();
+	return KErrNone;
+	}
@@ -32,6 +32,10 @@ public:
 		{
 		return RSessionBase::SendReceive(aService, args);
 		}
+	void SendReceiveBatch(const TIpcBatch& aBatch)
+		{
+		RSessionBase::SendReceiveBatch(aBatch);
+		}
 	};
 
 class CIpcScheduler : public CActiveScheduler
@@ -319,15 +323,139 @@ TBMResult* IpcLatency::Run(TBMUInt64 aIter, TInt* aCount)
 	return iResults;
 	}
 
+static const TInt KIpcBatchSizes[] = {1, 4, 16, TIpcBatch::KMaxMessages};
+static const TInt KNumIpcBatchSizes = sizeof(KIpcBatchSizes) / sizeof(KIpcBatchSizes[0]);
+static const TInt KMaxIpcBatchResults = 2 * KNumIpcBatchSizes;
+
+class IpcBatch : public BMProgram
+	{
+public :
+
+	TBMResult	iResults[KMaxIpcBatchResults];
+
+	IpcBatch() : BMProgram(_L("Client-server Framework[Batched Requests]"))
+		{}
+
+	virtual TBMResult* Run(TBMUInt64 aIter, TInt* aCount);
+	};
+
+TBMResult* IpcBatch::Run(TBMUInt64 aIter, TInt* aCount)
+	{
+	// The server has lower priority than the client so, either way, all the
+	// requests are sent before the server runs and the difference measured is
+	// the cost of sending each message and of the server waking up for it.
+	SpawnArgs sa(_L("BMServer"), KBMPriorityLow, EFalse, (TInt) aIter);
+
+	MBMChild* child = SpawnChild(&sa);
+
+	static const TPtrC KIndividual[KNumIpcBatchSizes] =
+		{
+		_L("1 Request Sent Individually"),
+		_L("4 Requests Sent Individually"),
+		_L("16 Requests Sent Individually"),
+		_L("32 Requests Sent Individually")
+		};
+	static const TPtrC KBatched[KNumIpcBatchSizes] =
+		{
+		_L("1 Request Batched"),
+		_L("4 Requests Batched"),
+		_L("16 Requests Batched"),
+		_L("32 Requests Batched")
+		};
+	TInt n = 0;
+	TInt j;
+	for (j = 0; j < KNumIpcBatchSizes; ++j)
+		{
+		iResults[n++].Reset(KIndividual[j]);
+		iResults[n++].Reset(KBatched[j]);
+		}
+	BM_ASSERT(KMaxIpcBatchResults >= n);
+
+	sa.iSem.Wait();
+	User::After(2000);
+
+	RIpcSession s;
+	TInt r = s.CreateSession(sa.iServerName, sa.iVersion, TIpcBatch::KMaxMessages);
+	BM_ERROR(r, r == KErrNone);
+
+	TRequestStatus st[TIpcBatch::KMaxMessages];
+	TIpcBatch batch;
+
+	for (TBMUInt64 i = 0; i < aIter; ++i)
+		{
+		n = 0;
+		for (j = 0; j < KNumIpcBatchSizes; ++j)
+			{
+			TInt size = KIpcBatchSizes[j];
+			TInt k;
+
+			TBMTicks t1;
+			::bmTimer.Stamp(&t1);
+			for (k = 0; k < size; ++k)
+				{
+				TIpcArgs args;
+				s.SendReceive(CIpcServer::ERunTest, args, st[k]);
+				}
+			for (k = 0; k < size; ++k)
+				{
+				User::WaitForRequest(st[k]);
+				BM_ERROR(st[k].Int(), st[k] == KErrNone);
+				}
+			TBMTicks t2;
+			::bmTimer.Stamp(&t2);
+			iResults[n++].Cumulate(TBMTicksDelta(t1, t2), size);
+
+			batch.Reset();
+			for (k = 0; k < size; ++k)
+				{
+				r = batch.Add(CIpcServer::ERunTest, TIpcArgs(), st[k]);
+				BM_ERROR(r, r == KErrNone);
+				}
+			::bmTimer.Stamp(&t1);
+			s.SendReceiveBatch(batch);
+			for (k = 0; k < size; ++k)
+				{
+				User::WaitForRequest(st[k]);
+				BM_ERROR(st[k].Int(), st[k] == KErrNone);
+				}
+			::bmTimer.Stamp(&t2);
+			iResults[n++].Cumulate(TBMTicksDelta(t1, t2), size);
+			}
+		BM_ASSERT(KMaxIpcBatchResults >= n);
+		}
+
+		{
+		TIpcArgs args;
+		s.SendReceive(CIpcServer::EStop, args);
+		}
+	s.Close();
+
+	child->WaitChildExit();
+
+	sa.Close();
+
+	for (j = 0; j < KMaxIpcBatchResults; ++j)
+		{
+		iResults[j].Update();
+		}
+
+	*aCount = KMaxIpcBatchResults;
+	return iResults;
+	}
+
 IpcLatency test1(EFalse,KBMPriorityHigh);
 IpcLatency test2(EFalse,KBMPriorityLow );
 IpcLatency test3(ETrue, KBMPriorityHigh);
 IpcLatency test4(ETrue, KBMPriorityLow );
+IpcBatch test5;
 
 void AddIpc()
 	{
 	BMProgram* next = bmSuite;
+	bmSuite=(BMProgram*)&test5;
+	bmSuite->Next()=next;
 	bmSuite=(BMProgram*)&test4;
+	bmSuite->Next()=&test5;
 	bmSuite->Next()=next;
 	bmSuite=(BMProgram*)&test3;
 	bmSuite->Next()=&test4;
@@ -39,12 +39,13 @@ struct Measurement
 	RProperty::TType	iType;
 	TInt				iSize;
 	TSetGetType			iSetGetType;
+	TInt				iThreads;
 
 	Measurement(MeasurementFunc aFunc, const TDesC& aName,
 				RProperty::TType aType, TInt aSize, TBool aRemote = EFalse, 
-				TSetGetType aSetGetType = EOneArg) : 
+				TSetGetType aSetGetType = EOneArg, TInt aThreads = 1) : 
 			iFunc(aFunc), iName(aName), iRemote(aRemote), iType(aType), iSize(aSize), 
-			iSetGetType(aSetGetType) {}
+			iSetGetType(aSetGetType), iThreads(aThreads) {}
 	};
 
 class Property : public BMProgram
@@ -64,6 +65,9 @@ public :
 	static void SetOverhead(TBMResult* aResult, TBMUInt64 aIter, struct Measurement* aM);
 	static void GetOverhead(TBMResult* aResult, TBMUInt64 aIter, struct Measurement* aM);
 
+	static void ManyPropertiesParent(TBMResult* aResult, TBMUInt64 aIter, struct Measurement* aM);
+	static TInt ManyPropertiesChild(TAny*);
+
 
 private:
 	static TBuf8<RProperty::KMaxPropertySize> iInBuf;
@@ -172,6 +176,15 @@ Measurement Property::iMeasurements[] =
 	Measurement(&Property::GetOverhead, _L("TUint16(512) Get Overhead ThreeArgsBuf16"),
 				RProperty::ELargeByteArray, 512, EFalse, EThreeArgsBuf16),
 
+
+
+	Measurement(&Property::ManyPropertiesParent, _L("Int Get/Set 10000 Properties 1 Thread"), 
+				RProperty::EInt, 0, EFalse, EThreeArgsInt, 1),
+	Measurement(&Property::ManyPropertiesParent, _L("Int Get/Set 10000 Properties 2 Threads"), 
+				RProperty::EInt, 0, EFalse, EThreeArgsInt, 2),
+	Measurement(&Property::ManyPropertiesParent, _L("Int Get/Set 10000 Properties 4 Threads"), 
+				RProperty::EInt, 0, EFalse, EThreeArgsInt, 4),
+
 	};
 TBMResult	Property::iResults[sizeof(Property::iMeasurements)/sizeof(Property::iMeasurements[0])];
 
@@ -512,6 +525,90 @@ void Property::GetOverhead(TBMResult* aResult, TBMUInt64 aIter, struct Measureme
 
 
 
+static const TInt KManyProperties = 10000;
+static const TInt KManyPropertiesKeyBase = 0x1000;
+
+class ManyPropertiesArgs : public TBMSpawnArgs
+	{
+public:
+	TBMUInt64		iIterationCount;
+	TUint			iSeed;
+	RSemaphore		iStart;
+
+	ManyPropertiesArgs(TBMUInt64 aIter, TUint aSeed, RSemaphore aStart) :
+		TBMSpawnArgs(Property::ManyPropertiesChild, KBMPriorityLow, EFalse, sizeof(*this)),
+		iIterationCount(aIter), iSeed(aSeed), iStart(aStart) {}
+	};
+
+//
+// Each of aM->iThreads local children does aIter Get()/Set() pairs on randomly 
+// chosen properties out of KManyProperties, using the category/key variants so 
+// that every call has to look the property up. The result is the elapsed time 
+// divided by the total number of pairs, so it falls as the threads scale.
+//
+void Property::ManyPropertiesParent(TBMResult* aResult, TBMUInt64 aIter, struct Measurement* aM)
+	{
+	TInt i;
+	TInt r;
+	for (i = 0; i < KManyProperties; ++i)
+		{
+		r = RProperty::Define(KPropBenchmarkCategory, KManyPropertiesKeyBase + i, RProperty::EInt, KPassPolicy, KPassPolicy);
+		BM_ERROR(r, r == KErrNone);
+		}
+
+	RSemaphore start;
+	r = start.CreateLocal(0);
+	BM_ERROR(r, r == KErrNone);
+
+	const TInt KMaxThreads = 4;
+	BM_ASSERT(aM->iThreads <= KMaxThreads);
+	ManyPropertiesArgs* args[KMaxThreads];
+	MBMChild* child[KMaxThreads];
+	for (i = 0; i < aM->iThreads; ++i)
+		{
+		args[i] = new ManyPropertiesArgs(aIter, 0x9e3779b9u * (i + 1), start);
+		BM_ERROR(KErrNoMemory, args[i]);
+		child[i] = property.SpawnChild(args[i]);
+		}
+
+	// all the children block on 'start' so that they begin together
+	TBMTimeInterval ti;
+	ti.Begin();
+	start.Signal(aM->iThreads);
+	for (i = 0; i < aM->iThreads; ++i)
+		child[i]->WaitChildExit();
+	TBMTicks t = ti.End();
+
+	for (i = 0; i < aM->iThreads; ++i)
+		delete args[i];
+	start.Close();
+	for (i = 0; i < KManyProperties; ++i)
+		{
+		r = RProperty::Delete(KPropBenchmarkCategory, KManyPropertiesKeyBase + i);
+		BM_ERROR(r, r == KErrNone);
+		}
+
+	aResult->Cumulate(t, aIter * aM->iThreads);
+	}
+
+TInt Property::ManyPropertiesChild(TAny* cookie)
+	{
+	ManyPropertiesArgs* args = (ManyPropertiesArgs*) cookie;
+	TUint seed = args->iSeed;
+	args->iStart.Wait();
+	for (TBMUInt64 i = 0; i < args->iIterationCount; ++i)
+		{
+		seed = seed * 69069 + 1;
+		TInt key = KManyPropertiesKeyBase + (TInt)((seed >> 8) % KManyProperties);
+		TInt r = RProperty::Set(KPropBenchmarkCategory, key, (TInt) seed);
+		BM_ERROR(r, r == KErrNone);
+		TInt value;
+		r = RProperty::Get(KPropBenchmarkCategory, key, value);
+		BM_ERROR(r, r == KErrNone);
+		}
+	return KErrNone;
+	}
+
 TBMResult* Property::Run(TBMUInt64 aIter, TInt* aCount)
 	{
 	TInt count = sizeof(iResults)/sizeof(iResults[0]);
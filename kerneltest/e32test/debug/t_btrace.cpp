@@ -48,6 +48,7 @@
 #define __E32TEST_EXTENSION__
 #include <e32test.h>
 #include <e32svr.h>
+#include <u32hal.h>
 #include <e32def.h>
 #include <e32def_private.h>
 
@@ -2452,6 +2453,170 @@ void TestBenchmark(TBool aUserTrace)
 	Trace.SetFilter2(0);
 	}
 
+const TInt KMaxPerCpuThreads = 8;
+
+struct SPerCpuThreadInfo
+	{
+	TUint iCount;		// number of traces output
+	TUint iReceived;	// number of traces found in buffer
+	TUint iLastSeq;		// last sequence number seen in buffer
+	TInt iBadSeq;		// number of traces whose sequence number went backwards
+	};
+
+SPerCpuThreadInfo PerCpuThreadInfo[KMaxPerCpuThreads];
+volatile TBool PerCpuStop;
+
+TInt PerCpuTraceThread(TAny* aIndex)
+	{
+	TInt index = (TInt)aIndex;
+	TUint count = 0;
+	RThread::Rendezvous(KErrNone);
+	while(!PerCpuStop)
+		BTrace8(BTrace::ETest1,KTest1SubCategory,index,++count);
+	PerCpuThreadInfo[index].iCount = count;
+	return KErrNone;
+	}
+
+void ProcessPerCpuData(TUint8* aData, TInt aSize)
+	{
+	TUint8* end = aData+aSize;
+	while(aData<end)
+		{
+		if(aData[BTrace::ECategoryIndex]==BTrace::ETest1 && aData[BTrace::ESubCategoryIndex]==KTest1SubCategory)
+			{
+			TUint32* body = Body(aData);
+			TUint index = body[0];
+			test(index<(TUint)KMaxPerCpuThreads);
+			SPerCpuThreadInfo& info = PerCpuThreadInfo[index];
+			if(body[1]<=info.iLastSeq)
+				++info.iBadSeq;
+			info.iLastSeq = body[1];
+			++info.iReceived;
+			}
+		aData = BTrace::NextRecord(aData);
+		}
+	}
+
+/**
+Run aThreads threads outputting traces for one second while this thread
+collects them, and return the number of traces output per second.
+*/
+TUint PerCpuRun(TInt aThreads)
+	{
+	RThread threads[KMaxPerCpuThreads];
+	TRequestStatus exits[KMaxPerCpuThreads];
+	memclr(PerCpuThreadInfo,sizeof(PerCpuThreadInfo));
+	PerCpuStop = EFalse;
+	TInt i;
+	for(i=0; i<aThreads; ++i)
+		{
+		test_KErrNone(threads[i].Create(KNullDesC,PerCpuTraceThread,0x1000,NULL,(TAny*)i));
+		threads[i].SetPriority(EPriorityLess);
+		TRequestStatus rv;
+		threads[i].Rendezvous(rv);
+		threads[i].Logon(exits[i]);
+		threads[i].Resume();
+		User::WaitForRequest(rv);
+		test_KErrNone(rv.Int());
+		}
+
+	RTimer timer;
+	test_KErrNone(timer.CreateLocal());
+	TRequestStatus timerStatus;
+	timer.After(timerStatus,1000000);
+	while(timerStatus==KRequestPending)
+		{
+		TUint8* data;
+		TInt size;
+		while((size=Trace.GetData(data))!=0)
+			{
+			ProcessPerCpuData(data,size);
+			Trace.DataUsed();
+			}
+		TRequestStatus dataStatus;
+		Trace.RequestData(dataStatus,0x1000);
+		User::WaitForRequest(dataStatus,timerStatus);
+		if(dataStatus==KRequestPending)
+			{
+			Trace.CancelRequestData();
+			User::WaitForRequest(dataStatus);
+			}
+		}
+	User::WaitForRequest(timerStatus);
+	timer.Close();
+
+	PerCpuStop = ETrue;
+	TUint count = 0;
+	for(i=0; i<aThreads; ++i)
+		{
+		User::WaitForRequest(exits[i]);
+		test_KErrNone(exits[i].Int());
+		CLOSE_AND_WAIT(threads[i]);
+		count += PerCpuThreadInfo[i].iCount;
+		}
+	return count;
+	}
+
+//---------------------------------------------
+//! @SYMTestCaseID KBASE-T_BTRACE-2443
+//! @SYMTestType UT
+//! @SYMTestCaseDesc Per-CPU trace buffers.
+//! @SYMTestActions Select per-CPU buffer mode and run one trace generating thread per CPU
+//!		while collecting the trace. Check that each thread's traces arrive in order.
+//!		Then compare the total trace rate for 1..N threads in single buffer and per-CPU
+//!		buffer modes.
+//! @SYMTestExpectedResults Traces from each thread are never reordered. On SMP the total
+//!		trace rate in per-CPU buffer mode should scale with the number of threads. (This is
+//!		not asserted.)
+//! @SYMTestPriority Medium
+//! @SYMTestStatus Implemented
+//---------------------------------------------
+void TestPerCpu()
+	{
+	TInt r = Trace.SetPerCpuBuffers(0x4000);
+	if(r==KErrNotSupported)
+		{
+		test.Printf(_L("Per-CPU buffers not supported by this kernel\n"));
+		return;
+		}
+	test_KErrNone(r);
+	TInt cpus = UserSvr::HalFunction(EHalGroupKernel, EKernelHalNumLogicalCpus, 0, 0);
+	if(cpus<1)
+		cpus = 1;
+	if(cpus>KMaxPerCpuThreads)
+		cpus = KMaxPerCpuThreads;
+
+	test.Start(_L("Check trace order"));
+	Trace.SetFilter(BTrace::ETest1,1);
+	Trace.SetFilter2(1);
+	Trace.SetMode(RBTrace::EEnable);
+	PerCpuRun(cpus);
+	TInt i;
+	for(i=0; i<cpus; ++i)
+		{
+		test_Equal(0,PerCpuThreadInfo[i].iBadSeq);
+		test(PerCpuThreadInfo[i].iReceived!=0);
+		}
+
+	test.Next(_L("Compare single buffer and per-CPU buffer trace rates"));
+	Trace.SetMode(RBTrace::EFreeRunning|RBTrace::EEnable);
+	for(TInt threads=1; threads<=cpus; ++threads)
+		{
+		test_KErrNone(Trace.SetPerCpuBuffers(0));
+		TUint single = PerCpuRun(threads);
+		test_KErrNone(Trace.SetPerCpuBuffers(0x4000));
+		TUint perCpu = PerCpuRun(threads);
+		test.Printf(_L("%d threads: single buffer %8u traces/s   per-CPU buffers %8u traces/s\n"),threads,single,perCpu);
+		}
+
+	test.Next(_L("Return to single buffer mode"));
+	test_KErrNone(Trace.SetPerCpuBuffers(0));
+	Trace.SetMode(0);
+	Trace.SetFilter(BTrace::ETest1,0);
+	Trace.SetFilter2(0);
+	test.End();
+	}
+
 struct THREADTRACETESTSTRUCT {
 	TInt* alloc_addr;
 	void* chunk_addr;
@@ -3388,6 +3553,8 @@ GLDEF_C TInt E32Main()
 	TestBenchmark(0);
 	test.Next(_L("Benchmark user tracing"));
 	TestBenchmark(1);
+	test.Next(_L("Per-CPU trace buffers"));
+	TestPerCpu();
 
 	test.Next(_L("Test category EHeap"));
 	TestHeapAndChunkTrace();
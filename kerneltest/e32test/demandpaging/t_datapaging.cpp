@@ -189,6 +189,64 @@ void TestOnePage()
 	CLOSE_AND_WAIT(gChunk);
 	}
 
+void TestCompressedSwap()
+	{
+	SVMSwapCompressionInfo before;
+	TInt r = UserSvr::HalFunction(EHalGroupVM, EVMHalGetSwapCompressionInfo, &before, 0);
+	if (r == KErrNotSupported)
+		{
+		test.Printf(_L("  Data paging device doesn't compress pages\n"));
+		return;
+		}
+	test_KErrNone(r);
+	test(before.iPoolUsed <= before.iPoolSize);
+	test(before.iCompressedSize <= before.iOriginalSize);
+
+	// Half the pages compress well, the other half are random and don't compress at all
+	const TInt KPages = 16;
+	CreatePagedChunk(KPages, 0);
+	TRandom random;
+	TUint32* base = (TUint32*)gChunk.Base();
+	const TInt KRandomStart = KPages / 2 * gPageSize / 4;
+	const TInt KRandomEnd = KPages * gPageSize / 4;
+	TUint32 sum = 0;
+	TInt i;
+	for (i = 0 ; i < KPages / 2 ; ++i)
+		WritePage(i, ETypeUniform | 0, ETypeIncreasing | i);
+	for (i = KRandomStart ; i < KRandomEnd ; ++i)
+		sum += (base[i] = random.Next());
+	PageOut();
+
+	SVMSwapCompressionInfo after;
+	test_KErrNone(UserSvr::HalFunction(EHalGroupVM, EVMHalGetSwapCompressionInfo, &after, 0));
+	test.Printf(_L("  Pool %d/%d KB, %d pages compressed to %d KB, %d uncompressed, %d on backing media\n"),
+				I64LOW(after.iPoolUsed >> 10), I64LOW(after.iPoolSize >> 10), after.iCompressedPages,
+				I64LOW(after.iCompressedSize >> 10), after.iUncompressedPages, after.iBackingPages);
+	test(after.iWriteCount - before.iWriteCount >= (TUint)KPages);
+	test(after.iCompressedPages - before.iCompressedPages >= (TUint)KPages / 2);
+	test((after.iUncompressedPages + after.iBackingPages) - (before.iUncompressedPages + before.iBackingPages) >= (TUint)KPages / 2);
+	test(after.iCompressedSize <= after.iOriginalSize);
+	test(after.iPoolUsed <= after.iPoolSize);
+
+	// Read everything back
+	for (i = 0 ; i < KPages / 2 ; ++i)
+		ReadPage(i, ETypeIncreasing | i);
+	for (i = KRandomStart ; i < KRandomEnd ; ++i)
+		sum -= base[i];
+	test_Equal(0, sum);
+	test_KErrNone(UserSvr::HalFunction(EHalGroupVM, EVMHalGetSwapCompressionInfo, &after, 0));
+	test(after.iReadCount - before.iReadCount >= (TUint)KPages / 2);
+	test.Printf(_L("  Average write %d ns, read %d ns; longest write %d ns, read %d ns\n"),
+				after.iAverageWriteTime, after.iAverageReadTime, after.iMaxWriteTime, after.iMaxReadTime);
+
+	// Freeing the memory releases its space in the pool
+	CLOSE_AND_WAIT(gChunk);
+	test_KErrNone(UserSvr::HalFunction(EHalGroupVM, EVMHalGetSwapCompressionInfo, &after, 0));
+	test_Equal(before.iCompressedPages, after.iCompressedPages);
+	test_Equal(before.iUncompressedPages, after.iUncompressedPages);
+	test_Equal(before.iBackingPages, after.iBackingPages);
+	}
+
 TInt PageInThreadFunc(TAny* aArg)
 	{
 	TUint8* page = (TUint8*)aArg;
@@ -1222,6 +1280,9 @@ TInt E32Main()
 		test.Next(_L("Test reading and writing to a single page"));
 		TestOnePage();
 
+		test.Next(_L("Test compressed swap, if the data paging device compresses pages"));
+		TestCompressedSwap();
+
 		test.Next(_L("Test 64-bit atomic operations are atomic with paged out data"));
 		TestAtomic64();
 
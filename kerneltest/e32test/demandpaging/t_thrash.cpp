@@ -732,8 +732,86 @@ void BenchmarkReplacement()
 			   1, ETrue, EWorkloadUniformRandom, (2 * gMinCacheSize) / 3, (3 * gMaxCacheSize) / 2, 0);
 	}
 
+void BenchmarkScanResistance()
+	{
+	test.Next(_L("Benchmark page replacement policies with a scanning workload"));
+	TInt originalPolicy = UserSvr::HalFunction(EHalGroupVM, EVMHalGetReplacementPolicy, 0, 0);
+	if (originalPolicy < 0)
+		{
+		test.Printf(_L("Page replacement policies not supported\n"));
+		return;
+		}
+
+	// A hot set that fits easily in the cache is accessed once per round, between which a quarter
+	// of a region four times the size of the cache is read sequentially.  With LRU replacement the
+	// scans flush the hot set every round.
+	const TInt KRounds = 16;
+	const TInt hotPages = gMinCacheSize / 4;
+	const TInt scanPages = 4 * gMaxCacheSize;
+	const TInt scanStep = scanPages / 4;
+	CreatePagedChunk(hotPages + scanPages);
+	TInt i;
+	for (i = 0 ; i < hotPages + scanPages ; ++i)
+		*PageBasePtr(i) = i;
+
+	test.Printf(_L("policy, pageFaults, pageInReads, hotPageInReads\n"));
+	TUint64 hotReads[EVMMaxReplacementPolicy];
+	for (TInt policy = 0 ; policy < EVMMaxReplacementPolicy ; ++policy)
+		{
+		test_KErrNone(UserSvr::HalFunction(EHalGroupVM, EVMHalSetReplacementPolicy, (TAny*)policy, 0));
+		DPTest::FlushCache();
+
+		TPckgBuf<SVMEventInfo> start, before, after;
+		test_KErrNone(UserSvr::HalFunction(EHalGroupVM, EVMHalGetEventInfo, &start, 0));
+		hotReads[policy] = 0;
+		TInt scanPos = 0;
+		for (TInt round = 0 ; round < KRounds ; ++round)
+			{
+			test_KErrNone(UserSvr::HalFunction(EHalGroupVM, EVMHalGetEventInfo, &before, 0));
+			for (i = 0 ; i < hotPages ; ++i)
+				test_Equal(i, *PageBasePtr(i));
+			test_KErrNone(UserSvr::HalFunction(EHalGroupVM, EVMHalGetEventInfo, &after, 0));
+			if (round)	// the first round always has to page in the hot set
+				hotReads[policy] += after().iPageInReadCount - before().iPageInReadCount;
+
+			for (i = 0 ; i < scanStep ; ++i)
+				{
+				TInt page = hotPages + scanPos;
+				test_Equal(page, *PageBasePtr(page));
+				scanPos = (scanPos + 1) % scanPages;
+				}
+			}
+		test_KErrNone(UserSvr::HalFunction(EHalGroupVM, EVMHalGetEventInfo, &after, 0));
+		test.Printf(_L("%6d, %10ld, %11ld, %14ld\n"), policy,
+					after().iPageFaultCount - start().iPageFaultCount,
+					after().iPageInReadCount - start().iPageInReadCount,
+					hotReads[policy]);
+		}
+	test(hotReads[EVMReplacementPolicyScanResistant] < hotReads[EVMReplacementPolicyLru]);
+
+	test_KErrNone(UserSvr::HalFunction(EHalGroupVM, EVMHalSetReplacementPolicy, (TAny*)originalPolicy, 0));
+	gChunk.Close();
+	test.Printf(_L("\n"));
+	}
+
+void TestReplacementPolicyHal()
+	{
+	test.Next(_L("Test EVMHalSetReplacementPolicy"));
+	TInt originalPolicy = UserSvr::HalFunction(EHalGroupVM, EVMHalGetReplacementPolicy, 0, 0);
+	test(originalPolicy >= 0 && originalPolicy < EVMMaxReplacementPolicy);
+	test_Equal(KErrArgument, UserSvr::HalFunction(EHalGroupVM, EVMHalSetReplacementPolicy, (TAny*)EVMMaxReplacementPolicy, 0));
+	for (TInt policy = 0 ; policy < EVMMaxReplacementPolicy ; ++policy)
+		{
+		test_KErrNone(UserSvr::HalFunction(EHalGroupVM, EVMHalSetReplacementPolicy, (TAny*)policy, 0));
+		test_Equal(policy, UserSvr::HalFunction(EHalGroupVM, EVMHalGetReplacementPolicy, 0, 0));
+		}
+	test_KErrNone(UserSvr::HalFunction(EHalGroupVM, EVMHalSetReplacementPolicy, (TAny*)originalPolicy, 0));
+	}
+
 void TestThrashHal()
 	{			 
+	TestReplacementPolicyHal();
+
 	test.Next(_L("Test EVMHalSetThrashThresholds"));
 	test_Equal(KErrArgument, UserSvr::HalFunction(EHalGroupVM, EVMHalSetThrashThresholds, (TAny*)256, 0));
 	test_Equal(KErrArgument, UserSvr::HalFunction(EHalGroupVM, EVMHalSetThrashThresholds, (TAny*)0, (TAny*)1));
@@ -898,6 +976,8 @@ TInt E32Main()
 		test.Next(_L("Benchmarking page replacement"));
 		TestDistributions();
 		BenchmarkReplacement();
+		if (gDataPagingSupported)
+			BenchmarkScanResistance();
 		}
 
 	if (gDataPagingSupported)
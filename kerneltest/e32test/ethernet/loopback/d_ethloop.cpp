@@ -0,0 +1,203 @@
+// Copyright (c) 2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of the License "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+// e32test\ethernet\loopback\d_ethloop.cpp
+// An Ethernet PDD with no hardware, which receives every frame it is asked to
+// send.  It lets the Ethernet LDD be tested and benchmarked on any platform.
+//
+
+#include <kernel/kern_priv.h>
+#include <drivers/ethernet.h>
+#include "d_ethloop.h"
+
+const TInt KEthLoopThreadPriority = 27;
+_LIT(KEthLoopThreadName, "EthLoopDfc");
+
+class DEthLoopFactory : public DPhysicalDevice
+	{
+public:
+	DEthLoopFactory();
+	~DEthLoopFactory();
+	virtual TInt Install();
+	virtual void GetCaps(TDes8& aDes) const;
+	virtual TInt Create(DBase*& aChannel, TInt aUnit, const TDesC8* aInfo, const TVersion& aVer);
+	virtual TInt Validate(TInt aUnit, const TDesC8* aInfo, const TVersion& aVer);
+public:
+	TDynamicDfcQue* iDfcQ;
+	};
+
+class DEthLoop : public DEthernet
+	{
+public:
+	DEthLoop(DEthLoopFactory* aFactory);
+	virtual TInt Start();
+	virtual void Stop(TStopMode aMode);
+	virtual TInt ValidateConfig(const TEthernetConfigV01& aConfig) const;
+	virtual TInt Configure(TEthernetConfigV01& aConfig);
+	virtual void MacConfigure(TEthernetConfigV01& aConfig);
+	virtual void GetConfig(TEthernetConfigV01& aConfig) const;
+	virtual void CheckConfig(TEthernetConfigV01& aConfig);
+	virtual void Caps(TDes8& aCaps) const;
+	virtual TInt Send(TBuf8<KMaxEthernetPacket+32>& aBuffer);
+	virtual TInt ReceiveFrame(TBuf8<KMaxEthernetPacket+32>& aBuffer, TBool aOkToUse);
+	virtual TInt DisableIrqs();
+	virtual void RestoreIrqs(TInt aIrq);
+	virtual TDfcQue* DfcQ(TInt aUnit);
+#ifdef ETH_CHIP_IO_ENABLED
+	virtual TInt BgeChipIOCtrl(TPckgBuf<TChipIOInfo>& aIOData);
+#endif
+private:
+	DEthLoopFactory* iFactory;
+	TEthernetConfigV01 iConfig;
+	TBool iStarted;
+	const TDesC8* iFrame;		// the frame being sent, while Send() runs
+	};
+
+
+DECLARE_STANDARD_PDD()
+	{
+	return new DEthLoopFactory;
+	}
+
+DEthLoopFactory::DEthLoopFactory()
+	{
+	iVersion = TVersion(KEthernetMajorVersionNumber, KEthernetMinorVersionNumber, KEthernetBuildVersionNumber);
+	}
+
+DEthLoopFactory::~DEthLoopFactory()
+	{
+	if (iDfcQ)
+		iDfcQ->Destroy();
+	}
+
+TInt DEthLoopFactory::Install()
+	{
+	TInt r = Kern::DynamicDfcQCreate(iDfcQ, KEthLoopThreadPriority, KEthLoopThreadName);
+	if (r != KErrNone)
+		return r;
+	return SetName(&KEthLoopPddName);
+	}
+
+void DEthLoopFactory::GetCaps(TDes8& /*aDes*/) const
+	{
+	}
+
+TInt DEthLoopFactory::Create(DBase*& aChannel, TInt /*aUnit*/, const TDesC8* /*aInfo*/, const TVersion& /*aVer*/)
+	{
+	aChannel = new DEthLoop(this);
+	return aChannel ? KErrNone : KErrNoMemory;
+	}
+
+TInt DEthLoopFactory::Validate(TInt aUnit, const TDesC8* /*aInfo*/, const TVersion& aVer)
+	{
+	if (aUnit != KEthLoopUnit)
+		return KErrNotSupported;
+	if (!Kern::QueryVersionSupported(iVersion, aVer))
+		return KErrNotSupported;
+	return KErrNone;
+	}
+
+
+DEthLoop::DEthLoop(DEthLoopFactory* aFactory)
+	: iFactory(aFactory)
+	{
+	iConfig.iEthSpeed = KEthSpeed100BaseTX;
+	iConfig.iEthDuplex = KEthDuplexFull;
+	// a locally administered address
+	iConfig.iEthAddress[0] = 0x02;
+	for (TInt i = 1; i < (TInt)KEthernetAddressLength; ++i)
+		iConfig.iEthAddress[i] = (TUint8)i;
+	}
+
+TInt DEthLoop::Start()
+	{
+	iStarted = ETrue;
+	return KErrNone;
+	}
+
+void DEthLoop::Stop(TStopMode /*aMode*/)
+	{
+	iStarted = EFalse;
+	}
+
+TInt DEthLoop::ValidateConfig(const TEthernetConfigV01& /*aConfig*/) const
+	{
+	return KErrNone;
+	}
+
+TInt DEthLoop::Configure(TEthernetConfigV01& aConfig)
+	{
+	iConfig.iEthSpeed = aConfig.iEthSpeed;
+	iConfig.iEthDuplex = aConfig.iEthDuplex;
+	return KErrNone;
+	}
+
+void DEthLoop::MacConfigure(TEthernetConfigV01& aConfig)
+	{
+	memcpy(iConfig.iEthAddress, aConfig.iEthAddress, KEthernetAddressLength);
+	}
+
+void DEthLoop::GetConfig(TEthernetConfigV01& aConfig) const
+	{
+	aConfig = iConfig;
+	}
+
+void DEthLoop::CheckConfig(TEthernetConfigV01& /*aConfig*/)
+	{
+	}
+
+void DEthLoop::Caps(TDes8& /*aCaps*/) const
+	{
+	}
+
+TInt DEthLoop::Send(TBuf8<KMaxEthernetPacket+32>& aBuffer)
+	{
+	if (iStarted)
+		{
+		// the LDD takes the frame straight back through ReceiveFrame()
+		iFrame = &aBuffer;
+		ReceiveIsr();
+		iFrame = NULL;
+		}
+	return KErrNone;
+	}
+
+TInt DEthLoop::ReceiveFrame(TBuf8<KMaxEthernetPacket+32>& aBuffer, TBool aOkToUse)
+	{
+	// the LDD passes a bad reference when it has no buffer free
+	if (!aOkToUse || !iFrame)
+		return KErrGeneral;
+	aBuffer.Copy(*iFrame);
+	return KErrNone;
+	}
+
+TInt DEthLoop::DisableIrqs()
+	{
+	return 0;
+	}
+
+void DEthLoop::RestoreIrqs(TInt /*aIrq*/)
+	{
+	}
+
+TDfcQue* DEthLoop::DfcQ(TInt /*aUnit*/)
+	{
+	return iFactory->iDfcQ;
+	}
+
+#ifdef ETH_CHIP_IO_ENABLED
+TInt DEthLoop::BgeChipIOCtrl(TPckgBuf<TChipIOInfo>& /*aIOData*/)
+	{
+	return KErrNotSupported;
+	}
+#endif
@@ -0,0 +1,27 @@
+// Copyright (c) 2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of the License "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+// e32test\ethernet\loopback\d_ethloop.h
+// Names shared by the loopback Ethernet PDD and its test.
+//
+
+#ifndef __D_ETHLOOP_H__
+#define __D_ETHLOOP_H__
+
+_LIT(KEthLoopPddFileName, "d_ethloop");
+_LIT(KEthLoopPddName, "Ethernet.Loopback");
+
+/** The only unit the loopback PDD accepts, so it never hides a real device */
+const TInt KEthLoopUnit = 7;
+
+#endif
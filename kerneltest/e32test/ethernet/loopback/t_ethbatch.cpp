@@ -0,0 +1,445 @@
+// Copyright (c) 2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of the License "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+// e32test\ethernet\loopback\t_ethbatch.cpp
+// Overview:
+// Test the batch mode of the Ethernet LDD over the loopback PDD, and compare
+// the rate at which frames pass through it with and without batch mode.
+// API Information:
+// RBusDevEthernet::StartBatch, ReceiveBatch, ReceiveBatchCancel, SendBatch
+// Details:
+// - Send a frame with Write() and read it back with Read().
+// - Start batch mode and check Read() and Write() are refused.
+// - Send a batch of frames through the transmit ring and check they all come
+// back through the receive ring in order, with ReceiveBatch() completing once.
+// - Check a frame which is too big is failed in its slot and not sent.
+// - Check SendBatch() fails with KErrCorrupt if the transmit ring's head is
+// more than a ring ahead of its tail or behind it, and sends nothing.
+// - Check the driver puts no frames in the receive ring while its tail is
+// ahead of the frames received or more than a ring behind them, and that the
+// frames held back arrive in order once the tail is put right.
+// - Check ReceiveBatch() completes after the coalescing time when fewer frames
+// than the coalescing count arrive.
+// - Cancel ReceiveBatch().
+// - Pass frames through the loopback with Read() and Write(), and in batches,
+// and print the number of frames per second.
+// Platforms/Drives/Compatibility:
+// All.
+// Assumptions/Requirement/Pre-requisites:
+// Failures and causes:
+// Base Port information:
+//
+//
+
+#define __E32TEST_EXTENSION__
+
+#include <e32test.h>
+#include <e32atomics.h>
+#include <d32ethernet.h>
+#include "d_ethloop.h"
+
+LOCAL_D RTest test(_L("T_ETHBATCH"));
+
+_LIT(KEthLddFileName, "enet");
+
+const TInt KFrameLength = 1514;
+// fewer than the LDD's FIFO holds, for frames which can't go in the ring yet
+const TInt KBatchFrames = 32;
+const TInt KBenchFrames = 20000;
+
+class RLoopEthernet : public RBusDevEthernet
+	{
+public:
+	TInt Open()
+		{
+		return DoCreate(_L("Ethernet"), VersionRequired(), KEthLoopUnit, &KEthLoopPddName, NULL);
+		}
+	};
+
+//
+// The client's side of a channel in batch mode
+//
+class TBatchChannel
+	{
+public:
+	void Open(TInt aCoalesceFrames, TInt aCoalesceTime);
+	void Close();
+	TUint8* TxFrame(const TEthernetSlot& aSlot);
+	const TUint8* RxFrame(const TEthernetSlot& aSlot);
+	void Queue(TInt aFrame, TInt aLength);
+	TInt Send();
+	TInt Received();
+	void CheckReceived(TInt aFirstFrame, TInt aCount);
+public:
+	RLoopEthernet iChannel;
+	RShPool iPool;
+	RShBuf iRingsBuf;
+	RShPool iRxPool;
+	RShBuf iRxFrames;
+	TEthernetRings* iRings;
+	TUint32 iTxHead;
+	TUint32 iRxTail;
+	};
+
+LOCAL_C void FillFrame(TUint8* aFrame, TInt aLength, TInt aNumber)
+	{
+	for (TInt i = 0; i < aLength; ++i)
+		aFrame[i] = (TUint8)(aNumber + i);
+	}
+
+LOCAL_C TBool CheckFrame(const TUint8* aFrame, TInt aLength, TInt aNumber)
+	{
+	for (TInt i = 0; i < aLength; ++i)
+		{
+		if (aFrame[i] != (TUint8)(aNumber + i))
+			return EFalse;
+		}
+	return ETrue;
+	}
+
+void TBatchChannel::Open(TInt aCoalesceFrames, TInt aCoalesceTime)
+	{
+	test_KErrNone(iChannel.Open());
+	TEthernetBatch batch;
+	batch().iRxCoalesceFrames = aCoalesceFrames;
+	batch().iRxCoalesceTime = aCoalesceTime;
+	test_KErrNone(iChannel.StartBatch(batch, iPool, iRingsBuf, iRxPool, iRxFrames));
+	test(iRingsBuf.Size() >= sizeof(TEthernetRings));
+	iRings = (TEthernetRings*)iRingsBuf.Ptr();
+	iTxHead = iRings->iTx.iHead;
+	iRxTail = iRings->iRx.iTail;
+	}
+
+void TBatchChannel::Close()
+	{
+	iRxFrames.Close();
+	iRxPool.Close();
+	iRingsBuf.Close();
+	iPool.Close();
+	iChannel.Close();
+	}
+
+TUint8* TBatchChannel::TxFrame(const TEthernetSlot& aSlot)
+	{
+	return (TUint8*)iRings + aSlot.iOffset;
+	}
+
+const TUint8* TBatchChannel::RxFrame(const TEthernetSlot& aSlot)
+	{
+	return iRxFrames.Ptr() + aSlot.iOffset;
+	}
+
+void TBatchChannel::Queue(TInt aFrame, TInt aLength)
+	{
+	TEthernetSlot& s = iRings->iTx.iSlots[iTxHead % KEthernetRingSlots];
+	FillFrame(TxFrame(s), aLength, aFrame);
+	s.iLength = (TUint16)aLength;
+	++iTxHead;
+	}
+
+TInt TBatchChannel::Send()
+	{
+	// the frames must be visible before the new head
+	__e32_memory_barrier();
+	iRings->iTx.iHead = iTxHead;
+	return iChannel.SendBatch();
+	}
+
+TInt TBatchChannel::Received()
+	{
+	TInt n = iRings->iRx.iHead - iRxTail;
+	__e32_memory_barrier();
+	return n;
+	}
+
+void TBatchChannel::CheckReceived(TInt aFirstFrame, TInt aCount)
+	{
+	for (TInt i = 0; i < aCount; ++i)
+		{
+		TEthernetSlot& s = iRings->iRx.iSlots[iRxTail % KEthernetRingSlots];
+		test_KErrNone(s.iStatus);
+		test_Equal(KFrameLength, s.iLength);
+		test(CheckFrame(RxFrame(s), s.iLength, aFirstFrame + i));
+		++iRxTail;
+		}
+	// give the slots back to the driver
+	__e32_memory_barrier();
+	iRings->iRx.iTail = iRxTail;
+	}
+
+LOCAL_C void WaitForFrames(TBatchChannel& aBatch, TInt aCount)
+	{
+	while (aBatch.Received() < aCount)
+		{
+		TRequestStatus s;
+		aBatch.iChannel.ReceiveBatch(s);
+		User::WaitForRequest(s);
+		test_KErrNone(s.Int());
+		}
+	}
+
+LOCAL_C void TestReadWrite()
+	{
+	RLoopEthernet channel;
+	test_KErrNone(channel.Open());
+	TBuf8<KFrameLength> tx;
+	TBuf8<KFrameLength> rx;
+	tx.SetLength(KFrameLength);
+	FillFrame((TUint8*)tx.Ptr(), KFrameLength, 1);
+	TRequestStatus ws;
+	TRequestStatus rs;
+	channel.Write(ws, tx);
+	User::WaitForRequest(ws);
+	test_KErrNone(ws.Int());
+	channel.Read(rs, rx);
+	User::WaitForRequest(rs);
+	test_KErrNone(rs.Int());
+	test(rx == tx);
+	channel.Close();
+	}
+
+LOCAL_C void TestBatch()
+	{
+	TBatchChannel b;
+	b.Open(KBatchFrames, 0);
+
+	test.Next(_L("Read and Write are refused in batch mode"));
+	TBuf8<KFrameLength> buf;
+	buf.SetLength(KFrameLength);
+	TRequestStatus s;
+	b.iChannel.Write(s, buf);
+	User::WaitForRequest(s);
+	test_Equal(KErrInUse, s.Int());
+	b.iChannel.Read(s, buf);
+	User::WaitForRequest(s);
+	test_Equal(KErrInUse, s.Int());
+	TEthernetBatch batch;
+	batch().iRxCoalesceFrames = 1;
+	batch().iRxCoalesceTime = 0;
+	RShPool pool;
+	RShBuf rings;
+	RShPool rxPool;
+	RShBuf rxFrames;
+	test_Equal(KErrInUse, b.iChannel.StartBatch(batch, pool, rings, rxPool, rxFrames));
+
+	test.Next(_L("Send a batch through the rings"));
+	TInt i;
+	for (TInt round = 0; round < 4; ++round)
+		{
+		for (i = 0; i < KBatchFrames; ++i)
+			b.Queue(round * KBatchFrames + i, KFrameLength);
+		test_Equal(KBatchFrames, b.Send());
+		test_Equal(b.iTxHead, b.iRings->iTx.iTail);
+		for (i = 0; i < KBatchFrames; ++i)
+			test_KErrNone(b.iRings->iTx.iSlots[i].iStatus);
+		b.iChannel.ReceiveBatch(s);
+		User::WaitForRequest(s);
+		test_KErrNone(s.Int());
+		test_Equal(KBatchFrames, b.Received());
+		b.CheckReceived(round * KBatchFrames, KBatchFrames);
+		}
+
+	test.Next(_L("A frame which is too big is not sent"));
+	TEthernetSlot& big = b.iRings->iTx.iSlots[b.iTxHead % KEthernetRingSlots];
+	b.Queue(0, KFrameLength);
+	big.iLength = KEthernetFrameBufferSize;
+	test_Equal(0, b.Send());
+	test_Equal(KErrTxFrameToBig, big.iStatus);
+	test_Equal(0, b.Received());
+
+	test.Next(_L("Cancel ReceiveBatch"));
+	b.iChannel.ReceiveBatch(s);
+	b.iChannel.ReceiveBatchCancel();
+	User::WaitForRequest(s);
+	test_Equal(KErrCancel, s.Int());
+	b.Close();
+	}
+
+LOCAL_C void TestBadTxHead(TBatchChannel& aBatch, TUint32 aHead)
+	{
+	TUint32 tail = aBatch.iRings->iTx.iTail;
+	aBatch.iRings->iTx.iHead = aHead;
+	test_Equal(KErrCorrupt, aBatch.iChannel.SendBatch());
+	test_Equal(tail, aBatch.iRings->iTx.iTail);
+	test_Equal(0, aBatch.Received());
+	}
+
+LOCAL_C void TestBadRxTail(TBatchChannel& aBatch, TUint32 aTail, TInt aFirstFrame)
+	{
+	TUint32 head = aBatch.iRings->iRx.iHead;
+	aBatch.iRings->iRx.iTail = aTail;
+	TInt i;
+	for (i = 0; i < KBatchFrames; ++i)
+		aBatch.Queue(aFirstFrame + i, KFrameLength);
+	test_Equal(KBatchFrames, aBatch.Send());
+	// the frames are held back rather than written over ones the client may be using
+	TRequestStatus s;
+	aBatch.iChannel.ReceiveBatch(s);
+	test_Equal(KRequestPending, s.Int());
+	test_Equal(head, aBatch.iRings->iRx.iHead);
+	aBatch.iChannel.ReceiveBatchCancel();
+	User::WaitForRequest(s);
+	test_Equal(KErrCancel, s.Int());
+
+	// they reach the ring once the tail is put right
+	aBatch.iRings->iRx.iTail = aBatch.iRxTail;
+	WaitForFrames(aBatch, KBatchFrames);
+	test_Equal(KBatchFrames, aBatch.Received());
+	aBatch.CheckReceived(aFirstFrame, KBatchFrames);
+	}
+
+LOCAL_C void TestBadRings()
+	{
+	TBatchChannel b;
+	b.Open(KBatchFrames, 0);
+
+	test.Next(_L("SendBatch fails with KErrCorrupt if the transmit head is more than a ring ahead"));
+	TestBadTxHead(b, b.iTxHead + KEthernetRingSlots + 1);
+
+	test.Next(_L("SendBatch fails with KErrCorrupt if the transmit head is behind the tail"));
+	TestBadTxHead(b, b.iTxHead - 1);
+
+	test.Next(_L("Frames still pass once the transmit head is put right"));
+	b.Queue(0, KFrameLength);
+	test_Equal(1, b.Send());
+	WaitForFrames(b, 1);
+	b.CheckReceived(0, 1);
+
+	test.Next(_L("No frames go in the receive ring while its tail is ahead of them"));
+	TestBadRxTail(b, b.iRxTail + 1, 100);
+
+	test.Next(_L("No frames go in the receive ring while its tail is more than a ring behind"));
+	TestBadRxTail(b, b.iRxTail - KEthernetRingSlots - 1, 200);
+
+	b.Close();
+	}
+
+LOCAL_C void TestCoalesceTime()
+	{
+	TBatchChannel b;
+	b.Open(KEthernetRingSlots, 20000);
+	TRequestStatus s;
+	b.iChannel.ReceiveBatch(s);
+	b.Queue(0, KFrameLength);
+	b.Queue(1, KFrameLength);
+	test_Equal(2, b.Send());
+	RTimer timer;
+	test_KErrNone(timer.CreateLocal());
+	TRequestStatus ts;
+	timer.After(ts, 2000000);
+	User::WaitForRequest(s, ts);
+	test_KErrNone(s.Int());
+	timer.Cancel();
+	User::WaitForRequest(ts);
+	timer.Close();
+	test_Equal(2, b.Received());
+	b.CheckReceived(0, 2);
+	b.Close();
+	}
+
+LOCAL_C TInt ReadWriteFramesPerSecond()
+	{
+	RLoopEthernet channel;
+	test_KErrNone(channel.Open());
+	TBuf8<KFrameLength> tx;
+	TBuf8<KFrameLength> rx;
+	tx.SetLength(KFrameLength);
+	FillFrame((TUint8*)tx.Ptr(), KFrameLength, 0);
+	TTime start;
+	start.UniversalTime();
+	for (TInt i = 0; i < KBenchFrames; ++i)
+		{
+		TRequestStatus ws;
+		TRequestStatus rs;
+		channel.Read(rs, rx);
+		channel.Write(ws, tx);
+		User::WaitForRequest(ws);
+		User::WaitForRequest(rs);
+		test_KErrNone(rs.Int());
+		}
+	TTime end;
+	end.UniversalTime();
+	channel.Close();
+	TInt64 us = end.MicroSecondsFrom(start).Int64();
+	if (us <= 0)
+		us = 1;
+	return (TInt)((TInt64)KBenchFrames * 1000000 / us);
+	}
+
+LOCAL_C TInt BatchFramesPerSecond()
+	{
+	TBatchChannel b;
+	b.Open(KBatchFrames, 0);
+	for (TInt slot = 0; slot < KEthernetRingSlots; ++slot)
+		FillFrame(b.TxFrame(b.iRings->iTx.iSlots[slot]), KFrameLength, slot);
+	TTime start;
+	start.UniversalTime();
+	for (TInt sent = 0; sent < KBenchFrames; sent += KBatchFrames)
+		{
+		for (TInt i = 0; i < KBatchFrames; ++i)
+			{
+			// only the length changes: the frames were filled in once, up front
+			b.iRings->iTx.iSlots[b.iTxHead % KEthernetRingSlots].iLength = KFrameLength;
+			++b.iTxHead;
+			}
+		test_Equal(KBatchFrames, b.Send());
+		WaitForFrames(b, KBatchFrames);
+		b.iRxTail += KBatchFrames;
+		__e32_memory_barrier();
+		b.iRings->iRx.iTail = b.iRxTail;
+		}
+	TTime end;
+	end.UniversalTime();
+	b.Close();
+	TInt64 us = end.MicroSecondsFrom(start).Int64();
+	if (us <= 0)
+		us = 1;
+	return (TInt)((TInt64)KBenchFrames * 1000000 / us);
+	}
+
+LOCAL_C void Benchmark()
+	{
+	TInt rw = ReadWriteFramesPerSecond();
+	TInt batch = BatchFramesPerSecond();
+	test.Printf(_L("%d byte frames: %8d frames/s with Read/Write, %8d frames/s in batches of %d\n"),
+				KFrameLength, rw, batch, KBatchFrames);
+	}
+
+GLDEF_C TInt E32Main()
+	{
+	test.Title();
+
+	test.Start(_L("Load the drivers"));
+	TInt r = User::LoadPhysicalDevice(KEthLoopPddFileName);
+	test(r == KErrNone || r == KErrAlreadyExists);
+	r = User::LoadLogicalDevice(KEthLddFileName);
+	test(r == KErrNone || r == KErrAlreadyExists);
+
+	test.Next(_L("Write and Read a frame"));
+	TestReadWrite();
+
+	test.Next(_L("Start batch mode"));
+	TestBatch();
+
+	test.Next(_L("Bad ring indices"));
+	TestBadRings();
+
+	test.Next(_L("ReceiveBatch completes after the coalescing time"));
+	TestCoalesceTime();
+
+	test.Next(_L("Frames per second with and without batch mode"));
+	Benchmark();
+
+	test.End();
+	return KErrNone;
+	}
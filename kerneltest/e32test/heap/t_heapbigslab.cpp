@@ -0,0 +1,231 @@
+// Copyright (c) 2010 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of the License "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+// e32test\heap\t_heapbigslab.cpp
+// Overview:
+// Tests RHybridHeap class: big slab allocator for 57-1016 byte cells
+// API Information:
+// RHybridHeap/RHeap
+// Details:
+//- Check that cells in the big slab size range come from slab pages when
+//  big slabs are configured and from the Doug Lea allocator when not.
+//- Check that cells of every size in the range are usable, and that the
+//  heap is consistent after freeing them in a scattered order.
+//- Run a workload of 64-1024 byte cells with a size distribution typical of
+//  descriptor buffers, CBase objects and array stores, through the Doug Lea
+//  path and through big slabs of up to 512 and 1016 bytes, and report the
+//  throughput and the heap footprint overhead of each.
+// Platforms/Drives/Compatibility:
+// All
+// Assumptions/Requirement/Pre-requisites:
+// Failures and causes:
+// Base Port information:
+//
+//
+
+#include <e32test.h>
+#include <e32hal.h>
+#include <hal.h>
+#include <e32svr.h>
+#include <e32def.h>
+#include <e32def_private.h>
+#include "dla.h"
+#include "slab.h"
+#include "page_alloc.h"
+#include "heap_hybrid.h"
+
+#define LIVE_CELLS 4096
+#define BENCH_OPS 200000
+
+LOCAL_D RTest test(_L("T_HEAPBIGSLAB"));
+
+LOCAL_D TAny* Cells[LIVE_CELLS];
+
+// Cumulative distribution (out of 100) of the workload cell sizes
+struct TSizeBand
+	{
+	TInt iPercent;
+	TInt iMin;
+	TInt iMax;
+	};
+
+LOCAL_D const TSizeBand SizeBands[] =
+	{
+	{30,   64,  128},		// small CBase objects, short HBufCs
+	{65,  129,  256},		// typical HBufCs and RArray stores
+	{90,  257,  512},		// file names, larger objects
+	{100, 513, 1024}		// buffers
+	};
+
+LOCAL_C RHeap* CreateBigSlabHeap(TInt aBigSlabSize)
+	{
+	RHeap* heap = User::ChunkHeap(0, 0x1000, 0x1000000);
+	test(heap!=NULL);
+
+	RHybridHeap::STestCommand cmd;
+	cmd.iCommand = RHybridHeap::ESetConfig;
+	cmd.iConfig.iSlabBits = 0xabe;
+	cmd.iConfig.iDelayedSlabThreshold = 0;
+	cmd.iConfig.iPagePower = 14;
+	TInt ret = heap->DebugFunction(RHeap::EHybridHeap, &cmd, 0);
+	test(ret == KErrNone);
+
+	cmd.iCommand = RHybridHeap::ESetBigSlabConfig;
+	cmd.iConfig.iBigSlabSize = aBigSlabSize;
+	ret = heap->DebugFunction(RHeap::EHybridHeap, &cmd, 0);
+	test(ret == KErrNone);
+
+	cmd.iCommand = RHybridHeap::EGetConfig;
+	ret = heap->DebugFunction(RHeap::EHybridHeap, &cmd, 0);
+	test(ret == KErrNone);
+	test(cmd.iConfig.iBigSlabSize == aBigSlabSize);
+
+	return heap;
+	}
+
+LOCAL_C TBool InSlabArea(RHeap* aHeap, TAny* aCell)
+	{
+	// slab and page allocator memory lies below the heap metadata, DL memory above it
+	return ((TUint8*)aCell < (TUint8*)aHeap) && ((TLinAddr)aCell & 0xfff);
+	}
+
+LOCAL_C void TestCellPlacement()
+	{
+	RHeap* heap = CreateBigSlabHeap(0);
+	TAny* p = heap->Alloc(200);
+	test(p != NULL);
+	test(!InSlabArea(heap, p));
+	heap->Free(p);
+	heap->Close();
+
+	heap = CreateBigSlabHeap(512);
+	p = heap->Alloc(200);
+	test(p != NULL);
+	test(InSlabArea(heap, p));
+	test(heap->AllocLen(p) >= 200);
+	heap->Free(p);
+	p = heap->Alloc(800);		// above the configured size
+	test(p != NULL);
+	test(!InSlabArea(heap, p));
+	heap->Free(p);
+	heap->Close();
+	}
+
+LOCAL_C void TestAllSizes()
+	{
+	RHeap* heap = CreateBigSlabHeap(MAXBIGSLABSIZE);
+	TInt n = 0;
+	TInt size;
+	for (size = MAXSLABSIZE + 1; size <= MAXBIGSLABSIZE - RHeap::EDebugHdrSize; ++size)
+		{
+		TUint8* p = (TUint8*)heap->Alloc(size);
+		test(p != NULL);
+		test(heap->AllocLen(p) >= size);
+		Mem::Fill(p, size, (TUint8)size);
+		Cells[n++] = p;
+		if (n == LIVE_CELLS)
+			break;
+		}
+	heap->Check();
+
+	// free every other cell, then the rest, checking the contents survived
+	TInt i;
+	for (TInt pass = 0; pass < 2; ++pass)
+		{
+		for (i = pass; i < n; i += 2)
+			{
+			TUint8* p = (TUint8*)Cells[i];
+			size = MAXSLABSIZE + 1 + i;
+			test(p[0] == (TUint8)size && p[size-1] == (TUint8)size);
+			heap->Free(p);
+			}
+		heap->Check();
+		}
+	TInt total;
+	test(heap->AllocSize(total) == 0);
+	heap->Close();
+	}
+
+LOCAL_C TInt RandomSize(TUint& aSeed)
+	{
+	aSeed = aSeed * 69069 + 1;
+	TInt pc = (aSeed >> 8) % 100;
+	TInt band = 0;
+	while (pc >= SizeBands[band].iPercent)
+		++band;
+	aSeed = aSeed * 69069 + 1;
+	return SizeBands[band].iMin + (TInt)((aSeed >> 8) % (SizeBands[band].iMax - SizeBands[band].iMin + 1));
+	}
+
+LOCAL_C void Benchmark(TInt aBigSlabSize)
+	{
+	RHeap* heap = CreateBigSlabHeap(aBigSlabSize);
+	TUint seed = 0x4d595df4;
+	TInt i;
+	for (i = 0; i < LIVE_CELLS; ++i)
+		{
+		Cells[i] = heap->Alloc(RandomSize(seed));
+		test(Cells[i] != NULL);
+		}
+
+	TUint32 start = User::FastCounter();
+	for (i = 0; i < BENCH_OPS; ++i)
+		{
+		seed = seed * 69069 + 1;
+		TInt ix = (seed >> 8) % LIVE_CELLS;
+		heap->Free(Cells[ix]);
+		Cells[ix] = heap->Alloc(RandomSize(seed));
+		test(Cells[ix] != NULL);
+		}
+	TUint32 ticks = User::FastCounter() - start;
+
+	TInt freq;
+	test(HAL::Get(HAL::EFastCounterFrequency, freq) == KErrNone);
+	TInt64 us = (TInt64)ticks * 1000000 / freq;
+
+	TInt total;
+	TInt count = heap->AllocSize(total);
+	test(count == LIVE_CELLS);
+	TInt footprint = heap->Size();
+	TInt overhead = (TInt)(((TInt64)(footprint - total) * 100) / footprint);
+	test.Printf(_L("Big slabs %4d: %d alloc/free pairs in %d us, footprint %d bytes for %d bytes allocated (%d%% overhead)\n"),
+				aBigSlabSize, BENCH_OPS, I64LOW(us), footprint, total, overhead);
+
+	heap->Check();
+	for (i = 0; i < LIVE_CELLS; ++i)
+		heap->Free(Cells[i]);
+	test(heap->AllocSize(total) == 0);
+	heap->Close();
+	}
+
+GLDEF_C TInt E32Main(void)
+	{
+	test.Title();
+
+	__KHEAP_MARK;
+
+	test.Start(_L("Big slab cell placement"));
+	TestCellPlacement();
+
+	test.Next(_L("Big slab cell sizes"));
+	TestAllSizes();
+
+	test.Next(_L("Doug Lea path vs big slab path benchmark"));
+	Benchmark(0);
+	Benchmark(512);
+	Benchmark(MAXBIGSLABSIZE);
+
+	__KHEAP_MARKEND;
+	test.End();
+	return 0;
+	}
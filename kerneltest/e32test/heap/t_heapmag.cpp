@@ -0,0 +1,253 @@
+// Copyright (c) 2010 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of the License "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+// e32test\heap\t_heapmag.cpp
+// Overview:
+// Tests RHybridHeap class: thread magazines in front of the slab allocator
+// API Information:
+// RHybridHeap/RHeap
+// Details:
+//- Create a heap configured to use the slab allocator for all cell sizes up
+//  to the slab threshold.
+//- Run 1..N threads (N = number of CPUs) churning 8-56 byte cells through
+//  the shared heap for a fixed period, with thread magazines disabled and
+//  then enabled, and report the allocation rate for each thread count.
+//- Check the heap is consistent and that all cells have been returned once
+//  every thread has freed its cells.
+//- Change the number of magazines, including disabling them, while threads
+//  are using them and check the heap is still consistent afterwards.
+//- Check a negative number of magazines is rejected.
+// Platforms/Drives/Compatibility:
+// All
+// Assumptions/Requirement/Pre-requisites:
+// Thread magazines are only used by release builds of euser.
+// Failures and causes:
+// Base Port information:
+//
+//
+
+#include <e32test.h>
+#include <e32hal.h>
+#include <e32svr.h>
+#include <e32def.h>
+#include <e32def_private.h>
+#include <u32hal.h>
+#include "dla.h"
+#include "slab.h"
+#include "page_alloc.h"
+#include "heap_hybrid.h"
+
+#define MAX_THREADS 8
+#define RING_SIZE 64			// cells kept live by each thread
+
+LOCAL_D RTest test(_L("T_HEAPMAG"));
+
+struct TMagThreadParm
+	{
+	RHeap*			iHeap;
+	TUint			iSeed;
+	TUint			iOps;
+	TInt			iFailed;
+	};
+
+LOCAL_D TMagThreadParm ThreadParm[MAX_THREADS];
+LOCAL_D volatile TBool Stop;
+
+LOCAL_C TInt GetMagazines(RHeap* aHeap)
+	{
+	RHybridHeap::STestCommand cmd;
+	cmd.iCommand = RHybridHeap::EGetConfig;
+	TInt ret = aHeap->DebugFunction(RHeap::EHybridHeap, &cmd, 0);
+	test(ret == KErrNone);
+	return cmd.iConfig.iMagazineCount;
+	}
+
+LOCAL_C void SetMagazines(RHeap* aHeap, TInt aMagazines)
+	{
+	RHybridHeap::STestCommand cmd;
+	cmd.iCommand = RHybridHeap::ESetMagazineConfig;
+	cmd.iConfig.iMagazineCount = aMagazines;
+	TInt ret = aHeap->DebugFunction(RHeap::EHybridHeap, &cmd, 0);
+	test(ret == KErrNone);
+	test(GetMagazines(aHeap) == aMagazines);
+	}
+
+LOCAL_C RHeap* CreateMagazineHeap(TInt aMagazines)
+	{
+	RHeap* heap = User::ChunkHeap(0, 0x1000, 0x400000);
+	test(heap!=NULL);
+
+	RHybridHeap::STestCommand cmd;
+	cmd.iCommand = RHybridHeap::ESetConfig;
+	cmd.iConfig.iSlabBits = 0x3fff;			// all slab sizes 4..56
+	cmd.iConfig.iDelayedSlabThreshold = 0;
+	cmd.iConfig.iPagePower = 0;				// 0 -> no page allocator
+	TInt ret = heap->DebugFunction(RHeap::EHybridHeap, &cmd, 0);
+	test(ret == KErrNone);
+
+	SetMagazines(heap, aMagazines);
+	return heap;
+	}
+
+LOCAL_C TInt ChurnThread(TAny* aParm)
+	{
+	TMagThreadParm& parm = *(TMagThreadParm*)aParm;
+	RHeap& heap = *parm.iHeap;
+	TAny* ring[RING_SIZE];
+	memclr(ring, sizeof(ring));
+	TUint seed = parm.iSeed;
+	TUint ops = 0;
+	TInt ix = 0;
+
+	RThread::Rendezvous(KErrNone);
+	while (!Stop)
+		{
+		seed = seed * 69069 + 1;
+		TInt size = 8 + ((seed >> 16) % 49);	// 8..56 bytes
+		heap.Free(ring[ix]);
+		TUint8* p = (TUint8*)heap.Alloc(size);
+		if (!p)
+			{
+			++parm.iFailed;
+			ring[ix] = NULL;
+			continue;
+			}
+		p[0] = (TUint8)size;
+		p[size-1] = (TUint8)size;
+		ring[ix] = p;
+		ix = (ix + 1) & (RING_SIZE - 1);
+		++ops;
+		}
+
+	for (ix = 0; ix < RING_SIZE; ++ix)
+		{
+		TUint8* p = (TUint8*)ring[ix];
+		if (p && (p[0] != p[p[0]-1]))
+			++parm.iFailed;			// cell was handed out twice
+		heap.Free(p);
+		}
+	parm.iOps = ops;
+	return KErrNone;
+	}
+
+LOCAL_C TUint RunChurn(RHeap* aHeap, TInt aThreadCount, TBool aReconfigure=EFalse)
+	{
+	RThread thread[MAX_THREADS];
+	TRequestStatus exit[MAX_THREADS];
+	TInt i;
+	Stop = EFalse;
+	for (i = 0; i < aThreadCount; ++i)
+		{
+		ThreadParm[i].iHeap = aHeap;
+		ThreadParm[i].iSeed = 0x1234567 * (i + 1);
+		ThreadParm[i].iOps = 0;
+		ThreadParm[i].iFailed = 0;
+		TInt r = thread[i].Create(KNullDesC, ChurnThread, 0x2000, aHeap, &ThreadParm[i]);
+		test(r == KErrNone);
+		TRequestStatus rv;
+		thread[i].Rendezvous(rv);
+		thread[i].Logon(exit[i]);
+		thread[i].Resume();
+		User::WaitForRequest(rv);
+		test(rv == KErrNone);
+		}
+
+	if (aReconfigure)
+		{
+		// cycle through disabled and each number of magazines while the threads run
+		for (TInt n = 0; n < 200; ++n)
+			{
+			SetMagazines(aHeap, (n & 1) ? (1 << ((n >> 1) % 4)) : 0);
+			User::AfterHighRes(5000);
+			}
+		}
+	else
+		User::After(1000000);
+	Stop = ETrue;
+
+	TUint ops = 0;
+	for (i = 0; i < aThreadCount; ++i)
+		{
+		User::WaitForRequest(exit[i]);
+		test(thread[i].ExitType() == EExitKill);
+		test(exit[i] == KErrNone);
+		test(ThreadParm[i].iFailed == 0);
+		ops += ThreadParm[i].iOps;
+		CLOSE_AND_WAIT(thread[i]);
+		}
+	return ops;
+	}
+
+LOCAL_C void TestMagazines(TInt aCpus, TInt aMagazines)
+	{
+	for (TInt threads = 1; threads <= aCpus; ++threads)
+		{
+		RHeap* heap = CreateMagazineHeap(aMagazines);
+		TUint ops = RunChurn(heap, threads);
+		test.Printf(_L("Magazines %d, threads %d: %u alloc/free pairs per second\n"), aMagazines, threads, ops);
+
+		heap->Check();
+		TInt total;
+		test(heap->AllocSize(total) == 0);
+		test(total == 0);
+		heap->Close();
+		}
+	}
+
+LOCAL_C void TestReconfigure(TInt aCpus)
+	{
+	RHeap* heap = CreateMagazineHeap(MAXMAGAZINES);
+	RunChurn(heap, Max(aCpus, 2), ETrue);
+	heap->Check();
+	TInt total;
+	test(heap->AllocSize(total) == 0);
+	test(total == 0);
+
+	TInt magazines = GetMagazines(heap);
+	RHybridHeap::STestCommand cmd;
+	cmd.iCommand = RHybridHeap::ESetMagazineConfig;
+	cmd.iConfig.iMagazineCount = -1;
+	TInt ret = heap->DebugFunction(RHeap::EHybridHeap, &cmd, 0);
+	test(ret == KErrArgument);
+	test(GetMagazines(heap) == magazines);
+	heap->Close();
+	}
+
+GLDEF_C TInt E32Main(void)
+	{
+	test.Title();
+
+	__KHEAP_MARK;
+
+	test.Start(_L("Thread magazine benchmark"));
+
+	TInt cpus = UserSvr::HalFunction(EHalGroupKernel, EKernelHalNumLogicalCpus, 0, 0);
+	if (cpus < 1)
+		cpus = 1;
+	if (cpus > MAX_THREADS)
+		cpus = MAX_THREADS;
+	test.Printf(_L("%d CPUs\n"), cpus);
+
+	test.Next(_L("Magazines disabled"));
+	TestMagazines(cpus, 0);
+
+	test.Next(_L("Magazines enabled"));
+	TestMagazines(cpus, MAXMAGAZINES);
+
+	test.Next(_L("Magazines reconfigured while in use"));
+	TestReconfigure(cpus);
+
+	__KHEAP_MARKEND;
+	test.End();
+	return 0;
+	}
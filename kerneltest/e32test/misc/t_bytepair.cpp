@@ -20,11 +20,23 @@
 #include <e32math.h>
 #include <e32rom.h>
 #include <e32svr.h>
+#include <hal.h>
 #include "decompress.h"
 
 #define BYTE_PAIR_COMPRESS_INCLUDE_IMPLEMENTATION
 #include <byte_pair_compress.h>
 
+#define LZ4_COMPRESS_INCLUDE_IMPLEMENTATION
+#include <lz4_compress.h>
+
+#ifdef __MARM__
+// The portable decoder, so it can be tested and benchmarked against the
+// assembler one the kernel and loader use on ARM
+#define BytePairDecompress BytePairDecompressC
+#include "../../../kernel/eka/kernel/byte_pair.cpp"
+#undef BytePairDecompress
+#endif
+
 const TInt KMaxSize = 0x1000;
 const TInt KPageSize = 0x1000;
 
@@ -36,6 +48,19 @@ TRomHeader* RomHeader = NULL;
 TInt RomOffset = 0;
 TInt FailCount = 0;
 TUint32 RandomState;
+TUint16 Lz4HashTable[1 << KLz4HashBits];
+
+typedef TInt (*TCompressFunction)(TUint8* aDest, TUint8* aSrc, TInt aSize);
+typedef TInt (*TDecompressFunction)(TUint8* dst, TInt dstSize, TUint8* src, TInt srcSize, TUint8*& srcNext);
+
+TInt CompressLz4(TUint8* aDest, TUint8* aSrc, TInt aSize)
+	{
+	return Lz4Compress(aDest, sizeof(CompressedBuffer), aSrc, aSize, Lz4HashTable);
+	}
+
+TCompressFunction Compress = BytePairCompress;
+TDecompressFunction Decompress = BytePairDecompress;
+TInt CompressBound = KMaxSize+1;	// largest compressed size of KMaxSize bytes for the codec under test
 
 void PrintHex(TUint8* aBuffer, TInt aSize)
 	{
@@ -122,8 +147,8 @@ void TestCompressDecompress(TGenerator aGenFunc, TInt aSize, TTestMode aMode = E
 		aGenFunc(InputBuffer, aSize);
 	
 		// Compress input data
-		compressedSize = BytePairCompress(CompressedBuffer, InputBuffer, aSize);
-		ASSERT(compressedSize <= KMaxSize+1);
+		compressedSize = Compress(CompressedBuffer, InputBuffer, aSize);
+		ASSERT(compressedSize >= 0 && compressedSize <= CompressBound);
 		}
 	else
 		{
@@ -152,7 +177,7 @@ void TestCompressDecompress(TGenerator aGenFunc, TInt aSize, TTestMode aMode = E
 		outputBufferSize = KMaxSize+1;
 	else if (aMode == EOutputBufferTooShort)
 		outputBufferSize = aSize / 2 + 1;
-	TInt decompressedSize = BytePairDecompress(OutputBuffer, outputBufferSize, CompressedBuffer, compressedSize, srcNext);
+	TInt decompressedSize = Decompress(OutputBuffer, outputBufferSize, CompressedBuffer, compressedSize, srcNext);
 	TInt srcUsed = srcNext ? srcNext - CompressedBuffer : 0;
 
 	// Print stats
@@ -219,20 +244,55 @@ void TestCompressDecompress(TGenerator aGenFunc, TInt aSize, TTestMode aMode = E
 		}
 	}
 
-TInt E32Main()
-//
-// Benchmark for Mem functions
-//
-    {
+#ifdef __EPOC32__
+void BenchmarkRomPages()
+	{
+	// Decompression throughput over real code, a page at a time as the paging system does it
+	const TInt KPages = 256;
+	const TInt KRepeat = 10;
+	const TInt KSlotSize = LZ4_COMPRESS_BOUND(KPageSize);
+	TInt pages = Min(KPages, TInt(RomHeader->iUncompressedSize / KPageSize));
+	TUint8* store = (TUint8*)User::Alloc(pages * KSlotSize);
+	TInt* sizes = (TInt*)User::Alloc(pages * sizeof(TInt));
+	test_NotNull(store);
+	test_NotNull(sizes);
+
+	TInt compressedTotal = 0;
 	TInt i;
-    test.Title();
-    test.Start(_L("T_BYTEPAIR"));
+	for (i = 0 ; i < pages ; ++i)
+		{
+		sizes[i] = Compress(CompressedBuffer, ((TUint8*)RomHeader) + i * KPageSize, KPageSize);
+		test(sizes[i] > 0 && sizes[i] <= KSlotSize);
+		Mem::Copy(store + i * KSlotSize, CompressedBuffer, sizes[i]);
+		compressedTotal += sizes[i];
+		}
 
-	RandomState = User::FastCounter();
-	RDebug::Printf("RandomState == %08x", RandomState);
-	
-	test_Equal(0, FailCount);
+	TUint32 start = User::FastCounter();
+	for (TInt r = 0 ; r < KRepeat ; ++r)
+		{
+		for (i = 0 ; i < pages ; ++i)
+			{
+			TUint8* srcNext = NULL;
+			test_Equal(KPageSize, Decompress(OutputBuffer, KPageSize, store + i * KSlotSize, sizes[i], srcNext));
+			}
+		}
+	TUint32 ticks = User::FastCounter() - start;
 
+	TInt freq = 0;
+	test_KErrNone(HAL::Get(HAL::EFastCounterFrequency, freq));
+	TInt64 bytes = TInt64(pages) * KPageSize * KRepeat;
+	TInt kbPerSec = ticks ? TInt((bytes * freq) / (TInt64(ticks) * 1024)) : 0;
+	test.Printf(_L("%d ROM pages compressed to %d%%, decompressed at %d KB/s\n"),
+				pages, compressedTotal * 100 / (pages * KPageSize), kbPerSec);
+
+	User::Free(sizes);
+	User::Free(store);
+	}
+#endif
+
+void RunTests()
+	{
+	TInt i;
 	const TInt KStartSize = KMaxSize / 2;
 
 	// Test correct operation
@@ -282,6 +342,46 @@ TInt E32Main()
 	for (i = KStartSize + 4 ; i < KMaxSize ; i += 19)
 		TestCompressDecompress(GenerateUniformRandom, i, ERandomCompressedData);
 
+#ifdef __EPOC32__
+	test.Next(_L("Benchmark decompressing ROM pages"));
+	BenchmarkRomPages();
+#endif
+	}
+
+TInt E32Main()
+//
+// Benchmark for Mem functions
+//
+    {
+    test.Title();
+    test.Start(_L("T_BYTEPAIR"));
+
+	RandomState = User::FastCounter();
+	RDebug::Printf("RandomState == %08x", RandomState);
+	
+	test_Equal(0, FailCount);
+
+	test.Next(_L("Test byte-pair compression"));
+	Compress = BytePairCompress;
+	Decompress = BytePairDecompress;
+	CompressBound = KMaxSize+1;
+	RunTests();
+	test_Equal(0, FailCount);
+
+#ifdef __MARM__
+	test.Next(_L("Test byte-pair compression with the portable decoder"));
+	Compress = BytePairCompress;
+	Decompress = BytePairDecompressC;
+	CompressBound = KMaxSize+1;
+	RunTests();
+	test_Equal(0, FailCount);
+#endif
+
+	test.Next(_L("Test LZ4 compression"));
+	Compress = CompressLz4;
+	Decompress = Lz4Decompress;
+	CompressBound = LZ4_COMPRESS_BOUND(KMaxSize);
+	RunTests();
 	test_Equal(0, FailCount);
 	
     test.End();
@@ -1241,6 +1241,69 @@ void TestContentsOfPagedDll()
 	library2.Close();
 	}
 
+void TestCodePageProfile()
+	{
+	test.Next(_L("Test recording and prefetching a code page profile"));
+
+	TInt r = UserSvr::HalFunction(EHalGroupVM, EVMHalSetCodePageProfiling, (TAny*)ETrue, 0);
+	if (r == KErrNotSupported)
+		{
+		test.Printf(_L("Code page profiling not supported, skipping\n"));
+		return;
+		}
+	test_KErrNone(r);
+
+	RLibrary library2;
+	test_noError(LoadSpecificLibrary(library2, 2, CurrentDrive));
+	test_KErrNone(UserSvr::HalFunction(EHalGroupVM, EVMHalSetCodePageProfiling, (TAny*)EFalse, 0));
+
+	TGetAddressOfDataFunction func = (TGetAddressOfDataFunction)library2.Lookup(KGetAddressOfDataFunctionOrdinal);
+	test_notNull(func);
+	TInt size;
+	TUint* data = func(size);
+	test_notNull(data);
+
+	// touch every page of the data...
+	FlushAllPages();
+	const TInt pageSize = 4096;
+	TInt i;
+	for (i = 0 ; i < size ; i += pageSize)
+		(void)*(volatile TUint*)((TUint8*)data + i);
+
+	TBuf8<256> profile;
+	r = UserSvr::HalFunction(EHalGroupVM, EVMHalGetCodePageProfile, data, &profile);
+	if (r == KErrNotReady)
+		{
+		// the code segment was already loaded before profiling was enabled
+		test.Printf(_L("DLL not profiled, skipping\n"));
+		library2.Close();
+		return;
+		}
+	test_Value(r, r > 0);
+	TInt marked = 0;
+	for (i = 0 ; i < profile.Length() * 8 ; ++i)
+		if (profile[i >> 3] & (1 << (i & 7)))
+			++marked;
+	test_Value(marked, marked >= size / pageSize && marked <= r);
+
+	// prefetch the profiled pages and check reading them again doesn't need the paging device...
+	FlushAllPages();
+	test_KErrNone(UserSvr::HalFunction(EHalGroupVM, EVMHalPrefetchCodePages, data, &profile));
+	TPckgBuf<SVMEventInfo> before, after;
+	test_KErrNone(UserSvr::HalFunction(EHalGroupVM, EVMHalGetEventInfo, &before, 0));
+	for (i = 0 ; i < size ; i += pageSize)
+		(void)*(volatile TUint*)((TUint8*)data + i);
+	test_KErrNone(UserSvr::HalFunction(EHalGroupVM, EVMHalGetEventInfo, &after, 0));
+	test_equal(before().iPageInReadCount, after().iPageInReadCount);
+
+	// a profile for a different sized code segment is rejected...
+	TUint8 tooBig[256+4];
+	TPtrC8 tooBigDes(tooBig, profile.Length() + 4);
+	test_equal(KErrArgument, UserSvr::HalFunction(EHalGroupVM, EVMHalPrefetchCodePages, data, &tooBigDes));
+
+	library2.Close();
+	}
+
 
 void CheckRelocatableData(RLibrary& library)
 	{
@@ -1576,6 +1639,7 @@ void RunDriveIndependantTests()
 void RunPerDriveTests()
 	{
 	TestContentsOfPagedDll();
+	TestCodePageProfile();
 	TestContentsOfPagedDllWithRelocatedData();
 	TestKillThreadWhilePaging();
 	TestUnloadDllWhilePaging();
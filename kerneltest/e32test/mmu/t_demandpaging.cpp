@@ -384,6 +384,33 @@ void TestResizeVMCache2()
 	}
 
 
+void TestPageInLatencyInfo()
+	{
+	test_KErrNone(UserSvr::HalFunction(EHalGroupVM,EVMHalResetEventInfo,0,0));
+	test_KErrNone(DPTest::FlushCache());
+	TInt size = Min(LargeBufferSize, 64*PageSize);
+	for(TInt i=0; i<size; i+=PageSize)
+		READ(LargeBuffer+i);
+
+	TPckgBuf<SVMEventInfoV2> infoBuf;
+	test_KErrNone(UserSvr::HalFunction(EHalGroupVM,EVMHalGetEventInfo,&infoBuf,0));
+	TUint reads = 0;
+	for(TInt b=0; b<SVMEventInfoV2::EPageInLatencyBuckets; ++b)
+		{
+		test.Printf(_L("%8dus: %d\n"),1<<b,infoBuf().iPageInLatency[b]);
+		reads += infoBuf().iPageInLatency[b];
+		}
+	// each read brings in at least one page...
+	test(reads>0);
+	test(reads<=infoBuf().iPageInReadCount);
+
+	// the original structure can still be read on its own...
+	TPckgBuf<SVMEventInfo> oldInfoBuf;
+	test_KErrNone(UserSvr::HalFunction(EHalGroupVM,EVMHalGetEventInfo,&oldInfoBuf,0));
+	test(oldInfoBuf().iPageInReadCount>=infoBuf().iPageInReadCount);
+	}
+
+
 void TestHAL()
 	{
 	test.Start(_L("DPTest::Attributes"));
@@ -432,6 +459,9 @@ void TestHAL()
 		TestResizeVMCache2();
 		}
 
+	test.Next(_L("EVMHalGetEventInfo page in latencies"));
+	TestPageInLatencyInfo();
+
 	test.End();
 	}
 
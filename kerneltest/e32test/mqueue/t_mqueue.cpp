@@ -15,7 +15,7 @@
 // Overview:
 // Test message queuing
 // API Information:
-// RMsgQueue, RMsgQueueBase
+// RMsgQueue, RMsgQueueBase, RSharedMsgQueue, RSharedMsgQueueBase
 // Details:
 // - Create various illegal and legal private message queues and verify 
 // results are as expected. Test private message queue functionality in
@@ -25,6 +25,9 @@
 // in both single threaded tests and multi-threaded tests.
 // - Test multi-process queues and template based queues, verify results are 
 // as expected.
+// - Test queues with shared slot rings: capacity rounding, notifications,
+// several producers with one consumer, and compare the Send/Receive cost
+// with an ordinary queue.
 // Platforms/Drives/Compatibility:
 // All.
 // Assumptions/Requirement/Pre-requisites:
@@ -37,6 +40,7 @@
 #include <e32svr.h>
 #include <e32msgqueue.h>
 #include <f32file.h>
+#include <hal.h>
 
 LOCAL_D RTest test(_L("t_mqueue"));
 
@@ -830,6 +834,172 @@ void TestNotifiedThreadDied()
 
 }
 
+const TInt KSharedProducers = 3;
+const TInt KSharedMessages = 10000;
+
+struct TSharedMsg
+	{
+	TInt iProducer;
+	TInt iSeq;
+	};
+
+LOCAL_C TInt sharedProducerEntryPoint(TAny* aData)
+	{
+	TInt producer = (TInt)aData;
+	RSharedMsgQueue<TSharedMsg> queue;
+	TInt r = queue.OpenGlobal(KGLobalName1);
+	if (r != KErrNone)
+		return r;
+	TSharedMsg msg;
+	msg.iProducer = producer;
+	for (msg.iSeq=0; msg.iSeq<KSharedMessages; ++msg.iSeq)
+		{
+		//only one thread may wait for space, so the producers poll
+		while (queue.Send(msg) == KErrOverflow)
+			User::AfterHighRes(100);
+		}
+	queue.Close();
+	return KErrNone;
+	}
+
+LOCAL_C TUint32 TimeRoundTrips(RMsgQueueBase& aQueue, TBool aShared, TInt aCount)
+	{
+	TInt msg[2] = {KTestValue, 0};
+	TUint32 start = User::FastCounter();
+	for (TInt i=0; i<aCount; ++i)
+		{
+		if (aShared)
+			{
+			RSharedMsgQueueBase& q = (RSharedMsgQueueBase&)aQueue;
+			test(q.Send(msg, sizeof(msg)) == KErrNone);
+			test(q.Receive(msg, sizeof(msg)) == KErrNone);
+			}
+		else
+			{
+			test(aQueue.Send(msg, sizeof(msg)) == KErrNone);
+			test(aQueue.Receive(msg, sizeof(msg)) == KErrNone);
+			}
+		}
+	return User::FastCounter() - start;
+	}
+
+LOCAL_C void TestSharedQueue()
+	{
+	test.Next(_L("Create shared message queue, 5 slots, length 8"));
+	RSharedMsgQueueBase queue;
+	test(KErrNone == queue.CreateLocal(5, 8));
+	test(queue.MessageSize() == 8);
+
+	test.Next(_L("Shared queue is rounded up to 8 slots"));
+	TInt msg[2];
+	TInt i;
+	for (i=0; i<8; ++i)
+		{
+		msg[0] = i;
+		test(queue.Send(msg, sizeof(msg)) == KErrNone);
+		}
+	test(queue.Send(msg, sizeof(msg)) == KErrOverflow);
+	for (i=0; i<8; ++i)
+		{
+		test(queue.Receive(msg, sizeof(msg)) == KErrNone);
+		test(msg[0] == i);
+		}
+	test(queue.Receive(msg, sizeof(msg)) == KErrUnderflow);
+
+	test.Next(_L("Shared queue can't be used through RMsgQueueBase"));
+	RMsgQueueBase& base = queue;
+	test(base.Send(msg, sizeof(msg)) == KErrNotSupported);
+	test(base.Receive(msg, sizeof(msg)) == KErrNotSupported);
+
+	test.Next(_L("Shared queue notifications"));
+	TRequestStatus stat;
+	queue.NotifyDataAvailable(stat);
+	test(stat == KRequestPending);
+	test(queue.Send(msg, sizeof(msg)) == KErrNone);
+	User::WaitForRequest(stat);
+	test(stat == KErrNone);
+	queue.NotifyDataAvailable(stat);
+	User::WaitForRequest(stat);			// completes at once, there is a message
+	test(stat == KErrNone);
+	test(queue.Receive(msg, sizeof(msg)) == KErrNone);
+	for (i=0; i<8; ++i)
+		test(queue.Send(msg, sizeof(msg)) == KErrNone);
+	queue.NotifySpaceAvailable(stat);
+	test(stat == KRequestPending);
+	test(queue.Receive(msg, sizeof(msg)) == KErrNone);
+	User::WaitForRequest(stat);
+	test(stat == KErrNone);
+	queue.Close();
+
+	test.Next(_L("Shared queue closed through RHandleBase releases its slots"));
+	TInt processHandles, threadHandles;
+	RThread().HandleCount(processHandles, threadHandles);
+	// objects are deleted by the supervisor thread, so let it catch up around the heap check
+	test(UserSvr::HalFunction(EHalGroupKernel, EKernelHalSupervisorBarrier, (TAny*)5000, 0) == KErrNone);
+	__KHEAP_MARK;
+	test(KErrNone == queue.CreateLocal(64, 64));
+	TInt processHandles2, threadHandles2;
+	RThread().HandleCount(processHandles2, threadHandles2);
+	test(processHandles2 == processHandles + 1);
+	RHandleBase& handle = queue;
+	handle.Close();
+	RThread().HandleCount(processHandles2, threadHandles2);
+	test(processHandles2 == processHandles);
+	test(UserSvr::HalFunction(EHalGroupKernel, EKernelHalSupervisorBarrier, (TAny*)5000, 0) == KErrNone);
+	__KHEAP_MARKEND;
+
+	test.Next(_L("Ordinary queue can't be opened as shared"));
+	RMsgQueueBase ordinary;
+	test(KErrNone == ordinary.CreateGlobal(KGLobalName1, 4, 8));
+	test(queue.OpenGlobal(KGLobalName1) == KErrNotSupported);
+	ordinary.Close();
+
+	test.Next(_L("Shared queue with several producers"));
+	RSharedMsgQueue<TSharedMsg> mpsc;
+	test(KErrNone == mpsc.CreateGlobal(KGLobalName1, 16));
+	RThread thread[KSharedProducers];
+	TRequestStatus exit[KSharedProducers];
+	TInt next[KSharedProducers];
+	for (i=0; i<KSharedProducers; ++i)
+		{
+		test(thread[i].Create(KNullDesC, sharedProducerEntryPoint, KDefaultStackSize, KHeapSize, KHeapSize, (TAny*)i) == KErrNone);
+		thread[i].Logon(exit[i]);
+		next[i] = 0;
+		}
+	for (i=0; i<KSharedProducers; ++i)
+		thread[i].Resume();
+	TSharedMsg m;
+	for (i=0; i<KSharedProducers*KSharedMessages; ++i)
+		{
+		mpsc.ReceiveBlocking(m);
+		test(TUint(m.iProducer) < TUint(KSharedProducers));
+		test(m.iSeq == next[m.iProducer]++);		// each producer's messages arrive in order
+		}
+	test(mpsc.Receive(m) == KErrUnderflow);
+	for (i=0; i<KSharedProducers; ++i)
+		{
+		User::WaitForRequest(exit[i]);
+		test(exit[i] == KErrNone);
+		CLOSE_AND_WAIT(thread[i]);
+		}
+	mpsc.Close();
+
+	test.Next(_L("Shared queue latency"));
+	const TInt KRoundTrips = 100000;
+	test(KErrNone == ordinary.CreateLocal(16, 8));
+	test(KErrNone == queue.CreateLocal(16, 8));
+	TUint32 kernel = TimeRoundTrips(ordinary, EFalse, KRoundTrips);
+	TUint32 shared = TimeRoundTrips(queue, ETrue, KRoundTrips);
+	TInt freq = 0;
+	test(HAL::Get(HAL::EFastCounterFrequency, freq) == KErrNone);
+	test.Printf(_L("Send+Receive: ordinary %dns, shared %dns\n"),
+				TInt(TInt64(kernel) * 1000000000 / freq / KRoundTrips),
+				TInt(TInt64(shared) * 1000000000 / freq / KRoundTrips));
+	queue.Close();
+	ordinary.Close();
+	}
+
+
 LOCAL_C void RunTests(void)
 	{
 	TInt ret = KErrNone;
@@ -1089,6 +1259,8 @@ _LIT(KTestName, "testQueue");
 	templateQueue2.Close();
 
 	
+	TestSharedQueue();
+
 	test.Next(_L("Ending test.\n"));
 	test.End();
 	
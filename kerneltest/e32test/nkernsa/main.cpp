@@ -27,11 +27,14 @@ extern void TestWaitFreePipe();
 extern void BenchmarkTests();
 extern void TestRWSpinLock();
 extern void TestTiedEvents();
+extern void TestTimerQueue();
 
 void Main(TAny*)
 	{
 	BenchmarkTests();
 
+	TestTimerQueue();
+
 	TestWaitFreePipe();
 
 	TestFastSemaphore();
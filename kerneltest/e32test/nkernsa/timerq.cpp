@@ -0,0 +1,217 @@
+// Copyright (c) 2010 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of the License "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+// e32test\nkernsa\timerq.cpp
+//
+//
+
+#include <nktest/nkutils.h>
+
+//---------------------------------------------------------------------------------------------------------------------
+//! @SYMTestCaseID				KBASE-timerq-2449
+//! @SYMTestType				UT
+//! @SYMTestCaseDesc			Nanokernel timer queue benchmark
+//! @SYMTestPriority			Medium
+//! @SYMTestActions
+//! 	1. 	For 10, 1000 and 100000 outstanding timers, start the timers with
+//!			expiry times spread over all levels of the timer queue, then cancel
+//!			them, and measure the cost of each start and cancel.
+//!		2.	Start the same timers to expire on a single tick far enough ahead
+//!			that they are all cascaded through the queue, and measure the cost
+//!			of each expiry.
+//!		3.	Start and cancel timers concurrently from a thread on each CPU, first
+//!			on one CPU then on all of them, and measure the overall rate.
+//!
+//! @SYMTestExpectedResults
+//! 	1.	All starts and cancels succeed.
+//!		2.	All timers expire, none of them before its expiry time.
+//!		3.	All starts and cancels succeed. Since each CPU has its own timer
+//!			queue the rate should scale with the number of CPUs.
+//---------------------------------------------------------------------------------------------------------------------
+
+struct STimerBench
+	{
+	NTimer		iTimer;
+	TUint32		iDue;		// tick count at which the timer should expire
+	};
+
+volatile TUint32 TimerBenchExpired;
+volatile TUint32 TimerBenchEarly;
+TUint64 TimerBenchFirst;
+TUint64 TimerBenchLast;
+
+void TimerBenchFn(TAny* aPtr)
+	{
+	TUint64 now = fast_counter();
+	STimerBench* b = (STimerBench*)aPtr;
+	if (TInt(NTickCount() - b->iDue) < 0)
+		__e32_atomic_add_ord32(&TimerBenchEarly, 1);
+	if (__e32_atomic_add_ord32(&TimerBenchExpired, 1) == 0)
+		TimerBenchFirst = now;
+	TimerBenchLast = now;
+	}
+
+TUint32 TimerBenchNs(TUint64 aDelta, TInt aCount)
+	{
+	TUint64 ns = aDelta * UI64LIT(1000000000);
+	ns /= fast_counter_freq();
+	ns /= TUint32(aCount);
+	if (ns >> 32)
+		return KMaxTUint32;
+	return (TUint32)ns;
+	}
+
+void TimerBenchmark(TInt aCount)
+	{
+	STimerBench* b = (STimerBench*)malloc(aCount * sizeof(STimerBench));
+	if (!b)
+		{
+		TEST_PRINT1("%6d timers: not enough memory, skipped", aCount);
+		return;
+		}
+	TInt i;
+	for (i=0; i<aCount; ++i)
+		new (&b[i].iTimer) NTimer(&TimerBenchFn, &b[i]);
+
+	// Start timers with expiry times from 1 second to several hours ahead
+	// so they are spread over the whole queue, then cancel them all.
+	TUint32 seed = 0xb504f333u;
+	TUint64 t0 = fast_counter();
+	for (i=0; i<aCount; ++i)
+		{
+		seed = seed * 69069 + 1;
+		TInt r = b[i].iTimer.OneShot(1000 + TInt((seed >> 8) % 0x1000000u));
+		TEST_RESULT(r==KErrNone, "OneShot failed");
+		}
+	TUint64 t1 = fast_counter();
+	for (i=0; i<aCount; ++i)
+		{
+		TBool c = b[i].iTimer.Cancel();
+		TEST_RESULT(c, "Cancel failed");
+		}
+	TUint64 t2 = fast_counter();
+
+	// Now let them all expire on the same tick. The expiry cost is measured
+	// from the first to the last expiry handler, which all run back to back
+	// in the tick interrupt.
+	TimerBenchExpired = 0;
+	TimerBenchEarly = 0;
+	TUint32 due = NTickCount() + 2000;
+	for (i=0; i<aCount; ++i)
+		{
+		TInt ticks = TInt(due - NTickCount());
+		if (ticks < 1)
+			ticks = 1;
+		b[i].iDue = NTickCount() + TUint32(ticks);
+		TInt r = b[i].iTimer.OneShot(ticks);
+		TEST_RESULT(r==KErrNone, "OneShot failed");
+		}
+	TUint32 start = NTickCount();
+	while (TimerBenchExpired < (TUint32)aCount)
+		{
+		NKern::Sleep(10);
+		TEST_RESULT(TInt(NTickCount() - start) < 10000, "Timers did not expire");
+		}
+	TEST_RESULT1(TimerBenchEarly==0, "%d timers expired early", TimerBenchEarly);
+
+	TUint32 start_ns = TimerBenchNs(t1 - t0, aCount);
+	TUint32 cancel_ns = TimerBenchNs(t2 - t1, aCount);
+	TUint32 expire_ns = aCount>1 ? TimerBenchNs(TimerBenchLast - TimerBenchFirst, aCount - 1) : 0;
+	TEST_PRINT4("%6d timers: start %uns cancel %uns expire %uns", aCount, start_ns, cancel_ns, expire_ns);
+	free(b);
+	}
+
+const TInt KParallelTimers = 1000;
+const TInt KParallelRounds = 100;
+
+struct STimerBenchThread
+	{
+	STimerBench*	iTimers;
+	TUint64			iTime;
+	TInt			iFailed;
+	};
+
+STimerBenchThread TimerBenchThreads[KMaxCpus];
+
+void TimerBenchThreadFn(TAny* aPtr)
+	{
+	STimerBenchThread& t = *(STimerBenchThread*)aPtr;
+	TInt i;
+	TInt round;
+	TUint64 t0 = fast_counter();
+	for (round=0; round<KParallelRounds; ++round)
+		{
+		for (i=0; i<KParallelTimers; ++i)
+			{
+			if (t.iTimers[i].iTimer.OneShot(1000 + ((i * 997) & 0xffff)) != KErrNone)
+				++t.iFailed;
+			}
+		for (i=0; i<KParallelTimers; ++i)
+			{
+			if (!t.iTimers[i].iTimer.Cancel())
+				++t.iFailed;
+			}
+		}
+	t.iTime = fast_counter() - t0;
+	}
+
+void TimerParallelBenchmark(TInt aCpus)
+	{
+	NFastSemaphore exitSem(0);
+	TInt cpu;
+	TInt i;
+	for (cpu=0; cpu<aCpus; ++cpu)
+		{
+		STimerBenchThread& t = TimerBenchThreads[cpu];
+		t.iTimers = (STimerBench*)malloc(KParallelTimers * sizeof(STimerBench));
+		TEST_OOM(t.iTimers);
+		for (i=0; i<KParallelTimers; ++i)
+			new (&t.iTimers[i].iTimer) NTimer(&TimerBenchFn, &t.iTimers[i]);
+		t.iTime = 0;
+		t.iFailed = 0;
+		}
+	for (cpu=0; cpu<aCpus; ++cpu)
+		CreateThreadSignalOnExit("TimerBench", &TimerBenchThreadFn, 11, &TimerBenchThreads[cpu], 0, KSmallTimeslice, &exitSem, cpu);
+	for (cpu=0; cpu<aCpus; ++cpu)
+		NKern::FSWait(&exitSem);
+
+	TUint64 longest = 0;
+	for (cpu=0; cpu<aCpus; ++cpu)
+		{
+		STimerBenchThread& t = TimerBenchThreads[cpu];
+		TEST_RESULT1(t.iFailed==0, "%d timer operations failed", t.iFailed);
+		if (t.iTime > longest)
+			longest = t.iTime;
+		free(t.iTimers);
+		}
+
+	// overall time per start/cancel pair across all CPUs
+	TUint32 ns = TimerBenchNs(longest, aCpus * KParallelTimers * KParallelRounds);
+	TEST_PRINT2("Start/cancel on %d CPUs: %uns per pair", aCpus, ns);
+	}
+
+void TestTimerQueue()
+	{
+	TEST_PRINT("Testing timer queue...");
+	TimerBenchmark(10);
+	TimerBenchmark(1000);
+	TimerBenchmark(100000);
+
+	TInt ncpus = 0;
+	TInt cpu;
+	for_each_cpu(cpu)
+		++ncpus;
+	TimerParallelBenchmark(1);
+	if (ncpus > 1)
+		TimerParallelBenchmark(ncpus);
+	}
@@ -23,6 +23,8 @@
 // are as expected.
 // - Read and write the drive using various drive sizes, verify results
 // are as expected.
+// - Read the local media I/O scheduler statistics, check that reads and
+// writes are counted and that the scheduling window can be changed.
 // - Format the drive, verify results.
 // - Set original size and reformat. 
 // Platforms/Drives/Compatibility:
@@ -188,6 +190,43 @@ GLDEF_C TInt E32Main()
   	    test(rdBuf.Compare(wrBuf)==0);
 		}
 
+	test.Next(_L("I/O scheduler statistics"));
+	TLocalDriveIoSchedulerInfoBuf schedBuf;
+	TLocalDriveIoSchedulerInfo& sched=schedBuf();
+	sched.iWindow=TLocalDriveIoSchedulerInfo::ENoChange;
+	sched.iReset=ETrue;
+	test(theInternalDrive.QueryDevice(RLocalDrive::EQueryIoSchedulerInfo,schedBuf)==KErrNone);
+	TInt saveWindow=sched.iWindow;
+	const TUint KSchedRequests=8;
+	for (i=0;i<KSchedRequests;i++)
+		{
+		// write back what was read, to leave the contents unchanged
+		test(theInternalDrive.Read(i*KTestBufLen,KTestBufLen,&rdBuf,msgHandle,0)==KErrNone);
+		test(theInternalDrive.Write(i*KTestBufLen,KTestBufLen,&rdBuf,msgHandle,0)==KErrNone);
+		}
+	sched.iWindow=TLocalDriveIoSchedulerInfo::ENoChange;
+	sched.iReset=EFalse;
+	test(theInternalDrive.QueryDevice(RLocalDrive::EQueryIoSchedulerInfo,schedBuf)==KErrNone);
+	test.Printf(_L("reads %d writes %d other %d max in flight %d\n"),sched.iReadCount,sched.iWriteCount,sched.iOtherCount,sched.iMaxInFlight);
+	test.Printf(_L("batches %d scheduled %d max batch %d reordered %d sequential %d promoted %d\n"),
+				sched.iBatchCount,sched.iScheduledCount,sched.iMaxBatch,sched.iReorderedCount,sched.iSequentialCount,sched.iPromotedCount);
+	// the file server may be using the drive too
+	test(sched.iReadCount>=KSchedRequests);
+	test(sched.iWriteCount>=KSchedRequests);
+	test(sched.iMaxInFlight>=1);
+	test(sched.iScheduledCount>=(TUint)sched.iBatchCount);
+
+	sched.iWindow=1;
+	test(theInternalDrive.QueryDevice(RLocalDrive::EQueryIoSchedulerInfo,schedBuf)==KErrNone);
+	sched.iWindow=TLocalDriveIoSchedulerInfo::ENoChange;
+	test(theInternalDrive.QueryDevice(RLocalDrive::EQueryIoSchedulerInfo,schedBuf)==KErrNone);
+	test(sched.iWindow==1);
+	sched.iWindow=KMaxTInt;
+	test(theInternalDrive.QueryDevice(RLocalDrive::EQueryIoSchedulerInfo,schedBuf)==KErrArgument);
+	sched.iWindow=saveWindow;
+	test(theInternalDrive.QueryDevice(RLocalDrive::EQueryIoSchedulerInfo,schedBuf)==KErrNone);
+	test(sched.iWindow==saveWindow);
+
 	test.Next(_L("Reduce size - 256 bytes from start"));
  	test(theInternalDrive.ReduceSize(0,KTestBufLen)==KErrNone);
 	test(theInternalDrive.Caps(infoPckg)==KErrNone);
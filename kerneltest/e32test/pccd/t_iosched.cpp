@@ -0,0 +1,231 @@
+// Copyright (c) 2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of the License "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+// e32test\pccd\t_iosched.cpp
+// Overview:
+// Tests for the local media I/O scheduler
+// API Information:
+// TBusLocalDrive, RLocalDrive::EQueryIoSchedulerInfo
+// Details:
+// - Find a local drive whose media has its own DFC queue and isn't paging,
+// so its requests are batched by the scheduler.
+// - Read the start of the drive from a single thread to get reference data.
+// - From several threads of higher priority than the media's DFC thread,
+// issue reads in descending order of position, so they are all queued
+// before the media DFC runs. Verify the data read by each thread and check
+// the scheduler batched the requests and reordered them into ascending order.
+// - Set the scheduling window to 0 and repeat, check that nothing is batched
+// or reordered.
+// - Restore the original scheduling window.
+// Platforms/Drives/Compatibility:
+// Hardware and emulator. Needs a media with a DFC queue, e.g. MMC/SD or LFFS,
+// otherwise the test does nothing.
+// Assumptions/Requirement/Pre-requisites:
+// Failures and causes:
+// The batching and reordering checks are only made on a single CPU, on SMP
+// the media DFC may run before all the reads have been queued.
+// Base Port information:
+//
+//
+
+#define __E32TEST_EXTENSION__
+
+#include <e32test.h>
+#include <e32svr.h>
+#include <e32hal.h>
+#include <d32locd.h>
+
+const TInt KSectorSize=512;
+const TInt KNumThreads=8;
+const TInt KWindow=16;
+
+LOCAL_D RTest test(_L("T_IOSCHED"));
+LOCAL_D TInt TheDrive=-1;
+LOCAL_D TBuf8<KSectorSize*KNumThreads> RefData;
+LOCAL_D RSemaphore StartSem;
+
+LOCAL_C TInt QueryScheduler(TBusLocalDrive& aDrive, TLocalDriveIoSchedulerInfo& aInfo)
+	{
+	TPckg<TLocalDriveIoSchedulerInfo> infoPckg(aInfo);
+	return aDrive.QueryDevice(RLocalDrive::EQueryIoSchedulerInfo, infoPckg);
+	}
+
+LOCAL_C TBool FindDrive()
+//
+// Find a drive with media present whose requests can be batched
+//
+	{
+	for (TInt i=0; i<KMaxLocalDrives; i++)
+		{
+		TBusLocalDrive drive;
+		TBool changed=EFalse;
+		if (drive.Connect(i, changed)!=KErrNone)
+			continue;
+		TLocalDriveCapsV2 caps;
+		TPckg<TLocalDriveCapsV2> capsPckg(caps);
+		TLocalDriveIoSchedulerInfo info;
+		info.iWindow=TLocalDriveIoSchedulerInfo::ENoChange;
+		info.iReset=EFalse;
+		TBool found = drive.Caps(capsPckg)==KErrNone
+					&& caps.iSize>=TInt64(RefData.MaxLength())
+					&& !(caps.iMediaAtt & KMediaAttPageable)
+					&& QueryScheduler(drive, info)==KErrNone
+					&& info.iBatching;
+		drive.Disconnect();
+		if (found)
+			{
+			test.Printf(_L("Using local drive %d, media type %d\n"), i, caps.iType);
+			TheDrive=i;
+			return ETrue;
+			}
+		}
+	return EFalse;
+	}
+
+LOCAL_C TInt ReadThread(TAny* aIndex)
+//
+// Read one sector, in descending order of position by thread index
+//
+	{
+	TInt index=(TInt)aIndex;
+	TBusLocalDrive drive;
+	TBool changed=EFalse;
+	TInt r=drive.Connect(TheDrive, changed);
+	if (r!=KErrNone)
+		return r;
+	TBuf8<KSectorSize> buf;
+	TInt pos=(KNumThreads-1-index)*KSectorSize;
+	RThread::Rendezvous(KErrNone);
+	StartSem.Wait();
+	r=drive.Read(pos, KSectorSize, buf);
+	drive.Disconnect();
+	if (r==KErrNone && buf!=RefData.Mid(pos, KSectorSize))
+		r=KErrCorrupt;
+	return r;
+	}
+
+LOCAL_C void ConcurrentReads()
+	{
+	RThread threads[KNumThreads];
+	TRequestStatus stat[KNumThreads];
+	TInt i;
+	for (i=0; i<KNumThreads; i++)
+		{
+		TBuf<16> name;
+		name.Format(_L("IoSchedRead%d"), i);
+		test_KErrNone(threads[i].Create(name, ReadThread, KDefaultStackSize, NULL, (TAny*)i));
+		threads[i].SetPriority(EPriorityAbsoluteRealTime1);
+		TRequestStatus rv;
+		threads[i].Rendezvous(rv);
+		threads[i].Logon(stat[i]);
+		threads[i].Resume();
+		User::WaitForRequest(rv);
+		test_KErrNone(rv.Int());
+		}
+
+	// the threads can't run until this one blocks, by which time all of them are ready
+	StartSem.Signal(KNumThreads);
+	for (i=0; i<KNumThreads; i++)
+		{
+		User::WaitForRequest(stat[i]);
+		test_Equal(EExitKill, threads[i].ExitType());
+		test_KErrNone(stat[i].Int());
+		CLOSE_AND_WAIT(threads[i]);
+		}
+	}
+
+LOCAL_C void TestScheduler(TBusLocalDrive& aDrive, TInt aWindow)
+	{
+	TLocalDriveIoSchedulerInfo info;
+	info.iWindow=aWindow;
+	info.iReset=ETrue;
+	test_KErrNone(QueryScheduler(aDrive, info));
+
+	ConcurrentReads();
+
+	info.iWindow=TLocalDriveIoSchedulerInfo::ENoChange;
+	info.iReset=EFalse;
+	test_KErrNone(QueryScheduler(aDrive, info));
+	test.Printf(_L("window %d reads %d writes %d other %d max in flight %d\n"),
+				info.iWindow, info.iReadCount, info.iWriteCount, info.iOtherCount, info.iMaxInFlight);
+	test.Printf(_L("batches %d scheduled %d max batch %d reordered %d sequential %d promoted %d\n"),
+				info.iBatchCount, info.iScheduledCount, info.iMaxBatch, info.iReorderedCount, info.iSequentialCount, info.iPromotedCount);
+
+	// the file server may be using the media too
+	test_Equal(aWindow, info.iWindow);
+	test_Compare(info.iReadCount, >=, (TUint32)KNumThreads);
+	test_Compare(info.iScheduledCount, >=, info.iBatchCount);
+	if (aWindow<=1)
+		{
+		test_Equal(0, info.iBatchCount);
+		test_Equal(0, info.iReorderedCount);
+		return;
+		}
+	test_Compare(info.iMaxBatch, <=, aWindow);
+	if (UserSvr::HalFunction(EHalGroupKernel, EKernelHalNumLogicalCpus, 0, 0) > 1)
+		return;
+	test_Compare(info.iMaxInFlight, >=, KNumThreads);
+	test_Compare(info.iBatchCount, >, 0);
+	test_Compare(info.iScheduledCount, >=, (TUint32)KNumThreads);
+	test_Compare(info.iReorderedCount, >, 0);
+	test_Compare(info.iSequentialCount, >, 0);
+	}
+
+GLDEF_C TInt E32Main()
+	{
+	test.Title();
+	test.Start(_L("Local media I/O scheduler"));
+
+	if (!FindDrive())
+		{
+		test.Printf(_L("No media with a DFC queue found, skipping test\n"));
+		test.End();
+		return KErrNone;
+		}
+
+	TBusLocalDrive drive;
+	TBool changed=EFalse;
+	test_KErrNone(drive.Connect(TheDrive, changed));
+
+	test.Next(_L("Read reference data"));
+	test_KErrNone(drive.Read(0, RefData.MaxLength(), RefData));
+	test_Equal(RefData.MaxLength(), RefData.Length());
+
+	TLocalDriveIoSchedulerInfo info;
+	info.iWindow=TLocalDriveIoSchedulerInfo::ENoChange;
+	info.iReset=EFalse;
+	test_KErrNone(QueryScheduler(drive, info));
+	TInt saveWindow=info.iWindow;
+
+	// run above the media's DFC thread so the reads queue up before it services them
+	RThread().SetPriority(EPriorityAbsoluteRealTime1);
+	test_KErrNone(StartSem.CreateLocal(0));
+
+	test.Next(_L("Concurrent reads are batched and reordered"));
+	TestScheduler(drive, KWindow);
+
+	test.Next(_L("Concurrent reads are not batched with a window of 0"));
+	TestScheduler(drive, 0);
+
+	test.Next(_L("Restore the scheduling window"));
+	info.iWindow=saveWindow;
+	info.iReset=EFalse;
+	test_KErrNone(QueryScheduler(drive, info));
+	test_Equal(saveWindow, info.iWindow);
+
+	StartSem.Close();
+	RThread().SetPriority(EPriorityNormal);
+	drive.Disconnect();
+	test.End();
+	return KErrNone;
+	}
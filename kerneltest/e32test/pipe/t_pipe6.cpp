@@ -0,0 +1,330 @@
+// Copyright (c) 2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of the License "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+// e32test\pipe\t_pipe6.cpp
+// Overview:
+// Test vectored reads and writes of pipes, and splicing data between pipes
+// and shared buffers, and measure the throughput of each at several block
+// sizes.
+// API Information:
+// RPipe::ReadV, RPipe::WriteV, RPipe::SpliceTo, RPipe::SpliceFrom
+// Details:
+// - Write several descriptors with WriteV() and read them back into several
+// descriptors of different sizes with ReadV(), wrapping round the end of the
+// pipe's buffer.
+// - Check WriteV() writes nothing if the pipe hasn't room for all the data,
+// and that bad arguments and handles are rejected.
+// - Splice data from a shared buffer into the pipe and from the pipe into
+// another shared buffer, and check it.
+// - Splice from page aligned buffers, which the kernel has no mapping of, and
+// check the data is written from the process's mapping, or that the splice
+// fails with KErrNotSupported if the buffer isn't mapped into the process.
+// - Pass data through a pipe in blocks of several sizes with Write()/Read(),
+// WriteV()/ReadV() and SpliceFrom()/SpliceTo(), and print the throughput.
+// Platforms/Drives/Compatibility:
+// All.
+// Assumptions/Requirement/Pre-requisites:
+// Failures and causes:
+// Base Port information:
+//
+//
+
+#define __E32TEST_EXTENSION__
+
+#include <e32test.h>
+#include <e32shbuf.h>
+#include "rpipe.h"
+
+LOCAL_D RTest test(_L("t_pipe6"));
+
+const TInt KPipeSize = 64 * 1024;
+const TInt KBenchBytes = 8 * 1024 * 1024;
+const TInt KVectors = 8;
+
+LOCAL_C void Fill(TUint8* aPtr, TInt aLength, TInt aSeed)
+	{
+	for (TInt i = 0; i < aLength; ++i)
+		aPtr[i] = (TUint8)(aSeed + i);
+	}
+
+LOCAL_C TBool Check(const TUint8* aPtr, TInt aLength, TInt aSeed)
+	{
+	for (TInt i = 0; i < aLength; ++i)
+		{
+		if (aPtr[i] != (TUint8)(aSeed + i))
+			return EFalse;
+		}
+	return ETrue;
+	}
+
+LOCAL_C void TestVectors()
+	{
+	const TInt KSize = 100;
+	RPipe reader, writer;
+	test_KErrNone(RPipe::Create(KSize, reader, writer));
+
+	// move the pipe's pointers so the data wraps round the end of its buffer
+	TBuf8<KSize> buf;
+	buf.SetLength(70);
+	test_Equal(70, writer.Write(buf, 70));
+	test_Equal(70, reader.Read(buf, 70));
+
+	TBuf8<10> w0;
+	TBuf8<30> w1;
+	TBuf8<20> w2;
+	w0.SetLength(10);
+	w1.SetLength(30);
+	w2.SetLength(0);
+	Fill((TUint8*)w0.Ptr(), 10, 0);
+	Fill((TUint8*)w1.Ptr(), 30, 10);
+	const TDesC8* wv[] = { &w0, &w1, &w2 };
+	test_Equal(40, writer.WriteV(wv, 3));
+
+	TBuf8<25> r0;
+	TBuf8<5> r1;
+	TBuf8<50> r2;
+	TBuf8<10> r3;
+	r3.SetLength(10);
+	TDes8* rv[] = { &r0, &r1, &r2, &r3 };
+	test_Equal(40, reader.ReadV(rv, 4));
+	test_Equal(25, r0.Length());
+	test_Equal(5, r1.Length());
+	test_Equal(10, r2.Length());
+	test_Equal(0, r3.Length());
+	test(Check(r0.Ptr(), 25, 0));
+	test(Check(r1.Ptr(), 5, 25));
+	test(Check(r2.Ptr(), 10, 30));
+	test_Equal(0, reader.ReadV(rv, 4));
+
+	test.Next(_L("WriteV writes all the data or none of it"));
+	const TDesC8* big[] = { &w1, &w1, &w1, &w1 };
+	test_Equal(KErrOverflow, writer.WriteV(big, 4));
+	test_Equal(0, reader.Read(buf, 1));
+	test_Equal(90, writer.WriteV(big, 3));
+	test_Equal(KErrOverflow, writer.WriteV(wv, 2));
+	test_Equal(10, writer.WriteV(wv, 1));
+	reader.Flush();
+
+	test.Next(_L("Bad arguments and handles are rejected"));
+	test_Equal(KErrArgument, writer.WriteV(wv, 0));
+	test_Equal(KErrArgument, writer.WriteV(wv, KPipeMaxIoVectors + 1));
+	test_Equal(KErrArgument, reader.ReadV(rv, 0));
+	test_Equal(KErrAccessDenied, reader.WriteV(wv, 1));
+	test_Equal(KErrAccessDenied, writer.ReadV(rv, 1));
+
+	writer.Close();
+	reader.Close();
+	}
+
+LOCAL_C void TestSplice()
+	{
+	const TInt KSize = 1000;
+	RPipe reader, writer;
+	test_KErrNone(RPipe::Create(KSize, reader, writer));
+	RShPool pool;
+	TShPoolCreateInfo info(TShPoolCreateInfo::ENonPageAlignedBuffer, KSize, 2, 0);
+	test_KErrNone(pool.Create(info, EShPoolWriteable | EShPoolAllocate));
+	RShBuf src, dest;
+	test_KErrNone(src.Alloc(pool));
+	test_KErrNone(dest.Alloc(pool));
+	Fill(src.Ptr(), KSize, 3);
+
+	test_Equal(600, writer.SpliceFrom(src, 100, 600));
+	test_Equal(KErrOverflow, writer.SpliceFrom(src, 0, 600));
+	test_Equal(KErrArgument, writer.SpliceFrom(src, 500, KSize));
+	test_Equal(KErrArgument, writer.SpliceFrom(src, -1, 1));
+	test_Equal(KErrAccessDenied, reader.SpliceFrom(src, 0, 1));
+	RShBuf closed;
+	test_Equal(KErrBadHandle, writer.SpliceFrom(closed, 0, 1));
+
+	Mem::FillZ(dest.Ptr(), KSize);
+	test_Equal(400, reader.SpliceTo(dest, 0, 400));
+	test_Equal(200, reader.SpliceTo(dest, 400, 500));
+	test(Check(dest.Ptr(), 600, 103));
+	test_Equal(0, reader.SpliceTo(dest, 0, 10));
+	test_Equal(KErrArgument, reader.SpliceTo(dest, 1, KSize));
+	test_Equal(KErrAccessDenied, writer.SpliceTo(dest, 0, 1));
+
+	// round the end of the pipe's buffer
+	test_Equal(KSize, writer.SpliceFrom(src, 0, KSize));
+	test_Equal(KSize, reader.SpliceTo(dest, 0, KSize));
+	test(Check(dest.Ptr(), KSize, 3));
+
+	dest.Close();
+	src.Close();
+	pool.Close();
+	writer.Close();
+	reader.Close();
+	}
+
+LOCAL_C void TestSplicePageAligned()
+	{
+	const TInt KSize = 4096;
+	RPipe reader, writer;
+	test_KErrNone(RPipe::Create(KSize, reader, writer));
+	RShPool pool;
+	TShPoolCreateInfo info(TShPoolCreateInfo::EPageAlignedBuffer, KSize, 2);
+	TInt r = pool.Create(info, EShPoolWriteable | EShPoolAllocate);
+	if (r == KErrNotSupported)
+		{
+		test.Printf(_L("Page aligned pools not supported\n"));
+		writer.Close();
+		reader.Close();
+		return;
+		}
+	test_KErrNone(r);
+	test_KErrNone(pool.SetBufferWindow(-1, ETrue));
+
+	// a buffer mapped into this process only
+	RShBuf mapped, dest;
+	test_KErrNone(mapped.Alloc(pool));
+	test_KErrNone(dest.Alloc(pool));
+	Fill(mapped.Ptr(), KSize, 5);
+	test_Equal(1000, writer.SpliceFrom(mapped, 100, 1000));
+	test_Equal(KErrOverflow, writer.SpliceFrom(mapped, 0, KSize));
+	test_Equal(KErrArgument, writer.SpliceFrom(mapped, 1, KSize));
+	test_Equal(KErrArgument, writer.SpliceFrom(mapped, -1, 1));
+	test_Equal(KErrNone, writer.SpliceFrom(mapped, 0, 0));
+	Mem::FillZ(dest.Ptr(), KSize);
+	test_Equal(1000, reader.SpliceTo(dest, 0, KSize));
+	test(Check(dest.Ptr(), 1000, 105));
+
+	// a buffer mapped nowhere, then mapped into this process
+	RShBuf unmapped;
+	test_KErrNone(unmapped.Alloc(pool, EShPoolAllocNoMap));
+	test_Equal(KErrNotSupported, writer.SpliceFrom(unmapped, 0, 10));
+	test_Equal(KErrArgument, writer.SpliceFrom(unmapped, 0, KSize + 1));
+	test_Equal(KErrNotReady, reader.SpliceTo(unmapped, 0, 10));
+	test_KErrNone(unmapped.Map());
+	Fill(unmapped.Ptr(), KSize, 9);
+	test_Equal(KSize, writer.SpliceFrom(unmapped, 0, KSize));
+	test_Equal(KSize, reader.SpliceTo(dest, 0, KSize));
+	test(Check(dest.Ptr(), KSize, 9));
+
+	RShBuf closed;
+	test_Equal(KErrBadHandle, writer.SpliceFrom(closed, 0, 1));
+
+	unmapped.Close();
+	dest.Close();
+	mapped.Close();
+	pool.Close();
+	writer.Close();
+	reader.Close();
+	}
+
+enum TMethod
+	{
+	EReadWrite,
+	EVectored,
+	ESplice
+	};
+
+LOCAL_C TInt KBytesPerSecond(TMethod aMethod, TInt aBlockSize)
+	{
+	RPipe reader, writer;
+	test_KErrNone(RPipe::Create(KPipeSize, reader, writer));
+	RShPool pool;
+	TShPoolCreateInfo info(TShPoolCreateInfo::ENonPageAlignedBuffer, aBlockSize * KVectors, 2, 0);
+	test_KErrNone(pool.Create(info, EShPoolWriteable | EShPoolAllocate));
+	RShBuf src, dest;
+	test_KErrNone(src.Alloc(pool));
+	test_KErrNone(dest.Alloc(pool));
+
+	// KVectors blocks, used as descriptors or as a single shared buffer
+	TPtrC8 wblocks[KVectors];
+	const TDesC8* wv[KVectors];
+	TDes8* rv[KVectors];
+	TInt i;
+	for (i = 0; i < KVectors; ++i)
+		{
+		wblocks[i].Set(src.Ptr() + i * aBlockSize, aBlockSize);
+		wv[i] = &wblocks[i];
+		rv[i] = new TPtr8(dest.Ptr() + i * aBlockSize, 0, aBlockSize);
+		test_NotNull(rv[i]);
+		}
+	const TInt chunk = aBlockSize * KVectors;
+
+	TTime start;
+	start.UniversalTime();
+	for (TInt moved = 0; moved < KBenchBytes; moved += chunk)
+		{
+		switch (aMethod)
+			{
+		case EReadWrite:
+			for (i = 0; i < KVectors; ++i)
+				test_Equal(aBlockSize, writer.Write(wblocks[i], aBlockSize));
+			for (i = 0; i < KVectors; ++i)
+				test_Equal(aBlockSize, reader.Read(*rv[i], aBlockSize));
+			break;
+		case EVectored:
+			test_Equal(chunk, writer.WriteV(wv, KVectors));
+			test_Equal(chunk, reader.ReadV(rv, KVectors));
+			break;
+		case ESplice:
+			test_Equal(chunk, writer.SpliceFrom(src, 0, chunk));
+			test_Equal(chunk, reader.SpliceTo(dest, 0, chunk));
+			break;
+			}
+		}
+	TTime end;
+	end.UniversalTime();
+
+	for (i = 0; i < KVectors; ++i)
+		delete rv[i];
+	dest.Close();
+	src.Close();
+	pool.Close();
+	writer.Close();
+	reader.Close();
+
+	TInt64 us = end.MicroSecondsFrom(start).Int64();
+	if (us <= 0)
+		us = 1;
+	return (TInt)((TInt64)KBenchBytes * 1000 / 1024 * 1000 / us);
+	}
+
+LOCAL_C void Benchmark()
+	{
+	const TInt KBlockSizes[] = { 16, 256, 4096 };
+	for (TUint i = 0; i < sizeof(KBlockSizes) / sizeof(KBlockSizes[0]); ++i)
+		{
+		TInt size = KBlockSizes[i];
+		TInt rw = KBytesPerSecond(EReadWrite, size);
+		TInt vec = KBytesPerSecond(EVectored, size);
+		TInt splice = KBytesPerSecond(ESplice, size);
+		test.Printf(_L("%5d byte blocks: %8d KB/s Read/Write, %8d KB/s ReadV/WriteV, %8d KB/s splice\n"),
+					size, rw, vec, splice);
+		}
+	}
+
+GLDEF_C TInt E32Main()
+	{
+	test.Title();
+	TInt r = RPipe::Init();
+	test(r == KErrNone || r == KErrAlreadyExists);
+
+	test.Start(_L("Vectored reads and writes"));
+	TestVectors();
+
+	test.Next(_L("Splice to and from shared buffers"));
+	TestSplice();
+
+	test.Next(_L("Splice from page aligned shared buffers"));
+	TestSplicePageAligned();
+
+	test.Next(_L("Throughput at several block sizes"));
+	Benchmark();
+
+	test.End();
+	return KErrNone;
+	}
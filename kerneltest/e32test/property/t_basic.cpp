@@ -756,6 +756,147 @@ void CPropSubsCancel::Run(TUint aCount)
 		}
 	}
 
+_LIT(KBatchName, "TPropertyBatch Basics");
+
+CPropBatch::CPropBatch(TUid aCategory, TUint aFirstKey) : 
+	  CTestProgram(KBatchName), iCategory(aCategory), iFirstKey(aFirstKey)
+	{
+	}
+
+void CPropBatch::CheckUnchanged(RProperty* aProps, TRequestStatus* aStatus)
+	{
+	for (TUint j = 0; j < KProps; ++j)
+		{
+		TF_ERROR(aStatus[j].Int(), aStatus[j].Int() == KRequestPending);
+		if (j < KProps/2)
+			{
+			TInt value;
+			TInt r = aProps[j].Get(value);
+			TF_ERROR(r, r == KErrNone);
+			TF_ERROR(value, value == (TInt) j);
+			}
+		else
+			{
+			TBuf8<RProperty::KMaxPropertySize> buf;
+			TInt r = aProps[j].Get(buf);
+			TF_ERROR(r, r == KErrNone);
+			TF_ERROR(buf.Length(), buf.Length() == 0);
+			}
+		}
+	}
+
+void CPropBatch::Run(TUint aCount)
+	{
+	for(TUint i = 0; i < aCount; ++i)
+		{
+		// The first half of the properties are integers, the rest byte arrays 
+		// defined with no preallocated space.
+		RProperty props[KProps];
+		TRequestStatus status[KProps];
+		TUint j;
+		TInt r;
+		for (j = 0; j < KProps; ++j)
+			{
+			r = props[j].Define(iCategory, iFirstKey + j, (j < KProps/2) ? RProperty::EInt : RProperty::EByteArray, 
+								KPassPolicy, KPassPolicy);
+			TF_ERROR(r, r == KErrNone);
+			r = props[j].Attach(iCategory, iFirstKey + j);
+			TF_ERROR(r, r == KErrNone);
+			if (j < KProps/2)
+				{
+				r = props[j].Set((TInt) j);
+				TF_ERROR(r, r == KErrNone);
+				}
+			props[j].Subscribe(status[j]);
+			}
+
+		TBuf8<RProperty::KMaxPropertySize> value;
+		value.SetMax();
+		value.Fill('b');
+		TPropertyBatch batch;
+
+		// A batch with an undefined property doesn't change anything.
+		for (j = 0; j < KProps; ++j)
+			{
+			r = (j < KProps/2) ? batch.Set(iCategory, iFirstKey + j, 1000) : batch.Set(iCategory, iFirstKey + j, value);
+			TF_ERROR(r, r == KErrNone);
+			}
+		r = batch.Set(iCategory, iFirstKey + KProps, 1);
+		TF_ERROR(r, r == KErrNone);
+		TF_ERROR(batch.Count(), batch.Count() == KProps + 1);
+		r = batch.Commit();
+		TF_ERROR(r, r == KErrNotFound);
+		TF_ERROR(batch.Count(), batch.Count() == 0);
+		CheckUnchanged(props, status);
+
+		// Nor does a batch with a value of the wrong type.
+		for (j = 0; j < KProps; ++j)
+			{
+			r = batch.Set(iCategory, iFirstKey + j, 1000);
+			TF_ERROR(r, r == KErrNone);
+			}
+		r = batch.Commit();
+		TF_ERROR(r, r == KErrArgument);
+		CheckUnchanged(props, status);
+
+		// A batch can't hold more than KMaxItems values, and Begin() empties it.
+		for (j = 0; j < (TUint) TPropertyBatch::KMaxItems; ++j)
+			{
+			r = batch.Set(iCategory, iFirstKey, (TInt) j);
+			TF_ERROR(r, r == KErrNone);
+			}
+		r = batch.Set(iCategory, iFirstKey, 0);
+		TF_ERROR(r, r == KErrOverflow);
+		batch.Begin();
+		TF_ERROR(batch.Count(), batch.Count() == 0);
+
+		// A good batch sets every value, the last value for a property set twice 
+		// winning, and completes each subscription once.
+		for (j = 0; j < KProps; ++j)
+			{
+			if (j < KProps/2)
+				r = batch.Set(iCategory, iFirstKey + j, 1000 + j);
+			else
+				r = batch.Set(iCategory, iFirstKey + j, value.Left(j));
+			TF_ERROR(r, r == KErrNone);
+			}
+		r = batch.Set(iCategory, iFirstKey, 2000);
+		TF_ERROR(r, r == KErrNone);
+		r = batch.Commit();
+		TF_ERROR(r, r == KErrNone);
+		for (j = 0; j < KProps; ++j)
+			{
+			User::WaitForRequest(status[j]);
+			TF_ERROR(status[j].Int(), status[j].Int() == KErrNone);
+			if (j < KProps/2)
+				{
+				TInt v;
+				r = props[j].Get(v);
+				TF_ERROR(r, r == KErrNone);
+				TF_ERROR(v, v == (j ? (TInt) (1000 + j) : 2000));
+				}
+			else
+				{
+				TBuf8<RProperty::KMaxPropertySize> buf;
+				r = props[j].Get(buf);
+				TF_ERROR(r, r == KErrNone);
+				TF_ERROR(buf.Length(), buf == value.Left(j));
+				}
+			}
+
+		// Committing an empty batch does nothing.
+		r = batch.Commit();
+		TF_ERROR(r, r == KErrNone);
+
+		for (j = 0; j < KProps; ++j)
+			{
+			r = props[j].Delete(iCategory, iFirstKey + j);
+			TF_ERROR(r, r == KErrNone);
+			props[j].Close();
+			}
+		}
+	}
+
 _LIT(KSecurityName, "RProperty Security Basics (Master)");
  
 CPropSecurity::CPropSecurity(TUid aCategory, TUint aMasterKey, RProperty::TType aType, TUint aSlaveKeySlot) : 
@@ -87,6 +87,19 @@ private:
 	RProperty::TType	iType;
 	};
 
+class CPropBatch : public CTestProgram
+	{
+public:
+	CPropBatch(TUid aCategory, TUint aFirstKey);
+	void Run(TUint aCount);
+private:
+	enum { KProps = 8 };
+	void CheckUnchanged(RProperty* aProps, TRequestStatus* aStatus);
+
+	TUid				iCategory;
+	TUint				iFirstKey;
+	};
+
 class CPropSecurity : public CTestProgram
 	{
 public:
@@ -108,6 +108,7 @@ GLDEF_C TInt E32Main()
 			new CPropSubsCancel(KPropTestCategory, 73, RProperty::ELargeByteArray),
 			new CPropSubsCancel(KPropTestCategory, 77, RProperty::EByteArray),
 			new CPropSubsCancel(KPropTestCategory, 88, RProperty::EInt),
+			new CPropBatch(KPropTestCategory, 200),
 			new CPropSecurity(KPropTestCategory, 99, RProperty::EInt, 1000),
 			new CPropSetGetRace(KPropTestCategory, 111),
 			new CPropCancelRace(KPropTestCategory, 122),
@@ -0,0 +1,339 @@
+// Copyright (c) 2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of the License "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+// e32test\system\t_ipcbatch.cpp
+// Overview:
+// Test batched client-server requests.
+// API Information:
+// RSessionBase::SendReceiveBatch, TIpcBatch, RMessagePtr2::CompleteBatch
+// Details:
+// - Send a batch of requests and check each is completed with its own result
+// and that the server receives them in the order they were added.
+// - Send a batch containing a negative function number and check only that
+// request fails, with KErrArgument.
+// - Send a batch larger than the session's message slots and check the
+// requests which don't get a slot fail with KErrServerBusy.
+// - Complete several held messages with RMessagePtr2::CompleteBatch and check
+// each gets its own completion code.
+// - Send a batch to a server which has gone away and check every request fails
+// with KErrServerTerminated.
+// - Check a server is panicked if it passes CompleteBatch too many messages, a
+// null message or a disconnect message.
+// Platforms/Drives/Compatibility:
+// All.
+// Assumptions/Requirement/Pre-requisites:
+// Failures and causes:
+// Base Port information:
+//
+//
+
+#define __E32TEST_EXTENSION__
+
+#include <e32test.h>
+#include <e32kpan.h>
+#include <e32panic.h>
+
+LOCAL_D RTest test(_L("T_IPCBATCH"));
+
+_LIT(KServerName, "T_IPCBATCH");
+_LIT(KUser, "USER");
+_LIT(KKernExec, "KERN-EXEC");
+
+const TInt KMsgSlots = 4;
+
+enum TFunction
+	{
+	EEcho,				// complete with Int0
+	EHold,				// keep until ECompleteHeld
+	ECompleteHeld,		// complete the held messages with CompleteBatch
+	EStop,
+	};
+
+enum TServerMode
+	{
+	ENormal,
+	ETooMany,			// pass CompleteBatch more than KMaxIpcBatchMessages messages
+	ENullMessage,		// pass CompleteBatch a null message
+	EDisconnect,		// pass CompleteBatch the disconnect message
+	};
+
+const TInt KHeldReason = 100;
+
+LOCAL_D TInt Received[KMaxIpcBatchMessages];
+LOCAL_D TInt ReceivedCount;
+
+LOCAL_C TInt ServerThreadFunction(TAny* aMode)
+	{
+	TServerMode mode = (TServerMode)(TInt)aMode;
+	RServer2 server;
+	TInt r = server.CreateGlobal(KServerName);
+	RThread::Rendezvous(r);
+	if (r != KErrNone)
+		return r;
+
+	RMessagePtr2 held[KMaxIpcBatchMessages + 1];
+	TInt reasons[KMaxIpcBatchMessages + 1];
+	TInt count = 0;
+	TBool stop = EFalse;
+	while (!stop)
+		{
+		RMessage2 m;
+		server.Receive(m);
+		switch (m.Function())
+			{
+		case RMessage2::EConnect:
+			m.Complete(KErrNone);
+			break;
+		case RMessage2::EDisConnect:
+			if (mode == EDisconnect)
+				{
+				held[0] = m;
+				reasons[0] = KErrNone;
+				RMessagePtr2::CompleteBatch(held, reasons, 1);	// panics
+				}
+			m.Complete(KErrNone);
+			break;
+		case EEcho:
+			if (ReceivedCount < KMaxIpcBatchMessages)
+				Received[ReceivedCount++] = m.Int0();
+			m.Complete(m.Int0());
+			break;
+		case EHold:
+			held[count] = m;
+			reasons[count] = KHeldReason + count;
+			++count;
+			break;
+		case ECompleteHeld:
+			if (mode == ETooMany)
+				count = KMaxIpcBatchMessages + 1;
+			else if (mode == ENullMessage)
+				held[count++] = RMessagePtr2();
+			RMessagePtr2::CompleteBatch(held, reasons, count);
+			while (count)
+				{
+				if (!held[--count].IsNull())
+					User::Panic(KServerName, count);
+				}
+			m.Complete(KErrNone);
+			break;
+		case EStop:
+			m.Complete(KErrNone);
+			stop = ETrue;
+			break;
+		default:
+			m.Complete(KErrNotSupported);
+			break;
+			}
+		}
+	server.Close();
+	return KErrNone;
+	}
+
+class RBatchSession : public RSessionBase
+	{
+public:
+	inline TInt Connect()
+		{ return CreateSession(KServerName, TVersion(), KMsgSlots); }
+	inline void Send(const TIpcBatch& aBatch)
+		{ SendReceiveBatch(aBatch); }
+	inline TInt CompleteHeld()
+		{ return SendReceive(ECompleteHeld); }
+	inline TInt Stop()
+		{ return SendReceive(EStop); }
+	};
+
+LOCAL_D RThread ServerThread;
+
+LOCAL_C void StartServer(TServerMode aMode)
+	{
+	TInt r = ServerThread.Create(KNullDesC, ServerThreadFunction, KDefaultStackSize, NULL, (TAny*)aMode);
+	test_KErrNone(r);
+	TRequestStatus s;
+	ServerThread.Rendezvous(s);
+	ServerThread.Resume();
+	User::WaitForRequest(s);
+	test_KErrNone(s.Int());
+	}
+
+LOCAL_C void WaitForServer(TExitType aType, const TDesC& aCategory, TInt aReason)
+	{
+	TRequestStatus s;
+	ServerThread.Logon(s);
+	User::WaitForRequest(s);
+	test_Equal(aType, ServerThread.ExitType());
+	test(ServerThread.ExitCategory() == aCategory);
+	test_Equal(aReason, ServerThread.ExitReason());
+	CLOSE_AND_WAIT(ServerThread);
+	}
+
+LOCAL_C void TestEcho(RBatchSession& aSession)
+	{
+	TIpcBatch batch;
+	TRequestStatus s[KMsgSlots];
+	TInt i;
+	ReceivedCount = 0;
+	for (i = 0; i < KMsgSlots; ++i)
+		test_KErrNone(batch.Add(EEcho, TIpcArgs(i + 1), s[i]));
+	test_Equal(KMsgSlots, batch.Count());
+	aSession.Send(batch);
+	for (i = 0; i < KMsgSlots; ++i)
+		{
+		User::WaitForRequest(s[i]);
+		test_Equal(i + 1, s[i].Int());
+		}
+	test_Equal(KMsgSlots, ReceivedCount);
+	for (i = 0; i < KMsgSlots; ++i)
+		test_Equal(i + 1, Received[i]);
+	}
+
+// TIpcBatch::Add() panics a negative function, so one is patched in afterwards
+struct SBatchLayout
+	{
+	TInt iCount;
+	SIpcBatchItem iItems[TIpcBatch::KMaxMessages];
+	};
+__ASSERT_COMPILE(sizeof(SBatchLayout) == sizeof(TIpcBatch));
+
+LOCAL_C void TestBadFunction(RBatchSession& aSession)
+	{
+	TIpcBatch batch;
+	TRequestStatus s[3];
+	TInt i;
+	for (i = 0; i < 3; ++i)
+		test_KErrNone(batch.Add(EEcho, TIpcArgs(i + 1), s[i]));
+	((SBatchLayout&)batch).iItems[1].iFunction = -3;
+	aSession.Send(batch);
+	for (i = 0; i < 3; ++i)
+		User::WaitForRequest(s[i]);
+	test_Equal(1, s[0].Int());
+	test_Equal(KErrArgument, s[1].Int());
+	test_Equal(3, s[2].Int());
+	}
+
+LOCAL_C void TestSlotsAndCompleteBatch(RBatchSession& aSession)
+	{
+	const TInt KCount = KMsgSlots + 2;
+	TIpcBatch batch;
+	TRequestStatus s[KCount];
+	TInt i;
+	for (i = 0; i < KCount; ++i)
+		test_KErrNone(batch.Add(EHold, TIpcArgs(), s[i]));
+	aSession.Send(batch);
+
+	// the messages without a slot fail at once; the others are held by the server
+	for (i = KMsgSlots; i < KCount; ++i)
+		{
+		User::WaitForRequest(s[i]);
+		test_Equal(KErrServerBusy, s[i].Int());
+		}
+	for (i = 0; i < KMsgSlots; ++i)
+		test_Equal(KRequestPending, s[i].Int());
+
+	test_KErrNone(aSession.CompleteHeld());
+	for (i = 0; i < KMsgSlots; ++i)
+		{
+		User::WaitForRequest(s[i]);
+		test_Equal(KHeldReason + i, s[i].Int());
+		}
+	}
+
+LOCAL_C void TestFull()
+	{
+	TIpcBatch batch;
+	TRequestStatus s;
+	TInt i;
+	for (i = 0; i < TIpcBatch::KMaxMessages; ++i)
+		test_KErrNone(batch.Add(EEcho, TIpcArgs(), s));
+	test_Equal(KErrOverflow, batch.Add(EEcho, TIpcArgs(), s));
+	batch.Reset();
+	test_Equal(0, batch.Count());
+	}
+
+LOCAL_C void TestServerGone(RBatchSession& aSession)
+	{
+	TIpcBatch batch;
+	TRequestStatus s[KMsgSlots];
+	TInt i;
+	for (i = 0; i < KMsgSlots; ++i)
+		test_KErrNone(batch.Add(EEcho, TIpcArgs(i + 1), s[i]));
+	aSession.Send(batch);
+	for (i = 0; i < KMsgSlots; ++i)
+		{
+		User::WaitForRequest(s[i]);
+		test_Equal(KErrServerTerminated, s[i].Int());
+		}
+	}
+
+LOCAL_C void TestServerPanic(TServerMode aMode, const TDesC& aCategory, TInt aReason)
+	{
+	StartServer(aMode);
+	RBatchSession session;
+	test_KErrNone(session.Connect());
+	if (aMode == EDisconnect)
+		session.Close();
+	else
+		{
+		TIpcBatch batch;
+		TRequestStatus s;
+		test_KErrNone(batch.Add(EHold, TIpcArgs(), s));
+		session.Send(batch);
+		test_Equal(KErrServerTerminated, session.CompleteHeld());
+		User::WaitForRequest(s);
+		test_Equal(KErrServerTerminated, s.Int());
+		session.Close();
+		}
+	WaitForServer(EExitPanic, aCategory, aReason);
+	}
+
+GLDEF_C TInt E32Main()
+	{
+	test.Title();
+	test.Start(_L("Start the server"));
+	StartServer(ENormal);
+	RBatchSession session;
+	test_KErrNone(session.Connect());
+
+	test.Next(_L("Batched requests are received in order and completed separately"));
+	TestEcho(session);
+
+	test.Next(_L("A bad function number only fails its own request"));
+	TestBadFunction(session);
+
+	test.Next(_L("Requests without a message slot fail with KErrServerBusy"));
+	TestSlotsAndCompleteBatch(session);
+
+	test.Next(_L("A batch holds at most KMaxMessages requests"));
+	TestFull();
+
+	test.Next(_L("Requests to a server which has gone fail with KErrServerTerminated"));
+	test_KErrNone(session.Stop());
+	WaitForServer(EExitKill, _L("Kill"), KErrNone);
+	TestServerGone(session);
+	session.Close();
+
+	TBool jit = User::JustInTime();
+	User::SetJustInTime(EFalse);
+
+	test.Next(_L("CompleteBatch panics with too many messages"));
+	TestServerPanic(ETooMany, KUser, ETMesCompletion);
+
+	test.Next(_L("CompleteBatch panics with a null message"));
+	TestServerPanic(ENullMessage, KUser, ETMesCompletion);
+
+	test.Next(_L("CompleteBatch panics with a disconnect message"));
+	TestServerPanic(EDisconnect, KKernExec, EBadMessageHandle);
+
+	User::SetJustInTime(jit);
+	test.End();
+	return KErrNone;
+	}
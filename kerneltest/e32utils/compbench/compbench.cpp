@@ -0,0 +1,192 @@
+// Copyright (c) 2010 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of the License "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+// e32utils\compbench\compbench.cpp
+// Host tool which compares the page compression schemes usable for demand paged code.  Each
+// input file (typically a ROM image, or the binaries that go into one) is split into 4KB pages
+// and every page is compressed independently, as it would be in a paged image.  The tool
+// reports the compression ratio and the compression and decompression throughput of each scheme.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <e32std.h>
+
+#define BYTE_PAIR_COMPRESS_INCLUDE_IMPLEMENTATION
+#include <byte_pair_compress.h>
+
+#define LZ4_COMPRESS_INCLUDE_IMPLEMENTATION
+#include <lz4_compress.h>
+
+#include "decompress.h"
+
+const int KPageSize = 0x1000;
+const int KMaxCompressedPage = LZ4_COMPRESS_BOUND(KPageSize) + KPageSize;
+
+TUint16 Lz4HashTable[1 << KLz4HashBits];
+
+int CompressLz4(TUint8* aDest, TUint8* aSrc, int aSize)
+	{
+	return Lz4Compress(aDest, KMaxCompressedPage, aSrc, aSize, Lz4HashTable);
+	}
+
+struct TScheme
+	{
+	const char* iName;
+	int (*iCompress)(TUint8* aDest, TUint8* aSrc, int aSize);
+	TInt (*iDecompress)(TUint8* dst, TInt dstSize, TUint8* src, TInt srcSize, TUint8*& srcNext);
+	};
+
+const TScheme Schemes[] =
+	{
+	{ "byte-pair",	BytePairCompress,	BytePairDecompress },
+	{ "lz4",		CompressLz4,		Lz4Decompress },
+	};
+const int KNumSchemes = sizeof(Schemes) / sizeof(Schemes[0]);
+
+struct TResult
+	{
+	double iInBytes;
+	double iOutBytes;
+	double iCompressTime;
+	double iDecompressTime;
+	int iErrors;
+	};
+
+TResult Results[KNumSchemes];
+int Repeat = 10;
+
+double Now()
+	{
+	return (double)clock() / CLOCKS_PER_SEC;
+	}
+
+void BenchmarkData(TUint8* aData, int aSize)
+	{
+	TUint8* compressed = (TUint8*)malloc(KMaxCompressedPage);
+	TUint8* output = (TUint8*)malloc(KPageSize);
+	for (int s = 0 ; s < KNumSchemes ; ++s)
+		{
+		const TScheme& scheme = Schemes[s];
+		TResult& result = Results[s];
+		for (int pos = 0 ; pos < aSize ; pos += KPageSize)
+			{
+			int size = aSize - pos < KPageSize ? aSize - pos : KPageSize;
+			double t0 = Now();
+			int compressedSize = scheme.iCompress(compressed, aData + pos, size);
+			double t1 = Now();
+			if (compressedSize < 0)
+				{
+				++result.iErrors;
+				continue;
+				}
+			for (int i = 0 ; i < Repeat ; ++i)
+				{
+				TUint8* srcNext = NULL;
+				if (scheme.iDecompress(output, size, compressed, compressedSize, srcNext) != size)
+					++result.iErrors;
+				}
+			double t2 = Now();
+			if (memcmp(output, aData + pos, size) != 0)
+				++result.iErrors;
+			result.iInBytes += size;
+			result.iOutBytes += compressedSize;
+			result.iCompressTime += t1 - t0;
+			result.iDecompressTime += t2 - t1;
+			}
+		}
+	free(output);
+	free(compressed);
+	}
+
+int BenchmarkFile(const char* aName)
+	{
+	FILE* file = fopen(aName, "rb");
+	if (!file)
+		{
+		fprintf(stderr, "Can't open input file '%s'\n", aName);
+		return 0;
+		}
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	TUint8* data = (TUint8*)malloc(size ? size : 1);
+	if (!data || fread(data, 1, size, file) != (size_t)size)
+		{
+		fprintf(stderr, "Can't read input file '%s'\n", aName);
+		free(data);
+		fclose(file);
+		return 0;
+		}
+	fclose(file);
+	BenchmarkData(data, size);
+	free(data);
+	return 1;
+	}
+
+double MBPerSec(double aBytes, double aTime)
+	{
+	return aTime > 0 ? aBytes / aTime / (1024 * 1024) : 0;
+	}
+
+char* ThisProgram = "COMPBENCH";
+
+int Help()
+	{
+	printf("Usage: %s [options] file...\n",ThisProgram);
+	printf("Options:\n");
+	printf("  -r<count>     Number of times to decompress each page (default 10)\n");
+	printf("\nTHIS TOOL IS UNOFFICIAL, UNSUPPORTED AND SUBJECT TO CHANGE WITHOUT NOTICE!\n");
+	return 1;
+	}
+
+int main(int argc, char** argv)
+	{
+	ThisProgram = argv[0];
+	int files = 0;
+	for (int arg = 1 ; arg < argc ; ++arg)
+		{
+		if (argv[arg][0] == '-')
+			{
+			if (argv[arg][1] == 'r' && atoi(argv[arg] + 2) > 0)
+				{
+				Repeat = atoi(argv[arg] + 2);
+				continue;
+				}
+			fprintf(stderr, "Unknown option: %s\n", argv[arg]);
+			return Help();
+			}
+		files += BenchmarkFile(argv[arg]);
+		}
+	if (!files)
+		{
+		fprintf(stderr, "Missing input file\n");
+		return Help();
+		}
+
+	printf("%-10s %12s %12s %7s %14s %14s %7s\n", "scheme", "in", "out", "ratio", "compress MB/s", "decomp MB/s", "errors");
+	for (int s = 0 ; s < KNumSchemes ; ++s)
+		{
+		const TResult& r = Results[s];
+		printf("%-10s %12.0f %12.0f %6.1f%% %14.1f %14.1f %7d\n",
+			   Schemes[s].iName, r.iInBytes, r.iOutBytes,
+			   r.iInBytes > 0 ? 100.0 * r.iOutBytes / r.iInBytes : 0.0,
+			   MBPerSec(r.iInBytes, r.iCompressTime),
+			   MBPerSec(r.iInBytes * Repeat, r.iDecompressTime),
+			   r.iErrors);
+		}
+	return 0;
+	}
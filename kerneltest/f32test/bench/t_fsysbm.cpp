@@ -712,6 +712,92 @@ static void TestFileWriteCPU(TBool aMisalignedReadWrites = EFalse)
 	}
 
 
+static TReal CopyRate(TInt aFileSize, TUint aInitTicks, TUint aFinalTicks)
+	{
+	TTimeIntervalMicroSeconds duration = TInt64(aFinalTicks - aInitTicks) * TInt64(1000000) / TInt64(gFastCounterFreq) ;
+	return TReal32(aFileSize) / TReal(duration.Int64()) * TReal(1000000) / TReal(K1K); // KB/s
+	}
+
+
+static void TestFileCopy()
+//
+// Benchmark copying a file inside the file server (as CFileMan now does) against
+// reading and writing it through the client (as CFileMan used to)
+//
+	{
+	ClearSessionDirectory();
+	test.Next(_L("Benchmark file copy"));
+
+	_LIT(KSrc, "COPYSRC");
+	_LIT(KDst, "COPYDST");
+	const TInt KClientBlockSize = Min(512 * K1K, KMaxFileSize);
+
+	DataBuf.SetLength(KMaxFileSize);
+	for (TInt m = 0; m < DataBuf.Length(); m++)
+		DataBuf[m] = TText8(m % 256);
+	TInt r = File.Replace(TheFs, KSrc, EFileWrite);
+	test_KErrNone(r);
+	r = File.Write(DataBuf);
+	test_KErrNone(r);
+	r = File.Flush();
+	test_KErrNone(r);
+	File.Close();
+
+	CFileMan* fman = NULL;
+	TRAP(r, fman = CFileMan::NewL(TheFs));
+	test_KErrNone(r);
+
+	TUint initTicks = User::FastCounter();
+	r = fman->Copy(KSrc, KDst, CFileMan::EOverWrite);
+	TUint finalTicks = User::FastCounter();
+	test_KErrNone(r);
+	TReal serverRate = CopyRate(KMaxFileSize, initTicks, finalTicks);
+	delete fman;
+
+	// check the copy once
+	r = File.Open(TheFs, KDst, EFileRead);
+	test_KErrNone(r);
+	r = File.Read(DataBuf);
+	test_KErrNone(r);
+	test_Equal(KMaxFileSize, DataBuf.Length());
+	for (TInt j = 0; j < DataBuf.Length(); j++)
+		test(DataBuf[j] == j % 256);
+	File.Close();
+
+	initTicks = User::FastCounter();
+	r = File.Open(TheFs, KSrc, EFileRead);
+	test_KErrNone(r);
+	r = File2.Replace(TheFs, KDst, EFileWrite);
+	test_KErrNone(r);
+	TInt size = 0;
+	r = File.Size(size);
+	test_KErrNone(r);
+	r = File2.SetSize(size);
+	test_KErrNone(r);
+	for (TInt pos = 0; pos < size; pos += KClientBlockSize)
+		{
+		r = File.Read(pos, DataBuf, KClientBlockSize);
+		test_KErrNone(r);
+		r = File2.Write(pos, DataBuf);
+		test_KErrNone(r);
+		}
+	r = File2.Flush();
+	test_KErrNone(r);
+	File2.Close();
+	File.Close();
+	finalTicks = User::FastCounter();
+	TReal clientRate = CopyRate(KMaxFileSize, initTicks, finalTicks);
+
+	test.Printf(_L("Copy %7d bytes:\t%11.3f KBytes/s in the file server, %11.3f KBytes/s through the client\n"),
+				KMaxFileSize, serverRate, clientRate);
+
+	r = TheFs.Delete(KDst);
+	test_KErrNone(r);
+	r = TheFs.Delete(KSrc);
+	test_KErrNone(r);
+	}
+
+
 static void TestFileSeek()
 //
 // Benchmark file seek method
@@ -1390,6 +1476,8 @@ GLDEF_C void CallTestsL(void)
 
 	TestFileWriteCPU(gMisalignedReadWrites);
 
+	TestFileCopy();
+
 	TestFileDelete();
 
 //	TestDirRead();
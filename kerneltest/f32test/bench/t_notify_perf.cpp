@@ -216,6 +216,12 @@ LOCAL_C void SingleFileSessionTestL(TInt aNum, TBool aRunPlugin)
 	testcase.SetTestSetting(setting);
 	testcase.RunTestCaseL();
 
+	test.Next(_L("Files, Single file session, enhanced notification - with many idle watchers"));
+	ClearTestPathL();
+	setting.iOption = (EEnhanced|EReportChg|EBigBuffer|EManyWatchers);
+	testcase.SetTestSetting(setting);
+	testcase.RunTestCaseL();
+
 	// ------------------------- Directories -------------------------
 	test.Next(_L("Dirs, Single file session, enhanced notification"));
 	ClearTestPathL();
@@ -74,7 +74,10 @@ enum TTestOptions
 	// and some are same on each clients, only support upto 4 clients - 5th bit
 	EMultiNoti2	= 0x0100,
 	
-	ENotPerfTestReserved6	= 0x0200, 
+	// Enhanced Notification Only!
+	// Set up a large number of other watchers, with filters on paths that the test doesn't change - 6th bit
+	EManyWatchers	= 0x0200,
+	
 	ENotPerfTestReserved7	= 0x0400, 
 	ENotPerfTestReserved8	= 0x0800, 
 	
@@ -151,6 +154,9 @@ const TInt KMaxHeapSize = 0x1000000;
 // used by SafeCheck
 const TInt KNoThreadId = -1;
 
+// number of idle watchers set up with EManyWatchers
+const TInt KNumIdleWatchers = 1024;
+
 // a Controllor of whether measure time and write loggs;
 extern TBool gPerfMeasure;
 
@@ -362,6 +368,8 @@ private:
 	TBool CompareEntry(const TEntry& aEntry1, const TEntry& aEntry2);
 	
 	void AddLotsOfFilters();
+	void AddIdleWatchersL();
+	void RemoveIdleWatchers();
 	
 	void RequestNotificationEnhanced();
 	void RequestNotificationOriginal();
@@ -390,6 +398,9 @@ private:
 	CTimerLogger* iLogger;
 	
 	CFsNotify* iNotify;
+	
+	RPointerArray<CFsNotify> iIdleWatchers;
+	TFixedArray<TRequestStatus, KNumIdleWatchers> iIdleStatus;
 	  
 	TMdsFSPStatusPckg iPluginStatusPkg;
     CMdsPluginControl iPlugin;	
@@ -222,6 +222,11 @@ TInt CTimerLogger::LogSettingDescription(const TInt aNumFile, const TInt aNumCli
 		buf.Append(_L(", 100 Filters"));
 		}
 	
+	if (aOption & EManyWatchers)
+		{
+		buf.AppendFormat(_L(", %d Idle Watchers"), KNumIdleWatchers);
+		}
+	
 	if (aOption & EReportChg)
 		{
 		buf.Append(_L(", Change Reporting"));
@@ -1193,6 +1198,7 @@ CNotifyWatcher::~CNotifyWatcher()
 	{
 	Cancel();
 	delete iNotify;
+	RemoveIdleWatchers();
 
     iFs.DismountPlugin(KPluginName);
     iFs.RemovePlugin(KPluginName);
@@ -1228,6 +1234,11 @@ void CNotifyWatcher::ConstructL()
 			bufferSize = KMinNotificationBufferSize;
 		
 		iNotify = CFsNotify::NewL(iFs, bufferSize);
+		
+		if (iOption & EManyWatchers)
+			{
+			AddIdleWatchersL();
+			}
 		}
 	else
 		iNotify = NULL;
@@ -1373,6 +1384,38 @@ void CNotifyWatcher::AddLotsOfFilters()
 		}
 	}
 
+// set up watchers on directories which the test doesn't touch, so that each change made by
+// the test has to be checked against a large number of filters that don't match it
+void CNotifyWatcher::AddIdleWatchersL()
+	{
+	for (TInt i = 0; i < KNumIdleWatchers; i++)
+		{
+		CFsNotify* notify = CFsNotify::NewL(iFs, KMinNotificationBufferSize);
+		CleanupStack::PushL(notify);
+		iIdleWatchers.AppendL(notify);
+		CleanupStack::Pop(notify);
+		
+		TFileName path;
+		path.Copy(gTestPath);
+		path.AppendFormat(_L("Idle%04d\\"), i);
+		TInt r = notify->AddNotification((TUint)TFsNotification::EAllOps, path, _L("*"));
+		SAFETEST2(r, KErrNone, (iOption & KNotifyTreadIdMask));
+		r = notify->RequestNotifications(iIdleStatus[i]);
+		SAFETEST2(r, KErrNone, (iOption & KNotifyTreadIdMask));
+		}
+	}
+
+void CNotifyWatcher::RemoveIdleWatchers()
+	{
+	TInt count = iIdleWatchers.Count();
+	for (TInt i = 0; i < count; i++)
+		{
+		iIdleWatchers[i]->CancelNotifications(iIdleStatus[i]);
+		User::WaitForRequest(iIdleStatus[i]);
+		}
+	iIdleWatchers.ResetAndDestroy();
+	}
+
 void CNotifyWatcher::RequestNotification()
 	{
 	switch (iOption & KNotifyOptionMask)
@@ -0,0 +1,220 @@
+// Copyright (c) 2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of the License "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+// f32test\loader\t_ldrcache.cpp
+// Overview:
+// Test the loader cache snapshot, \sys\ldrcache.dat on the system drive.
+// API Information:
+// RLoader::DebugFunction (ELoaderDebug_SaveCacheSnapshot, ELoaderDebug_ReloadCacheSnapshot)
+// Details:
+// - Save the snapshot and check it is accepted when read back.
+// - Corrupt a byte of it, truncate it and change its version, and check each
+// is rejected.
+// - Load a DLL from c:\sys\bin, save the snapshot, then replace the DLL with
+// one of the same name and size but a different UID3 and a modification time
+// which differs only in its high word. Check the new DLL's UIDs are used and
+// not the ones saved in the snapshot.
+// Platforms/Drives/Compatibility:
+// Debug builds of the file server only; the test does nothing on release builds.
+// Assumptions/Requirement/Pre-requisites:
+// t_ldrcache_dlla.dll and t_ldrcache_dllb.dll are in z:\sys\bin as non-XIP images.
+// Failures and causes:
+// Base Port information:
+//
+//
+
+#define __E32TEST_EXTENSION__
+
+#include <e32test.h>
+#include <e32svr.h>
+#include <f32file.h>
+#include <f32dbg.h>
+
+LOCAL_D RTest test(_L("T_LDRCACHE"));
+LOCAL_D RFs TheFs;
+
+_LIT(KSnapshotFile, "?:\\sys\\ldrcache.dat");
+_LIT(KDllA, "z:\\sys\\bin\\t_ldrcache_dlla.dll");
+_LIT(KDllB, "z:\\sys\\bin\\t_ldrcache_dllb.dll");
+_LIT(KTestDll, "c:\\sys\\bin\\t_ldrcache.dll");
+const TUid KUidDllA = {0x00004ca1};
+const TUid KUidDllB = {0x00004ca2};
+
+// snapshot header fields
+const TInt KVersionOffset = 4;
+const TInt KHeaderSize = 24;
+
+LOCAL_D TFileName SnapshotName;
+
+LOCAL_C TInt LoaderDebug(TInt aFunction)
+	{
+	RLoader l;
+	test_KErrNone(l.Connect());
+	TInt r = l.DebugFunction(aFunction, 0, 0, 0);
+	l.Close();
+	return r;
+	}
+
+LOCAL_C void SaveSnapshot()
+	{
+	test_KErrNone(LoaderDebug(ELoaderDebug_SaveCacheSnapshot));
+	}
+
+LOCAL_C TInt ReloadSnapshot()
+	{
+	return LoaderDebug(ELoaderDebug_ReloadCacheSnapshot);
+	}
+
+LOCAL_C TInt SnapshotSize()
+	{
+	TEntry e;
+	test_KErrNone(TheFs.Entry(SnapshotName, e));
+	return e.iSize;
+	}
+
+LOCAL_C void PatchSnapshot(TInt aPos, TUint8 aXor)
+	{
+	RFile f;
+	test_KErrNone(f.Open(TheFs, SnapshotName, EFileWrite));
+	TBuf8<1> b;
+	test_KErrNone(f.Read(aPos, b, 1));
+	test_Equal(1, b.Length());
+	b[0] ^= aXor;
+	test_KErrNone(f.Write(aPos, b));
+	f.Close();
+	}
+
+LOCAL_C void TruncateSnapshot(TInt aSize)
+	{
+	RFile f;
+	test_KErrNone(f.Open(TheFs, SnapshotName, EFileWrite));
+	test_KErrNone(f.SetSize(aSize));
+	f.Close();
+	}
+
+LOCAL_C void TestRejected()
+	{
+	test.Next(_L("A saved snapshot is accepted"));
+	SaveSnapshot();
+	test_KErrNone(ReloadSnapshot());
+	TInt size = SnapshotSize();
+	test_Compare(size, >, KHeaderSize);
+
+	test.Next(_L("A corrupt snapshot is rejected"));
+	PatchSnapshot(KHeaderSize + (size - KHeaderSize) / 2, 0x5a);
+	test_Equal(KErrCorrupt, ReloadSnapshot());
+	SaveSnapshot();
+	PatchSnapshot(size - 1, 0x01);
+	test_Equal(KErrCorrupt, ReloadSnapshot());
+
+	test.Next(_L("A truncated snapshot is rejected"));
+	SaveSnapshot();
+	TruncateSnapshot(size - 4);
+	test_Equal(KErrCorrupt, ReloadSnapshot());
+	SaveSnapshot();
+	TruncateSnapshot(KHeaderSize / 2);
+	test_Equal(KErrCorrupt, ReloadSnapshot());
+
+	test.Next(_L("A snapshot with another version is rejected"));
+	SaveSnapshot();
+	PatchSnapshot(KVersionOffset, 0x01);
+	test_Equal(KErrCorrupt, ReloadSnapshot());
+
+	SaveSnapshot();
+	test_KErrNone(ReloadSnapshot());
+	}
+
+LOCAL_C TInt CopyDll(const TDesC& aSource, const TTime& aModified)
+	{
+	RFile src;
+	test_KErrNone(src.Open(TheFs, aSource, EFileRead|EFileShareReadersOnly));
+	TInt size;
+	test_KErrNone(src.Size(size));
+	HBufC8* buf = HBufC8::New(size);
+	test_NotNull(buf);
+	TPtr8 p(buf->Des());
+	test_KErrNone(src.Read(p));
+	src.Close();
+
+	RFile dest;
+	test_KErrNone(dest.Replace(TheFs, KTestDll, EFileWrite));
+	test_KErrNone(dest.Write(p));
+	test_KErrNone(dest.Flush());
+	dest.Close();
+	delete buf;
+	test_KErrNone(TheFs.SetModified(KTestDll, aModified));
+	return size;
+	}
+
+LOCAL_C TInt LoadTestDll(TUid aUid3)
+	{
+	RLibrary lib;
+	TInt r = lib.Load(KTestDll, TUidType(KDynamicLibraryUid, KNullUid, aUid3));
+	if (r == KErrNone)
+		{
+		test(lib.Type()[2] == aUid3);
+		lib.Close();
+
+		// make sure the code segment is gone before the file is replaced
+		RLoader l;
+		test_KErrNone(l.Connect());
+		l.CancelLazyDllUnload();
+		l.Close();
+		}
+	return r;
+	}
+
+LOCAL_C void TestReplacedDll()
+	{
+	test.Next(_L("A replaced DLL is not served from the snapshot"));
+	TheFs.MkDirAll(KTestDll);
+	TTime modified;
+	modified.UniversalTime();
+	TInt sizeA = CopyDll(KDllA, modified);
+	test_KErrNone(LoadTestDll(KUidDllA));
+	SaveSnapshot();
+
+	// only the high word of the modification time changes
+	TInt sizeB = CopyDll(KDllB, modified + TTimeIntervalMicroSeconds(MAKE_TINT64(1, 0)));
+	if (sizeA != sizeB)
+		test.Printf(_L("DLL sizes differ (%d, %d), so the time isn't what tells them apart\n"), sizeA, sizeB);
+	test_KErrNone(ReloadSnapshot());
+	test_KErrNone(LoadTestDll(KUidDllB));
+	test_Equal(KErrNotFound, LoadTestDll(KUidDllA));
+
+	test_KErrNone(TheFs.Delete(KTestDll));
+	}
+
+GLDEF_C TInt E32Main()
+	{
+	test.Title();
+	test.Start(_L("Loader cache snapshot"));
+	test_KErrNone(TheFs.Connect());
+	SnapshotName = KSnapshotFile;
+	SnapshotName[0] = (TText)RFs::GetSystemDriveChar();
+
+	TInt r = LoaderDebug(ELoaderDebug_SaveCacheSnapshot);
+	if (r == KErrNotSupported)
+		test.Printf(_L("Loader debug functions not supported, skipping test\n"));
+	else
+		{
+		test_KErrNone(r);
+		TestRejected();
+		TestReplacedDll();
+		SaveSnapshot();
+		}
+
+	TheFs.Close();
+	test.End();
+	return KErrNone;
+	}
@@ -0,0 +1,21 @@
+// Copyright (c) 2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of the License "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+// f32test\loader\t_ldrcache_dll.cpp
+// Built twice with different UID3s, so t_ldrcache can replace one with the other.
+//
+
+#include <e32std.h>
+
+// Dummy export because toolchain gives warning for DLLs without exports
+EXPORT_C void dummyExport() {}
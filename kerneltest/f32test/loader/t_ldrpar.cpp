@@ -0,0 +1,241 @@
+// Copyright (c) 2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of the License "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+// f32test\loader\t_ldrpar.cpp
+// Overview:
+// Test the loader loads the new dependencies of an image the same way whether or
+// not it shares them between several threads, and the loader's BTrace output.
+// API Information:
+// RLibrary, RBTrace (BTrace::ELoader)
+// Details:
+// - Load t_ldrpar_root.dll, which imports from four DLLs which aren't loaded, so the
+// loader loads them together, on several threads when there are spare CPUs. Read
+// the code segment ID the loader stamped into each DLL, unload them all and repeat.
+// Check the leaf DLLs are always numbered immediately after the root DLL, in the
+// same order each time.
+// - With the ELoader BTrace category enabled, check each load is traced as one
+// ELoaderImageTimes record for every image loaded into RAM, followed by an
+// ELoaderLoadDone record with the matching count, and that one of those loads was
+// t_ldrpar_root.dll and its four leaves.
+// Platforms/Drives/Compatibility:
+// Hardware only. The emulator loads DLLs through Windows, which doesn't number
+// code segments.
+// Assumptions/Requirement/Pre-requisites:
+// t_ldrpar_root.dll and t_ldrpar_dll0-3.dll are in z:\sys\bin as non-XIP images.
+// Failures and causes:
+// Base Port information:
+//
+//
+
+#define __E32TEST_EXTENSION__
+
+#include <e32test.h>
+#include <e32svr.h>
+#include <e32btrace.h>
+#include <d32btrace.h>
+#include <e32ldr.h>
+#include <e32ldr_private.h>
+#include <f32file.h>
+#include <f32image.h>
+#include "t_ldrpar.h"
+
+LOCAL_D RTest test(_L("T_LDRPAR"));
+
+_LIT(KRootDll, "t_ldrpar_root.dll");
+const TInt KLoadCount = 8;
+
+LOCAL_C TUint32 CodeSegId(TInt aEntryPoint)
+	{
+	return *(const TUint32*)(aEntryPoint + KCodeSegIdOffset);
+	}
+
+LOCAL_C void UnloadDlls()
+	{
+	RLoader l;
+	test_KErrNone(l.Connect());
+	l.CancelLazyDllUnload();
+	l.Close();
+	}
+
+LOCAL_C void LoadRoot(TInt* aOffsets)
+//
+// Load the root DLL and return the code segment IDs of the leaves relative to it
+//
+	{
+	RLibrary lib;
+	test_KErrNone(lib.Load(KRootDll));
+	TEntryPointsFn entryPoints = (TEntryPointsFn)lib.Lookup(1);
+	test_NotNull(entryPoints);
+	TInt entry[KNumDlls];
+	entryPoints(entry);
+	TUint32 root = CodeSegId(entry[0]);
+	test_Compare(root, !=, 0);
+	for (TInt i=0; i<KNumLeafDlls; ++i)
+		aOffsets[i] = CodeSegId(entry[i+1]) - root;
+	lib.Close();
+	UnloadDlls();
+	}
+
+LOCAL_C void TestOrder()
+	{
+	test.Next(_L("Dependencies are numbered in the same order on every load"));
+	TInt first[KNumLeafDlls];
+	LoadRoot(first);
+	TUint seen = 0;
+	TInt i;
+	for (i=0; i<KNumLeafDlls; ++i)
+		{
+		test.Printf(_L("t_ldrpar_dll%d.dll is root+%d\n"), i, first[i]);
+		test_Compare(first[i], >=, 1);
+		test_Compare(first[i], <=, KNumLeafDlls);
+		seen |= 1u << first[i];
+		}
+	// each leaf has its own ID, allocated while loading the root
+	test_Equal(((1u << KNumLeafDlls) - 1) << 1, seen);
+
+	for (TInt n=1; n<KLoadCount; ++n)
+		{
+		TInt offsets[KNumLeafDlls];
+		LoadRoot(offsets);
+		for (i=0; i<KNumLeafDlls; ++i)
+			test_Equal(first[i], offsets[i]);
+		}
+	}
+
+LOCAL_C TUint32 TraceWord(const TUint8*& aData)
+	{
+	TUint32 x = aData[0] | (aData[1] << 8) | (aData[2] << 16) | (aData[3] << 24);
+	aData += 4;
+	return x;
+	}
+
+LOCAL_C TInt CheckLoaderTrace(RBTrace& aTrace)
+//
+// Check the ELoader records in the trace buffer and return the number of loads of
+// exactly the root DLL and its leaves
+//
+	{
+	TInt rootLoads = 0;
+	TInt images = 0;
+	TUint32 handles[KNumDlls];
+	TUint8* data;
+	TInt size;
+	while ((size = aTrace.GetData(data)) > 0)
+		{
+		const TUint8* end = data + size;
+		while (data < end)
+			{
+			TUint8* record = data;
+			TUint8 recSize = record[BTrace::ESizeIndex];
+			TUint8 flags = record[BTrace::EFlagsIndex];
+			test_Equal(BTrace::ELoader, record[BTrace::ECategoryIndex]);
+			test_Equal(0, flags & (BTrace::ERecordTruncated | BTrace::EMissingRecord));
+			const TUint8* p = record + 4;
+			if (flags & BTrace::EHeader2Present)
+				p += 4;
+			if (flags & BTrace::ETimestampPresent)
+				p += 4;
+			if (flags & BTrace::ETimestamp2Present)
+				p += 4;
+			if (flags & BTrace::EContextIdPresent)
+				p += 4;
+			if (flags & BTrace::EPcPresent)
+				p += 4;
+			if (flags & BTrace::EExtraPresent)
+				p += 4;
+			TUint32 handle = TraceWord(p);
+			TUint32 total = TraceWord(p);
+			switch (record[BTrace::ESubCategoryIndex])
+				{
+			case BTrace::ELoaderImageTimes:
+				// after the search time, the read, decompress, relocate and fixup times
+				test_Equal(4 * 4, record + recSize - p);
+				test_Compare(handle, !=, 0);
+				if (images < KNumDlls)
+					handles[images] = handle;
+				++images;
+				break;
+
+			case BTrace::ELoaderLoadDone:
+				{
+				test_Equal(2 * 4, record + recSize - p);
+				TInt loaded = TraceWord(p);
+				TInt threads = TraceWord(p);
+				test.Printf(_L("load %08x took %u, %d images on %d threads\n"), handle, total, loaded, threads);
+				test_Equal(images, loaded);
+				test_Compare(threads, >=, 1);
+				test_Compare(threads, <=, Max(loaded, 1));
+				if (loaded == KNumDlls)
+					{
+					// the main image is one of those loaded
+					TInt i = 0;
+					while (i < KNumDlls && handles[i] != handle)
+						++i;
+					test_Compare(i, <, KNumDlls);
+					++rootLoads;
+					}
+				images = 0;
+				}
+				break;
+
+			default:
+				test(0);
+				}
+			data = BTrace::NextRecord(record);
+			}
+		aTrace.DataUsed();
+		}
+	// every load is completed by its summary
+	test_Equal(0, images);
+	return rootLoads;
+	}
+
+LOCAL_C void TestTrace()
+	{
+	test.Next(_L("Loads are traced"));
+	RBTrace trace;
+	test_KErrNone(trace.Open());
+	test_KErrNone(trace.ResizeBuffer(0x10000));
+	TUint oldMode = trace.Mode();
+	TBool oldFilter = trace.SetFilter(BTrace::ELoader, ETrue);
+	trace.Empty();
+	trace.SetMode(RBTrace::EEnable);
+
+	TInt offsets[KNumLeafDlls];
+	LoadRoot(offsets);
+
+	trace.SetMode(0);
+	trace.SetFilter(BTrace::ELoader, oldFilter);
+	test_Compare(CheckLoaderTrace(trace), >=, 1);
+	trace.SetMode(oldMode);
+	trace.Close();
+	}
+
+GLDEF_C TInt E32Main()
+	{
+	test.Title();
+	test.Start(_L("Parallel loading of dependencies"));
+
+#ifdef __WINS__
+	test.Printf(_L("Not supported on the emulator, skipping test\n"));
+#else
+	test.Printf(_L("%d CPUs\n"), UserSvr::HalFunction(EHalGroupKernel, EKernelHalNumLogicalCpus, 0, 0));
+	// make sure none of the DLLs are still loaded from a previous run
+	UnloadDlls();
+	TestOrder();
+	TestTrace();
+#endif
+
+	test.End();
+	return KErrNone;
+	}
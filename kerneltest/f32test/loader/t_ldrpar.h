@@ -0,0 +1,38 @@
+// Copyright (c) 2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of the License "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+// f32test\loader\t_ldrpar.h
+// 
+//
+
+#ifndef __T_LDRPAR_H__
+#define __T_LDRPAR_H__
+
+#include <e32std.h>
+
+// t_ldrpar_root.dll and the leaf DLLs it imports from
+const TInt KNumLeafDlls = 4;
+const TInt KNumDlls = KNumLeafDlls + 1;
+
+#define LEAF_ENTRY_POINT_(n)	LeafEntryPoint##n
+#define LEAF_ENTRY_POINT(n)		LEAF_ENTRY_POINT_(n)
+
+IMPORT_C TInt LeafEntryPoint0();
+IMPORT_C TInt LeafEntryPoint1();
+IMPORT_C TInt LeafEntryPoint2();
+IMPORT_C TInt LeafEntryPoint3();
+
+// t_ldrpar_root.dll's only export, at ordinal 1
+typedef void (*TEntryPointsFn)(TInt* aEntryPoints);
+
+#endif
@@ -0,0 +1,27 @@
+// Copyright (c) 2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of the License "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+// f32test\loader\t_ldrpar_dll.cpp
+// Built four times as the leaves of t_ldrpar_root.dll, with T_LDRPAR_LEAF set to 0-3
+// so each has its own export.
+//
+
+#include <e32std.h>
+#include "t_ldrpar.h"
+
+extern "C" TInt _E32Dll(TInt);
+
+EXPORT_C TInt LEAF_ENTRY_POINT(T_LDRPAR_LEAF)()
+	{
+	return (TInt)&_E32Dll;
+	}
@@ -0,0 +1,30 @@
+// Copyright (c) 2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of the License "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+// f32test\loader\t_ldrpar_root.cpp
+// Imports from each of the t_ldrpar leaf DLLs, so they are all loaded with it.
+//
+
+#include <e32std.h>
+#include "t_ldrpar.h"
+
+extern "C" TInt _E32Dll(TInt);
+
+EXPORT_C void EntryPoints(TInt* aEntryPoints)
+	{
+	aEntryPoints[0] = (TInt)&_E32Dll;
+	aEntryPoints[1] = LEAF_ENTRY_POINT(0)();
+	aEntryPoints[2] = LEAF_ENTRY_POINT(1)();
+	aEntryPoints[3] = LEAF_ENTRY_POINT(2)();
+	aEntryPoints[4] = LEAF_ENTRY_POINT(3)();
+	}
@@ -19,6 +19,7 @@
 #include <e32std_private.h>
 #include <e32test.h>
 #include <f32file.h>
+#include <f32dbg.h>
 #include "utl.h"
 #include "randgen.h"
 
@@ -481,6 +482,64 @@ LOCAL_C void TestStreamReadL(TInt aDriveToTest)
 		}
 	}
 
+LOCAL_C void TestSequentialReadL(TInt aDriveToTest)
+	//
+	// Reads a file sequentially in small pieces, bypassing the file server's
+	// file cache so the reads go through the ROFS data cache, and checks the
+	// cache counters show them being served from the cache
+	//
+	{
+	test.Next( _L("Testing small sequential reads through the data cache") );
+
+	TPckgBuf<TRofsCacheInfo> before;
+	TInt r = TheFs.ControlIo( aDriveToTest, KControlIoRofsCacheInfo, before );
+	TEST_FOR_ERROR( r );
+	test.Printf( _L("Cache of %d segments of %d bytes, prefetching %d"),
+		before().iSegmentCount, before().iSegmentSize, before().iPrefetchSegments );
+
+	TFileName name(KDriveBase);
+	name[0] = TText('A' + aDriveToTest);
+	name.Append( KRandomReadFile );
+	RFile file;
+	r = file.Open( TheFs, name, EFileRead | EFileReadDirectIO );
+	TEST_FOR_ERROR( r );
+
+	TRandomGenerator rand;
+	rand.SetSeed( KRandomReadFileSeed );
+	FillRandomBuffer( gFileBuffer, rand, KRandomReadFileSize );
+
+	const TInt KReadLen = 256;
+	TBuf8<KReadLen> buf;
+	TInt pos = 0;
+	FOREVER
+		{
+		r = file.Read( buf );
+		TEST_FOR_ERROR( r );
+		if( buf.Length() == 0 )
+			{
+			break;
+			}
+		test( 0 == Mem::Compare( gFileBuffer.Ptr() + pos, buf.Length(), buf.Ptr(), buf.Length() ) );
+		pos += buf.Length();
+		}
+	TEST_FOR_MATCH( pos, KRandomReadFileSize );
+	file.Close();
+
+	TPckgBuf<TRofsCacheInfo> after;
+	r = TheFs.ControlIo( aDriveToTest, KControlIoRofsCacheInfo, after );
+	TEST_FOR_ERROR( r );
+	test.Printf( _L("Hits %u, misses %u, evictions %u, prefetched %u"),
+		after().iHits - before().iHits, after().iMisses - before().iMisses,
+		after().iEvictions - before().iEvictions, after().iPrefetched - before().iPrefetched );
+
+	// Each segment holds several reads, so most should be hits
+	test( after().iHits - before().iHits > after().iMisses - before().iMisses );
+	if( after().iPrefetchSegments > 1 )
+		{
+		test( after().iPrefetched > before().iPrefetched );
+		}
+	}
+
 //************************
 // Entry point
 
@@ -517,6 +576,7 @@ void DoTestL(TInt aDriveToTest)
 	TestRandomSeekL(aDriveToTest);
 	TestEofReadL(aDriveToTest);
 	TestStreamReadL(aDriveToTest);
+	TestSequentialReadL(aDriveToTest);
 
 	test.End();
 	}
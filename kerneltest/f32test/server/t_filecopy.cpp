@@ -0,0 +1,449 @@
+// Copyright (c) 2009 Nokia Corporation and/or its subsidiary(-ies).
+// All rights reserved.
+// This component and the accompanying materials are made available
+// under the terms of the License "Eclipse Public License v1.0"
+// which accompanies this distribution, and is available
+// at the URL "http://www.eclipse.org/legal/epl-v10.html".
+//
+// Initial Contributors:
+// Nokia Corporation - initial contribution.
+//
+// Contributors:
+//
+// Description:
+// f32test\server\t_filecopy.cpp
+// Overview:
+// Test copying inside the file server with RFile::CopyFrom().
+// API Information:
+// RFile::CopyFrom, CFileMan::Copy
+// Details:
+// - Copy a file larger than the server's buffers and check the data.
+// - Check copying a file onto itself fails with KErrArgument.
+// - Check a locked region of the source or target fails with KErrLocked.
+// - Check a target opened for reading fails with KErrAccessDenied.
+// - Check a copy is cut short at the end of the source, and copies nothing
+// from beyond it.
+// - Copy to a file on another drive.
+// - Check files in different sessions, or a plugin which intercepts reads and
+// writes, give KErrNotSupported and that CFileMan still copies the file.
+// Platforms/Drives/Compatibility:
+// All.
+// Assumptions/Requirement/Pre-requisites:
+// Failures and causes:
+// Base Port information:
+//
+//
+
+#define __E32TEST_EXTENSION__
+#include <f32file.h>
+#include <e32test.h>
+#include "t_server.h"
+
+GLDEF_D RTest test(_L("T_FILECOPY"));
+
+_LIT(KSrcName, "SRC.BIN");
+_LIT(KDstName, "DST.BIN");
+_LIT(KCopyName, "COPY.BIN");
+_LIT(KObserverPluginFileName, "observer_plugin");
+_LIT(KObserverPluginName, "ObserverPlugin");
+
+// larger than the server's two 256K buffers, so each is used more than once
+const TInt KFileSize = 600 * 1024 + 123;
+const TInt KBlockSize = 4096;
+
+LOCAL_D TBool gServerCopy;
+
+LOCAL_C TUint8 Pattern(TInt aPos)
+	{
+	return (TUint8) (aPos * 7 + (aPos >> 8));
+	}
+
+LOCAL_C void MakePatternFile(const TDesC& aName, TInt aSize)
+	{
+	RFile f;
+	TInt r = f.Replace(TheFs, aName, EFileWrite);
+	test_KErrNone(r);
+	TBuf8<KBlockSize> buf;
+	for (TInt pos = 0; pos < aSize; pos += buf.Length())
+		{
+		buf.SetLength(Min(KBlockSize, aSize - pos));
+		for (TInt i = 0; i < buf.Length(); ++i)
+			buf[i] = Pattern(pos + i);
+		test_KErrNone(f.Write(buf));
+		}
+	f.Close();
+	}
+
+// Check aLength bytes at aPos in aFile are the source's bytes from aSrcPos
+LOCAL_C void CheckPattern(RFile& aFile, TInt aPos, TInt aSrcPos, TInt aLength)
+	{
+	TBuf8<KBlockSize> buf;
+	for (TInt done = 0; done < aLength; done += buf.Length())
+		{
+		TInt r = aFile.Read(aPos + done, buf, Min(KBlockSize, aLength - done));
+		test_KErrNone(r);
+		test_Equal(Min(KBlockSize, aLength - done), buf.Length());
+		for (TInt i = 0; i < buf.Length(); ++i)
+			test_Equal(Pattern(aSrcPos + done + i), buf[i]);
+		}
+	}
+
+LOCAL_C void CheckPatternFile(const TDesC& aName, TInt aSize)
+	{
+	RFile f;
+	TInt r = f.Open(TheFs, aName, EFileRead);
+	test_KErrNone(r);
+	TInt size;
+	test_KErrNone(f.Size(size));
+	test_Equal(aSize, size);
+	CheckPattern(f, 0, 0, aSize);
+	f.Close();
+	}
+
+LOCAL_C void OpenFiles(RFile& aSrc, RFile& aDst)
+	{
+	TInt r = aSrc.Open(TheFs, KSrcName, EFileRead | EFileShareAny);
+	test_KErrNone(r);
+	r = aDst.Replace(TheFs, KDstName, EFileWrite | EFileShareAny);
+	test_KErrNone(r);
+	}
+
+LOCAL_C void TestCopy()
+	{
+	RFile src, dst;
+	OpenFiles(src, dst);
+	TInt copied = -1;
+	TInt r = dst.CopyFrom(src, 0, 0, KFileSize, copied);
+	if (r == KErrNotSupported)
+		{
+		test.Printf(_L("Drive can't copy inside the file server\n"));
+		test_Equal(0, copied);
+		dst.Close();
+		src.Close();
+		return;
+		}
+	test_KErrNone(r);
+	test_Equal(KFileSize, copied);
+	gServerCopy = ETrue;
+
+	// the file positions don't move
+	TInt64 pos = 0;
+	test_KErrNone(src.Seek(ESeekCurrent, pos));
+	test_Equal(0, (TInt) pos);
+	test_KErrNone(dst.Seek(ESeekCurrent, pos));
+	test_Equal(0, (TInt) pos);
+
+	// a copy into the middle of the target overwrites what is there
+	r = dst.CopyFrom(src, 1000, 5000, 10000, copied);
+	test_KErrNone(r);
+	test_Equal(10000, copied);
+	CheckPattern(dst, 0, 0, 5000);
+	CheckPattern(dst, 5000, 1000, 10000);
+	CheckPattern(dst, 15000, 15000, KFileSize - 15000);
+
+	// a target position beyond the end of the target appends
+	test_KErrNone(dst.SetSize(100));
+	r = dst.CopyFrom(src, 0, 1000, 200, copied);
+	test_KErrNone(r);
+	test_Equal(200, copied);
+	TInt size;
+	test_KErrNone(dst.Size(size));
+	test_Equal(300, size);
+	CheckPattern(dst, 100, 0, 200);
+
+	dst.Close();
+	src.Close();
+	}
+
+LOCAL_C void TestSameFile()
+	{
+	RFile src, dst;
+	OpenFiles(src, dst);
+	TInt copied = -1;
+	TInt r = src.CopyFrom(src, 0, 0, 100, copied);
+	test_Equal(KErrAccessDenied, r);	// not open for writing
+
+	// the same file through the same handle, and through a second handle
+	r = dst.CopyFrom(dst, 0, 10, 100, copied);
+	test_Equal(KErrArgument, r);
+	test_Equal(0, copied);
+	RFile dst2;
+	r = dst2.Open(TheFs, KDstName, EFileWrite | EFileShareAny);
+	test_KErrNone(r);
+	r = dst.CopyFrom(dst2, 0, 10, 100, copied);
+	test_Equal(KErrArgument, r);
+	dst2.Close();
+
+	dst.Close();
+	src.Close();
+	}
+
+LOCAL_C void TestLocked()
+	{
+	RFile src, dst, other;
+	OpenFiles(src, dst);
+	test_KErrNone(dst.SetSize(KFileSize));
+	TInt copied = -1;
+
+	// a region of the source locked through another handle
+	TInt r = other.Open(TheFs, KSrcName, EFileRead | EFileShareAny);
+	test_KErrNone(r);
+	test_KErrNone(other.Lock(2000, 100));
+	r = dst.CopyFrom(src, 0, 0, 4096, copied);
+	test_Equal(KErrLocked, r);
+	test_Equal(0, copied);
+	r = dst.CopyFrom(src, 2100, 0, 4096, copied);
+	test_KErrNone(r);
+	test_Equal(4096, copied);
+	test_KErrNone(other.UnLock(2000, 100));
+	other.Close();
+
+	// a region of the target locked through another handle
+	r = other.Open(TheFs, KDstName, EFileWrite | EFileShareAny);
+	test_KErrNone(r);
+	test_KErrNone(other.Lock(8192, 1));
+	r = dst.CopyFrom(src, 0, 4096, 4097, copied);
+	test_Equal(KErrLocked, r);
+	r = dst.CopyFrom(src, 0, 4096, 4096, copied);
+	test_KErrNone(r);
+	test_Equal(4096, copied);
+	test_KErrNone(other.UnLock(8192, 1));
+	other.Close();
+
+	dst.Close();
+	src.Close();
+	}
+
+LOCAL_C void TestReadOnlyTarget()
+	{
+	test_KErrNone(TheFs.Delete(KDstName));
+	MakePatternFile(KDstName, 10);
+	RFile src, dst;
+	TInt r = src.Open(TheFs, KSrcName, EFileRead | EFileShareAny);
+	test_KErrNone(r);
+	r = dst.Open(TheFs, KDstName, EFileRead | EFileShareAny);
+	test_KErrNone(r);
+	TInt copied = -1;
+	r = dst.CopyFrom(src, 0, 0, 100, copied);
+	test_Equal(KErrAccessDenied, r);
+	test_Equal(0, copied);
+	dst.Close();
+	src.Close();
+
+	// a target shared with readers only can't be written either
+	r = src.Open(TheFs, KSrcName, EFileRead | EFileShareAny);
+	test_KErrNone(r);
+	r = dst.Open(TheFs, KDstName, EFileRead | EFileShareReadersOnly);
+	test_KErrNone(r);
+	r = dst.CopyFrom(src, 0, 0, 100, copied);
+	test_Equal(KErrAccessDenied, r);
+	dst.Close();
+	src.Close();
+	}
+
+LOCAL_C void TestPastEof()
+	{
+	RFile src, dst;
+	OpenFiles(src, dst);
+	TInt copied = -1;
+
+	// cut short at the end of the source
+	TInt r = dst.CopyFrom(src, KFileSize - 1000, 0, 5000, copied);
+	test_KErrNone(r);
+	test_Equal(1000, copied);
+	TInt size;
+	test_KErrNone(dst.Size(size));
+	test_Equal(1000, size);
+	CheckPattern(dst, 0, KFileSize - 1000, 1000);
+
+	// nothing at or beyond the end
+	r = dst.CopyFrom(src, KFileSize, 0, 5000, copied);
+	test_KErrNone(r);
+	test_Equal(0, copied);
+	r = dst.CopyFrom(src, KFileSize + 100000, 0, 5000, copied);
+	test_KErrNone(r);
+	test_Equal(0, copied);
+	test_KErrNone(dst.Size(size));
+	test_Equal(1000, size);
+
+	// a negative position or length is an error
+	r = dst.CopyFrom(src, -1, 0, 10, copied);
+	test_Equal(KErrArgument, r);
+	r = dst.CopyFrom(src, 0, 0, -1, copied);
+	test_Equal(KErrArgument, r);
+
+	dst.Close();
+	src.Close();
+	}
+
+LOCAL_C TBool GetOtherDrive(TDes& aPath)
+//
+// Find another writable drive and make a test directory on it
+//
+	{
+	TDriveList list;
+	test_KErrNone(TheFs.DriveList(list));
+	TInt thisDrive = CurrentDrive();
+	for (TInt drv = EDriveA; drv < EDriveZ; ++drv)
+		{
+		if (drv == thisDrive || list[drv] == 0)
+			continue;
+		TDriveInfo info;
+		if (TheFs.Drive(info, drv) != KErrNone || info.iType == EMediaNotPresent ||
+			(info.iMediaAtt & KMediaAttWriteProtected) || (info.iDriveAtt & KDriveAttRom))
+			continue;
+		TVolumeInfo vol;
+		if (TheFs.Volume(vol, drv) != KErrNone || vol.iFree < 4 * KFileSize)
+			continue;
+		aPath.Format(_L("%c:\\F32-TST\\TFILECOPY\\"), 'A' + drv);
+		TInt r = TheFs.MkDirAll(aPath);
+		if (r == KErrNone || r == KErrAlreadyExists)
+			return ETrue;
+		}
+	return EFalse;
+	}
+
+LOCAL_C void TestOtherDrive()
+	{
+	TFileName path;
+	if (!GetOtherDrive(path))
+		{
+		test.Printf(_L("No other writable drive\n"));
+		return;
+		}
+	TFileName name(path);
+	name.Append(KDstName);
+	test.Printf(_L("Copy to %S\n"), &name);
+
+	RFile src, dst;
+	TInt r = src.Open(TheFs, KSrcName, EFileRead | EFileShareAny);
+	test_KErrNone(r);
+	r = dst.Replace(TheFs, name, EFileWrite | EFileShareAny);
+	test_KErrNone(r);
+	TInt copied = -1;
+	r = dst.CopyFrom(src, 0, 0, KFileSize, copied);
+	if (r == KErrNotSupported)
+		test.Printf(_L("Drive can't copy inside the file server\n"));
+	else
+		{
+		test_KErrNone(r);
+		test_Equal(KFileSize, copied);
+		}
+	dst.Close();
+	src.Close();
+	if (r == KErrNone)
+		CheckPatternFile(name, KFileSize);
+
+	// CFileMan copies across drives either way
+	CFileMan* fileMan = CFileMan::NewL(TheFs);
+	r = fileMan->Copy(KSrcName, name, CFileMan::EOverWrite);
+	test_KErrNone(r);
+	delete fileMan;
+	CheckPatternFile(name, KFileSize);
+
+	test_KErrNone(TheFs.Delete(name));
+	TheFs.RmDir(path);
+	}
+
+LOCAL_C void TestFallback()
+	{
+	TInt copied = -1;
+	CFileMan* fileMan = CFileMan::NewL(TheFs);
+
+	// files in different sessions
+	RFs fs2;
+	test_KErrNone(fs2.Connect());
+	RFile src, dst;
+	TFileName name(gSessionPath);
+	name.Append(KSrcName);
+	TInt r = src.Open(fs2, name, EFileRead | EFileShareAny);
+	test_KErrNone(r);
+	r = dst.Replace(TheFs, KDstName, EFileWrite | EFileShareAny);
+	test_KErrNone(r);
+	r = dst.CopyFrom(src, 0, 0, KFileSize, copied);
+	test_Equal(KErrNotSupported, r);
+	test_Equal(0, copied);
+	dst.Close();
+	src.Close();
+	fs2.Close();
+
+	// a plugin which intercepts reads and writes must see the data, so the
+	// server leaves the copy to the client
+	r = TheFs.AddPlugin(KObserverPluginFileName);
+	if (r == KErrNotFound)
+		test.Printf(_L("Observer plugin not found\n"));
+	else
+		{
+		test_Value(r, r == KErrNone || r == KErrAlreadyExists);
+		r = TheFs.MountPlugin(KObserverPluginName);
+		test_Value(r, r == KErrNone || r == KErrNotSupported);
+		if (r == KErrNone)
+			{
+			OpenFiles(src, dst);
+			r = dst.CopyFrom(src, 0, 0, KFileSize, copied);
+			test_Equal(KErrNotSupported, r);
+			test_Equal(0, copied);
+			dst.Close();
+			src.Close();
+
+			r = fileMan->Copy(KSrcName, KCopyName, CFileMan::EOverWrite);
+			test_KErrNone(r);
+			CheckPatternFile(KCopyName, KFileSize);
+			test_KErrNone(TheFs.Delete(KCopyName));
+
+			test_KErrNone(TheFs.DismountPlugin(KObserverPluginName));
+			}
+		test_KErrNone(TheFs.RemovePlugin(KObserverPluginName));
+
+		// the server copies again once the plugin has gone
+		OpenFiles(src, dst);
+		r = dst.CopyFrom(src, 0, 0, KFileSize, copied);
+		test_Equal(gServerCopy ? KErrNone : KErrNotSupported, r);
+		dst.Close();
+		src.Close();
+		}
+
+	r = fileMan->Copy(KSrcName, KCopyName, CFileMan::EOverWrite);
+	test_KErrNone(r);
+	CheckPatternFile(KCopyName, KFileSize);
+	test_KErrNone(TheFs.Delete(KCopyName));
+
+	delete fileMan;
+	}
+
+GLDEF_C void CallTestsL()
+//
+// Do all tests
+//
+	{
+	CreateTestDirectory(_L("\\F32-TST\\TFILECOPY\\"));
+	MakePatternFile(KSrcName, KFileSize);
+
+	test.Next(_L("Copy inside the file server"));
+	TestCopy();
+
+	test.Next(_L("Source and target the same file"));
+	TestSameFile();
+
+	if (gServerCopy)
+		{
+		test.Next(_L("Locked regions"));
+		TestLocked();
+
+		test.Next(_L("Copying beyond the end of the source"));
+		TestPastEof();
+		}
+
+	test.Next(_L("Read only target"));
+	TestReadOnlyTarget();
+
+	test.Next(_L("Copy to another drive"));
+	TestOtherDrive();
+
+	test.Next(_L("Fall back to copying through the client"));
+	TestFallback();
+
+	test_KErrNone(TheFs.Delete(KSrcName));
+	test_KErrNone(TheFs.Delete(KDstName));
+	DeleteTestDirectory();
+	}
@@ -3775,6 +3775,284 @@ void TestExternalNotifications()
     safe_external_test(test,r,__LINE__,(TText*)Expand("t_notifier.cpp"));
     }
 
+_LIT(KIdxDir,":\\F32-TST\\T_NOTIFIER\\IDX\\");
+_LIT(KIdxMarker,"marker.idx");
+
+// Files created by TestIndexedFilters(), relative to KIdxDir, and the filters they match
+const TText* const KIdxFiles[] =
+	{
+	_S("A\\a.txt"),			// A\* *.txt
+	_S("A\\sub\\b.txt"),	// A\* *.txt
+	_S("A\\c.dat"),			// none
+	_S("B\\c.txt"),			// ?:\F32-TST\T_NOTIFIER\IDX\B\ c.txt
+	_S("B\\e.log"),			// none
+	_S("C1\\d.txt"),		// C?\ *
+	_S("D\\f.txt"),			// *\IDX\D\ f.txt
+	_S("D\\sub\\f.txt"),	// none, the path doesn't end in *
+	_S("E\\idxname.log")	// no path, idxname.log
+	};
+const TInt KNumIdxFiles = sizeof(KIdxFiles)/sizeof(KIdxFiles[0]);
+
+void IdxName(TDes& aName, const TDesC& aRelative)
+	{
+	aName.Zero();
+	aName.Append((TChar)gDriveToTest);
+	aName.Append(KIdxDir);
+	aName.Append(aRelative);
+	}
+
+void CreateIdxFile(RFs& aFs, const TDesC& aRelative)
+	{
+	TFileName name;
+	IdxName(name,aRelative);
+	RFile file;
+	TInt r = file.Replace(aFs,name,EFileWrite);
+	test_KErrNone(r);
+	file.Close();
+	}
+
+void AddIdxFilter(CFsNotify* aNotify, const TDesC& aRelativePath, const TDesC& aFilename)
+	{
+	TFileName path;
+	IdxName(path,aRelativePath);
+	TInt r = aNotify->AddNotification((TUint)TFsNotification::ECreate,path,aFilename);
+	test_KErrNone(r);
+	}
+
+/*
+ * Reads aNotify's notifications until the one for the creation of the marker file.
+ * Returns a bitmask of the KIdxFiles reported before it.
+ */
+TUint CollectIdxNotifications(CFsNotify* aNotify, TRequestStatus& aStatus)
+	{
+	TFileName marker;
+	IdxName(marker,KIdxMarker);
+	TFileName name;
+	TUint seen = 0;
+	FOREVER
+		{
+		RTimer timer;
+		TInt r = timer.CreateLocal();
+		test_KErrNone(r);
+		TRequestStatus timeout;
+		TTimeIntervalMicroSeconds32 time = 10000000;    //10 seconds
+		timer.After(timeout,time);
+		User::WaitForRequest(timeout,aStatus);
+		test(aStatus.Int() != KRequestPending);
+		timer.Cancel();
+		User::WaitForRequest(timeout);
+		timer.Close();
+		test_KErrNone(aStatus.Int());
+		
+		TBool found = EFalse;
+		const TFsNotification* notification;
+		while(notification = aNotify->NextNotification(), notification != NULL)
+			{
+			TPtrC path;
+			r = notification->Path(path);
+			test_KErrNone(r);
+			if(path.CompareF(marker) == 0)
+				{
+				found = ETrue;
+				continue;
+				}
+			TInt i;
+			for(i = 0; i < KNumIdxFiles; ++i)
+				{
+				IdxName(name,TPtrC(KIdxFiles[i]));
+				if(path.CompareF(name) == 0)
+					break;
+				}
+			if(i == KNumIdxFiles)
+				test.Printf(_L("Unexpected notification for %S\n"),&path);
+			test(i < KNumIdxFiles);
+			seen |= 1 << i;
+			}
+		
+		r = aNotify->RequestNotifications(aStatus);
+		test_KErrNone(r);
+		if(found)
+			return seen;
+		}
+	}
+
+/*
+ * Filters are indexed by the directories in their paths up to the first wildcard.
+ * Check filters with wildcards at various places in the path and filename,
+ * filters for any drive and without a path, and filters which are removed and added
+ * after the index has been built.
+ */
+void TestIndexedFilters()
+	{
+	test.Next(_L("TestIndexedFilters"));
+	RFs fs;
+	TInt r = fs.Connect();
+	test_KErrNone(r);
+	
+	//Create the directories first, so only the files are reported
+	TFileName name;
+	TInt i;
+	for(i = 0; i < KNumIdxFiles; ++i)
+		{
+		IdxName(name,TPtrC(KIdxFiles[i]));
+		r = fs.MkDirAll(name);
+		test_Value(r, r == KErrNone || r == KErrAlreadyExists);
+		}
+	
+	CFsNotify* notify1 = NULL;
+	TRAP(r,notify1 = CFsNotify::NewL(fs,KMinNotificationBufferSize*8));
+	test_KErrNone(r);
+	AddIdxFilter(notify1,KNullDesC,KIdxMarker);
+	AddIdxFilter(notify1,_L("A\\*"),_L("*.txt"));
+	AddIdxFilter(notify1,_L("C?\\"),_L("*"));
+	IdxName(name,_L("B\\"));
+	name[0] = '?';
+	r = notify1->AddNotification((TUint)TFsNotification::ECreate,name,_L("c.txt"));
+	test_KErrNone(r);
+	r = notify1->AddNotification((TUint)TFsNotification::ECreate,_L("*\\IDX\\D\\"),_L("f.txt"));
+	test_KErrNone(r);
+	r = notify1->AddNotification((TUint)TFsNotification::ECreate,KNullDesC,_L("idxname.log"));
+	test_KErrNone(r);
+	TRequestStatus status1;
+	r = notify1->RequestNotifications(status1);
+	test_KErrNone(r);
+	
+	test.Printf(_L("Wildcard filters\n"));
+	for(i = 0; i < KNumIdxFiles; ++i)
+		CreateIdxFile(fs,TPtrC(KIdxFiles[i]));
+	CreateIdxFile(fs,KIdxMarker);
+	test_Equal(1<<0 | 1<<1 | 1<<3 | 1<<5 | 1<<6 | 1<<8, CollectIdxNotifications(notify1,status1));
+	
+	test.Printf(_L("Filters added after the index is built\n"));
+	CFsNotify* notify2 = NULL;
+	TRAP(r,notify2 = CFsNotify::NewL(fs,KMinNotificationBufferSize*8));
+	test_KErrNone(r);
+	AddIdxFilter(notify2,KNullDesC,KIdxMarker);
+	AddIdxFilter(notify2,_L("A\\"),_L("a.txt"));
+	TRequestStatus status2;
+	r = notify2->RequestNotifications(status2);
+	test_KErrNone(r);
+	CreateIdxFile(fs,TPtrC(KIdxFiles[0]));
+	CreateIdxFile(fs,KIdxMarker);
+	test_Equal(1<<0, CollectIdxNotifications(notify1,status1));
+	test_Equal(1<<0, CollectIdxNotifications(notify2,status2));
+	
+	test.Printf(_L("Filters removed and replaced\n"));
+	r = notify2->RemoveNotifications();
+	test_KErrNone(r);
+	AddIdxFilter(notify2,KNullDesC,KIdxMarker);
+	AddIdxFilter(notify2,_L("B\\"),_L("*"));
+	CreateIdxFile(fs,TPtrC(KIdxFiles[0]));
+	CreateIdxFile(fs,TPtrC(KIdxFiles[4]));
+	CreateIdxFile(fs,KIdxMarker);
+	test_Equal(1<<0, CollectIdxNotifications(notify1,status1));
+	test_Equal(1<<4, CollectIdxNotifications(notify2,status2));
+	
+	test.Printf(_L("Filters removed by deleting their CFsNotify\n"));
+	r = notify1->CancelNotifications(status1);
+	test_KErrNone(r);
+	User::WaitForRequest(status1);
+	delete notify1;
+	CreateIdxFile(fs,TPtrC(KIdxFiles[0]));
+	CreateIdxFile(fs,TPtrC(KIdxFiles[4]));
+	CreateIdxFile(fs,KIdxMarker);
+	test_Equal(1<<4, CollectIdxNotifications(notify2,status2));
+	
+	r = notify2->CancelNotifications(status2);
+	test_KErrNone(r);
+	User::WaitForRequest(status2);
+	delete notify2;
+	
+	CFileMan* fileMan = NULL;
+	TRAP(r,fileMan = CFileMan::NewL(fs));
+	test_KErrNone(r);
+	IdxName(name,KNullDesC);
+	r = fileMan->RmDir(name);
+	test_KErrNone(r);
+	delete fileMan;
+	fs.Close();
+	}
+
+/*
+ * A filter without a path only matches changes in data cages that its client can access.
+ * That applies to the new name of a rename as well as the old name.
+ * aProcessName is a t_notifier_caps process which watches for renames to cage.txt,
+ * aExpected is 1 if it should be told of a rename into \PRIVATE\01234567\, else 0.
+ */
+void TestRenameIntoDataCage(const TDesC& aProcessName, TInt aExpected)
+	{
+	test.Next(_L("TestRenameIntoDataCage"));
+	TBuf<40> path;
+	path.Append((TChar)gDriveToTest);
+	path.Append(_L(":\\F32-TST\\T_NOTIFIER\\"));
+	TBuf<40> cage;
+	cage.Append((TChar)gDriveToTest);
+	cage.Append(_L(":\\PRIVATE\\01234567\\"));
+	TInt r = TheFs.MkDirAll(path);
+	test_Value(r, r == KErrNone || r == KErrAlreadyExists);
+	r = TheFs.MkDirAll(cage);
+	test_Value(r, r == KErrNone || r == KErrAlreadyExists);
+	
+	TBuf<60> source1(path);
+	source1.Append(_L("cage_src1.txt"));
+	TBuf<60> source2(path);
+	source2.Append(_L("cage_src2.txt"));
+	TBuf<60> caged(cage);
+	caged.Append(_L("cage.txt"));
+	TBuf<60> uncaged(path);
+	uncaged.Append(_L("cage.txt"));
+	TheFs.Delete(caged);
+	TheFs.Delete(uncaged);
+	
+	RFile file;
+	r = file.Replace(TheFs,source1,EFileWrite);
+	test_KErrNone(r);
+	file.Close();
+	r = file.Replace(TheFs,source2,EFileWrite);
+	test_KErrNone(r);
+	file.Close();
+	
+	RProcess process;
+	TBuf<2> command;
+	command.Append((TChar)gDriveToTest);
+	command.Append('R');
+	r = process.Create(aProcessName,command,TUidType());
+	test_KErrNone(r);
+	TRequestStatus rendezvous;
+	TRequestStatus exit;
+	process.Rendezvous(rendezvous);
+	process.Logon(exit);
+	process.Resume();
+	User::WaitForRequest(rendezvous);
+	test_KErrNone(rendezvous.Int());
+	
+	//The watcher stops at the first rename it is told of
+	r = TheFs.Rename(source1,caged);
+	test_KErrNone(r);
+	r = TheFs.Rename(source2,uncaged);
+	test_KErrNone(r);
+	
+	RTimer timer;
+	r = timer.CreateLocal();
+	test_KErrNone(r);
+	TRequestStatus timeout;
+	TTimeIntervalMicroSeconds32 time = 10000000;    //10 seconds
+	timer.After(timeout,time);
+	User::WaitForRequest(timeout,exit);
+	test(exit.Int() != KRequestPending);
+	timer.Cancel();
+	User::WaitForRequest(timeout);
+	timer.Close();
+	test_Equal(EExitKill, process.ExitType());
+	test_Equal(aExpected, exit.Int());
+	process.Close();
+	
+	r = TheFs.Delete(caged);
+	test_KErrNone(r);
+	r = TheFs.Delete(uncaged);
+	test_KErrNone(r);
+	}
+
 /*
  * This test is testing the use cases
  * and for negative testing of SYMBIAN_F32_ENHANCED_CHANGE_NOTIFICATION
@@ -4598,6 +4876,16 @@ void CallTestsL()
 	test.Printf(_L("NegativeTests() I\n"));
 	NegativeTestDirStar();
 	test.Printf(_L("------- End of Negative Tests ----------------------------------------\n"));
+	//
+	// 6.	Add filters with wildcards in the path and filename, for any drive and without a path
+	//		Create files that do and don't match them
+	//		Add and remove filters, check the changes are seen
+	//
+	PrintLine();
+	__UHEAP_MARK;
+	TestIndexedFilters();
+	__UHEAP_MARKEND;
+	test.Printf(_L("------- End of Indexed Filter Tests ----------------------------------\n"));
 	
 	
     //=============================================================================
@@ -4667,6 +4955,13 @@ void CallTestsL()
 	test.Next(_L("Test T_NOTIFIER_BELONGS.EXE"));
 	r = TestProcessCapabilities(_L("T_NOTIFIER_BELONGS.EXE"));
 	test_KErrNone(r);
+	//
+	//	4.	Rename files into the private folder and then into a public one, using a filter
+	//		without a path in each of the processes
+	//
+	TestRenameIntoDataCage(_L("T_NOTIFIER_NOCAPS.EXE"),0); //Failure on emulator -> Did you forget to do a wintest?
+	TestRenameIntoDataCage(_L("T_NOTIFIER_ALLFILES.EXE"),1);
+	TestRenameIntoDataCage(_L("T_NOTIFIER_BELONGS.EXE"),1);
 	test.Printf(_L("------- End of Data-Caging Tests -------------------------------------\n"));
 	
 	PrintLine();
@@ -24,6 +24,37 @@
 const TInt KNotificationHeaderSize = (sizeof(TUint16)*2)+(sizeof(TUint));
 const TInt KMinNotificationBufferSize = 2*KNotificationHeaderSize + 2*KMaxFileName;
 
+/*
+ * Used by TestRenameIntoDataCage() in t_notifier.
+ * Watches for files being renamed to cage.txt in any directory. The test renames one
+ * into \PRIVATE\01234567\ and then one into a public directory.
+ * Returns 1 if the rename into the data cage was reported, 0 if the public one was reported first.
+ */
+TInt RenameWatcher(CFsNotify* aNotify)
+	{
+	TInt r = aNotify->AddNotification((TUint)TFsNotification::ERename,_L(""),_L("cage.txt"));
+	if(r != KErrNone)
+		return r;
+	
+	TRequestStatus status;
+	r = aNotify->RequestNotifications(status);
+	if(r != KErrNone)
+		return r;
+	RProcess::Rendezvous(KErrNone);
+	User::WaitForRequest(status);
+	if(status.Int() != KErrNone)
+		return status.Int();
+	
+	const TFsNotification* notification = aNotify->NextNotification();
+	if(notification == NULL)
+		return KErrNotFound;
+	TPtrC newName;
+	r = notification->NewName(newName);
+	if(r != KErrNone)
+		return r;
+	return newName.FindF(_L("\PRIVATE\")) != KErrNotFound ? 1 : 0;
+	}
+
 TInt E32Main()
 	{
 	TInt r = KErrNone;
@@ -38,6 +69,18 @@ TInt E32Main()
 	TRAP(r, notify = CFsNotify::NewL(fs,KMinNotificationBufferSize));
 	User::LeaveIfError(r);
 	
+	TBuf<2> command;
+	if(User::CommandLineLength() == command.MaxLength())
+		User::CommandLine(command);
+	if(command.Length() == 2 && command[1] == 'R')
+		{
+		r = RenameWatcher(notify);
+		delete notify;
+		delete cleanup;
+		fs.Close();
+		return r;
+		}
+	
 	TChar systemChar = fs.GetSystemDriveChar();
 	TBuf<40> path;
 	path.Append(systemChar);
@@ -184,6 +184,7 @@ enum TFsMessage
 	EFsNotificationAdd,			///< -- 140 Adds filter to the server, comprising a path and notification type
 	EFsNotificationRemove,		///< Removes filters from Server-Side
 	EFsLoadCodePage,			///< Loads a code page library
+	EFsFileCopy,				///< Copies data from another file without passing it through the client
 	EMaxClientOperations		///< This must always be the last operation insert above
 	};
 
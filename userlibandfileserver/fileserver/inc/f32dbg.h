@@ -348,10 +348,33 @@ public:
 
 #endif
 
+/**
+@internalTechnology
+
+ControlIo command for the ROFS file system. Writes a TPckgBuf<TRofsCacheInfo> to the
+third argument of RFs::ControlIo() describing the drive's data cache.
+Unlike the commands above this is supported in release builds.
+*/
+const TInt KControlIoRofsCacheInfo=KMaxTInt-31;
+
+class TRofsCacheInfo
+	{
+public:
+	TInt iSegmentSize;			// size of each cache segment, in bytes
+	TInt iSegmentCount;			// number of segments in the cache
+	TInt iPrefetchSegments;		// segments read at once when a file is read sequentially
+	TUint32 iHits;				// reads found in the cache
+	TUint32 iMisses;			// reads which had to go to the media
+	TUint32 iEvictions;			// cached segments discarded to make room for others
+	TUint32 iPrefetched;		// segments read ahead of sequential file reads
+	};
+
 enum TLoaderDebugFunction
 	{
 	ELoaderDebug_SetHeapFail,
-	ELoaderDebug_SetRFsFail
+	ELoaderDebug_SetRFsFail,
+	ELoaderDebug_SaveCacheSnapshot,		// write \sys\ldrcache.dat now
+	ELoaderDebug_ReloadCacheSnapshot	// read \sys\ldrcache.dat again, KErrCorrupt if it is rejected
 	};
 
 
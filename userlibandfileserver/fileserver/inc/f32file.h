@@ -2450,6 +2450,7 @@ public:
 	EFSRV_IMPORT_C TInt FullName(TDes& aName) const;
 	EFSRV_IMPORT_C TInt BlockMap(SBlockMapInfo& aInfo, TInt64& aStartPos, TInt64 aEndPos=-1, TInt aBlockMapusage=EBlockMapUsagePaging) const;
 	TInt Clamp(RFileClamp& aHandle);
+	EFSRV_IMPORT_C TInt CopyFrom(const RFile& aSource, TInt64 aSrcPos, TInt64 aPos, TInt aLength, TInt& aCopied);
 
 protected:
 	// RSubSessionBase overrides
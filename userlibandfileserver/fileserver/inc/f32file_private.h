@@ -287,6 +287,24 @@ struct SBlockMapArgs
 	};
 
 
+/**
+@internalTechnology
+
+Arguments for a copy between two files inside the file server.
+On return iDstPos is where the data was written and iLength is the number
+of bytes copied.
+
+@see RFile::CopyFrom()
+@note This structure is intended for use inside Kernel and Hardware Services only.
+*/
+struct SFileCopyArgs
+	{
+	TInt64 iSrcPos;
+	TInt64 iDstPos;
+	TInt iLength;
+	};
+
+
 /**
 @internalTechnology
 
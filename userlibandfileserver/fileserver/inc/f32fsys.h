@@ -2185,6 +2185,7 @@ private:
 	friend class CFileShare;
 	friend class TFsFileRead;
 	friend class TFsFileWrite;
+	friend class TFsFileCopy;
 	friend class TFsFileSetSize;
 	friend class TFsFileReadCancel;
 	friend class TFsFileDuplicate;
@@ -677,7 +677,7 @@ TInt E32ImageHeaderV::ValidateHeader(TInt aFileSize, TUint32& aUncompressedSize)
 	TUint uncompressedSize = aFileSize;
 	if(compression!=KFormatNotCompressed)
 		{
-		if(compression!=KUidCompressionDeflate && compression!=KUidCompressionBytePair)
+		if(compression!=KUidCompressionDeflate && compression!=KUidCompressionBytePair && compression!=KUidCompressionLz4)
 	        RETURN_FAILURE(KErrNotSupported);  // unknown compression method
 		uncompressedSize = headerSize+iUncompressedSize;
 		if(uncompressedSize<headerSize)
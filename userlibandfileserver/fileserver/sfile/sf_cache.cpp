@@ -26,6 +26,7 @@
 const TInt KMaxCachedDirectories=6;
 
 TInt RefreshDriveInfo();
+const TCacheSnapshotDir* FindSnapshotDir(TInt aDrive, const TDesC8& aPath, TBool& aCurrent);
 void DestroyCachedDirectories(TPathListRecord* aPathRec);
 void DestroyCachedDirectory(TDriveNumber aDrive, TDirectoryCacheHeader* aDirCache);
 void DestroyCachedDirectory(TDriveNumber aDrive, TPathListRecord* aPathRec);
@@ -179,6 +180,18 @@ TInt TFileCacheRecord::Order(const TFileCacheRecord& aL, const TFileCacheRecord&
 	return aL.Name().CompareF(aR.Name());
 	}
 
+// Number of bytes following the name which hold the export description or, if the extra
+// information isn't valid yet, which are reserved for it.
+TInt TFileCacheRecord::ExportDescriptionSize() const
+	{
+	if (!ExtrasValid())
+		return iExportDirCount;
+	if (IsXIP())
+		return 0;
+	const TUint8* xd = ExportDescription();
+	return 2 + (xd[0] | (xd[1]<<8));
+	}
+
 //=============================== TPathListRecord ==================================
 //
 #if defined(_DEBUG) || defined(_DEBUG_RELEASE)
@@ -421,8 +434,24 @@ TInt TDriveCacheHeader::GetDirCache(TDirectoryCacheHeader*& aCache, TPathListRec
 	TDirectoryCacheHeader* p = new TDirectoryCacheHeader(aPath);
 	if (!p)
 		return KErrNoMemory;
-	TInt r = p->PopulateFromDrive(aDriveAndPath);
-	__IF_DEBUG(Printf("PopulateFromDrive ret %d", r));
+	TInt r;
+	TBool current;
+	const TCacheSnapshotDir* snapshot = FindSnapshotDir(iDriveNumber, *aPath->PathName(), current);
+	if (snapshot && current && (iDriveAtt & KDriveAttRom))
+		{
+		// read-only drive which hasn't changed since the snapshot was taken
+		r = p->PopulateFromSnapshot(*snapshot);
+		__IF_DEBUG(Printf("PopulateFromSnapshot ret %d", r));
+		}
+	else
+		{
+		r = p->PopulateFromDrive(aDriveAndPath);
+		__IF_DEBUG(Printf("PopulateFromDrive ret %d", r));
+		if (r == KErrNone && snapshot)
+			r = p->MergeSnapshot(*snapshot);
+		if (r == KErrNone)
+			LoaderCacheChanged();
+		}
 	if (r != KErrNoMemory && r != KErrLocked && iDriveNumber != EDriveZ)
 		r = SetupNotify((TDriveNumber)iDriveNumber, *p);
 	if (r == KErrNoMemory || r == KErrLocked)
@@ -504,6 +533,8 @@ TFileCacheRecord* TDirectoryCacheHeader::NewRecord(const TDesC8& aName, TUint32
 		p->iNameLength = l;
 		p->iExportDescType = (aEntry.iAtt & KEntryAttXIP) ? KImageHdr_ExpD_Xip : KImageHdr_ExpD_NoHoles;	// for now
 		p->iCacheStatus = 0;
+		p->iFileSize = aEntry.iSize;
+		p->SetFileTime(aEntry.iModified);
 		memcpy(p+1, aName.Ptr(), l);
 		}
 	return p;
@@ -525,6 +556,15 @@ TFileCacheRecord* TDirectoryCacheHeader::NewRecord(const TFileCacheRecord& aReco
 	return p;
 	}
 
+TFileCacheRecord* TDirectoryCacheHeader::CopyRecord(const TFileCacheRecord& aRecord)
+	{
+	TInt eds = aRecord.ExportDescriptionSize();
+	TFileCacheRecord* p = NewRecord(aRecord, eds - 2);
+	if (p && aRecord.ExtrasValid())
+		memcpy((TUint8*)p->ExportDescription(), aRecord.ExportDescription(), eds);
+	return p;
+	}
+
 TInt TDirectoryCacheHeader::PopulateFromDrive(const TDesC8& aPathName)
 	{
 	// Wildcard searches through a named directory on a drive.
@@ -636,6 +676,84 @@ TInt TDirectoryCacheHeader::PopulateFromDrive(const TDesC8& aPathName)
 	return KErrNone;
 	}
 
+inline const TFileCacheRecord* NextSnapshotRecord(const TUint8*& aPos)
+	{
+	const TFileCacheRecord* f = (const TFileCacheRecord*)(aPos + sizeof(TInt));
+	aPos += sizeof(TInt) + Align4(*(const TInt*)aPos);
+	return f;
+	}
+
+TInt TDirectoryCacheHeader::PopulateFromSnapshot(const TCacheSnapshotDir& aDir)
+	{
+	// Fills the cache with the records from a directory in the snapshot, which are
+	// already sorted, instead of reading the directory and image headers.
+	__IF_DEBUG(Printf("PopulateFromSnapshot %S %d records", iPath->PathName(), aDir.iRecordCount));
+	iCache = (TFileCacheRecord**)User::Alloc(sizeof(TFileCacheRecord*) * aDir.iRecordCount);
+	if (!iCache && aDir.iRecordCount)
+		return KErrNoMemory;
+	const TUint8* pos = aDir.Records();
+	TInt i;
+	for (i=0; i<aDir.iRecordCount; ++i)
+		{
+		TFileCacheRecord* f = CopyRecord(*NextSnapshotRecord(pos));
+		if (!f)
+			return KErrNoMemory;
+		iCache[i] = f;
+		}
+	iRecordCount = aDir.iRecordCount;
+	iNotPresent = EFalse;
+	return KErrNone;
+	}
+
+TInt TDirectoryCacheHeader::MergeSnapshot(const TCacheSnapshotDir& aDir)
+	{
+	// Copies the extra information from the snapshot into records which don't have it yet,
+	// where the file has the same name, version, size and modification time as it had when
+	// the snapshot was taken. Both lists are sorted by name.
+	const TUint8* pos = aDir.Records();
+	TInt remaining = aDir.iRecordCount;
+	TInt merged = 0;
+	TInt i;
+	for (i=0; i<iRecordCount; ++i)
+		{
+		TFileCacheRecord* f = iCache[i];
+		// skip snapshot records for files which aren't in the directory any more
+		while (remaining)
+			{
+			const TUint8* next = pos;
+			if (TFileCacheRecord::Order(*NextSnapshotRecord(next), *f) >= 0)
+				break;
+			pos = next;
+			--remaining;
+			}
+		if (f->ExtrasValid())
+			continue;
+		const TUint8* q = pos;
+		TInt n;
+		for (n=remaining; n; --n)
+			{
+			const TFileCacheRecord* s = NextSnapshotRecord(q);
+			if (TFileCacheRecord::Order(*s, *f) != 0)
+				break;
+			// the version only comes from the name if it's explicit, otherwise it's from the header
+			TUint32 expVer = f->iAttr & ECodeSegAttExpVer;
+			if (s->ExtrasValid() && (s->iAttr & ECodeSegAttExpVer) == expVer
+				&& (!expVer || s->iModuleVersion == f->iModuleVersion)
+				&& s->iFileSize == f->iFileSize && s->FileTime() == f->FileTime())
+				{
+				TFileCacheRecord* t = CopyRecord(*s);
+				if (!t)
+					return KErrNoMemory;
+				iCache[i] = t;
+				++merged;
+				break;
+				}
+			}
+		}
+	__IF_DEBUG(Printf("MergeSnapshot %S %d records", iPath->PathName(), merged));
+	return KErrNone;
+	}
+
 TInt RefreshDriveInfo()
 	{
 	// Find out what drives are present
@@ -678,6 +796,348 @@ TInt RefreshDriveInfo()
 	return KErrNone;
 	}
 
+//=============================== Cache snapshot ==================================
+//
+_LIT(KCacheSnapshotFile, "?:\\sys\\ldrcache.dat");
+_LIT(KCacheSnapshotTempFile, "?:\\sys\\ldrcache.tmp");
+_LIT(KCacheDriveRoot, "?:\\");
+const TInt KCacheSnapshotMaxSize=0x100000;		// ignore a snapshot larger than 1MB
+const TInt KCacheSnapshotDelay=30;				// save 30 seconds after the cache last changed
+
+TCacheSnapshotHeader* gCacheSnapshot;			// snapshot read at boot
+TBool gCacheSnapshotRead;						// no point trying to read the snapshot again
+TBool gCacheSnapshotDirty;						// cache has changed since the snapshot was taken
+CCacheSnapshotTimer* gCacheSnapshotTimer;
+
+inline TUint32 RomCheckSum()
+	{
+	return ((const TRomHeader*)UserSvr::RomHeaderAddress())->iCheckSum;
+	}
+
+// Get the values used to check whether a directory has changed since the snapshot was taken
+TInt GetDirStamp(TInt aDrive, const TDesC8& aPath, TUint& aUniqueID, TInt64& aVolumeSize, TInt64& aModified)
+	{
+	if (aPath.Length() > KMaxFileName - KCacheDriveRoot().Length())
+		return KErrBadName;
+	TVolumeInfo vi;
+	TInt r = gTheLoaderFs.Volume(vi, aDrive);
+	if (r != KErrNone)
+		return r;
+	TChar c;
+	RFs::DriveToChar(aDrive, c);
+	TFileName dir;
+	dir.Copy(aPath);
+	dir.Insert(0, KCacheDriveRoot);
+	dir[0] = (TText)c;
+	TTime modified;
+	r = gTheLoaderFs.Modified(dir, modified);
+	if (r != KErrNone)
+		return r;
+	aUniqueID = vi.iUniqueID;
+	aVolumeSize = vi.iSize;
+	aModified = modified.Int64();
+	return KErrNone;
+	}
+
+TBool CheckCacheSnapshot(const TCacheSnapshotHeader& aHeader, TInt aSize)
+	{
+	if (aHeader.iMagic != (TUint32)TCacheSnapshotHeader::EMagic || aHeader.iVersion != TCacheSnapshotHeader::EVersion
+		|| aHeader.iSize != aSize || aHeader.iRomCheckSum != RomCheckSum())
+		return EFalse;
+	TUint32 crc = 0;
+	Mem::Crc32(crc, &aHeader + 1, aSize - sizeof(TCacheSnapshotHeader));
+	if (crc != aHeader.iCheckSum)
+		return EFalse;
+
+	// make sure everything lies within the snapshot so it can be used without further checks
+	const TUint8* p = (const TUint8*)(&aHeader + 1);
+	const TUint8* end = (const TUint8*)&aHeader + aSize;
+	TInt i;
+	for (i=0; i<aHeader.iDirCount; ++i)
+		{
+		const TCacheSnapshotDir& d = *(const TCacheSnapshotDir*)p;
+		if (end - p < (TInt)sizeof(TCacheSnapshotDir) || d.iSize < (TInt)sizeof(TCacheSnapshotDir) || d.iSize > end - p
+			|| (d.iSize & 7) || d.iPathLength < 0 || d.iPathLength > KMaxFileName || d.iRecordCount < 0)
+			return EFalse;
+		const TUint8* dirEnd = p + d.iSize;
+		const TUint8* r = d.Records();
+		if (r > dirEnd)
+			return EFalse;
+		TInt j;
+		for (j=0; j<d.iRecordCount; ++j)
+			{
+			if (dirEnd - r < (TInt)sizeof(TInt))
+				return EFalse;
+			TInt l = *(const TInt*)r;
+			if (l < (TInt)sizeof(TFileCacheRecord) || l > dirEnd - r - (TInt)sizeof(TInt))
+				return EFalse;
+			const TFileCacheRecord& f = *(const TFileCacheRecord*)(r + sizeof(TInt));
+			TInt minsize = sizeof(TFileCacheRecord) + f.iNameLength;
+			if (minsize > l)
+				return EFalse;
+			if (f.ExtrasValid() && !f.IsXIP() && (minsize + 2 > l || minsize + f.ExportDescriptionSize() > l))
+				return EFalse;
+			NextSnapshotRecord(r);
+			}
+		p = dirEnd;
+		}
+	return p == end;
+	}
+
+const TCacheSnapshotDir* FindSnapshotDir(TInt aDrive, const TDesC8& aPath, TBool& aCurrent)
+	{
+	// Returns the snapshot of a directory if the drive still has the same volume mounted.
+	// aCurrent is set if the directory doesn't seem to have changed since.
+	aCurrent = EFalse;
+	if (!gCacheSnapshot)
+		return NULL;
+	const TUint8* p = (const TUint8*)(gCacheSnapshot + 1);
+	const TCacheSnapshotDir* d = NULL;
+	TInt i;
+	for (i=0; i<gCacheSnapshot->iDirCount; ++i, p+=d->iSize)
+		{
+		d = (const TCacheSnapshotDir*)p;
+		if (d->iDrive == aDrive && d->PathName().CompareF(aPath) == 0)
+			break;
+		}
+	if (i == gCacheSnapshot->iDirCount)
+		return NULL;
+	TUint uniqueID;
+	TInt64 volumeSize;
+	TInt64 modified;
+	if (GetDirStamp(aDrive, aPath, uniqueID, volumeSize, modified) != KErrNone || uniqueID != d->iUniqueID)
+		return NULL;
+	aCurrent = (volumeSize == d->iVolumeSize && modified == d->iModified);
+	__IF_DEBUG(Printf("FindSnapshotDir drive %d path %S current %d", aDrive, &aPath, aCurrent));
+	return d;
+	}
+
+TInt ReadCacheSnapshot()
+	{
+	TInt sysDrive = RFs::GetSystemDrive();
+	if (!gDriveFileNamesCache[sysDrive])
+		return KErrNotReady;		// try again once the system drive is there
+	TFileName name(KCacheSnapshotFile);
+	name[0] = (TText)RFs::GetSystemDriveChar();
+	RFile f;
+	TInt r = f.Open(gTheLoaderFs, name, EFileRead|EFileShareReadersOnly|EFileReadDirectIO);
+	__IF_DEBUG(Printf("ReadCacheSnapshot open %d", r));
+	if (r == KErrNotReady)
+		return r;		// not mounted yet
+	gCacheSnapshotRead = ETrue;
+	if (r != KErrNone)
+		return r;
+	TInt size = 0;
+	r = f.Size(size);
+	TCacheSnapshotHeader* h = NULL;
+	if (r == KErrNone && size >= (TInt)sizeof(TCacheSnapshotHeader) && size <= KCacheSnapshotMaxSize)
+		h = (TCacheSnapshotHeader*)User::Alloc(size);
+	if (h)
+		{
+		TPtr8 buf((TUint8*)h, size);
+		r = f.Read(buf);
+		if (r != KErrNone || buf.Length() != size || !CheckCacheSnapshot(*h, size))
+			{
+			User::Free(h);
+			h = NULL;
+			}
+		}
+	f.Close();
+	__IF_DEBUG(Printf("ReadCacheSnapshot size %d valid %d", size, h!=NULL));
+	gCacheSnapshot = h;
+	if (!h)
+		return KErrCorrupt;
+
+	// bring in what we can for directories which were read before the snapshot was available
+	TInt drive;
+	for (drive=0; drive<KMaxDrives; ++drive)
+		{
+		TDriveCacheHeader* pDH = gDriveFileNamesCache[drive];
+		if (!pDH)
+			continue;
+		TDirectoryCacheHeader* p = pDH->iDirectoryList;
+		for (; p; p=p->iNext)
+			{
+			TBool current;
+			const TCacheSnapshotDir* d = FindSnapshotDir(drive, *p->iPath->PathName(), current);
+			if (d && !p->iNotPresent)
+				p->MergeSnapshot(*d);
+			}
+		}
+	return KErrNone;
+	}
+
+TInt SnapshotRecordSize(const TFileCacheRecord& aRecord)
+	{
+	TInt size = sizeof(TFileCacheRecord) + aRecord.iNameLength;
+	if (aRecord.ExtrasValid())
+		size += aRecord.ExportDescriptionSize();
+	return size;
+	}
+
+TInt SnapshotDirSize(const TDirectoryCacheHeader& aDir)
+	{
+	if (aDir.iNotPresent)
+		return 0;
+	TInt size = sizeof(TCacheSnapshotDir) + Align4(aDir.iPath->PathName()->Length());
+	TInt i;
+	for (i=0; i<aDir.iRecordCount; ++i)
+		size += sizeof(TInt) + Align4(SnapshotRecordSize(*aDir.iCache[i]));
+	return (size + 7) &~ 7;
+	}
+
+TInt WriteCacheSnapshot()
+	{
+	// Removable media can be changed elsewhere, so only internal drives are saved
+	const TUint KExcludeAtt = KDriveAttRemovable|KDriveAttRemote|KDriveAttSubsted;
+	TInt size = sizeof(TCacheSnapshotHeader);
+	TInt drive;
+	for (drive=0; drive<KMaxDrives; ++drive)
+		{
+		TDriveCacheHeader* pDH = gDriveFileNamesCache[drive];
+		if (!pDH || (pDH->iDriveAtt & KExcludeAtt))
+			continue;
+		TDirectoryCacheHeader* p = pDH->iDirectoryList;
+		for (; p; p=p->iNext)
+			size += SnapshotDirSize(*p);
+		}
+	TCacheSnapshotHeader* h = (TCacheSnapshotHeader*)User::AllocZ(size);
+	if (!h)
+		return KErrNoMemory;
+	h->iMagic = TCacheSnapshotHeader::EMagic;
+	h->iVersion = TCacheSnapshotHeader::EVersion;
+	h->iRomCheckSum = RomCheckSum();
+
+	TUint8* q = (TUint8*)(h + 1);
+	for (drive=0; drive<KMaxDrives; ++drive)
+		{
+		TDriveCacheHeader* pDH = gDriveFileNamesCache[drive];
+		if (!pDH || (pDH->iDriveAtt & KExcludeAtt))
+			continue;
+		TDirectoryCacheHeader* p = pDH->iDirectoryList;
+		for (; p; p=p->iNext)
+			{
+			TInt dirSize = SnapshotDirSize(*p);
+			if (!dirSize)
+				continue;
+			TCacheSnapshotDir& d = *(TCacheSnapshotDir*)q;
+			const TDesC8& path = *p->iPath->PathName();
+			if (GetDirStamp(drive, path, d.iUniqueID, d.iVolumeSize, d.iModified) != KErrNone)
+				continue;
+			d.iSize = dirSize;
+			d.iDrive = drive;
+			d.iRecordCount = p->iRecordCount;
+			d.iPathLength = path.Length();
+			memcpy(&d + 1, path.Ptr(), path.Length());
+			TUint8* r = (TUint8*)d.Records();
+			TInt i;
+			for (i=0; i<p->iRecordCount; ++i)
+				{
+				const TFileCacheRecord& f = *p->iCache[i];
+				TInt l = SnapshotRecordSize(f);
+				*(TInt*)r = l;
+				TFileCacheRecord* t = (TFileCacheRecord*)(r + sizeof(TInt));
+				memcpy(t, &f, l);
+				t->iCacheStatus = 0;		// hash checks must be redone
+				r += sizeof(TInt) + Align4(l);
+				}
+			q += dirSize;
+			++h->iDirCount;
+			}
+		}
+	h->iSize = q - (TUint8*)h;
+	Mem::Crc32(h->iCheckSum, h + 1, h->iSize - sizeof(TCacheSnapshotHeader));
+
+	// write a new file and then replace the old one, so there's always a complete snapshot
+	TFileName tempName(KCacheSnapshotTempFile);
+	tempName[0] = (TText)RFs::GetSystemDriveChar();
+	gTheLoaderFs.MkDirAll(tempName);	// ignore error and let the create fail if the path doesn't exist
+	RFile f;
+	TInt r = f.Replace(gTheLoaderFs, tempName, EFileWrite|EFileWriteDirectIO);
+	if (r == KErrNone)
+		{
+		r = f.Write(TPtrC8((const TUint8*)h, h->iSize));
+		if (r == KErrNone)
+			r = f.Flush();
+		f.Close();
+		if (r == KErrNone)
+			{
+			TFileName name(KCacheSnapshotFile);
+			name[0] = tempName[0];
+			r = gTheLoaderFs.Replace(tempName, name);
+			}
+		if (r != KErrNone)
+			gTheLoaderFs.Delete(tempName);
+		}
+	__IF_DEBUG(Printf("WriteCacheSnapshot %d dirs %d bytes ret %d", h->iDirCount, h->iSize, r));
+	User::Free(h);
+	return r;
+	}
+
+CCacheSnapshotTimer* CCacheSnapshotTimer::New()
+	{
+	CCacheSnapshotTimer* timer = new CCacheSnapshotTimer;
+	if (timer)
+		{
+		TRAPD(r, timer->ConstructL());
+		if (r != KErrNone)
+			{
+			delete timer;
+			return NULL;
+			}
+		CActiveSchedulerLoader::Add(timer);
+		}
+	return timer;
+	}
+
+CCacheSnapshotTimer::CCacheSnapshotTimer()
+	: CTimer(EPriorityIdle)
+	{}
+
+void CCacheSnapshotTimer::Start()
+	{
+	Cancel();
+	After(KCacheSnapshotDelay*1000000);
+	}
+
+void CCacheSnapshotTimer::RunL()
+	{
+	if (gCacheSnapshotDirty && WriteCacheSnapshot() == KErrNone)
+		gCacheSnapshotDirty = EFalse;
+
+	// directories not used by now are unlikely to be needed, so free the old snapshot
+	User::Free(gCacheSnapshot);
+	gCacheSnapshot = NULL;
+	}
+
+void LoaderCacheChanged()
+	{
+	// Save once things have settled down after startup, so all the directories
+	// used during boot are included and the drives are all mounted.
+	gCacheSnapshotDirty = ETrue;
+	if (gCacheSnapshotTimer && gInitCacheCheckDrivesAndAddNotifications)
+		gCacheSnapshotTimer->Start();
+	}
+
+#ifdef _DEBUG
+TInt SaveCacheSnapshot()
+	{
+	TInt r = WriteCacheSnapshot();
+	if (r == KErrNone)
+		gCacheSnapshotDirty = EFalse;
+	return r;
+	}
+
+// Discards the snapshot and reads it again, returning KErrCorrupt if the file is rejected
+TInt ReloadCacheSnapshot()
+	{
+	User::Free(gCacheSnapshot);
+	gCacheSnapshot = NULL;
+	gCacheSnapshotRead = EFalse;
+	return ReadCacheSnapshot();
+	}
+#endif
+
 //
 void InitializeFileNameCache()
 	{
@@ -685,11 +1145,13 @@ void InitializeFileNameCache()
 	gInitCacheCheckDrivesAndAddNotifications = EFalse;
 	gCacheCheckDrives = ETrue;
 	__ASSERT_ALWAYS(TPathListRecord::Init()==KErrNone, User::Invariant());
+	gCacheSnapshotTimer = CCacheSnapshotTimer::New();	// if this fails the cache just isn't saved
 	}
 
 TInt CheckLoaderCacheInit()
 	{
 	TInt r=KErrNone;
+	TBool refreshed=EFalse;
 	if(RefreshZDriveCache)
 		{
 		// force z: drive cache to be refreshed
@@ -705,6 +1167,7 @@ TInt CheckLoaderCacheInit()
 		__IF_DEBUG(Printf("Refreshing cache"));
 		r = RefreshDriveInfo();						// refreshing is a 'once-only' operation after setting
 		gCacheCheckDrives = EFalse;					// gCacheCheckDrives so as to prevent excessive refreshing
+		refreshed = ETrue;
 		}
 	if (!gInitCacheCheckDrivesAndAddNotifications && StartupInitCompleted)
 		{
@@ -712,7 +1175,12 @@ TInt CheckLoaderCacheInit()
 		r = RefreshDriveInfo();						// this is to provide an extra refresh to explicitly find
 		r = AddNotifications();						// all drives set up during FS initialisation
 		gInitCacheCheckDrivesAndAddNotifications = ETrue;	
+		refreshed = ETrue;
+		if (gCacheSnapshotTimer)
+			gCacheSnapshotTimer->Start();
 		}
+	if (refreshed && !gCacheSnapshotRead)
+		ReadCacheSnapshot();						// the system drive may have been mounted
 	return r;
 	}
 
@@ -785,6 +1253,8 @@ TInt RImageFinder::SearchSingleDir()
 			if (r == KErrNoMemory)
 				return r;
 			f = dch->iCache[ix];	// may have been moved
+			if (r == KErrNone)
+				LoaderCacheChanged();
 			}
 		if (r==KErrNone)
 			{
@@ -40,10 +40,19 @@ public:
 	inline TBool IsXIP() const
 		{ return !(iUid[0]&3); }
 	static TInt Order(const TFileCacheRecord& aL, const TFileCacheRecord& aR);
+	TInt ExportDescriptionSize() const;
 	void Dump(const char* aTitle);
 public:
 	TInt GetImageInfo(RImageInfo& aInfo, const TDesC8& aPathName, TDirectoryCacheHeader* aDirHead, TInt aIndex);
 public:
+	inline TInt64 FileTime() const
+		{ return MAKE_TINT64(iFileTimeHigh, iFileTimeLow); }
+	inline void SetFileTime(const TTime& aTime)
+		{ iFileTimeLow = I64LOW(aTime.Int64()); iFileTimeHigh = I64HIGH(aTime.Int64()); }
+public:
+	TUint32 iFileSize;			// size and modification time of the file, used to check a
+	TUint32 iFileTimeLow;		// record from the cache snapshot is still current. The time is
+	TUint32 iFileTimeHigh;		// split so records in the snapshot need only be 4-byte aligned.
 	// UID1 must be EXE or DLL, 0 means extra information not valid
 	// UID1 nonzero and multiple of 4 means XIP in which case it points to the ROM image header
 	// iExportDirCount = number of bytes available for export description if iUid[0]=0
@@ -107,6 +116,53 @@ private:
 	TDirectoryCacheHeader* iDirHead;
 	};
 
+// Header of the loader cache snapshot. This is a copy of the directory caches of the
+// internal drives, saved on the system drive once the cache has settled and read back at
+// the next boot so that directories and image headers which haven't changed needn't be
+// read again.
+class TCacheSnapshotHeader
+	{
+public:
+	enum {EMagic=0x4352444c, EVersion=2};	// 'LDRC'
+public:
+	TUint32 iMagic;
+	TInt iVersion;
+	TInt iSize;					// size of the snapshot, including this header
+	TUint32 iCheckSum;			// CRC of everything after this header
+	TUint32 iRomCheckSum;		// checksum of the ROM the snapshot was taken with
+	TInt iDirCount;
+	};
+
+// A directory in the snapshot. The path follows, padded to a multiple of 4 bytes, then
+// iRecordCount records, each a TInt length followed by the TFileCacheRecord with its name
+// and export description, padded to a multiple of 4 bytes.
+class TCacheSnapshotDir
+	{
+public:
+	inline TPtrC8 PathName() const
+		{ return TPtrC8((const TText8*)(this + 1), iPathLength); }
+	inline const TUint8* Records() const
+		{ return (const TUint8*)(this + 1) + Align4(iPathLength); }
+public:
+	TInt64 iVolumeSize;
+	TInt64 iModified;			// modification time of the directory
+	TInt iSize;					// size of this entry, including path and records
+	TInt iDrive;
+	TUint iUniqueID;			// unique ID of the volume
+	TInt iRecordCount;
+	TInt iPathLength;
+	};
+
+NONSHARABLE_CLASS(CCacheSnapshotTimer) : public CTimer
+	{
+public:
+	static CCacheSnapshotTimer* New();
+	void Start();
+private:
+	CCacheSnapshotTimer();
+	void RunL();
+	};
+
 class TEntry;
 class TDirectoryCacheHeader
 	{
@@ -116,7 +172,10 @@ public:
 	TAny* Allocate(const TInt aBytes);
 	TFileCacheRecord* NewRecord(const TDesC8& aName, TUint32 aAttr, TUint32 aVer, const TEntry& aEntry);
 	TFileCacheRecord* NewRecord(const TFileCacheRecord& aRecord, TInt aEDS);
+	TFileCacheRecord* CopyRecord(const TFileCacheRecord& aRecord);
 	TInt PopulateFromDrive(const TDesC8& aPathName);
+	TInt PopulateFromSnapshot(const TCacheSnapshotDir& aDir);
+	TInt MergeSnapshot(const TCacheSnapshotDir& aDir);
 public:
 	TDirectoryCacheHeader* iNext;		// list of directories per drive
 	TCacheHeapList* iFirstHeapBlock;	// heap blocks to hold TFileCacheRecord entries
@@ -145,5 +204,10 @@ public:
 
 void InitializeFileNameCache();
 TInt CheckLoaderCacheInit();
+void LoaderCacheChanged();
+#ifdef _DEBUG
+TInt SaveCacheSnapshot();
+TInt ReloadCacheSnapshot();
+#endif
 
 #endif
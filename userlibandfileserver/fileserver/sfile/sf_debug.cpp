@@ -315,6 +315,7 @@ TPtrC GetFunctionName(TInt aFunction)
 	case EFsNotificationRequest : return _L("EFsNotificationRequest");
 	case EFsNotificationSubClose : return _L("EFsNotificationSubClose");
 	case EFsLoadCodePage: return _L("EFsLoadCodePage");
+	case EFsFileCopy: return _L("EFsFileCopy");
 	default:
 		return _L("Error unknown function");
 		}
@@ -1272,6 +1272,438 @@ TInt TFsFileWrite::Complete(CFsRequest* aRequest)
 	return CFsRequest::EReqActionComplete;
 	}
 
+//
+// Server-side copy.
+//
+// The client's request runs in the target file's drive thread and moves the data with
+// internal read and write requests, as the file cache does, through a pair of buffers
+// so that one buffer is being read from the source while the other is being written to
+// the target. The internal requests go straight to DoRequestL(), so they bypass both
+// files' caches: dirty data in either cache is flushed first, and anything the target's
+// cache holds is purged afterwards. Between internal completions the client's request
+// is parked rather than requeued, so that a copy between two drives doesn't keep the
+// target drive thread busy while it waits for the source.
+//
+const TInt KFileCopyBuffers = 2;
+const TInt KFileCopyBufferSize = 256 * 1024;
+const TInt KFileCopyMinBufferSize = 16 * 1024;
+
+class TFsFileCopy::TBuffer
+	{
+public:
+	enum TState {EIdle, EReading, EWriting};
+public:
+	TCopy* iCopy;
+	TState iState;
+	TUint8* iData;
+	TInt iOffset;			// from the start of the copy
+	TInt iLength;
+	TInt iRead;				// the length the last read returned, short at the end of the source
+	TUint32 iDone;			// set when the current internal request has completed
+	TInt iError;
+	};
+
+class TFsFileCopy::TCopy
+	{
+public:
+	TCopy();
+	~TCopy();
+	inline void Open();
+	void Close();
+public:
+	TUint32 iRefs;			// the client's request and each internal request in progress
+	CFsMessageRequest* iRequest;
+	CFileShare* iSrcShare;
+	CFileCB* iSrc;
+	CFileCB* iDst;
+	TInt64 iSrcPos;
+	TInt64 iDstPos;
+	TInt iLength;
+	TInt iIssued;
+	TInt iCopied;
+	TInt iError;
+	TBool iFlushed;
+	TUint32 iWaiting;		// the client's request is parked
+	TUint8* iData;
+	TInt iBufferSize;
+	TBuffer iBuffer[KFileCopyBuffers];
+	};
+
+TFsFileCopy::TCopy::TCopy()
+	{
+	memclr(this, sizeof(*this));
+	iRefs = 1;
+	}
+
+TFsFileCopy::TCopy::~TCopy()
+	{
+	if (iSrcShare)
+		iSrcShare->Close();
+	User::Free(iData);
+	}
+
+inline void TFsFileCopy::TCopy::Open()
+	{
+	__e32_atomic_add_ord32(&iRefs, 1);
+	}
+
+void TFsFileCopy::TCopy::Close()
+	{
+	if (__e32_atomic_add_ord32(&iRefs, (TUint32) -1) == 1)
+		delete this;
+	}
+
+
+TInt TFsFileCopy::Initialise(CFsRequest* aRequest)
+//
+//
+//
+	{
+	CFsMessageRequest& msgRequest = *(CFsMessageRequest*) aRequest;
+
+	TInt r = DoInitNoParse(aRequest);
+	if (r != KErrNone)
+		return r;
+
+	if (!FsThreadManager::IsDriveAvailable(aRequest->DriveNumber(), EFalse))
+		return KErrNotReady;
+
+	CFileShare* share;
+	CFileCB* file;
+	GetFileFromScratch(aRequest, share, file);
+
+	if ( !file->Drive().IsCurrentMount(file->Mount())  )
+		return KErrDisMounted;
+
+	// the bottom TMsgOperation holds the copy's state for TFsFileCopy::Complete()
+	TMsgOperation* msgOp = msgRequest.CurrentOperationPtr();
+	if (!msgOp)	// initialised already ?
+		{
+		r = msgRequest.PushOperation();
+		if (r == KErrNone)
+			{
+			msgRequest.CurrentOperation().iScratchValue0 = NULL;
+			r = msgRequest.PushOperation(TFsFileCopy::Complete);
+			}
+		if (r != KErrNone)
+			return r;
+		msgOp = msgRequest.CurrentOperationPtr();
+		}
+
+	if (!share->RequestStart(&msgRequest))
+		return CFsRequest::EReqActionPending;
+
+	if ((share->iMode & EFileWrite)==0 || (share->iMode & KFileShareMask) == EFileShareReadersOnly)
+		return KErrAccessDenied;
+
+	CFileShare* srcShare = GetShareFromHandle(aRequest->Session(), aRequest->Message().Int0());
+	if (!srcShare)
+		return KErrBadHandle;
+	CFileCB* src = &srcShare->File();
+	if (src == file)
+		return KErrArgument;
+
+	// the internal requests bypass plugins, so a plugin which intercepts reads or
+	// writes must see the copy as the client's own reads and writes
+	if (FsPluginManager::IsIntercepted(EFsFileRead) || FsPluginManager::IsIntercepted(EFsFileWrite))
+		return KErrNotSupported;
+
+	// the internal requests need local buffers and a drive thread on each side
+	TInt srcDrive = src->Drive().DriveNumber();
+	if (!src->LocalBufferSupport() || !file->LocalBufferSupport() ||
+		FsThreadManager::IsDriveSync(srcDrive, EFalse) || FsThreadManager::IsDriveSync(aRequest->DriveNumber(), EFalse))
+		return KErrNotSupported;
+	if (!FsThreadManager::IsDriveAvailable(srcDrive, EFalse))
+		return KErrNotReady;
+
+	SFileCopyArgs args;
+	TPckg<SFileCopyArgs> pkArgs(args);
+	aRequest->ReadL(KMsgPtr1, pkArgs);
+	if (args.iSrcPos < 0 || args.iDstPos < 0 || args.iLength < 0)
+		return KErrArgument;
+
+	const TInt64 srcSize = src->CachedSize64();
+	if (args.iSrcPos >= srcSize)
+		args.iLength = 0;
+	else if (args.iSrcPos + args.iLength > srcSize)
+		args.iLength = (TInt) (srcSize - args.iSrcPos);
+
+	if (args.iLength == 0)
+		{
+		r = aRequest->Write(KMsgPtr1, pkArgs);
+		return(r == KErrNone?CFsRequest::EReqActionComplete:r);
+		}
+
+	if ((r = src->CheckLock64(srcShare, args.iSrcPos, args.iLength)) != KErrNone)
+		return r;
+
+	const TInt64 dstSize = file->CachedSize64();
+	if (args.iDstPos > dstSize)
+		args.iDstPos = dstSize;
+	const TUint64 endPos = args.iDstPos + args.iLength;
+	if (!share->IsFileModeBig() && endPos > KMaxLegacyFileSize)
+		return KErrTooBig;
+	if (endPos > file->MaxSupportedSize())
+		return KErrNotSupported;
+	if ((r = file->CheckLock64(share, args.iDstPos, args.iLength)) != KErrNone)
+		return r;
+
+	TCopy* copy = (TCopy*) msgOp->iPrev->iScratchValue0;
+	if (!copy)
+		{
+		copy = new TCopy;
+		if (!copy)
+			return KErrNoMemory;
+		msgOp->iPrev->iScratchValue0 = copy;
+
+		// a smaller pair of buffers is better than falling back to copying through the client
+		TInt size = Min(KFileCopyBufferSize, (args.iLength + 1) / KFileCopyBuffers);
+		size = Max(size, KFileCopyMinBufferSize);
+		while ((copy->iData = (TUint8*) User::Alloc(size * KFileCopyBuffers)) == NULL && size > KFileCopyMinBufferSize)
+			size >>= 1;
+		if (!copy->iData)
+			return KErrNoMemory;
+		copy->iBufferSize = size;
+		for (TInt i = 0; i < KFileCopyBuffers; ++i)
+			{
+			copy->iBuffer[i].iCopy = copy;
+			copy->iBuffer[i].iData = copy->iData + i * size;
+			}
+
+		r = srcShare->Open();
+		if (r != KErrNone)
+			return r;
+		copy->iSrcShare = srcShare;
+		}
+
+	copy->iRequest = &msgRequest;
+	copy->iSrc = src;
+	copy->iDst = file;
+	copy->iSrcPos = args.iSrcPos;
+	copy->iDstPos = args.iDstPos;
+	copy->iLength = args.iLength;
+	msgOp->iScratchValue0 = copy;
+
+	return KErrNone;
+	}
+
+
+TInt TFsFileCopy::DoRequestL(CFsRequest* aRequest)
+//
+// Copy data from one file to another, without passing it through the client.
+//
+	{
+	__PRINT(_L("TFsFileCopy::DoRequestL(CFsRequest* aRequest)"));
+
+	CFsMessageRequest& msgRequest = *(CFsMessageRequest*) aRequest;
+	TCopy& copy = *(TCopy*) msgRequest.CurrentOperation().iScratchValue0;
+	TInt r;
+
+	if (!copy.iFlushed)
+		{
+		r = copy.iSrc->CheckMount();
+		if (r == KErrNone)
+			r = copy.iDst->CheckMount();
+		if (r != KErrNone)
+			return r;
+
+		// the internal requests bypass both caches, so neither may hold dirty data
+		CFileCache* fileCache = copy.iSrc->FileCache();
+		if (fileCache && (r = fileCache->FlushDirty()) != CFsRequest::EReqActionComplete)
+			return r;
+		fileCache = copy.iDst->FileCache();
+		if (fileCache && (r = fileCache->FlushDirty(aRequest)) != CFsRequest::EReqActionComplete)
+			return r;
+
+		copy.iDst->SetArchiveAttribute();
+		copy.iFlushed = ETrue;
+		}
+
+	TBool busy;
+	FOREVER
+		{
+		busy = EFalse;
+		for (TInt i = 0; i < KFileCopyBuffers; ++i)
+			{
+			TBuffer& b = copy.iBuffer[i];
+			if (b.iState != TBuffer::EIdle)
+				{
+				if (!__e32_atomic_load_acq32(&b.iDone))
+					{
+					busy = ETrue;
+					continue;
+					}
+				if (copy.iError == KErrNone)
+					copy.iError = b.iError;
+				if (copy.iError == KErrNone && b.iState == TBuffer::EReading && b.iRead < b.iLength)
+					{
+					// the source has been truncated since the copy started: write only
+					// what was read and don't copy anything beyond it
+					b.iLength = b.iRead;
+					copy.iLength = Min(copy.iLength, b.iOffset + b.iRead);
+					}
+				if (copy.iError == KErrNone && b.iState == TBuffer::EReading && b.iLength > 0)
+					{
+					copy.iError = Issue(copy, b, EFsFileWriteDirty);
+					if (copy.iError == KErrNone)
+						{
+						busy = ETrue;
+						continue;
+						}
+					}
+				else if (copy.iError == KErrNone && b.iState == TBuffer::EWriting)
+					copy.iCopied += b.iLength;
+				b.iState = TBuffer::EIdle;
+				}
+
+			if (copy.iError == KErrNone && copy.iIssued < copy.iLength)
+				{
+				b.iOffset = copy.iIssued;
+				b.iLength = Min(copy.iLength - copy.iIssued, copy.iBufferSize);
+				copy.iError = Issue(copy, b, EFsFileRead);
+				if (copy.iError == KErrNone)
+					{
+					copy.iIssued += b.iLength;
+					busy = ETrue;
+					}
+				}
+			}
+
+		if (!busy)
+			break;
+
+		// Park until an internal request completes. If one completed while we were
+		// looking, either take it back and go round again or, if BufferComplete() has
+		// seen us waiting, leave it to the dispatch BufferComplete() has made.
+		__e32_atomic_store_ord32(&copy.iWaiting, 1);
+		TBool done = EFalse;
+		for (TInt j = 0; j < KFileCopyBuffers; ++j)
+			{
+			if (copy.iBuffer[j].iState != TBuffer::EIdle && __e32_atomic_load_acq32(&copy.iBuffer[j].iDone))
+				done = ETrue;
+			}
+		if (!done || __e32_atomic_swp_ord32(&copy.iWaiting, 0) == 0)
+			return CFsRequest::EReqActionPending;
+		}
+
+	if (copy.iError != KErrNone)
+		return copy.iError;
+
+	// anything the target's cache holds for the range written is stale
+	CFileCache* fileCache = copy.iDst->FileCache();
+	if (fileCache)
+		fileCache->Purge(EFalse);
+
+	SFileCopyArgs args;
+	args.iSrcPos = copy.iSrcPos;
+	args.iDstPos = copy.iDstPos;
+	args.iLength = Min(copy.iCopied, copy.iLength);
+	TPckgC<SFileCopyArgs> pkArgs(args);
+	return aRequest->Write(KMsgPtr1, pkArgs);
+	}
+
+
+TInt TFsFileCopy::Issue(TCopy& aCopy, TBuffer& aBuffer, TInt aFunction)
+//
+// Read a buffer from the source, or write it to the target, with an internal request
+//
+	{
+	TBool read = (aFunction == EFsFileRead);
+	CFileCB* file = read ? aCopy.iSrc : aCopy.iDst;
+	TInt64 pos = (read ? aCopy.iSrcPos : aCopy.iDstPos) + aBuffer.iOffset;
+
+	RLocalMessage msgNew;
+	const TOperation& oP = OperationArray[aFunction];
+	CFsClientMessageRequest* newRequest = NULL;
+	TInt r = RequestAllocator::GetMessageRequest(oP, msgNew, newRequest);
+	if (r != KErrNone)
+		return r;
+
+	newRequest->Set(msgNew, oP, aCopy.iRequest->Session(), aCopy.iRequest->Uid());
+	newRequest->SetDrive(&file->Drive());
+
+	// like the file cache's requests, these are not posted to plugins
+	newRequest->iCurrentPlugin = NULL;
+	newRequest->EnablePostIntercept(EFalse);
+	newRequest->SetScratchValue64( MAKE_TINT64(EFalse, (TUint) file) );
+
+	// don't call Initialise() or PostInitialise(), don't call Message().Complete()
+	newRequest->SetState(CFsRequest::EReqStateDoRequest);
+	newRequest->SetCompleted(EFalse);
+
+	// the bottom TMsgOperation tells BufferComplete() which buffer this is
+	r = newRequest->PushOperation();
+	if (r == KErrNone)
+		{
+		newRequest->CurrentOperation().iScratchValue0 = &aBuffer;
+		r = newRequest->PushOperation(pos, aBuffer.iLength, aBuffer.iData, 0, TFsFileCopy::BufferComplete);
+		if (r != KErrNone)
+			newRequest->PopOperation();
+		}
+	if (r != KErrNone)
+		{
+		newRequest->Free();
+		return r;
+		}
+
+	aBuffer.iState = read ? TBuffer::EReading : TBuffer::EWriting;
+	aBuffer.iDone = EFalse;
+	aBuffer.iError = KErrNone;
+	aCopy.Open();
+	newRequest->Dispatch();
+	return KErrNone;
+	}
+
+
+TInt TFsFileCopy::BufferComplete(CFsRequest* aRequest)
+//
+// Called, in the source or target drive thread, when an internal request has completed
+//
+	{
+	CFsMessageRequest& msgRequest = *(CFsMessageRequest*) aRequest;
+	TBuffer& b = *(TBuffer*) msgRequest.CurrentOperation().iScratchValue0;
+	TCopy* copy = b.iCopy;
+
+	b.iError = msgRequest.LastError();
+
+	// A read stops short at the end of the file, leaving the rest of the buffer as it
+	// was. This runs in the source's drive thread, after the read and before anything
+	// else can change the file's size, so the size now is the size the read saw.
+	if (b.iState == TBuffer::EReading && b.iError == KErrNone)
+		{
+		TInt64 avail = copy->iSrc->CachedSize64() - (copy->iSrcPos + b.iOffset);
+		b.iRead = (TInt) Max(Min(avail, TInt64(b.iLength)), TInt64(0));
+		}
+	__e32_atomic_store_rel32(&b.iDone, ETrue);
+	if (__e32_atomic_swp_ord32(&copy->iWaiting, 0))
+		copy->iRequest->Dispatch();
+	copy->Close();
+
+	return CFsRequest::EReqActionComplete;
+	}
+
+
+TInt TFsFileCopy::Complete(CFsRequest* aRequest)
+	{
+	CFsMessageRequest& msgRequest = *(CFsMessageRequest*) aRequest;
+
+	CFileShare* share;
+	CFileCB* file;
+	GetFileFromScratch(aRequest, share, file);
+
+	TCopy* copy = (TCopy*) msgRequest.CurrentOperation().iScratchValue0;
+	if (copy)
+		copy->Close();
+
+	if (share)
+		share->RequestEnd(&msgRequest);
+
+	if (file->NotifyAsyncReadersPending())
+		file->NotifyAsyncReaders();
+
+	return CFsRequest::EReqActionComplete;
+	}
+
 TInt TFsFileLock::DoRequestL(CFsRequest* aRequest)
 //
 // Lock a region of the file.
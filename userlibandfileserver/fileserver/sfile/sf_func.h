@@ -334,6 +334,19 @@ private:
 	static TInt CommonInit(CFileShare* aShare, CFileCB* aFile, TInt64& aPos, TInt& aLen, TInt64 aFileSize, TFsMessage aFsOp);
 	};
 
+class TFsFileCopy
+	{
+public:
+	static TInt Initialise(CFsRequest* aRequest);
+	static TInt DoRequestL(CFsRequest* aRequest);
+	static TInt Complete(CFsRequest* aRequest);
+private:
+	class TBuffer;
+	class TCopy;
+	static TInt Issue(TCopy& aCopy, TBuffer& aBuffer, TInt aFunction);
+	static TInt BufferComplete(CFsRequest* aRequest);
+	};
+
 class TFsFileLock
 	{
 public:
@@ -253,6 +253,19 @@ enum TVersionCompareAction
 
 class E32Image : public TProcessCreateInfo
 	{
+public:
+	/**
+	Phases of loading an image, timed for BTrace::ELoaderImageTimes.
+	*/
+	enum TLoadPhase
+		{
+		ELoadSearch,
+		ELoadRead,
+		ELoadDecompress,
+		ELoadRelocate,
+		ELoadFixup,
+		ELoadPhases
+		};
 public:
 	E32Image();
 	~E32Image();
@@ -268,6 +281,7 @@ public:
 	TInt LoadCodeSeg(const RLdrReq& aReq);
 	TInt DoLoadCodeSeg(const RLdrReq& aReq, RImageFinder& aFinder);
 	TInt DoLoadCodeSeg(const TRomImageHeader& aRomImgHdr);
+	TInt CreateCodeSeg(RImageFinder& aFinder);
 	TInt CheckAlreadyLoaded();
 	TInt CheckRomXIPAlreadyLoaded();
 	TInt ProcessFileName();
@@ -275,6 +289,9 @@ public:
 	static TBool TraverseDirs(const TRomDir& aDir, const TRomImageHeader* aHdr, TDes8& aName);
 
 	TInt LoadToRam();
+	TInt ReadAndRelocate();
+	TInt CompleteLoadToRam(TInt aResult);
+	TInt SetCodeSegId();
 	TInt LoadFile();
 	TInt LoadFileNoCompress();
 	TInt Read(TUint aPos,TUint8* aDest,TUint aSize,TBool aSvPerms=EFalse);
@@ -291,11 +308,14 @@ public:
 	TInt ProcessImports();
 
 	TInt LoadDlls(RImageArray& aDllArray);
+	TInt ResolveDlls(RImageArray& aDllArray, RPointerArray<E32Image>& aNewDlls);
+	TInt LoadNewDlls(RPointerArray<E32Image>& aDllArray);
 	TInt GetCurrentImportList(const E32ImportBlock* aBlock);
 	static TInt FixupDlls(RImageArray& aDllArray);
 	TUint64* ExpandFixups(TInt aNumFixups);
 	TInt FinaliseDlls(RImageArray& aDllArray);
 	void CleanupDlls(RImageArray& aDllArray);
+	void TraceLoadTimes(RImageArray& aDllArray, TUint32 aStartTime);
 
 	TInt LastCurrentImport();
 	void SortCurrentImportList();
@@ -333,9 +353,47 @@ public:
 	TUint8 iCurrentImportListSorted;
 	TUint8 iIsDll;
 	TUint8 iAlreadyLoaded;
-	TUint8 iPadding2;
+	TUint8 iLoadDllsPending;		// set from creating a new DLL's code segment until its imports are loaded
 	TInt iFixupCount;				// number of fixups in iFixups
 	TUint64* iFixups;				// array of fixups to apply to demand paged code {addr,value} pairs
+	TUint32 iPhaseTime[ELoadPhases];	// fast counter ticks spent in each TLoadPhase
+	TInt iLoadThreads;				// main loadee only: most threads used to load its dependencies
+	};
+
+
+/**
+A set of new images whose code segments have been created, to be read and relocated
+by the image load threads and the loader thread together.
+*/
+struct SImageLoadJob
+	{
+	E32Image** iImages;
+	TInt* iResults;					// result of ReadAndRelocate() for each image
+	TInt iCount;
+	TInt iNextImage;				// next image to load, claimed with User::LockedInc
+	};
+
+// Maximum number of threads helping the loader thread load new DLLs
+const TInt KMaxImageLoadThreads = 3;
+
+/**
+Threads which help the loader thread load several new DLLs at once on multiprocessor systems.
+They are created the first time an executable has more than one new DLL to load.
+*/
+class ImageLoadThreads
+	{
+public:
+	static TInt Count();
+	static TInt Run(SImageLoadJob& aJob);
+private:
+	static TInt Create();
+	static TInt ThreadFunction(TAny*);
+	static void LoadImages(SImageLoadJob& aJob);
+private:
+	static TInt iCount;				// number of threads, or -1 if not created yet
+	static RSemaphore iStart;
+	static RSemaphore iDone;
+	static SImageLoadJob* iJob;
 	};
 
 
@@ -330,6 +330,8 @@ GLDEF_C TInt LoaderThread(TAny*)
 	RThread::Rendezvous(KErrNone);
 	r=gTheLoaderFs.Connect();
 	__ASSERT_ALWAYS(r==KErrNone, Fault(ELdrFsConnect));
+	r=gTheLoaderFs.ShareAuto();	// image load threads read through image file handles
+	__ASSERT_ALWAYS(r==KErrNone, Fault(ELdrFsConnect));
 	TBuf<sizeof(KDriveSystemRoot)> driveSystemRoot(KDriveSystemRoot);
 	driveSystemRoot[0] = (TUint8) RFs::GetSystemDriveChar();
 	r=gTheLoaderFs.SetSessionPath(driveSystemRoot);
@@ -1917,6 +1919,10 @@ TInt DoLoaderDebugFunction(const RMessage2& aMsg)
 		RFsErrorCode = aMsg.Int1();
 		RFsFailCount = aMsg.Int2();
 		return KErrNone;
+	case ELoaderDebug_SaveCacheSnapshot:
+		return SaveCacheSnapshot();
+	case ELoaderDebug_ReloadCacheSnapshot:
+		return ReloadCacheSnapshot();
 	default:
 		return KErrNotSupported;
 		}
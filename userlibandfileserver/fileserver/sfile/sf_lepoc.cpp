@@ -1287,10 +1287,12 @@ TInt E32Image::LoadProcess(const RLdrReq& aReq)
 	{
 	__LDRTRACE(aReq.Dump("E32Image::LoadProcess"));
 
+	TUint32 searchStart = User::FastCounter();
 	RImageFinder finder;
 	TInt r = finder.Set(aReq);
 	if (r == KErrNone)
 		r = finder.Search();
+	iPhaseTime[ELoadSearch] = User::FastCounter() - searchStart;
 	if (r!=KErrNone)
 		{
 		finder.Close();
@@ -1408,10 +1410,12 @@ TInt E32Image::LoadCodeSeg(const RLdrReq& aReq)
 		}
 #endif
 
+	TUint32 searchStart = User::FastCounter();
 	RImageFinder finder;
 	TInt r = finder.Set(aReq);
 	if (r == KErrNone)
 		r = finder.Search();
+	iPhaseTime[ELoadSearch] = User::FastCounter() - searchStart;
 	if (r!=KErrNone)
 		{
 		finder.Close();
@@ -1425,6 +1429,42 @@ TInt E32Image::DoLoadCodeSeg(const RLdrReq& aReq, RImageFinder& aFinder)
 	{
 	__LDRTRACE(aReq.Dump(">E32Image::DoLoadCodeSeg"));
 
+	TInt r = CreateCodeSeg(aFinder);
+	if (r!=KErrNone || !iCloseCodeSeg)
+		return r;	// failed, or code segment already loaded
+
+	if (!iRomImageHeader)
+		r=LoadToRam();
+	if (r==KErrNone)
+		{
+		iCloseCodeSeg=NULL;
+		if (iMain==this)
+			{
+			r=ProcessImports();	// this sets up gLoadeePath
+			// transfers ownership of clamp handle to codeseg; nulls handle if successful
+			if (r==KErrNone)
+				{
+				r=E32Loader::CodeSegLoaded(*this);
+				if ((r==KErrNone) && iUseCodePaging)
+					{
+					iFileClamp.iCookie[0]=0;// null handle to indicate 
+					iFileClamp.iCookie[1]=0;// transfer of ownership of clamp handle to codeseg
+					}
+				}
+			}
+		}
+
+	__IF_DEBUG(Printf("<DoLoadCodeSeg, r=%d, iIsDll=%d",r,iIsDll));
+	return r;
+	}
+
+/**
+Construct this image from the module found by aFinder, closing aFinder, and create a code
+segment for it unless it is already loaded.  If a new code segment is created iCloseCodeSeg
+is set, so the code segment is removed again if the rest of the load fails.
+*/
+TInt E32Image::CreateCodeSeg(RImageFinder& aFinder)
+	{
 	TInt r = Construct(aFinder);	// needs to find it if it's already loaded
 	aFinder.Close();
 	if (r!=KErrNone)
@@ -1448,32 +1488,8 @@ TInt E32Image::DoLoadCodeSeg(const RLdrReq& aReq, RImageFinder& aFinder)
 
 	__IF_DEBUG(Printf("CodeSeg create"));
 	r=E32Loader::CodeSegCreate(*this);
-	if (r!=KErrNone)
-		return r;
-	
-	iCloseCodeSeg=iHandle;	// so new code segment is removed if the load fails
-	if (!iRomImageHeader)
-		r=LoadToRam();
 	if (r==KErrNone)
-		{
-		iCloseCodeSeg=NULL;
-		if (iMain==this)
-			{
-			r=ProcessImports();	// this sets up gLoadeePath
-			// transfers ownership of clamp handle to codeseg; nulls handle if successful
-			if (r==KErrNone)
-				{
-				r=E32Loader::CodeSegLoaded(*this);
-				if ((r==KErrNone) && iUseCodePaging)
-					{
-					iFileClamp.iCookie[0]=0;// null handle to indicate 
-					iFileClamp.iCookie[1]=0;// transfer of ownership of clamp handle to codeseg
-					}
-				}
-			}
-		}
-
-	__IF_DEBUG(Printf("<DoLoadCodeSeg, r=%d, iIsDll=%d",r,iIsDll));
+		iCloseCodeSeg=iHandle;	// so new code segment is removed if the load fails
 	return r;
 	}
 
@@ -1966,6 +1982,17 @@ Fix up the import address table and the export table for real addresses.
 TInt E32Image::LoadToRam()
 	{
 	__IF_DEBUG(Printf("E32Image::LoadToRam %S",&iFileName));
+	return CompleteLoadToRam(ReadAndRelocate());
+	}
+
+
+/**
+The part of LoadToRam() which only touches this image, so may be run on an image load
+thread while other images are loaded.
+*/
+TInt E32Image::ReadAndRelocate()
+	{
+	__IF_DEBUG(Printf("E32Image::ReadAndRelocate %S",&iFileName));
 
 	// offset of data after code which will be erad into iRestOfFileData...
 	iConversionOffset = iHeader->iCodeOffset + iHeader->iCodeSize;
@@ -1985,6 +2012,7 @@ TInt E32Image::LoadToRam()
 	if(r!=KErrNone)
 		return r;
 
+	TUint32 relocateStart = User::FastCounter();
 	__IF_DEBUG(Printf("iHeader->iCodeRelocOffset %d",iHeader->iCodeRelocOffset));
 	r = ((E32ImageHeaderV*)iHeader)->ValidateRelocations(iRestOfFileData,iRestOfFileSize,iHeader->iCodeRelocOffset,iHeader->iCodeSize,iCodeRelocSection);
 	if(r!=KErrNone)
@@ -2005,10 +2033,33 @@ TInt E32Image::LoadToRam()
 	if(r==KErrNone)
     	r = ReadImportData();
 
+	iPhaseTime[ELoadRelocate] = User::FastCounter() - relocateStart;
 	return r;
 	}
 
 
+/**
+Finish loading this image to RAM after ReadAndRelocate() returned aResult.  This must run on
+the loader thread, in the order the code segments were created, so that code segment IDs are
+allocated the same way on every boot however the images were loaded.
+*/
+TInt E32Image::CompleteLoadToRam(TInt aResult)
+	{
+	// we're done with the file contents now, free up memory before resolving imports
+	if(iFileData)
+		{
+		gFileDataAllocator.Free(iFileData);
+		iFileData=NULL;
+		}
+
+	if(aResult==KErrNone)
+		aResult = SetCodeSegId();
+
+	__IF_DEBUG(Printf("E32Image::CompleteLoadToRam %S r=%d",&iFileName,aResult));
+	return aResult;
+	}
+
+
 TInt E32Image::ShouldBeCodePaged(TBool& aPage)
 /**
 	Determine whether this binary should be paged.  Some of this
@@ -2046,11 +2097,11 @@ TInt E32Image::ShouldBeCodePaged(TBool& aPage)
 	if (iFileData != NULL)
 		return KErrNone;
 
-	// 4. if not compressed with bytepair or uncompressed then unpaged
+	// 4. if not compressed with bytepair, LZ4 or uncompressed then unpaged
 	__IF_DEBUG(Printf("sbcp,iHeader=0x%08x", iHeader));
 	TUint32 comp = iHeader->CompressionType();
 	__IF_DEBUG(Printf("sbcp,comp=0x%x", comp));
-	if (comp != KUidCompressionBytePair && comp != KFormatNotCompressed)
+	if (comp != KUidCompressionBytePair && comp != KUidCompressionLz4 && comp != KFormatNotCompressed)
 		return KErrNone;
 
 	aPage = ETrue;
@@ -2196,7 +2247,7 @@ TInt E32Image::LoadCompressionData()
 		{
 		r = LoadCompressionDataNoCompress();
 		}
-	else if(compression==KUidCompressionBytePair)
+	else if(compression==KUidCompressionBytePair || compression==KUidCompressionLz4)
 		{
 		TRAP(r,LoadCompressionDataBytePairUnpakL());
 		}
@@ -2232,7 +2283,7 @@ void E32Image::LoadCompressionDataBytePairUnpakL()
 	TInt pos = iHeader->TotalSize();
 	User::LeaveIfError(iFile.Seek(ESeekStart,pos)); // Start at beginning of compressed data
 
-	CBytePairReader* reader = CBytePairFileReader::NewLC(iFile);
+	CBytePairReader* reader = CBytePairFileReader::NewLC(iFile, iHeader->CompressionType());
 
 	if (iHeader->iCodeSize)
 		{
@@ -2271,6 +2322,7 @@ TInt E32Image::LoadFile()
 	__IF_DEBUG(Printf("E32Image::LoadFile %S 0x%08x",&iFileName,iHeader->CompressionType()));
 
 	TUint compression = iHeader->CompressionType();
+	TUint32 start = User::FastCounter();
 
 	TInt r=KErrNone;
 	if(compression==KFormatNotCompressed)
@@ -2283,7 +2335,7 @@ TInt E32Image::LoadFile()
 		TRAP(r,LoadFileInflateL());
 		CHECK_FAILURE(r);
 		}
-	else if(compression==KUidCompressionBytePair)
+	else if(compression==KUidCompressionBytePair || compression==KUidCompressionLz4)
 		{
 		TRAP(r,LoadFileBytePairUnpakL());
 		CHECK_FAILURE(r);
@@ -2294,12 +2346,12 @@ TInt E32Image::LoadFile()
 		CHECK_FAILURE(r); // Fuzzer can't trigger this because header validation ensures compression type is OK
 		}
 
-	// we're done with the file contents now, free up memory before resolving imports
-	if(iFileData)
-		{
-		gFileDataAllocator.Free(iFileData);
-		iFileData=NULL;
-		}
+	// any time not spent reading the file was spent decompressing it
+	TUint32 elapsed = User::FastCounter() - start;
+	if(compression==KFormatNotCompressed)
+		iPhaseTime[ELoadRead] = elapsed;
+	else
+		iPhaseTime[ELoadDecompress] = elapsed - iPhaseTime[ELoadRead];
 
 	__IF_DEBUG(Printf("E32Image::LoadFile exiting %S r=%d",&iFileName,r));
 	return r;
@@ -2426,7 +2478,8 @@ void E32Image::LoadFileInflateL()
 	
 
 /**
-Read all image data into memory, decompressing it using the BytePair method.
+Read all image data into memory, decompressing it using the BytePair or LZ4 method.
+Both use the same container of independently compressed pages.
 If code isn't being demand paged the code part is read into #iCodeLoadAddress.
 The rest of the file data after the code part is read into #iRestOfFileData.
 */
@@ -2439,11 +2492,11 @@ void E32Image::LoadFileBytePairUnpakL()
 
 	CBytePairReader* reader;
 	if(iFileData)
-		reader = CBytePairReader::NewLC(iFileData+pos, iFileSize-pos);
+		reader = CBytePairReader::NewLC(iFileData+pos, iFileSize-pos, iHeader->CompressionType());
 	else
 		{
 		iFile.Seek(ESeekStart, pos);
-		reader = CBytePairFileReader::NewLC(iFile);
+		reader = CBytePairFileReader::NewLC(iFile, iHeader->CompressionType());
 		}
 
 	TBool codeLoaded = false;
@@ -2484,7 +2537,8 @@ void E32Image::LoadFileBytePairUnpakL()
 		if(bytes!=iRestOfFileSize)
 			User::Leave(KErrCorrupt);
 		}
-		
+
+	iPhaseTime[ELoadRead] = reader->ReadTime();
 	CleanupStack::PopAndDestroy(reader);
 	}
 
@@ -2516,39 +2570,42 @@ TInt E32Image::RelocateCode()
 	if(r==KErrNone)
 		r = RelocateExports();
 
-	if(r==KErrNone)
-		{
-		// put a unique ID into the third word after the entry point
+	return r;
+	}
 
-		// address for ID...
-		TLinAddr csid_addr = iFileEntryPoint+KCodeSegIdOffset-iCodeRunAddress+iCodeLoadAddress;
-		__IF_DEBUG(Printf("csid_addr %08x", csid_addr));
 
-		// get existing ID...
-		TUint x;
-		WordCopy(&x, (const TAny*)csid_addr, sizeof(x));
-		if(x==0)
-			{
-			// generate next ID...
-			if(++NextCodeSegId == 0xffffffffu)
-				Fault(ELdrCsIdWrap);
-			__IF_DEBUG(Printf("NextCSID %08x", NextCodeSegId));
-			// store ID...
-			if(!iUseCodePaging)
-				WordCopy((TAny*)csid_addr, &NextCodeSegId, sizeof(NextCodeSegId));
-			else
-				{
-				// demand paged code needs modifying when paged in, so add ID as a new 'fixup'...
-				TUint64* fixup = ExpandFixups(1);
-				if(!fixup)
-					r = KErrNoMemory;
-				else
-					*fixup = MAKE_TUINT64(csid_addr,NextCodeSegId);
-				}
-			}
-		}
+/**
+Put a unique ID into the third word after the entry point, unless the image already has one.
+*/
+TInt E32Image::SetCodeSegId()
+	{
+	// address for ID...
+	TLinAddr csid_addr = iFileEntryPoint+KCodeSegIdOffset-iCodeRunAddress+iCodeLoadAddress;
+	__IF_DEBUG(Printf("csid_addr %08x", csid_addr));
 
-	return r;
+	// get existing ID...
+	TUint x;
+	WordCopy(&x, (const TAny*)csid_addr, sizeof(x));
+	if(x!=0)
+		return KErrNone;
+
+	// generate next ID...
+	if(++NextCodeSegId == 0xffffffffu)
+		Fault(ELdrCsIdWrap);
+	__IF_DEBUG(Printf("NextCSID %08x", NextCodeSegId));
+
+	// store ID...
+	if(!iUseCodePaging)
+		WordCopy((TAny*)csid_addr, &NextCodeSegId, sizeof(NextCodeSegId));
+	else
+		{
+		// demand paged code needs modifying when paged in, so add ID as a new 'fixup'...
+		TUint64* fixup = ExpandFixups(1);
+		if(!fixup)
+			return KErrNoMemory;
+		*fixup = MAKE_TUINT64(csid_addr,NextCodeSegId);
+		}
+	return KErrNone;
 	}
 
 
@@ -2886,6 +2943,7 @@ TInt E32Image::ProcessImports()
 			UseFloppy = EDriveB;
 		}
 #endif
+	TUint32 start = User::FastCounter();
 	RImageArray array;
 	TInt r = array.Add(this);
 	if (r==KErrNone)
@@ -2893,7 +2951,10 @@ TInt E32Image::ProcessImports()
 	if (r==KErrNone)
 		r = FixupDlls(array);
 	if (r==KErrNone)
+		{
+		TraceLoadTimes(array, start);
 		r = FinaliseDlls(array);
+		}
 	CleanupDlls(array);
 	array.Close();
 
@@ -2919,6 +2980,27 @@ void E32Image::CleanupDlls(RImageArray& aArray)
 		}
 	}
 
+/**
+Output the time spent in each phase of loading each image that was loaded into RAM, and
+the time taken to load all of the dependencies of this one.
+*/
+void E32Image::TraceLoadTimes(RImageArray& aArray, TUint32 aStartTime)
+	{
+	TUint32 total = User::FastCounter() - aStartTime;
+	TUint32 info[2] = { 0, Max(iLoadThreads, 1) };	// images loaded, threads loading them
+	TInt n = aArray.Count();
+	for (TInt i=0; i<n; ++i)
+		{
+		E32Image* e = aArray[i];
+		if (e->iAlreadyLoaded || e->iRomImageHeader || !e->iHandle)
+			continue;
+		++info[0];
+		BTraceN(BTrace::ELoader, BTrace::ELoaderImageTimes, e->iHandle, e->iPhaseTime[ELoadSearch],
+				&e->iPhaseTime[ELoadRead], sizeof(TUint32) * (ELoadPhases - 1));
+		}
+	BTraceN(BTrace::ELoader, BTrace::ELoaderLoadDone, iHandle, total, info, sizeof(info));
+	}
+
 TInt E32Image::FinaliseDlls(RImageArray& aArray)
 	{
 	__IF_DEBUG(Printf("E32Image::FinaliseDlls"));
@@ -2952,6 +3034,107 @@ TInt E32Image::LoadDlls(RImageArray& aArray)
 //
 	{
 	__IF_DEBUG(Printf("E32Image::LoadDlls"));
+
+	// Find the modules this one references and create code segments for the new ones, in
+	// import order so that code segments are always created in the same order, then read
+	// and relocate all the new ones together.
+	RPointerArray<E32Image> newDlls;
+	TInt r = ResolveDlls(aArray, newDlls);
+	if (r==KErrNone)
+		r = LoadNewDlls(newDlls);
+	newDlls.Close();
+	if (r!=KErrNone)
+		return r;
+
+	E32ImportSection* importSection=(E32ImportSection *)iImportData;
+	E32ImportBlock* block;
+	if(importSection)
+		block=(E32ImportBlock*)(importSection+1);
+	else
+		block=NULL;
+	const TRomImageHeader* const * pR=NULL;
+	if (iRomImageHeader)
+		pR=iRomImageHeader->iDllRefTable->iEntry;
+
+	// For each module referenced by this module
+	for (TInt i=0; i<iDepCount; ++i)
+		{
+		E32Image* e;
+		if (pR)
+			e = aArray.Find(*pR++);
+		else
+			{
+			e = (E32Image*)block->iOffsetOfDllName;	// ResolveDlls() set this to the exporter
+			block = (E32ImportBlock*)block->NextBlock(iHeader->ImportFormat());
+			}
+
+		//	Now go nice and recursive, and call LoadDlls on a new dll which 
+		//	imports anything, unless an earlier import has already done so
+		//	This recursive horror *will* terminate because it is only called
+		//	once on each "new" dll
+		if (e->iLoadDllsPending)
+			{
+			e->iLoadDllsPending = EFalse;
+			__IF_DEBUG(Printf("****Going recursive****"));
+			r = e->LoadDlls(aArray);
+			__IF_DEBUG(Printf("****Returned from recursion****"));
+			if (r!=KErrNone)
+				{
+				return r;
+				}
+			}
+
+		// If we added an SMP unsafe dependent, this image is SMP unsafe.
+		// This is done after recursing into LoadDlls, so a single unsafe
+		// dependent anywhere down the tree will poison everything above it.
+		// This isn't sufficient to deal with cycles, though, so the kernel
+		// also has to update the flag in DCodeSeg::FinaliseRecursiveFlags.
+		// It has to be done here first because the kernel doesn't know
+		// about XIP DLLs that don't have a codeseg created.
+		if (!(e->iAttr & ECodeSegAttSMPSafe))
+			{
+			__IF_DEBUG(Printf("%S is not SMP safe because it loads %S", &iFileName, &e->iFileName));
+			iAttr &= ~ECodeSegAttSMPSafe;
+			}
+
+		// If exporter is an EXE it must be the same as the client process or newly created process
+		__IF_DEBUG(Printf("Check EXE->EXE"));
+		if (gExeCodeSeg && !e->iIsDll && e->iHandle!=gExeCodeSeg)
+			return KErrNotSupported;
+
+		// A globally-visible module may only link to other globally visible modules
+		__IF_DEBUG(Printf("Check Global Attribute"));
+		if ( (iAttr&ECodeSegAttGlobal) && !(e->iAttr&ECodeSegAttGlobal) )
+			return KErrNotSupported;
+
+		// A ram-loaded globally-visible module may only link to ROM XIP modules with no static data
+		__IF_DEBUG(Printf("Check RAM Global"));
+		if ( (iAttr&ECodeSegAttGlobal) && !iRomImageHeader && e->iHandle)
+			return KErrNotSupported;
+
+		if (e->iHandle)
+			{
+			//	Record the dependence of this on e
+			r=E32Loader::CodeSegAddDependency(iHandle, e->iHandle);
+			if (r!=KErrNone)
+				{
+				return r;
+				}
+			}
+		}
+	__IF_DEBUG(Printf("E32Image::LoadDlls OK"));
+	return KErrNone;
+	}
+
+
+TInt E32Image::ResolveDlls(RImageArray& aArray, RPointerArray<E32Image>& aNewDlls)
+//
+// Find each DLL referenced by this one, adding any not already in the array.
+// New DLLs loaded from ROM are completely loaded; others only have their code
+// segments created, and are added to aNewDlls to be loaded by LoadNewDlls().
+//
+	{
+	__IF_DEBUG(Printf("E32Image::ResolveDlls"));
 	TInt r=KErrNone;
 	E32ImportSection* importSection=(E32ImportSection *)iImportData;
 	E32ImportBlock* block;
@@ -2974,6 +3157,7 @@ TInt E32Image::LoadDlls(RImageArray& aArray)
 		RLdrReq req;		// new loader request to load referenced module
 		TBuf8<KMaxKernelName> rootname;
 		req.iFileName = (HBufC8*)&rootname;
+		TUint32 searchStart = User::FastCounter();
 
 		if (pR)
 			{
@@ -3063,9 +3247,10 @@ TInt E32Image::LoadDlls(RImageArray& aArray)
 				}
 			else
 				{
-				// loading a DLL by name
-				r = e->DoLoadCodeSeg(req, finder); // also closes 'finder'
-				__IF_DEBUG(Printf("%S DoLoadCodeSeg returned %d",req.iFileName,r));
+				// creating the code segment for a DLL by name, to be loaded by LoadNewDlls()
+				e->iPhaseTime[ELoadSearch] = User::FastCounter() - searchStart;
+				r = e->CreateCodeSeg(finder); // also closes 'finder'
+				__IF_DEBUG(Printf("%S CreateCodeSeg returned %d",req.iFileName,r));
 				}
 
 			//	Add the new entry to the array
@@ -3079,66 +3264,180 @@ TInt E32Image::LoadDlls(RImageArray& aArray)
 				delete e;
 				return r;
 				}
-						
-			//	Now go nice and recursive, and call LoadDlls on this latest dll, if it 
-			//	imports anything
-			//	This recursive horror *will* terminate because it is only called
-			//	on "new" dlls
-			if (e->iDepCount && !e->iAlreadyLoaded && e->iIsDll)
+			if (e->iCloseCodeSeg && !e->iRomImageHeader)
 				{
-				__IF_DEBUG(Printf("****Going recursive****"));
-				r = e->LoadDlls(aArray);
-				__IF_DEBUG(Printf("****Returned from recursion****"));
+				r = aNewDlls.Append(e);
 				if (r!=KErrNone)
-					{
 					return r;
-					}
 				}
-
+			e->iLoadDllsPending = e->iDepCount && !e->iAlreadyLoaded && e->iIsDll;
 			}
 
-		// If we added an SMP unsafe dependent, this image is SMP unsafe.
-		// This is done after recursing into LoadDlls, so a single unsafe
-		// dependent anywhere down the tree will poison everything above it.
-		// This isn't sufficient to deal with cycles, though, so the kernel
-		// also has to update the flag in DCodeSeg::FinaliseRecursiveFlags.
-		// It has to be done here first because the kernel doesn't know
-		// about XIP DLLs that don't have a codeseg created.
-		if (!(e->iAttr & ECodeSegAttSMPSafe))
-			{
-			__IF_DEBUG(Printf("%S is not SMP safe because it loads %S", &iFileName, &e->iFileName));
-			iAttr &= ~ECodeSegAttSMPSafe;
-			}
+		if (thisBlock)
+			thisBlock->iOffsetOfDllName=(TUint32)e;   // For easy access when fixing up imports
+		}
+	return KErrNone;
+	}
 
-		// If exporter is an EXE it must be the same as the client process or newly created process
-		__IF_DEBUG(Printf("Check EXE->EXE"));
-		if (gExeCodeSeg && !e->iIsDll && e->iHandle!=gExeCodeSeg)
-			return KErrNotSupported;
 
-		// A globally-visible module may only link to other globally visible modules
-		__IF_DEBUG(Printf("Check Global Attribute"));
-		if ( (iAttr&ECodeSegAttGlobal) && !(e->iAttr&ECodeSegAttGlobal) )
-			return KErrNotSupported;
+/**
+Read and relocate each of the new DLLs in aArray.  If there are several and spare CPUs they
+are shared out between the image load threads and this one.  The DLLs are then completed in
+array order, so that the results are the same however they were loaded.
+*/
+TInt E32Image::LoadNewDlls(RPointerArray<E32Image>& aArray)
+	{
+	TInt count = aArray.Count();
+	if (count==0)
+		return KErrNone;
+	__IF_DEBUG(Printf("E32Image::LoadNewDlls %d",count));
 
-		// A ram-loaded globally-visible module may only link to ROM XIP modules with no static data
-		__IF_DEBUG(Printf("Check RAM Global"));
-		if ( (iAttr&ECodeSegAttGlobal) && !iRomImageHeader && e->iHandle)
-			return KErrNotSupported;
+	TInt* results = NULL;
+	if (count>1 && ImageLoadThreads::Count()>0)
+		results = new TInt[count];
+	if (results)
+		{
+		SImageLoadJob job;
+		job.iImages = &aArray[0];
+		job.iResults = results;
+		job.iCount = count;
+		job.iNextImage = 0;
+		TInt threads = 1 + ImageLoadThreads::Run(job);
+		if (iMain->iLoadThreads < threads)
+			iMain->iLoadThreads = threads;
+		}
 
-		if (thisBlock)
-			thisBlock->iOffsetOfDllName=(TUint32)e;   // For easy access when fixing up imports
-		if (e->iHandle)
-			{
-			//	Record the dependence of this on e
-			r=E32Loader::CodeSegAddDependency(iHandle, e->iHandle);
-			if (r!=KErrNone)
-				{
-				return r;
-				}
-			}
+	TInt r = KErrNone;
+	for (TInt i=0; i<count && r==KErrNone; ++i)
+		{
+		E32Image* e = aArray[i];
+		r = e->CompleteLoadToRam(results ? results[i] : e->ReadAndRelocate());
+		if (r==KErrNone)
+			e->iCloseCodeSeg = NULL;
+		}
+	delete[] results;
+	__IF_DEBUG(Printf("E32Image::LoadNewDlls returns %d",r));
+	return r;
+	}
+
+
+// ImageLoadThreads - helpers for loading several DLLs on several CPUs
+
+
+_LIT(KImageLoadThreadName, "LoaderImageLoad%d");
+const TInt KImageLoadThreadStackSize = 0x4000;
+
+TInt ImageLoadThreads::iCount = -1;
+RSemaphore ImageLoadThreads::iStart;
+RSemaphore ImageLoadThreads::iDone;
+SImageLoadJob* ImageLoadThreads::iJob = NULL;
+
+
+/**
+Return the number of threads available to help load images, creating them if this is the
+first time it has been called.  Only the loader thread may call this.
+*/
+TInt ImageLoadThreads::Count()
+	{
+	if (iCount < 0)
+		{
+		iCount = 0;
+		// images being loaded on these threads may decompress pages in parallel, so the page
+		// decompression threads must already exist...
+		PageDecompressThreads::Count();
+		TInt r = Create();
+		__IF_DEBUG(Printf("ImageLoadThreads::Create r=%d count=%d", r, iCount));
+		(void)r;
+		}
+	return iCount;
+	}
+
+
+TInt ImageLoadThreads::Create()
+	{
+	TInt cpus = UserSvr::HalFunction(EHalGroupKernel, EKernelHalNumLogicalCpus, 0, 0);
+	TInt count = Min(cpus - 1, KMaxImageLoadThreads);
+	if (count <= 0)
+		return KErrNone;
+
+	TInt r = iStart.CreateLocal(0);
+	if (r != KErrNone)
+		return r;
+	r = iDone.CreateLocal(0);
+	if (r != KErrNone)
+		{
+		iStart.Close();
+		return r;
+		}
+
+	// the threads share the loader heap and file server session...
+	TThreadPriority priority = RThread().Priority();
+	for (TInt i = 0; i < count; ++i)
+		{
+		TBuf<KMaxKernelName> name;
+		name.Format(KImageLoadThreadName, i);
+		RThread thread;
+		r = thread.Create(name, ThreadFunction, KImageLoadThreadStackSize, NULL, NULL);
+		if (r != KErrNone)
+			break;
+		TRequestStatus started;
+		thread.Rendezvous(started);
+		thread.SetPriority(priority);
+		thread.Resume();
+		User::WaitForRequest(started);
+		thread.Close();
+		r = started.Int();
+		if (r != KErrNone)
+			break;
+		++iCount;
+		}
+	return r;
+	}
+
+
+TInt ImageLoadThreads::ThreadFunction(TAny*)
+	{
+	// loading an image uses the cleanup stack...
+	CTrapCleanup* cleanup = CTrapCleanup::New();
+	if (!cleanup)
+		return KErrNoMemory;
+	RThread::Rendezvous(KErrNone);
+	for (;;)
+		{
+		iStart.Wait();
+		LoadImages(*iJob);
+		iDone.Signal();
+		}
+	}
+
+
+/**
+Read and relocate the images of aJob on this thread and as many helper threads as are useful,
+returning the number of helper threads used when they have all been done.
+*/
+TInt ImageLoadThreads::Run(SImageLoadJob& aJob)
+	{
+	TInt helpers = Min(iCount, aJob.iCount - 1);
+	iJob = &aJob;
+	if (helpers > 0)
+		iStart.Signal(helpers);
+	LoadImages(aJob);
+	for (TInt i = 0; i < helpers; ++i)
+		iDone.Wait();
+	iJob = NULL;
+	return helpers;
+	}
+
+
+void ImageLoadThreads::LoadImages(SImageLoadJob& aJob)
+	{
+	for (;;)
+		{
+		TInt i = User::LockedInc(aJob.iNextImage);
+		if (i >= aJob.iCount)
+			break;
+		aJob.iResults[i] = aJob.iImages[i]->ReadAndRelocate();
 		}
-	__IF_DEBUG(Printf("E32Image::LoadDlls OK"));
-	return KErrNone;
 	}
 
 
@@ -3179,6 +3478,7 @@ TInt E32Image::FixupDlls(RImageArray& aArray)
 
 		E32Image* imp = aArray[i];
 		__IF_DEBUG(Printf("Dll number %d %S",i,&imp->iFileName));
+		TUint32 start = User::FastCounter();
 
 		const E32ImportSection* importSection = (const E32ImportSection*)imp->iImportData;
 		if (!importSection)
@@ -3254,6 +3554,7 @@ TInt E32Image::FixupDlls(RImageArray& aArray)
 			if (r != KErrNone)
 				return r;
 			}
+		imp->iPhaseTime[ELoadFixup] = User::FastCounter() - start;
 		}
 
 	__IF_DEBUG(Printf("E32Image::FixupDlls OK"));
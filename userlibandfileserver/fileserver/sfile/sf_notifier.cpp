@@ -22,6 +22,11 @@ CFsObjectCon* FsNotificationManager::iNotifyRequests = NULL;
 RFastLock FsNotificationManager::iChainLock;
 TInt FsNotificationManager::iFilterRegister[];
 CFsPool<CFsNotificationBlock>* FsNotificationManager::iPool;
+CFsNotificationPathTrie* FsNotificationManager::iFilterIndex[KMaxDrives+1][KNumRegisterableFilters];
+TBool FsNotificationManager::iFilterIndexValid = EFalse;
+
+//Slot in FsNotificationManager::iFilterIndex for filters which aren't tied to a drive
+const TInt KFilterIndexAnyDrive = KMaxDrives;
 
 
 CFsNotificationPathFilter* CFsNotificationPathFilter::NewL(const TDesC& aPath, const TDesC& aFilename, TInt aDriveNum)
@@ -54,6 +59,164 @@ CFsNotificationPathFilter::CFsNotificationPathFilter()
 	{
 	}
 
+CFsNotificationTrieNode* CFsNotificationTrieNode::NewL(const TDesC& aName)
+	{
+	CFsNotificationTrieNode* self = new(ELeave) CFsNotificationTrieNode();
+	CleanupStack::PushL(self);
+	self->iName = aName.AllocL();
+	CleanupStack::Pop(self);
+	return self;
+	}
+
+CFsNotificationTrieNode::~CFsNotificationTrieNode()
+	{
+	iChildren.ResetAndDestroy();
+	iExact.Close();
+	iWild.Close();
+	delete iName;
+	}
+
+//Binary search of iChildren.
+//If there is no child called aName, aIndex is set to where it would be inserted.
+TInt CFsNotificationTrieNode::FindChild(const TDesC& aName, TInt& aIndex) const
+	{
+	TInt low = 0;
+	TInt high = iChildren.Count();
+	while(low < high)
+		{
+		TInt mid = (low + high) >> 1;
+		TInt c = aName.CompareF(*iChildren[mid]->iName);
+		if(c == 0)
+			{
+			aIndex = mid;
+			return KErrNone;
+			}
+		if(c < 0)
+			high = mid;
+		else
+			low = mid + 1;
+		}
+	aIndex = low;
+	return KErrNotFound;
+	}
+
+CFsNotificationTrieNode* CFsNotificationTrieNode::Child(const TDesC& aName) const
+	{
+	TInt index;
+	if(FindChild(aName,index) != KErrNone)
+		return NULL;
+	return iChildren[index];
+	}
+
+CFsNotificationTrieNode* CFsNotificationTrieNode::ChildL(const TDesC& aName)
+	{
+	TInt index;
+	if(FindChild(aName,index) == KErrNone)
+		return iChildren[index];
+	
+	CFsNotificationTrieNode* child = CFsNotificationTrieNode::NewL(aName);
+	CleanupStack::PushL(child);
+	iChildren.InsertL(child,index);
+	CleanupStack::Pop(child);
+	return child;
+	}
+
+CFsNotificationPathTrie* CFsNotificationPathTrie::NewL()
+	{
+	CFsNotificationPathTrie* self = new(ELeave) CFsNotificationPathTrie();
+	CleanupStack::PushL(self);
+	self->iRoot = CFsNotificationTrieNode::NewL(KNullDesC);
+	CleanupStack::Pop(self);
+	return self;
+	}
+
+CFsNotificationPathTrie::~CFsNotificationPathTrie()
+	{
+	delete iRoot;
+	}
+
+//The filter's path is a pattern for TDesC::MatchF against the operation's DriveAndPath.
+//So an operation can only match if its path starts with the part of the pattern before
+//the first wildcard, and it can only match exactly if the pattern has no wildcards.
+void CFsNotificationPathTrie::AddL(const TFsNotificationTrieEntry& aEntry)
+	{
+	const TDesC& path = *aEntry.iFilter->iPath;
+	TInt literalLength = path.Length();
+	for(TInt i = 0; i < path.Length(); i++)
+		{
+		if(path[i] == '*' || path[i] == '?')
+			{
+			literalLength = i;
+			break;
+			}
+		}
+	
+	//Walk down to the last whole directory before any wildcard
+	CFsNotificationTrieNode* node = iRoot;
+	TInt dirsLength = path.Left(literalLength).LocateReverse(KPathDelimiter);
+	if(dirsLength >= 0)
+		{
+		TPtrC dirs(path.Left(dirsLength));
+		TInt pos = 0;
+		FOREVER
+			{
+			TPtrC rest(dirs.Mid(pos));
+			TInt sep = rest.Locate(KPathDelimiter);
+			node = node->ChildL(sep < 0 ? rest : rest.Left(sep));
+			if(sep < 0)
+				break;
+			pos += sep + 1;
+			}
+		}
+	
+	if(literalLength == path.Length() && dirsLength == path.Length() - 1)
+		node->iExact.AppendL(aEntry);
+	else
+		node->iWild.AppendL(aEntry);
+	}
+
+static TInt AppendTrieEntries(const RArray<TFsNotificationTrieEntry>& aEntries, RArray<TFsNotificationTrieEntry>& aCandidates)
+	{
+	TInt count = aEntries.Count();
+	for(TInt i = 0; i < count; i++)
+		{
+		TInt r = aCandidates.Append(aEntries[i]);
+		if(r != KErrNone)
+			return r;
+		}
+	return KErrNone;
+	}
+
+TInt CFsNotificationPathTrie::FindCandidates(const TDesC& aPath, RArray<TFsNotificationTrieEntry>& aCandidates) const
+	{
+	CFsNotificationTrieNode* node = iRoot;
+	TInt r = AppendTrieEntries(node->iWild,aCandidates);
+	
+	TInt dirsLength = aPath.LocateReverse(KPathDelimiter);
+	if(dirsLength < 0)
+		return r;
+	
+	//Every directory on the way down has filters whose wildcards could match the rest of aPath
+	TPtrC dirs(aPath.Left(dirsLength));
+	TInt pos = 0;
+	while(r == KErrNone)
+		{
+		TPtrC rest(dirs.Mid(pos));
+		TInt sep = rest.Locate(KPathDelimiter);
+		node = node->Child(sep < 0 ? rest : rest.Left(sep));
+		if(!node)
+			return KErrNone;
+		r = AppendTrieEntries(node->iWild,aCandidates);
+		if(sep < 0)
+			break;
+		pos += sep + 1;
+		}
+	
+	if(r == KErrNone && dirsLength == aPath.Length() - 1)
+		r = AppendTrieEntries(node->iExact,aCandidates);
+	return r;
+	}
+
 CFsNotifyRequest* CFsNotifyRequest::NewL()
 	{
 	CFsNotifyRequest* self = new(ELeave) CFsNotifyRequest();
@@ -342,6 +505,10 @@ void FsNotificationManager::SetFilterRegister(TUint aFilter, TBool aAdd, TInt aC
 	TInt& fr = FsNotificationManager::FilterRegister(index);
 	__ASSERT_DEBUG((aAdd) ? fr >= 0 : fr > 0,Fault(ENotificationFault));
 	fr+= aAdd ? aCount : -aCount; 
+	
+	//Filters have been added or removed so the index needs rebuilding.
+	//This is called with the iChainLock held, so HandleChange can't miss it while rebuilding.
+	iFilterIndexValid = EFalse;
 	}
 
 void FsNotificationManager::SetFilterRegisterMask(TUint aMask,TBool aAdd)
@@ -379,6 +546,75 @@ void FsNotificationManager::Close()
 		iPool = NULL;
 		}
 	request = NULL;
+	DeleteFilterIndex();
+	iFilterIndexValid = EFalse;
+	}
+
+//Must be called with the iChainLock
+TInt FsNotificationManager::UpdateFilterIndex()
+	{
+	if(iFilterIndexValid)
+		return KErrNone;
+	
+	__PRINT(_L("FsNotificationManager::UpdateFilterIndex() - rebuilding"));
+	DeleteFilterIndex();
+	TRAPD(r,BuildFilterIndexL());
+	if(r != KErrNone)
+		{
+		DeleteFilterIndex();
+		return r;
+		}
+	iFilterIndexValid = ETrue;
+	return KErrNone;
+	}
+
+void FsNotificationManager::BuildFilterIndexL()
+	{
+	TInt count = iNotifyRequests->Count();
+	for(TInt i = 0; i < count; i++)
+		{
+		CFsNotifyRequest* notifyRequest = (CFsNotifyRequest*)(*iNotifyRequests)[i];
+		
+		//For every drive with filters set...
+		RHashMap<TInt,TFsNotificationTypeDriveArray>::TIter iterator(notifyRequest->iDrivesTypesFiltersMap);
+		for(const TInt* driveNum = iterator.NextKey(); driveNum; driveNum = iterator.NextKey())
+			{
+			TInt slot = (*driveNum == KErrNotFound) ? KFilterIndexAnyDrive : *driveNum;
+			if(slot < EDriveA || slot > KFilterIndexAnyDrive)
+				continue;
+			
+			TFsNotificationTypeDriveArray& driveFilters = *iterator.CurrentValue();
+			TInt numTypes = Min(driveFilters.Count(),KNumRegisterableFilters);
+			for(TInt filterType = 0; filterType < numTypes; filterType++)
+				{
+				TFsNotificationTypeArray& filterList = driveFilters[filterType];
+				TInt numFilters = filterList.Count();
+				for(TInt j = 0; j < numFilters; j++)
+					{
+					CFsNotificationPathTrie*& trie = iFilterIndex[slot][filterType];
+					if(!trie)
+						trie = CFsNotificationPathTrie::NewL();
+					
+					TFsNotificationTrieEntry entry;
+					entry.iRequest = notifyRequest;
+					entry.iFilter = filterList[j].iPathFilter;
+					trie->AddL(entry);
+					}
+				}
+			}
+		}
+	}
+
+void FsNotificationManager::DeleteFilterIndex()
+	{
+	for(TInt slot = 0; slot <= KFilterIndexAnyDrive; slot++)
+		{
+		for(TInt filterType = 0; filterType < KNumRegisterableFilters; filterType++)
+			{
+			delete iFilterIndex[slot][filterType];
+			iFilterIndex[slot][filterType] = NULL;
+			}
+		}
 	}
 
 TInt FsNotificationManager::Count()
@@ -853,6 +1089,16 @@ void FsNotificationManager::HandleChange(CFsNotificationInfo& aRequest)
                 return;
                 }
             
+            //Apart from EMediaChange, which is reported regardless of filters,
+            //only check the filters indexed under the path that has changed.
+            //If the index can't be built then fall back to checking every filter.
+            if(aRequest.NotificationType() != TFsNotification::EMediaChange &&
+               (seenFilter == 0 || DoHandleChangeIndexed(aRequest,index) == KErrNone))
+                {
+                Unlock();
+                return;
+                }
+            
             //For every notification request(i.e. every CFsNotify client-side).
             for(TInt i=0; i<count && seenFilter; ++i)
                 {
@@ -955,51 +1201,146 @@ void FsNotificationManager::DoHandleChange(TFsNotificationTypeArray* aFilterType
 		//Is the correct notification type
 		aSeenFilter--;
 		
-		TBool filterMatch = EDifferent;
         if(aNotificationInfo.NotificationType()  != TFsNotification::EMediaChange)
 			{
 			CFsNotificationPathFilter& filter = *(((*aFilterTypeArray)[j]).iPathFilter);
-            __PRINT2(_L("FsNotificationManager::DoHandleChange() operationName=%S, filterName=%S"),&aNotificationInfo.Source().FullName(),filter.iPath);
-            
-			//buferMsg here is the message of the client *recieving* the notification
-            const RMessage2& bufferMsg = aNotifyRequest->BufferMessage();
-            filterMatch = DoMatchFilter(bufferMsg,aNotificationInfo.Source().FullName(),filter);
-			if(filterMatch == FsNotificationManager::EContinue)
-			    continue; //triggers for data cages
-			
-			//We need to check for changes coming in to a directory when its rename
-            if(aNotificationInfo.NotificationType() == TFsNotification::ERename && filterMatch==FsNotificationManager::EDifferent)  
-                {
-                __PRINT2(_L("FsNotificationManager::DoHandleChange() destinationName=%S, filterName=%S"),&aNotificationInfo.NewName().FullName(),filter.iPath);
-                if(aNotificationInfo.DestDriveIsSet())
-                    filterMatch = DoMatchFilter(bufferMsg,aNotificationInfo.NewName().FullName().Mid(2),filter);
-                else
-                    filterMatch = DoMatchFilter(bufferMsg,aNotificationInfo.NewName().FullName(),filter);
-                }
+			if(DoMatchChange(aNotificationInfo,filter,aNotifyRequest) != FsNotificationManager::EMatch)
+			    continue; //next filter
 			}
 
-        if(filterMatch || (aNotificationInfo.NotificationType() == TFsNotification::EMediaChange))//Match or MediaChange (report regardless of filters)
+		//Match or MediaChange (report regardless of filters) - Handle change
+		if(DoNotifyChange(aNotificationInfo,aNotifyRequest) != KErrNone)
+			break; //Go to outer for (i.e. next request in HandleChange)
+		}
+	}
+
+//Called from DoHandleChange and DoHandleChangeIndexed
+FsNotificationManager::TFsNotificationFilterMatch FsNotificationManager::DoMatchChange(CFsNotificationInfo& aNotificationInfo, CFsNotificationPathFilter& aFilter, CFsNotifyRequest* aNotifyRequest)
+	{
+	__PRINT2(_L("FsNotificationManager::DoMatchChange() operationName=%S, filterName=%S"),&aNotificationInfo.Source().FullName(),aFilter.iPath);
+	
+	//buferMsg here is the message of the client *recieving* the notification
+	const RMessage2& bufferMsg = aNotifyRequest->BufferMessage();
+	TFsNotificationFilterMatch filterMatch = DoMatchFilter(bufferMsg,aNotificationInfo.Source().FullName(),aFilter);
+	
+	//We need to check for changes coming in to a directory when its rename
+	if(aNotificationInfo.NotificationType() == TFsNotification::ERename && filterMatch==FsNotificationManager::EDifferent)  
+		{
+		__PRINT2(_L("FsNotificationManager::DoMatchChange() destinationName=%S, filterName=%S"),&aNotificationInfo.NewName().FullName(),aFilter.iPath);
+		if(aNotificationInfo.DestDriveIsSet())
+			filterMatch = DoMatchFilter(bufferMsg,aNotificationInfo.NewName().FullName().Mid(2),aFilter);
+		else
+			filterMatch = DoMatchFilter(bufferMsg,aNotificationInfo.NewName().FullName(),aFilter);
+		}
+	return filterMatch;
+	}
+
+TInt FsNotificationManager::DoNotifyChange(CFsNotificationInfo& aNotificationInfo, CFsNotifyRequest* aNotifyRequest)
+	{
+	//Get a CFsNotificationBlock to use 
+	//So that we can do IPC from a single place.
+	CFsNotificationBlock* block = iPool->Allocate();
+		
+	TInt r = aNotifyRequest->NotifyChange(&aNotificationInfo,*block);
+		
+	//Free block
+	iPool->Free(block);
+		
+	if(r != KErrNone)
+		{
+		//Something went wrong writing to the client's buffer
+		aNotifyRequest->SetActive(CFsNotifyRequest::EInactive);
+		if(aNotifyRequest->ClientMsgHandle()!=0)
+			aNotifyRequest->CompleteClientRequest(r,EFalse);
+		}
+	return r;
+	}
+
+//Orders the candidates by request, then by filter, so that each request is handled in one go
+//and a filter which was found under both names of a rename can be skipped the second time.
+static TInt CompareTrieEntries(const TFsNotificationTrieEntry& aLeft, const TFsNotificationTrieEntry& aRight)
+	{
+	if(aLeft.iRequest != aRight.iRequest)
+		return (TLinAddr)aLeft.iRequest < (TLinAddr)aRight.iRequest ? -1 : 1;
+	if(aLeft.iFilter != aRight.iFilter)
+		return (TLinAddr)aLeft.iFilter < (TLinAddr)aRight.iFilter ? -1 : 1;
+	return 0;
+	}
+
+static TInt FindTrieCandidates(CFsNotificationPathTrie* aDriveIndex, CFsNotificationPathTrie* aAnyDriveIndex, const TDesC& aOperationName, RArray<TFsNotificationTrieEntry>& aCandidates)
+	{
+	TParsePtrC parseOp(aOperationName);
+	TInt r = KErrNone;
+	if(aDriveIndex)
+		r = aDriveIndex->FindCandidates(parseOp.DriveAndPath(),aCandidates);
+	if(r == KErrNone && aAnyDriveIndex)
+		r = aAnyDriveIndex->FindCandidates(parseOp.DriveAndPath(),aCandidates);
+	return r;
+	}
+
+const TInt KFilterCandidatesGranularity = 16;
+
+//Must be called with the iChainLock
+TInt FsNotificationManager::DoHandleChangeIndexed(CFsNotificationInfo& aNotificationInfo, TInt aIndex)
+	{
+	__PRINT(_L("FsNotificationManager::DoHandleChangeIndexed()"));
+	
+	TInt r = UpdateFilterIndex();
+	if(r != KErrNone)
+		return r;
+	
+	TInt driveNum = aNotificationInfo.DriveNumber();
+	CFsNotificationPathTrie* driveIndex = (driveNum >= EDriveA && driveNum <= EDriveZ) ? iFilterIndex[driveNum][aIndex] : NULL;
+	CFsNotificationPathTrie* anyDriveIndex = iFilterIndex[KFilterIndexAnyDrive][aIndex];
+	if(!driveIndex && !anyDriveIndex)
+		return KErrNone;
+	
+	RArray<TFsNotificationTrieEntry> candidates(KFilterCandidatesGranularity);
+	r = FindTrieCandidates(driveIndex,anyDriveIndex,aNotificationInfo.Source().FullName(),candidates);
+	
+	//We need to check for changes coming in to a directory when its rename
+	if(r == KErrNone && aNotificationInfo.NotificationType() == TFsNotification::ERename)
+		{
+		TPtrC newName(aNotificationInfo.NewName().FullName());
+		if(aNotificationInfo.DestDriveIsSet())
+			newName.Set(newName.Mid(2));
+		r = FindTrieCandidates(driveIndex,anyDriveIndex,newName,candidates);
+		}
+	
+	if(r != KErrNone)
+		{
+		candidates.Close();
+		return r;
+		}
+	
+	candidates.Sort(TLinearOrder<TFsNotificationTrieEntry>(CompareTrieEntries));
+	
+	CFsNotifyRequest* notifyRequest = NULL;
+	TBool active = EFalse;
+	TInt count = candidates.Count();
+	for(TInt i = 0; i < count; i++)
+		{
+		const TFsNotificationTrieEntry& entry = candidates[i];
+		if(i > 0 && CompareTrieEntries(entry,candidates[i-1]) == 0)
+			continue; //already checked
+		
+		if(entry.iRequest != notifyRequest)
 			{
-			//Matching - Handle change
-			
-			//Get a CFsNotificationBlock to use 
-			//So that we can do IPC from a single place.
-			CFsNotificationBlock* block = iPool->Allocate();
-				
-            TInt r = aNotifyRequest->NotifyChange(&aNotificationInfo,*block);
-				
-			//Free block
-			iPool->Free(block);
-				
-			if(r != KErrNone)
-				{
-				//Something went wrong writing to the client's buffer
-				aNotifyRequest->SetActive(CFsNotifyRequest::EInactive);
-				if(aNotifyRequest->ClientMsgHandle()!=0)
-					aNotifyRequest->CompleteClientRequest(r,EFalse);
-				break; //Go to outer for (i.e. next request in HandleChange)
-				}
-			}	
-		continue; //next filter
+			//As in HandleChange, only requests which are active
+			//before we start on them are notified.
+			notifyRequest = entry.iRequest;
+			CFsNotifyRequest::TNotifyRequestStatus status = notifyRequest->ActiveStatus();
+			active = (status==CFsNotifyRequest::EActive || status==CFsNotifyRequest::EOutstanding);
+			}
+		if(!active)
+			continue;
+		
+		if(DoMatchChange(aNotificationInfo,*entry.iFilter,notifyRequest) == FsNotificationManager::EMatch)
+			{
+			if(DoNotifyChange(aNotificationInfo,notifyRequest) != KErrNone)
+				active = EFalse; //no more notifications for this request
+			}
 		}
+	candidates.Close();
+	return KErrNone;
 	}
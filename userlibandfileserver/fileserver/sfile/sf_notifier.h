@@ -89,6 +89,73 @@ typedef RArray<TFsNotificationTypeFilter> TFsNotificationTypeArray;
 typedef RArray<TFsNotificationTypeArray> TFsNotificationTypeDriveArray;
 
 class CFsNotificationBlock; //forward decl.
+class CFsNotifyRequest; //forward decl.
+
+/**
+ * A TFsNotificationTrieEntry is a filter held in a CFsNotificationPathTrie
+ * along with the request it belongs to.
+ * 
+ * @internalTechnology
+ */
+class TFsNotificationTrieEntry
+	{
+public:
+	CFsNotifyRequest* iRequest;
+	CFsNotificationPathFilter* iFilter;
+	};
+
+/**
+ * A CFsNotificationTrieNode represents a directory in a CFsNotificationPathTrie.
+ * 
+ * @internalTechnology
+ */
+class CFsNotificationTrieNode : public CBase
+	{
+public:
+	static CFsNotificationTrieNode* NewL(const TDesC& aName);
+	~CFsNotificationTrieNode();
+	
+	//Returns the child directory called aName, or NULL
+	CFsNotificationTrieNode* Child(const TDesC& aName) const;
+	
+	//Returns the child directory called aName, adding it if necessary
+	CFsNotificationTrieNode* ChildL(const TDesC& aName);
+private:
+	TInt FindChild(const TDesC& aName, TInt& aIndex) const;
+public:
+	HBufC* iName;
+	RPointerArray<CFsNotificationTrieNode> iChildren;	//In folded order of iName
+	RArray<TFsNotificationTrieEntry> iExact;	//Filters whose path is this directory
+	RArray<TFsNotificationTrieEntry> iWild;		//Filters whose path starts with this directory followed by wildcards
+	};
+
+/**
+ * A CFsNotificationPathTrie indexes the filters for one drive and notification type by
+ * the directories at the start of their paths, up to the first wildcard.
+ * 
+ * This means the filters which could match an operation are found by following the
+ * operation's path down the trie rather than by checking every filter.
+ * Filters which have no path, or which start with a wildcard, are held at the root and
+ * so are checked for every operation.
+ * 
+ * @internalTechnology
+ */
+class CFsNotificationPathTrie : public CBase
+	{
+public:
+	static CFsNotificationPathTrie* NewL();
+	~CFsNotificationPathTrie();
+	
+	void AddL(const TFsNotificationTrieEntry& aEntry);
+	
+	/*
+	 * Appends the filters which could match an operation in the directory aPath to aCandidates.
+	 * They must still be checked with FsNotificationManager::DoMatchFilter.
+	 */
+	TInt FindCandidates(const TDesC& aPath, RArray<TFsNotificationTrieEntry>& aCandidates) const;
+private:
+	CFsNotificationTrieNode* iRoot;
+	};
 
 /**
  * CFsNotifyRequest is a file-server side object representation of an RFsNotify sub-session.   
@@ -345,12 +412,36 @@ private:
      */
     static TFsNotificationFilterMatch DoMatchFilter(const RMessage2& aMessage, const TDesC& aOperationName,CFsNotificationPathFilter& aFilter);
     
+    /*
+     * Checks the operation's name, and for a rename its new name, against aFilter.
+     */
+    static TFsNotificationFilterMatch DoMatchChange(CFsNotificationInfo& aNotificationInfo, CFsNotificationPathFilter& aFilter, CFsNotifyRequest* aNotifyRequest);
+    
+    /*
+     * Sends the notification to aNotifyRequest.
+     * If this fails the request is made inactive and the error returned.
+     */
+    static TInt DoNotifyChange(CFsNotificationInfo& aNotificationInfo, CFsNotifyRequest* aNotifyRequest);
+    
 	/*
 	 * Iterates filters for a particular drive.
 	 * Called from HandleChange
 	 */
 	static void DoHandleChange(TFsNotificationTypeArray* aFilterTypeArray, TInt& aSeenFilter, CFsNotificationInfo& aNotificationInfo, CFsNotifyRequest* aNotifyRequest);
 	
+	/*
+	 * Checks only the filters found in iFilterIndex under the operation's path.
+	 * Called from HandleChange, which checks every filter instead if this returns an error.
+	 */
+	static TInt DoHandleChangeIndexed(CFsNotificationInfo& aNotificationInfo, TInt aIndex);
+	
+	/*
+	 * Rebuilds iFilterIndex if filters have been added or removed since it was built.
+	 */
+	static TInt UpdateFilterIndex();
+	static void BuildFilterIndexL();
+	static void DeleteFilterIndex();
+	
 	/*
 	 * Stores the CFsNotifyRequests
 	 */
@@ -368,6 +459,16 @@ private:
 	 */
 	static TInt iFilterRegister[KNumRegisterableFilters];
 	
+	/*
+	 * Index of the filters of every request, per drive and per filter type.
+	 * The last drive slot is for filters which aren't tied to a drive.
+	 * 
+	 * It is rebuilt by HandleChange when iFilterIndexValid has been cleared
+	 * by a change to iFilterRegister.
+	 */
+	static CFsNotificationPathTrie* iFilterIndex[KMaxDrives+1][KNumRegisterableFilters];
+	static TBool iFilterIndexValid;
+	
 	/*
 	 * This is a pool of blocks which are server-side versions of TFsNotification.
 	 * They are used so that we can have a single IPC from server to client.
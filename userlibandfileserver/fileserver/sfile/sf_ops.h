@@ -169,6 +169,7 @@ static const TOperation OperationArray[EMaxClientOperations]=
 		{	EFsNotificationAdd,			ESync,								&TFsNotificationAdd::Initialise,			NULL,								&TFsNotificationAdd::DoRequestL				},
 		{	EFsNotificationRemove,		ESync,								&TFsNotificationRemove::Initialise,			NULL,								&TFsNotificationRemove::DoRequestL			},
 		{	EFsLoadCodePage,			0,									&TFsLoadCodePage::Initialise,				NULL,								&TFsLoadCodePage::DoRequestL				},
+		{	EFsFileCopy,				EParseSrc | EFileShare | EFsDspObj,	&TFsFileCopy::Initialise,					NULL,								&TFsFileCopy::DoRequestL					},
 	};
 
 #endif //SF_OPS_H
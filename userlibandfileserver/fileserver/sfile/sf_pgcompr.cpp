@@ -25,23 +25,25 @@
 #include "sf_cache.h"
 
 #include "sf_pgcompr.h"
+#include <u32hal.h>
 
 extern TInt BytePairDecompress(TUint8* /*dst*/, TInt /*dstSize*/, TUint8* /*src*/, TInt /*srcSize*/, TUint8*& /*srcNext*/);
+extern TInt Lz4Decompress(TUint8* /*dst*/, TInt /*dstSize*/, TUint8* /*src*/, TInt /*srcSize*/, TUint8*& /*srcNext*/);
 
 
 // CBytePairReader - reading from in-memory buffer
 
 
-CBytePairReader* CBytePairReader::NewLC(TUint8* aBuffer, TUint32 aLength)
+CBytePairReader* CBytePairReader::NewLC(TUint8* aBuffer, TUint32 aLength, TUint32 aCompression)
 	{
-	CBytePairReader* reader = new (ELeave) CBytePairReader(aBuffer, aLength);
+	CBytePairReader* reader = new (ELeave) CBytePairReader(aBuffer, aLength, aCompression);
 	CleanupStack::PushL(reader);
 	return reader;
 	}
 
 
-CBytePairReader::CBytePairReader(TUint8* aBuffer, TUint32 aLength)
-	: iNextPage(aBuffer), iBytesLeft(aLength)
+CBytePairReader::CBytePairReader(TUint8* aBuffer, TUint32 aLength, TUint32 aCompression)
+	: iNextPage(aBuffer), iBytesLeft(aLength), iCompression(aCompression)
 	{
 	}
 
@@ -91,12 +93,13 @@ TUint CBytePairReader::GetPageL(TUint aPageNum, TUint8* aTarget, TInt aLength, T
 	aLength = Min(aLength, KBytePairPageSize);
 
 	TInt size;
-	TUint8* nextPage;
+	TUint8* nextPage = NULL;
+	TUint8* dst = aMemMoveFn ? iPageBuf : aTarget;
 
-	if (aMemMoveFn)
-		size = BytePairDecompress(iPageBuf, aLength, iNextPage, iIndexTable[aPageNum], nextPage);
+	if (iCompression == KUidCompressionLz4)
+		size = Lz4Decompress(dst, aLength, iNextPage, iIndexTable[aPageNum], nextPage);
 	else
-		size = BytePairDecompress(aTarget, aLength, iNextPage, iIndexTable[aPageNum], nextPage);
+		size = BytePairDecompress(dst, aLength, iNextPage, iIndexTable[aPageNum], nextPage);
 		
 	User::LeaveIfError(size);
 	if (size != aLength)
@@ -118,6 +121,20 @@ TUint CBytePairReader::DecompressPagesL(TUint8* aTarget, TInt aLength, TMemoryMo
 	TUint decompressedSize = 0;
 
 	ReadInTableL();
+
+	if (DecompressInParallel())
+		{
+		TUint bytes = 0;
+		for (TUint i = 0; i < iHeader.iNumberOfPages; ++i)
+			bytes += iIndexTable[i];
+		if (bytes > iBytesLeft)
+			LEAVE_FAILURE(KErrCorrupt);
+		decompressedSize = DecompressPagesInParallelL(iNextPage, bytes, aTarget, aLength, aMemMoveFn);
+		iNextPage += bytes;
+		iBytesLeft -= bytes;
+		ReleaseTable();
+		return decompressedSize;
+		}
 	
 	for (TUint curPage = 0; curPage < iHeader.iNumberOfPages; ++curPage)
 		{
@@ -156,19 +173,67 @@ void CBytePairReader::GetPageOffsetsL(TInt32 aInitialOffset, TInt& aPageCount, T
 	}
 
 
+TBool CBytePairReader::DecompressInParallel()
+	{
+	return iHeader.iNumberOfPages >= KMinPagesToDecompressInParallel && PageDecompressThreads::Count() > 0;
+	}
+
+
+/**
+Decompress all the pages described by the index table, which have been read into aSrc, using the
+page decompression threads as well as this one.
+*/
+TUint CBytePairReader::DecompressPagesInParallelL(TUint8* aSrc, TUint aSrcSize, TUint8* aTarget, TInt aLength, TMemoryMoveFunction aMemMoveFn)
+	{
+	TInt pageCount = iHeader.iNumberOfPages;
+	TInt32* offsets = new (ELeave) TInt32[pageCount+1];
+	CleanupArrayDeletePushL(offsets);
+	TUint bytes = 0;
+	for (TInt i = 0; i < pageCount; ++i)
+		{
+		offsets[i] = bytes;
+		bytes += iIndexTable[i];
+		}
+	offsets[pageCount] = bytes;
+	if (bytes > aSrcSize)
+		LEAVE_FAILURE(KErrCorrupt);
+
+	SPageDecompressJob job;
+	job.iCompression = iCompression;
+	job.iSrc = aSrc;
+	job.iSrcOffsets = offsets;
+	job.iNumberOfPages = pageCount;
+	job.iTarget = aTarget;
+	job.iLength = aLength;
+	job.iMemMoveFn = aMemMoveFn;
+	job.iNextPage = 0;
+	job.iError = KErrNone;
+	PageDecompressThreads::Run(job, iPageBuf);
+	if (job.iError != KErrNone)
+		LEAVE_FAILURE(job.iError);
+
+	CleanupStack::PopAndDestroy(offsets);
+
+	// each page decompressed to a whole page, or what was left of aLength...
+	TUint decompressedSize = Min(aLength, pageCount * (TInt)KBytePairPageSize);
+	__IF_DEBUG(Printf("decompressedSize:%d in parallel", decompressedSize));
+	return decompressedSize;
+	}
+
+
 // CBytePairFileReader - reading from file
 
 
-CBytePairFileReader* CBytePairFileReader::NewLC(RFile& aFile)
+CBytePairFileReader* CBytePairFileReader::NewLC(RFile& aFile, TUint32 aCompression)
 	{
-	CBytePairFileReader* reader = new (ELeave) CBytePairFileReader(aFile);
+	CBytePairFileReader* reader = new (ELeave) CBytePairFileReader(aFile, aCompression);
 	CleanupStack::PushL(reader);
 	return reader;
 	}
 
 
-CBytePairFileReader::CBytePairFileReader(RFile& aFile)
-	: CBytePairReader(NULL, 0), iFile(aFile)
+CBytePairFileReader::CBytePairFileReader(RFile& aFile, TUint32 aCompression)
+	: CBytePairReader(NULL, 0, aCompression), iFile(aFile)
 	{
 	}	
 
@@ -189,26 +254,51 @@ void CBytePairFileReader::SeekForwardL(TUint aBytes)
 void CBytePairFileReader::ReadInTableL()
 	{
 	TPtr8 header((TUint8*)&iHeader, KIndexTableHeaderSize);
-	User::LeaveIfError(iFile.Read(header, KIndexTableHeaderSize));
-	if (header.Length() != (TInt)KIndexTableHeaderSize)
-		LEAVE_FAILURE(KErrCorrupt);
+	ReadL(header, KIndexTableHeaderSize);
 	
 	__IF_DEBUG(Printf("numberOfPages:%d", iHeader.iNumberOfPages));
 	
 	TInt size = iHeader.iNumberOfPages * sizeof(TUint16);
 	iIndexTable = new (ELeave) TUint16[size/sizeof(TUint16)];
 	TPtr8 indexTable((TUint8*)iIndexTable, size);
-	User::LeaveIfError(iFile.Read(indexTable, size));
-	if (indexTable.Length() != size)
-		LEAVE_FAILURE(KErrCorrupt);
+	ReadL(indexTable, size);
 	} 
 
 
+/**
+Read aLength bytes from the file, noting the time taken.
+*/
+void CBytePairFileReader::ReadL(TDes8& aDes, TInt aLength)
+	{
+	TUint32 start = User::FastCounter();
+	TInt r = iFile.Read(aDes, aLength);
+	iReadTime += User::FastCounter() - start;
+	User::LeaveIfError(r);
+	if (aDes.Length() != aLength)
+		LEAVE_FAILURE(KErrCorrupt);
+	}
+
+
 TUint CBytePairFileReader::DecompressPagesL(TUint8* aTarget, TInt aLength, TMemoryMoveFunction aMemMoveFn)
 	{
 	TUint decompressedSize = 0;
 
 	ReadInTableL();
+
+	if (DecompressInParallel())
+		{
+		// read all the pages in so they can be shared out...
+		TUint bytes = 0;
+		for (TUint i = 0; i < iHeader.iNumberOfPages; ++i)
+			bytes += iIndexTable[i];
+		TUint8* data = (TUint8*)User::AllocLC(bytes);
+		TPtr8 ptr(data, bytes);
+		ReadL(ptr, bytes);
+		decompressedSize = DecompressPagesInParallelL(data, bytes, aTarget, aLength, aMemMoveFn);
+		CleanupStack::PopAndDestroy(data);
+		ReleaseTable();
+		return decompressedSize;
+		}
 	
 	TUint curPage = 0;
 	while (curPage < iHeader.iNumberOfPages)
@@ -224,9 +314,7 @@ TUint CBytePairFileReader::DecompressPagesL(TUint8* aTarget, TInt aLength, TMemo
 		if(!bytes)
 			LEAVE_FAILURE(KErrCorrupt);
 		TPtr8 data(iBuffer, bytes);
-		User::LeaveIfError(iFile.Read(data, bytes));
-		if (data.Length() != (TInt)bytes)
-			LEAVE_FAILURE(KErrCorrupt);
+		ReadL(data, bytes);
 		iNextPage = iBuffer;
 		iBytesLeft = bytes;
 
@@ -248,3 +336,149 @@ TUint CBytePairFileReader::DecompressPagesL(TUint8* aTarget, TInt aLength, TMemo
 
 	return decompressedSize;
 	}
+
+
+// PageDecompressThreads - helpers for decompressing pages on several CPUs
+
+
+_LIT(KPageDecompressThreadName, "LoaderPageDecompress%d");
+const TInt KPageDecompressThreadStackSize = 0x2000;
+
+TInt PageDecompressThreads::iCount = -1;
+TInt PageDecompressThreads::iBusy = 0;
+RSemaphore PageDecompressThreads::iStart;
+RSemaphore PageDecompressThreads::iDone;
+SPageDecompressJob* PageDecompressThreads::iJob = NULL;
+
+
+/**
+Return the number of threads available to help decompress pages, creating them if this is the
+first time it has been called.  The first call must be made on the loader thread, before any
+image load threads are started.
+*/
+TInt PageDecompressThreads::Count()
+	{
+	if (iCount < 0)
+		{
+		iCount = 0;
+		TInt r = Create();
+		__IF_DEBUG(Printf("PageDecompressThreads::Create r=%d count=%d", r, iCount));
+		(void)r;
+		}
+	return iCount;
+	}
+
+
+TInt PageDecompressThreads::Create()
+	{
+	TInt cpus = UserSvr::HalFunction(EHalGroupKernel, EKernelHalNumLogicalCpus, 0, 0);
+	TInt count = Min(cpus - 1, KMaxPageDecompressThreads);
+	if (count <= 0)
+		return KErrNone;
+
+	TInt r = iStart.CreateLocal(0);
+	if (r != KErrNone)
+		return r;
+	r = iDone.CreateLocal(0);
+	if (r != KErrNone)
+		{
+		iStart.Close();
+		return r;
+		}
+
+	// the threads share the loader heap but never allocate from it...
+	TThreadPriority priority = RThread().Priority();
+	for (TInt i = 0; i < count; ++i)
+		{
+		TBuf<KMaxKernelName> name;
+		name.Format(KPageDecompressThreadName, i);
+		RThread thread;
+		r = thread.Create(name, ThreadFunction, KPageDecompressThreadStackSize, NULL, NULL);
+		if (r != KErrNone)
+			break;
+		thread.SetPriority(priority);
+		thread.Resume();
+		thread.Close();
+		++iCount;
+		}
+	return r;
+	}
+
+
+TInt PageDecompressThreads::ThreadFunction(TAny*)
+	{
+	TUint8 pageBuf[KBytePairPageSize];
+	for (;;)
+		{
+		iStart.Wait();
+		DecompressPages(*iJob, pageBuf);
+		iDone.Signal();
+		}
+	}
+
+
+/**
+Decompress the pages of aJob on this thread and as many helper threads as are useful, returning
+when they have all been done.  aPageBuf is a page sized buffer for this thread's use.
+If another thread's job is already using the helpers, the pages are all decompressed here.
+*/
+void PageDecompressThreads::Run(SPageDecompressJob& aJob, TUint8* aPageBuf)
+	{
+	if (User::LockedInc(iBusy) != 0)
+		{
+		User::LockedDec(iBusy);
+		DecompressPages(aJob, aPageBuf);
+		return;
+		}
+	TInt helpers = Min(iCount, aJob.iNumberOfPages - 1);
+	iJob = &aJob;
+	if (helpers > 0)
+		iStart.Signal(helpers);
+	DecompressPages(aJob, aPageBuf);
+	for (TInt i = 0; i < helpers; ++i)
+		iDone.Wait();
+	iJob = NULL;
+	User::LockedDec(iBusy);
+	}
+
+
+void PageDecompressThreads::DecompressPages(SPageDecompressJob& aJob, TUint8* aPageBuf)
+	{
+	for (;;)
+		{
+		TInt page = User::LockedInc(aJob.iNextPage);
+		if (page >= aJob.iNumberOfPages || aJob.iError != KErrNone)
+			break;
+		TInt r = DecompressPage(aJob, page, aPageBuf);
+		if (r != KErrNone)
+			aJob.iError = r;
+		}
+	}
+
+
+TInt PageDecompressThreads::DecompressPage(SPageDecompressJob& aJob, TInt aPage, TUint8* aPageBuf)
+	{
+	TUint8* src = aJob.iSrc + aJob.iSrcOffsets[aPage];
+	TInt srcSize = aJob.iSrcOffsets[aPage+1] - aJob.iSrcOffsets[aPage];
+	TInt offset = aPage * KBytePairPageSize;
+	TInt length = Min(aJob.iLength - offset, (TInt)KBytePairPageSize);
+	if (length <= 0)
+		return KErrCorrupt;
+
+	TUint8* dst = aJob.iMemMoveFn ? aPageBuf : aJob.iTarget + offset;
+	TUint8* srcNext = NULL;
+	TInt size;
+	if (aJob.iCompression == KUidCompressionLz4)
+		size = Lz4Decompress(dst, length, src, srcSize, srcNext);
+	else
+		size = BytePairDecompress(dst, length, src, srcSize, srcNext);
+	if (size < 0)
+		return size;
+	if (size != length || srcNext != src + srcSize)
+		return KErrCorrupt;
+
+	// If a memmove() was provided, use that to copy the data to its final target
+	if (aJob.iMemMoveFn)
+		aJob.iMemMoveFn(aJob.iTarget + offset, aPageBuf, size);
+	return KErrNone;
+	}
@@ -31,9 +31,16 @@
 const TUint KBytePairPageSize = 4096;
 
 // Buffer sized for at least 8 compressed pages - a noncompressible page is one byte larger
+// (an LZ4 page a few bytes larger, which still leaves room for 7 of them)
 const TUint KReadNumberOfPages = 8;
 const TUint KPagesBufferSize = (KBytePairPageSize + 1) * KReadNumberOfPages;
 
+// Sections with at least this many pages are decompressed on several CPUs if there are any
+const TInt KMinPagesToDecompressInParallel = 8;
+
+// Maximum number of threads helping the loader thread decompress pages
+const TInt KMaxPageDecompressThreads = 3;
+
 typedef TUint8* (*TMemoryMoveFunction)(TAny* aTrg,const TAny* aSrc,TInt aLength); 
 
 struct IndexTableHeader
@@ -49,30 +56,36 @@ const TUint KIndexTableHeaderSize = sizeof(TInt) + sizeof(TInt) + sizeof(TUint16
 NONSHARABLE_CLASS(CBytePairReader) : public CBase
 	{
 public:
-	static CBytePairReader* NewLC(TUint8* aBuffer, TUint32 aLength);
-	CBytePairReader(TUint8* aBuffer, TUint32 aLength);
+	static CBytePairReader* NewLC(TUint8* aBuffer, TUint32 aLength, TUint32 aCompression = KUidCompressionBytePair);
+	CBytePairReader(TUint8* aBuffer, TUint32 aLength, TUint32 aCompression);
 
 	virtual TUint DecompressPagesL(TUint8* aTarget, TInt aLength, TMemoryMoveFunction aMemMoveFn);
 	void GetPageOffsetsL(TInt32 aInitialOffset, TInt& aPageCount, TInt32*& aPageStarts);
 	TUint GetPageL(TUint aPageNum, TUint8* aTarget, TInt aLength, TMemoryMoveFunction aMemMoveFn);		
 	virtual void SeekForwardL(TUint aBytes);
+	inline TUint32 ReadTime() const
+		{ return iReadTime; }
 
 protected:
 	virtual void ReadInTableL();
 	void ReleaseTable();
+	TBool DecompressInParallel();
+	TUint DecompressPagesInParallelL(TUint8* aSrc, TUint aSrcSize, TUint8* aTarget, TInt aLength, TMemoryMoveFunction aMemMoveFn);
 
 	IndexTableHeader iHeader;
 	TUint16* iIndexTable;
 	TUint8* iNextPage;
 	TUint iBytesLeft;
+	TUint32 iCompression;	// KUidCompressionBytePair or KUidCompressionLz4
+	TUint32 iReadTime;		// fast counter ticks spent reading the file
 	TUint8 iPageBuf[KBytePairPageSize];
 	};
 
 NONSHARABLE_CLASS(CBytePairFileReader) : public CBytePairReader
 	{
 public:
-	static CBytePairFileReader* NewLC(RFile& aFile);
-	CBytePairFileReader(RFile& aFile);
+	static CBytePairFileReader* NewLC(RFile& aFile, TUint32 aCompression = KUidCompressionBytePair);
+	CBytePairFileReader(RFile& aFile, TUint32 aCompression);
 	~CBytePairFileReader();
 
 	virtual TUint DecompressPagesL(TUint8* aTarget, TInt aLength, TMemoryMoveFunction aMemMovefn);
@@ -80,9 +93,50 @@ public:
 
 protected:
 	virtual void ReadInTableL();
+	void ReadL(TDes8& aDes, TInt aLength);
 
 	RFile& iFile;
 	TUint8 iBuffer[KPagesBufferSize];
 	};
 
+/**
+A section of independently compressed pages, shared by the threads decompressing it.
+*/
+struct SPageDecompressJob
+	{
+	TUint32 iCompression;
+	TUint8* iSrc;
+	TInt32* iSrcOffsets;			// offset of each page in iSrc, plus the end of the last one
+	TInt iNumberOfPages;
+	TUint8* iTarget;
+	TInt iLength;
+	TMemoryMoveFunction iMemMoveFn;
+	TInt iNextPage;					// next page to decompress, claimed with User::LockedInc
+	volatile TInt iError;
+	};
+
+/**
+Threads which help the loader thread decompress pages on multiprocessor systems.
+They are created the first time a large enough section is loaded, or when the image
+load threads are created.  Only one job at a time can use them; when image load threads
+are decompressing several images at once, the others decompress on their own thread.
+*/
+class PageDecompressThreads
+	{
+public:
+	static TInt Count();
+	static void Run(SPageDecompressJob& aJob, TUint8* aPageBuf);
+private:
+	static TInt DecompressPage(SPageDecompressJob& aJob, TInt aPage, TUint8* aPageBuf);
+	static TInt Create();
+	static TInt ThreadFunction(TAny*);
+	static void DecompressPages(SPageDecompressJob& aJob, TUint8* aPageBuf);
+private:
+	static TInt iCount;				// number of threads, or -1 if not created yet
+	static TInt iBusy;				// non-zero while a job is using the threads
+	static RSemaphore iStart;
+	static RSemaphore iDone;
+	static SPageDecompressJob* iJob;
+	};
+
 #endif // __SF_PGCOMPR_H__
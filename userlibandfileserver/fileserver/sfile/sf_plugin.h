@@ -70,6 +70,7 @@ public:
 	static void TransferRequests(CPluginThread* aPluginThread);
 	static TInt ChainCount();
 	static TInt Plugin(CFsPlugin*& aPlugin, TInt aPos);
+	static TBool IsIntercepted(TInt aFunction);
 
 	static void ReadLockChain();
 	static void WriteLockChain();
@@ -578,6 +578,23 @@ TInt FsPluginManager::Plugin(CFsPlugin*& aPlugin, TInt aPos)
 	return KErrNone;
 	}
 
+/**
+Checks whether any plugin in the chain intercepts a function, before or after
+the file system, on any drive.
+
+Takes the chain lock for reading, so it must not be held already.
+*/
+TBool FsPluginManager::IsIntercepted(TInt aFunction)
+	{
+	ReadLockChain();
+	TBool intercepted = EFalse;
+	TInt count = iPluginChain.Count();
+	for(TInt i=0; i<count && !intercepted; i++)
+		intercepted = iPluginChain[i]->IsRegistered(aFunction);
+	UnlockChain();
+	return intercepted;
+	}
+
 /**
 Locks the chain for reading
 */
@@ -1147,6 +1147,11 @@ void CFsMessageRequest::ProcessDriveOperation()
 		return;
 		}
 
+	// request waiting for internal requests it has issued (e.g. a file copy) ?
+	// it will be dispatched again when one of them completes
+	if (err == EReqActionPending)
+		return;
+
 	iLastError = err;
 
 	if(!IsExpectedResult(err) || IsPluginSpecific())
@@ -1130,7 +1130,10 @@ public:
 		The request cannot be processed because there is already an active read/write request 
 		for the associated file share. This request has been linked to the currently active
 		request and will be dispatched to the the drive thread when the current request has completed.
+		If returned by DoRequestL(), the request is waiting for requests of its own to complete
+		and will be dispatched again by one of them.
 		@see CFileShare::RequestStart() & CFileShare::RequestEnd()
+		@see TFsFileCopy::DoRequestL()
 		*/
 		EReqActionPending = EReqActionOwnedByPlugin,
 		};
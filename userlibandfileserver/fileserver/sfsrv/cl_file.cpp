@@ -1860,6 +1860,47 @@ Instructs the File Server that the file is not to be modified on storage media.
 	return r;
 	}
 
+EFSRV_EXPORT_C TInt RFile::CopyFrom(const RFile& aSource, TInt64 aSrcPos, TInt64 aPos, TInt aLength, TInt& aCopied)
+/**
+Copies data from another file into this one inside the File Server, without
+passing it through the client.
+
+Neither file's current position is changed. Fewer bytes than requested are
+copied if the end of the source file is reached.
+
+@param aSource	The file to copy from.  It should be open in the same file
+				server session as this file.
+@param aSrcPos	The position in the source file to copy from.
+@param aPos		The position in this file to copy to. If it is beyond the end
+				of the file, the data is written at the end.
+@param aLength	The number of bytes to copy.
+@param aCopied	On return, the number of bytes copied.
+
+@return				KErrNone, if successful;
+					KErrNotSupported, if the files are in different sessions
+					or either file system can't copy inside the File Server,
+					or a plugin intercepts file reads or writes, in which case the data should be read and written by the
+					client;
+					otherwise one of the other system-wide error codes.
+*/
+	{
+	OstTraceExt3(TRACE_BORDER, EFSRV_EFILECOPYFROM, "sess %x subs %x src %x", (TUint) Session().Handle(), (TUint) SubSessionHandle(), (TUint) aSource.SubSessionHandle());
+	aCopied = 0;
+	if (aSource.Session().Handle() != Session().Handle())
+		return KErrNotSupported;
+
+	SFileCopyArgs args;
+	args.iSrcPos = aSrcPos;
+	args.iDstPos = aPos;
+	args.iLength = aLength;
+	TPckg<SFileCopyArgs> pkArgs(args);
+	TInt r = SendReceive(EFsFileCopy, TIpcArgs(aSource.SubSessionHandle(), &pkArgs));
+	if (r == KErrNone)
+		aCopied = args.iLength;
+	OstTraceExt2(TRACE_BORDER, EFSRV_EFILECOPYFROMRETURN, "r %d copied %d", r, aCopied);
+	return r;
+	}
+
 /**
 Fetches the Block Map of a file. Each file in the file system will consist of
 a number of groups of blocks. Each group represents a number of contiguous blocks.
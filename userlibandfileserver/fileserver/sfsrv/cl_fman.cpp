@@ -29,6 +29,9 @@ const TUint KCopyFromHandle	=	0x00000001;
 
 const TInt KPathIncGran=32;
 
+// the amount copied by the file server between calls to the observer
+const TInt KServerCopySize = 1024 * 1024;
+
 const TUint KMovingFilesMask = KEntryAttMatchExclude | KEntryAttDir;
 
 TInt ShrinkNames(RFs& aFs, TFileName& aParent, TFileName& aItem, TBool aAppend);
@@ -2874,11 +2877,10 @@ TInt CFileMan::DoCopy(const RFile64& aSrcFile, RFile64& aDstFile, TInt& aRet)
 		return r;
 		}
 
+	// Let the file server copy the data if it can; otherwise read it into a
+	// buffer here and write it out again
 	HBufC8* bufPtr = NULL;
-	bufPtr = AllocateBuffer(rem);
-	if (bufPtr == NULL)
-		return KErrNoMemory;
-	TPtr8 copyBuf=bufPtr->Des();
+	TBool serverCopy = ETrue;
 
 #ifndef SYMBIAN_ENABLE_64_BIT_FILE_SERVER_API
 	TInt pos=0;
@@ -2888,17 +2890,45 @@ TInt CFileMan::DoCopy(const RFile64& aSrcFile, RFile64& aDstFile, TInt& aRet)
 	aRet = MFileManObserver::EContinue;
 	while(rem && aRet == MFileManObserver::EContinue)
 		{
+		TInt s;
+		if (serverCopy)
+			{
 #ifndef SYMBIAN_ENABLE_64_BIT_FILE_SERVER_API
-		TInt s=Min(rem,copyBuf.MaxSize());
+			s=Min(rem,KServerCopySize);
 #else
-		// Min result shall be of TInt size
-		TInt s=(TInt)(Min(rem,(TInt64)copyBuf.MaxSize()));
+			s=(TInt)(Min(rem,(TInt64)KServerCopySize));
 #endif
-		r=aSrcFile.Read(pos,copyBuf,s);
-		if (r==KErrNone && copyBuf.Length()!=s)
-			r = KErrCorrupt;
-		if (r==KErrNone)
-			r=aDstFile.Write(pos,copyBuf,s);
+			TInt copied;
+			r=aDstFile.CopyFrom(aSrcFile,pos,pos,s,copied);
+			if (r==KErrNotSupported)
+				{
+				serverCopy = EFalse;
+				continue;
+				}
+			if (r==KErrNone && copied!=s)
+				r = KErrCorrupt;
+			}
+		else
+			{
+			if (bufPtr == NULL)
+				{
+				bufPtr = AllocateBuffer(rem);
+				if (bufPtr == NULL)
+					return KErrNoMemory;
+				}
+			TPtr8 copyBuf=bufPtr->Des();
+#ifndef SYMBIAN_ENABLE_64_BIT_FILE_SERVER_API
+			s=Min(rem,copyBuf.MaxSize());
+#else
+			// Min result shall be of TInt size
+			s=(TInt)(Min(rem,(TInt64)copyBuf.MaxSize()));
+#endif
+			r=aSrcFile.Read(pos,copyBuf,s);
+			if (r==KErrNone && copyBuf.Length()!=s)
+				r = KErrCorrupt;
+			if (r==KErrNone)
+				r=aDstFile.Write(pos,copyBuf,s);
+			}
 		if (r!=KErrNone)
 			break;
 		pos+= s;
@@ -36,7 +36,7 @@ TCacheSegment::TCacheSegment()
 //
 // Constructor
 //
-	: iPos(-1)
+	: iPos(-1), iHashNext(NULL)
 	{}
 
 void TCacheSegment::Set(TInt aPos)
@@ -70,6 +70,68 @@ CRofsLruCache::~CRofsLruCache()
 		{
 		User::Free(iter++);
 		}
+	User::Free(iHash);
+	User::Free(iPrefetchBuffer);
+	}
+
+TCacheSegment* CRofsLruCache::Lookup(TInt aPos) const
+//
+// Find the segment which starts at aPos
+//
+	{
+	TCacheSegment* seg=Bucket(aPos);
+	while(seg && seg->iPos!=aPos)
+		seg=seg->iHashNext;
+	return(seg);
+	}
+
+void CRofsLruCache::Hash(TCacheSegment* aSeg)
+	{
+	TCacheSegment*& bucket=Bucket(aSeg->iPos);
+	aSeg->iHashNext=bucket;
+	bucket=aSeg;
+	}
+
+void CRofsLruCache::Unhash(TCacheSegment* aSeg)
+	{
+	TCacheSegment** link=&Bucket(aSeg->iPos);
+	while(*link!=aSeg)
+		link=&(*link)->iHashNext;
+	*link=aSeg->iHashNext;
+	aSeg->iHashNext=NULL;
+	}
+
+TCacheSegment* CRofsLruCache::AllocateSegment(TInt aPos)
+//
+// Get a segment for the data at aPos, reusing the least recently used one
+//
+	{
+	TCacheSegment* seg=Lookup(aPos);
+	if(!seg)
+		{
+		seg=iQue.Last();
+		if(seg->iPos>=0)
+			{
+			Unhash(seg);
+			++iInfo.iEvictions;
+			}
+		seg->Set(aPos);
+		Hash(seg);
+		}
+	seg->iLink.Deque();
+	iQue.AddFirst(*seg);
+	return(seg);
+	}
+
+void CRofsLruCache::Discard(TCacheSegment* aSeg)
+//
+// Forget the contents of a segment, e.g. when reading it failed
+//
+	{
+	Unhash(aSeg);
+	aSeg->Set(-1);
+	aSeg->iLink.Deque();
+	iQue.AddLast(*aSeg);
 	}
 
 TUint8* CRofsLruCache::Find(TInt aPos, TInt aLength)
@@ -79,36 +141,29 @@ TUint8* CRofsLruCache::Find(TInt aPos, TInt aLength)
 	{
 	__PRINT(_L("CLruCache::Find()"));
 
-	TDblQueIter<TCacheSegment> iter(iQue);
-	TCacheSegment* data;
-	while((data=iter++)!=NULL)		//need to do a range check here
+	// Segments start on a page boundary and are two pages long, so only the
+	// segments starting on aPos's page or the page before can hold aPos
+	const TInt pagePos = aPos & ~(KPageSize-1);
+	TCacheSegment* data=Lookup(pagePos);
+	if(!data || (aPos+aLength) > (data->iPos+KSizeOfSegment))
 		{
-		if(data->iPos < 0)
-			continue;
-		const TInt KEndOfSegment= data->iPos+ KSizeOfSegment;
-		if(data->iPos <= aPos && (KEndOfSegment >=aPos))
-			{
-			if((aPos+aLength) > (KEndOfSegment))
-				{
-				data->iLink.Deque();
-				iQue.AddLast(*data);
-				return(NULL);
-				}
-			if(!iQue.IsFirst(data)) 
-				{
-				data->iLink.Deque(); 
-				iQue.AddFirst(*data); 
-				}
-			return(&data->Data()[aPos-data->iPos]);
-			}
+		data = (pagePos>=KPageSize) ? Lookup(pagePos-KPageSize) : NULL;
+		if(data && (aPos+aLength) > (data->iPos+KSizeOfSegment))
+			data=NULL;
 		}
-	// If we got here, it means that we don't have it in cache at all 
-	return(NULL);
-		
+	if(!data)
+		return(NULL);
+
+	if(!iQue.IsFirst(data)) 
+		{
+		data->iLink.Deque(); 
+		iQue.AddFirst(*data); 
+		}
+	return(&data->Data()[aPos-data->iPos]);
 	}
 
 
-TUint8* CRofsLruCache::ReadL(TInt aPos, TInt aLength)
+TUint8* CRofsLruCache::ReadL(TInt aPos, TInt aLength, TBool aPrefetch)
 //
 // Find aPos in the cache or read the data
 //
@@ -120,44 +175,87 @@ TUint8* CRofsLruCache::ReadL(TInt aPos, TInt aLength)
 	// Search the cache 
 	TUint8* res=Find(aPos, aLength);
 	if (res)
+		{
+		++iInfo.iHits;
 		return(res); 
+		}
+	++iInfo.iMisses;
 	
 	// Didn't find in the cache, read data from media 	 
 	// Align to page boundaries
 	TInt pagePos = aPos & ~(KPageSize-1);
 	
-	// Read from media
-	// Buffer to accomodate two page of data. 
-	// We won't cache any read bigger than one page
-	// Check if we have any segment available
-	TCacheSegment* seg= iQue.Last();
-	seg->iLink.Deque();
-	seg->Set(pagePos);
-	iQue.AddFirst(*seg);
+	if (!aPrefetch || !iPrefetchBuffer)
+		{
+		// Read from media
+		// Buffer to accomodate two page of data. 
+		// We won't cache any read bigger than one page
+		TCacheSegment* seg=AllocateSegment(pagePos);
 
-	// ensure we don't read past end of media
-	TInt cacheLen = (TInt) Min(iMediaSize -  pagePos, KSizeOfSegment);
-	TPtr8 dataBuf((seg->Data()), cacheLen);
-	TInt ret = iMount->LocalDrive()->Read(pagePos,cacheLen,dataBuf);
+		// ensure we don't read past end of media
+		TInt cacheLen = (TInt) Min(iMediaSize -  pagePos, KSizeOfSegment);
+		TPtr8 dataBuf((seg->Data()), cacheLen);
+		TInt ret = iMount->LocalDrive()->Read(pagePos,cacheLen,dataBuf);
 
-	if (ret!=KErrNone)
+		if (ret!=KErrNone)
+			{
+			Discard(seg);
+			User::Leave(ret);
+			}
+
+		return(&dataBuf[aPos & (KPageSize-1)]);
+		}
+
+	// A file is being read sequentially, so read the following segments from the
+	// media at the same time rather than one at a time as the reads reach them
+	TInt readLen = (TInt) Min(iMediaSize - pagePos, iInfo.iPrefetchSegments*KSizeOfSegment);
+	TPtr8 prefetchBuf(iPrefetchBuffer, readLen);
+	User::LeaveIfError(iMount->LocalDrive()->Read(pagePos,readLen,prefetchBuf));
+
+	// Fill the segments last first, so the one being read now ends up most recently used
+	TInt offset = ((readLen-1)/KSizeOfSegment)*KSizeOfSegment;
+	for (; offset>0; offset-=KSizeOfSegment)
 		{
-		User::Leave(ret);
+		if (Lookup(pagePos+offset))
+			continue;
+		TCacheSegment* seg=AllocateSegment(pagePos+offset);
+		Mem::Copy(seg->Data(), iPrefetchBuffer+offset, Min(readLen-offset, KSizeOfSegment));
+		++iInfo.iPrefetched;
 		}
+	TCacheSegment* seg=AllocateSegment(pagePos);
+	Mem::Copy(seg->Data(), iPrefetchBuffer, Min(readLen, KSizeOfSegment));
 
-	return(&dataBuf[aPos & (KPageSize-1)]);
+	return(&seg->Data()[aPos-pagePos]);
 	}
 
-CRofsLruCache* CRofsLruCache::New(TInt aSegmentSize, CRofsMountCB* aMount, TInt64 aMediaSize)
+void CRofsLruCache::GetInfo(TRofsCacheInfo& aInfo) const
+	{
+	aInfo=iInfo;
+	}
+
+CRofsLruCache* CRofsLruCache::New(TInt aSegmentSize, TInt aSegmentCount, CRofsMountCB* aMount, TInt64 aMediaSize)
 //
-// Create an LruList and one segment
+// Create an LruList and its segments
 //
 	{
 	__PRINT(_L("CRofsLruCache::New()"));
 	CRofsLruCache* lru=new CRofsLruCache(aMount, aMediaSize);
 	if (lru==NULL)
 		return(NULL);
-	for(TInt i=0; i<KSizeOfCacheInPages;i++)
+
+	// Hash table with at least as many buckets as segments
+	TInt buckets=1;
+	while(buckets<aSegmentCount)
+		buckets<<=1;
+	lru->iHash=(TCacheSegment**)User::AllocZ(buckets*sizeof(TCacheSegment*));
+	if (lru->iHash==NULL)
+		{
+		delete lru;
+		return(NULL);
+		}
+	lru->iHashMask=buckets-1;
+
+	for(TInt i=0; i<aSegmentCount;i++)
 		{
 		TCacheSegment* seg=(TCacheSegment*)User::Alloc(aSegmentSize+sizeof(TCacheSegment));
 		if (seg==NULL)
@@ -169,6 +267,16 @@ CRofsLruCache* CRofsLruCache::New(TInt aSegmentSize, CRofsMountCB* aMount, TInt6
 		*seg=TCacheSegment();
 		lru->iQue.AddFirst(*seg);
 		}
+
+	// Don't let prefetching flush more than half the cache. If the buffer
+	// can't be allocated the cache still works, just without prefetching.
+	TInt prefetch=Min(KSizeOfPrefetchInSegments, aSegmentCount/2);
+	if (prefetch>1)
+		lru->iPrefetchBuffer=(TUint8*)User::Alloc(prefetch*aSegmentSize);
+	
+	lru->iInfo.iSegmentSize=aSegmentSize;
+	lru->iInfo.iSegmentCount=aSegmentCount;
+	lru->iInfo.iPrefetchSegments=lru->iPrefetchBuffer ? prefetch : 1;
 	return(lru);
 	}
 
@@ -177,7 +285,7 @@ CRofsLruCache* CRofsLruCache::New(TInt aSegmentSize, CRofsMountCB* aMount, TInt6
 //***********************************************************
 
 
-void CRofsMountCB::CacheReadL(TInt aPos, TInt aLength,const TAny* aDes,TInt anOffset, const RMessagePtr2& aMessage) const
+void CRofsMountCB::CacheReadL(TInt aPos, TInt aLength,const TAny* aDes,TInt anOffset, const RMessagePtr2& aMessage, TBool aSequential) const
 //
 //	Do a cached read if possible else read from media and insert to cache
 //
@@ -195,7 +303,7 @@ void CRofsMountCB::CacheReadL(TInt aPos, TInt aLength,const TAny* aDes,TInt anOf
 		}
 	else
 		{
-		TUint8* data =iDataCache->ReadL(aPos, aLength);	//added length to enable cache to fill in the blanks
+		TUint8* data =iDataCache->ReadL(aPos, aLength, aSequential);	//added length to enable cache to fill in the blanks
 		TPtrC8 buf(data,aLength);			//return buffer
 		aMessage.WriteL(0,buf,anOffset);
 		}
@@ -261,7 +369,19 @@ void CRofsMountCB::MountL(TBool /*aForceMount*/)
 	//
 	// Construct the data cache
 	//
-	iDataCache = CRofsLruCache::New(KSizeOfSegment,this, iMediaSize);
+	// ESTART.TXT can give the size of the cache, in KB, for this drive
+	TInt segmentCount = KSizeOfCacheInPages;
+	TBuf8<8> section;
+	section.Format(_L8("Drive%c"), 'A'+Drive().DriveNumber());
+	TInt32 cacheSize;
+	if(F32Properties::GetInt(section, _L8("ROFS_DataCacheSize"), cacheSize))
+		{
+		segmentCount = (cacheSize << 10) / KSizeOfSegment;
+		segmentCount = Max(KSizeOfCacheInPages, Min(segmentCount, KMaxSizeOfCacheInSegments));
+		}
+	__PRINT1(_L("CRofsMountCB::MountL, Data cache segments %d"), segmentCount);
+
+	iDataCache = CRofsLruCache::New(KSizeOfSegment, segmentCount, this, iMediaSize);
 	if(!iDataCache)
 		User::Leave(KErrNoMemory);
 #endif
@@ -740,6 +860,25 @@ TInt CRofsMountCB::Spare1(TInt /*aVal*/, TAny* /*aPtr1*/, TAny* /*aPtr2*/)
 	return KErrNotSupported;
 	}
 
+TInt CRofsMountCB::ControlIO(const RMessagePtr2& aMessage,TInt aCommand,TAny* /*aParam1*/,TAny* /*aParam2*/)
+	{
+	switch(aCommand)
+		{
+		case KControlIoRofsCacheInfo:
+			{
+			TRofsCacheInfo info;
+			Mem::FillZ(&info, sizeof(info));
+#ifdef _USE_TRUE_LRU_CACHE
+			iDataCache->GetInfo(info);
+#endif
+			TPckgBuf<TRofsCacheInfo> pkgBuf(info);
+			return aMessage.Write(2, pkgBuf);
+			}
+		default:
+			return KErrNotSupported;
+		}
+	}
+
 
 //***********************************************************
 //* File object
@@ -751,6 +890,7 @@ CRofsFileCB::CRofsFileCB()
 //
 // Constructor
 //
+	: iNextReadPos(-1)
 	{
 	}
 
@@ -782,7 +922,11 @@ void CRofsFileCB::ReadL(TInt64 aPos,TInt& aLength,TDes8* aDes,const RMessagePtr2
 #ifdef _USE_TRUE_LRU_CACHE
 
 		__PRINT2(_L("ROFS::ReadL() pos=%d len=%d"),pos, len);
-		RofsMount().CacheReadL( pos + iMediaBase, len, aDes, aOffset, aMessage );
+		// If this read carries on from the last one the file is probably being streamed,
+		// so let the cache read ahead
+		TBool sequential = (pos == iNextReadPos);
+		iNextReadPos = pos + len;
+		RofsMount().CacheReadL( pos + iMediaBase, len, aDes, aOffset, aMessage, sequential );
 #else
 		TInt r = RofsMount().LocalDrive()->Read( pos + iMediaBase, len, aDes, aMessage.Handle(),aOffset) ;
 		User::LeaveIfError( r );
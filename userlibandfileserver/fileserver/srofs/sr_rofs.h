@@ -167,9 +167,10 @@ public:
 	virtual TInt Spare3(TInt aVal, TAny* aPtr1, TAny* aPtr2);
 	virtual TInt Spare2(TInt aVal, TAny* aPtr1, TAny* aPtr2);
 	virtual TInt Spare1(TInt aVal, TAny* aPtr1, TAny* aPtr2);
+	TInt ControlIO(const RMessagePtr2& aMessage,TInt aCommand,TAny* aParam1,TAny* aParam2);
 
 #ifdef _USE_TRUE_LRU_CACHE
-	void CacheReadL(TInt aPos, TInt aLength, const TAny* aDes, TInt anOffset, const RMessagePtr2& aMessage) const;
+	void CacheReadL(TInt aPos, TInt aLength, const TAny* aDes, TInt anOffset, const RMessagePtr2& aMessage, TBool aSequential=EFalse) const;
 #endif
 	TUint8 iMountId;
 
@@ -215,6 +216,7 @@ private:
 private:
 	TUint iMediaBase;
 	TUint8	iAttExtra;
+	TInt iNextReadPos;	// where a sequential read would continue from
 	};
 
 class CRofsDirCB : public CDirCB
@@ -237,9 +239,11 @@ private:
 	};
 
 #ifdef _USE_TRUE_LRU_CACHE
-const TInt KSizeOfCacheInPages = 5;	// 5K Cache
+const TInt KSizeOfCacheInPages = 5;	// 5K Cache, unless ESTART.TXT sets ROFS_DataCacheSize
+const TInt KMaxSizeOfCacheInSegments = 4096;	// 4MB
 const TInt KSizeOfSegment = 1024;	//Two pages
 const TInt KPageSize = 512;
+const TInt KSizeOfPrefetchInSegments = 4;	// Read ahead for sequential file reads
 
 class TCacheSegment
 	{
@@ -250,6 +254,7 @@ public:
 public:
 	TInt iPos;	
 	TDblQueLink iLink;
+	TCacheSegment* iHashNext;	// Next segment in the same hash bucket
 	};
 
 //
@@ -259,15 +264,27 @@ class CRofsLruCache: public CBase
 	{
 public:
 	~CRofsLruCache();
-	static CRofsLruCache* New(TInt aSegmentSize, CRofsMountCB* aMount, TInt64 aMediaSize);
+	static CRofsLruCache* New(TInt aSegmentSize, TInt aSegmentCount, CRofsMountCB* aMount, TInt64 aMediaSize);
 	TUint8* Find(TInt aPos , TInt aLength);
-	TUint8* ReadL(TInt aPos , TInt aLength);
+	TUint8* ReadL(TInt aPos , TInt aLength, TBool aPrefetch=EFalse);
+	void GetInfo(TRofsCacheInfo& aInfo) const;
 protected:
 	CRofsLruCache(CRofsMountCB* aMount, TInt64 aMediaSize);
+private:
+	TCacheSegment* Lookup(TInt aPos) const;
+	TCacheSegment* AllocateSegment(TInt aPos);
+	void Discard(TCacheSegment* aSeg);
+	void Hash(TCacheSegment* aSeg);
+	void Unhash(TCacheSegment* aSeg);
+	inline TCacheSegment*& Bucket(TInt aPos) const;
 private:
 	TDblQue<TCacheSegment> iQue;
 	CRofsMountCB* iMount;
 	TInt64 iMediaSize;
+	TCacheSegment** iHash;		// Segments by position, chained through iHashNext
+	TUint iHashMask;
+	TUint8* iPrefetchBuffer;
+	TRofsCacheInfo iInfo;
 	};
 #endif
 
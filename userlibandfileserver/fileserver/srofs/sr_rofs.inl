@@ -85,6 +85,12 @@ inline void CRofsDirCB::SetCache( CDirectoryCache* aCache )
 	{iCache = aCache;}
 
 
+#ifdef _USE_TRUE_LRU_CACHE
+inline TCacheSegment*& CRofsLruCache::Bucket(TInt aPos) const
+	{return iHash[(TUint(aPos)/KPageSize) & iHashMask];}
+#endif
+
+
 inline CRofs& CRofsMountCB::FileSystem() const
 	{return((CRofs&)Drive().FSys());}
 